@@ -0,0 +1,39 @@
+#include <filesystem>
+#include <string>
+
+#include "ProgramCache.h"
+#include "bench_utils.h"
+
+/*
+ * Compares lexing and parsing a large program with loading it from the on-disk AST cache.
+ */
+int main(int argc, char* argv[]) {
+  int numFunctions = argc > 1 ? std::stoi(argv[1]) : 2000;
+  const int iterations = 10;
+
+  auto source = generateProgramSource(numFunctions);
+  std::string key(reinterpret_cast<const char*>(source.data()),
+                  source.size() * sizeof(wchar_t));
+
+  auto directory = std::filesystem::temp_directory_path() / "proton_ast_cache_bench";
+  ProgramCache cache{directory, "bench"};
+
+  auto program = parseSource(source);
+  if (!program.has_value() || !cache.store(key, *program)) {
+    std::cerr << "Failed to prepare the cache entry\n";
+    return 1;
+  }
+
+  std::cout << "AST cache, " << numFunctions << " functions ("
+            << std::filesystem::file_size(cache.entryPath(key)) << " bytes on disk)\n";
+
+  auto parseTime = measure(iterations, [&] { parseSource(source); });
+  auto loadTime = measure(iterations, [&] { cache.load(key, "bench.prot"); });
+
+  report("lex + parse", parseTime);
+  report("cache load ", loadTime);
+  std::cout << "  speedup: " << parseTime / loadTime << "x\n";
+
+  std::filesystem::remove_all(directory);
+  return 0;
+}
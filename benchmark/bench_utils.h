@@ -0,0 +1,68 @@
+#pragma once
+
+#include <chrono>
+#include <iostream>
+#include <optional>
+#include <string>
+
+#include "ErrorHandler.h"
+#include "Lexer.h"
+#include "Parser.h"
+#include "StringCharReader.h"
+
+/**
+ * @brief Generates a syntactically valid program with `numFunctions` functions exercising most
+ * kinds of statements and expressions.
+ */
+inline std::wstring generateProgramSource(int numFunctions) {
+  std::wstring source =
+      L"struct Point { x: int; y: int; };\n"
+      L"variant Number { int, float };\n"
+      L"const LIMIT: int = 1000;\n"
+      L"var origin: Point = { x: 0, y: 0 };\n";
+
+  for (int i = 0; i < numFunctions; i++) {
+    auto n = std::to_wstring(i);
+    source += L"fn helper" + n + L"(a: int, const p: Point, number: Number) -> int {\n" +
+              L"  var sum: int = a * 2 + p.x - (p.y % 3);\n" +
+              L"  for i in 0 until LIMIT {\n" +
+              L"    if i == " + n + L" && !(sum > 10) { sum = sum + i; }\n" +
+              L"    elif i > 5 { continue; }\n" +
+              L"    else { break; }\n" +
+              L"  }\n" +
+              L"  while sum < 100 { sum = sum + float(a) * 1.5; }\n" +
+              L"  match number {\n" +
+              L"    case int -> { << \"int \" << number as int << \"\\n\"; }\n" +
+              L"    case float -> { << 'f' << number as float; }\n" +
+              L"  }\n" +
+              L"  >> sum;\n" +
+              L"  return helper" + n + L"(sum - 1, { x: sum, y: p.y }, number);\n" +
+              L"}\n";
+  }
+
+  source += L"fn main() -> int { return helper0(1, origin, 2); }\n";
+  return source;
+}
+
+inline std::optional<Program> parseSource(const std::wstring& source) {
+  ErrorHandler errorHandler;
+  StringCharReader reader{source};
+  Lexer lexer{reader, errorHandler};
+  Parser parser{lexer, errorHandler};
+  return parser.parseProgram();
+}
+
+/**
+ * @brief Runs `fn` `iterations` times and returns the mean duration in microseconds.
+ */
+template <typename Fn>
+double measure(int iterations, Fn&& fn) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) fn();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::micro>(end - start).count() / iterations;
+}
+
+inline void report(const std::string& name, double micros) {
+  std::cout << "  " << name << ": " << micros << " us\n";
+}
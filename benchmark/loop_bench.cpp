@@ -0,0 +1,83 @@
+#include <string>
+
+#include "CountedLoops.h"
+#include "Evaluator.h"
+#include "ScopeChecker.h"
+#include "TypeChecker.h"
+#include "bench_utils.h"
+
+/*
+ * Range loops run by the Evaluator, with an empty body and with a small arithmetic one. The
+ * bounds are constants, so the direction is resolved before the loop runs, or variables, so it
+ * is resolved by comparing them when it starts.
+ */
+
+namespace {
+
+std::wstring generateLoopSource(int count, bool constantBounds, const std::wstring& body) {
+  auto n = std::to_wstring(count);
+  auto start = constantBounds ? n : std::wstring{L"n"};
+  std::wstring source =
+      L"const RESULT: int = main();\n"
+      L"fn main() -> int {\n";
+  source += L"  var n: int = " + n + L";\n";
+  source += L"  var total: int = 0;\n";
+  source += L"  for i in " + start + L" until 0 { " + body + L" }\n";
+  source += L"  return total;\n}\n";
+  return source;
+}
+
+/**
+ * @brief Checks the program and resolves its loops, nullopt if it is not valid.
+ */
+std::optional<Program> prepare(const std::wstring& source) {
+  auto program = parseSource(source);
+  if (!program.has_value()) return std::nullopt;
+
+  ErrorHandler errorHandler;
+  ScopeChecker{errorHandler}.check(*program);
+  TypeChecker{errorHandler}.check(*program);
+  if (errorHandler.hasErrors()) return std::nullopt;
+  specializeCountedLoops(*program);
+  return program;
+}
+
+/**
+ * @brief Evaluates RESULT, returning -1 if the Evaluator gives up.
+ */
+int run(const Program& program) {
+  Evaluator evaluator{program, EvaluationLimits{.steps = 1'000'000'000}};
+  auto value = evaluator.evaluate(*cast<ConstDef>(*program.definitions.at(L"RESULT")).value);
+  return value.has_value() ? std::get<int>(value->data) : -1;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  int count = argc > 1 ? std::stoi(argv[1]) : 100'000;
+  const int iterations = 5;
+
+  const std::wstring emptyBody;
+  const std::wstring arithmeticBody = L"total = (total + i * 3) % 1000;";
+
+  std::cout << "Range loops, " << count << " iterations\n";
+  for (auto constantBounds : {true, false}) {
+    for (const auto* body : {&emptyBody, &arithmeticBody}) {
+      auto program = prepare(generateLoopSource(count, constantBounds, *body));
+      if (!program.has_value()) {
+        std::cerr << "Failed to check the generated program\n";
+        return 1;
+      }
+
+      int result = 0;
+      auto time = measure(iterations, [&] { result = run(*program); });
+      if (result < 0) {
+        std::cerr << "The Evaluator gave up on the loop\n";
+        return 1;
+      }
+      std::string name = constantBounds ? "constant bounds, " : "variable bounds, ";
+      report(name + (body->empty() ? "empty body     " : "arithmetic body"), time);
+    }
+  }
+  return 0;
+}
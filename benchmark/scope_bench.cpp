@@ -0,0 +1,115 @@
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ScopeChecker.h"
+#include "ScopedTable.h"
+#include "bench_utils.h"
+
+/*
+ * Symbol table under deep block nesting: the previous stack of hash maps against the flat table
+ * with an undo log, and the ScopeChecker running over a deeply nested program.
+ */
+
+namespace {
+
+/**
+ * @brief The previous ScopedTable, one hash map per scope searched from the innermost outwards.
+ */
+template <typename T>
+class MapStackTable {
+ public:
+  void enterScope() { m_scopes.emplace_back(); }
+  void exitScope() { m_scopes.pop_back(); }
+
+  auto insert(const Identifier& id, T&& value) {
+    return m_scopes.back().insert({id, std::move(value)});
+  }
+
+  const T* find(const Identifier& id) const noexcept {
+    for (auto it = m_scopes.crbegin(); it != m_scopes.crend(); ++it) {
+      if (auto entry = it->find(id); entry != it->end()) return &entry->second;
+    }
+    return nullptr;
+  }
+
+ private:
+  std::vector<std::unordered_map<Identifier, T>> m_scopes;
+};
+
+using Names = std::vector<std::vector<Identifier>>;
+
+Names generateNames(int depth, int variables) {
+  Names names(depth);
+  for (int level = 0; level < depth; level++) {
+    for (int i = 0; i < variables; i++) {
+      names[level].push_back(L"var" + std::to_wstring(level) + L"_" + std::to_wstring(i));
+    }
+  }
+  return names;
+}
+
+/**
+ * @brief Declares the variables of every level, looking up the ones of the outermost and the
+ * current level after each, then leaves all scopes again.
+ */
+template <typename Table>
+long nestScopes(const Names& names) {
+  Table table;
+  long found = 0;
+  for (const auto& level : names) {
+    table.enterScope();
+    for (const auto& name : level) table.insert(name, 1);
+    for (const auto& name : names.front()) found += *table.find(name);
+    for (const auto& name : level) found += *table.find(name);
+  }
+  for (std::size_t i = 0; i < names.size(); i++) table.exitScope();
+  return found;
+}
+
+std::wstring generateNestedSource(int depth, int variables) {
+  std::wstring source = L"fn main() -> int {\n";
+  for (int level = 0; level < depth; level++) {
+    source += L"{\n";
+    for (int i = 0; i < variables; i++) {
+      auto name = L"var" + std::to_wstring(level) + L"_" + std::to_wstring(i);
+      auto value = level == 0 ? std::wstring{L"0"} : L"var0_" + std::to_wstring(i);
+      source += L"var " + name + L": int = " + value + L";\n";
+    }
+  }
+  source += std::wstring(depth, L'}') + L"\nreturn 0;\n}\n";
+  return source;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  int depth = argc > 1 ? std::stoi(argv[1]) : 500;
+  int variables = argc > 2 ? std::stoi(argv[2]) : 16;
+  const int iterations = 20;
+
+  auto names = generateNames(depth, variables);
+  long mapStackFound = 0;
+  long flatFound = 0;
+  auto mapStackTime =
+      measure(iterations, [&] { mapStackFound = nestScopes<MapStackTable<int>>(names); });
+  auto flatTime = measure(iterations, [&] { flatFound = nestScopes<ScopedTable<int>>(names); });
+  if (mapStackFound != flatFound) {
+    std::cerr << "Tables disagree\n";
+    return 1;
+  }
+
+  auto program = parseSource(generateNestedSource(depth, variables));
+  if (!program.has_value()) {
+    std::cerr << "Failed to parse the generated program\n";
+    return 1;
+  }
+  ErrorHandler errorHandler;
+  auto checkerTime = measure(iterations, [&] { ScopeChecker{errorHandler}.check(*program); });
+
+  std::cout << "Nested scopes, depth " << depth << ", " << variables << " variables each\n";
+  report("stack of hash maps", mapStackTime);
+  report("flat undo log     ", flatTime);
+  report("ScopeChecker      ", checkerTime);
+  return 0;
+}
@@ -0,0 +1,241 @@
+#include <string>
+#include <type_traits>
+
+#include "ASTDispatch.h"
+#include "RecursiveASTVisitor.h"
+#include "bench_utils.h"
+
+/*
+ * Full traversal of a large program, classifying every node with dynamic_cast, with
+ * kind based dyn_cast, with the switch based dispatcher and with RecursiveASTVisitor.
+ */
+
+namespace {
+
+struct RttiCast {
+  template <typename To, typename From>
+  static To* as(From* node) {
+    return dynamic_cast<To*>(node);
+  }
+};
+
+struct KindCast {
+  template <typename To, typename From>
+  static To* as(From* node) {
+    return dyn_cast<To>(node);
+  }
+};
+
+/**
+ * @brief Walks the tree with if/else chains of casts, as passes without node kinds have to.
+ */
+template <typename Cast>
+struct CastWalker {
+  void program(Program& program) {
+    for (auto& [name, definition] : program.definitions) statement(definition.get());
+  }
+
+  void block(BlockStmt& block) {
+    nodes++;
+    for (auto& stmt : block.statements) statement(stmt.get());
+  }
+
+  void statement(Statement* stmt) {
+    nodes++;
+    if (auto varDef = Cast::template as<VarDef>(stmt)) {
+      expression(varDef->value.get());
+    } else if (auto constDef = Cast::template as<ConstDef>(stmt)) {
+      expression(constDef->value.get());
+    } else if (Cast::template as<StructDef>(stmt) || Cast::template as<VariantDef>(stmt)) {
+    } else if (auto fnDef = Cast::template as<FnDef>(stmt)) {
+      block(fnDef->body);
+    } else if (auto blockStmt = Cast::template as<BlockStmt>(stmt)) {
+      block(*blockStmt);
+    } else if (auto exprStmt = Cast::template as<ExpressionStmt>(stmt)) {
+      expression(exprStmt->expr.get());
+    } else if (auto assignment = Cast::template as<AssignmentStmt>(stmt)) {
+      expression(assignment->lhs.get());
+      expression(assignment->rhs.get());
+    } else if (auto extraction = Cast::template as<StdinExtractionStmt>(stmt)) {
+      for (auto& expr : extraction->expressions) expression(expr.get());
+    } else if (auto insertion = Cast::template as<StdoutInsertionStmt>(stmt)) {
+      for (auto& expr : insertion->expressions) expression(expr.get());
+    } else if (auto match = Cast::template as<VariantMatchStmt>(stmt)) {
+      expression(match->expr.get());
+      for (auto& [variant, matchCase] : match->cases) block(matchCase.block);
+    } else if (auto ifStmt = Cast::template as<IfStmt>(stmt)) {
+      expression(ifStmt->condition.get());
+      block(ifStmt->block);
+      for (auto& elif : ifStmt->elifs) {
+        expression(elif.condition.get());
+        block(elif.block);
+      }
+      if (ifStmt->elseClause) block(ifStmt->elseClause->block);
+    } else if (auto forStmt = Cast::template as<ForStmt>(stmt)) {
+      expression(forStmt->range.start.get());
+      expression(forStmt->range.end.get());
+      block(forStmt->block);
+    } else if (auto whileStmt = Cast::template as<WhileStmt>(stmt)) {
+      expression(whileStmt->condition.get());
+      block(whileStmt->block);
+    } else if (auto returnStmt = Cast::template as<ReturnStmt>(stmt)) {
+      if (returnStmt->expr) expression(returnStmt->expr.get());
+    }
+  }
+
+  void expression(Expression* expr) {
+    nodes++;
+    if (auto binary = Cast::template as<BinaryExpression>(expr)) {
+      expression(binary->lhs.get());
+      expression(binary->rhs.get());
+    } else if (auto unary = Cast::template as<UnaryExpression>(expr)) {
+      expression(unary->expr.get());
+    } else if (auto functional = Cast::template as<FunctionalExpression>(expr)) {
+      expression(functional->expr.get());
+      if (auto call = Cast::template as<FnCallPostfix>(functional->postfix.get())) {
+        for (auto& arg : call->args) expression(arg.get());
+      }
+    } else if (auto object = Cast::template as<Object>(expr)) {
+      for (auto& [name, member] : object->members) expression(member.value.get());
+    } else if (auto paren = Cast::template as<ParenExpr>(expr)) {
+      expression(paren->expr.get());
+    } else if (auto castExpr = Cast::template as<CastExpr>(expr)) {
+      expression(castExpr->expr.get());
+    } else if (auto literal = Cast::template as<Literal<int>>(expr)) {
+      sum += literal->value;
+    }
+  }
+
+  std::size_t nodes = 0;
+  long sum = 0;
+};
+
+/**
+ * @brief Walks the tree with one switch per node.
+ */
+struct DispatchWalker {
+  void visit(ASTNode* node) {
+    if (node == nullptr) return;
+    nodes++;
+    dispatch(*node, [this](auto& n) { children(n); });
+  }
+
+  void children(Program& program) {
+    for (auto& [name, definition] : program.definitions) visit(definition.get());
+  }
+  void children(VarDef& varDef) { visit(varDef.value.get()); }
+  void children(ConstDef& constDef) { visit(constDef.value.get()); }
+  void children(FnDef& fnDef) { visit(&fnDef.body); }
+  void children(BlockStmt& block) {
+    for (auto& stmt : block.statements) visit(stmt.get());
+  }
+  void children(ExpressionStmt& stmt) { visit(stmt.expr.get()); }
+  void children(AssignmentStmt& stmt) {
+    visit(stmt.lhs.get());
+    visit(stmt.rhs.get());
+  }
+  void children(StdinExtractionStmt& stmt) {
+    for (auto& expr : stmt.expressions) visit(expr.get());
+  }
+  void children(StdoutInsertionStmt& stmt) {
+    for (auto& expr : stmt.expressions) visit(expr.get());
+  }
+  void children(VariantMatchStmt& stmt) {
+    visit(stmt.expr.get());
+    for (auto& [variant, matchCase] : stmt.cases) visit(&matchCase.block);
+  }
+  void children(IfStmt& stmt) {
+    visit(stmt.condition.get());
+    visit(&stmt.block);
+    for (auto& elif : stmt.elifs) {
+      visit(elif.condition.get());
+      visit(&elif.block);
+    }
+    if (stmt.elseClause) visit(&stmt.elseClause->block);
+  }
+  void children(ForStmt& stmt) {
+    visit(stmt.range.start.get());
+    visit(stmt.range.end.get());
+    visit(&stmt.block);
+  }
+  void children(WhileStmt& stmt) {
+    visit(stmt.condition.get());
+    visit(&stmt.block);
+  }
+  void children(ReturnStmt& stmt) { visit(stmt.expr.get()); }
+  void children(BinaryExpression& expr) {
+    visit(expr.lhs.get());
+    visit(expr.rhs.get());
+  }
+  void children(UnaryExpression& expr) { visit(expr.expr.get()); }
+  void children(FunctionalExpression& expr) {
+    visit(expr.expr.get());
+    if (auto call = dyn_cast<FnCallPostfix>(expr.postfix.get())) {
+      for (auto& arg : call->args) visit(arg.get());
+    }
+  }
+  void children(Object& object) {
+    for (auto& [name, member] : object.members) visit(member.value.get());
+  }
+  void children(ParenExpr& expr) { visit(expr.expr.get()); }
+  void children(CastExpr& expr) { visit(expr.expr.get()); }
+  void children(Literal<int>& literal) { sum += literal.value; }
+  void children(ASTNode&) {}
+
+  std::size_t nodes = 0;
+  long sum = 0;
+};
+
+/**
+ * @brief Same work on top of RecursiveASTVisitor, hooks only for the nodes it needs.
+ */
+class CountingVisitor : public RecursiveASTVisitor<CountingVisitor> {
+ public:
+  void visit(ASTNode&) { nodes++; }
+  void visit(Literal<int>& literal) {
+    nodes++;
+    sum += literal.value;
+  }
+
+  std::size_t nodes = 0;
+  long sum = 0;
+};
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  int numFunctions = argc > 1 ? std::stoi(argv[1]) : 2000;
+  const int iterations = 20;
+
+  auto program = parseSource(generateProgramSource(numFunctions));
+  if (!program.has_value()) {
+    std::cerr << "Failed to parse the generated program\n";
+    return 1;
+  }
+
+  std::size_t nodes = 0;
+  auto rttiTime = measure(iterations, [&] {
+    CastWalker<RttiCast> walker;
+    walker.program(*program);
+    nodes = walker.nodes;
+  });
+  auto kindTime = measure(iterations, [&] {
+    CastWalker<KindCast> walker;
+    walker.program(*program);
+  });
+  auto dispatchTime = measure(iterations, [&] {
+    DispatchWalker walker;
+    walker.visit(&*program);
+  });
+  auto visitorTime = measure(iterations, [&] {
+    CountingVisitor visitor;
+    visitor.traverse(*program);
+  });
+
+  std::cout << "Full traversal, " << numFunctions << " functions (" << nodes << " nodes)\n";
+  report("dynamic_cast", rttiTime);
+  report("dyn_cast    ", kindTime);
+  report("dispatch    ", dispatchTime);
+  report("visitor     ", visitorTime);
+  return 0;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+
+#include "ErrorType.h"
+
+enum class ErrorLevel : std::uint8_t { Error, Warning };
+
+/**
+ * @brief Compact record of a reported error. Nothing is formatted until the record is written to
+ * a DiagnosticSink, the source file is an index into the files interned by the ErrorHandler.
+ */
+struct Diagnostic {
+  ErrorType type;
+  ErrorLevel level;
+  std::uint32_t sourceFile;
+  int line;
+  int column;
+};
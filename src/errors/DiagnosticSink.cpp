@@ -0,0 +1,65 @@
+#include <sstream>
+
+#include "DiagnosticSink.h"
+
+namespace {
+
+void writeJsonString(std::ostream& out, std::string_view str) {
+  out << '"';
+  for (char c : str) {
+    switch (c) {
+      case '"':
+        out << "\\\"";
+        break;
+      case '\\':
+        out << "\\\\";
+        break;
+      case '\n':
+        out << "\\n";
+        break;
+      case '\t':
+        out << "\\t";
+        break;
+      default:
+        // Any other control character is not allowed in a JSON string
+        if (static_cast<unsigned char>(c) < 0x20) {
+          constexpr char hex[] = "0123456789abcdef";
+          out << "\\u00" << hex[c >> 4] << hex[c & 0xf];
+        } else {
+          out << c;
+        }
+    }
+  }
+  out << '"';
+}
+
+}  // namespace
+
+std::string formatDiagnostic(const Diagnostic& diagnostic, std::string_view sourceFile) {
+  const auto& info = errorInfo(diagnostic.type);
+  std::stringstream message;
+
+  message << "\n"
+          << (diagnostic.level == ErrorLevel::Error ? "ERROR" : "WARNING") << " in line "
+          << diagnostic.line << " col " << diagnostic.column << " of " << sourceFile << "\n"
+          << "WHAT? " << info.category << ": " << info.message << "\n";
+
+  return message.str();
+}
+
+void TextDiagnosticSink::write(const Diagnostic& diagnostic, std::string_view sourceFile) {
+  m_out << formatDiagnostic(diagnostic, sourceFile);
+}
+
+void JsonLinesDiagnosticSink::write(const Diagnostic& diagnostic, std::string_view sourceFile) {
+  const auto& info = errorInfo(diagnostic.type);
+
+  m_out << "{\"level\":\"" << (diagnostic.level == ErrorLevel::Error ? "error" : "warning")
+        << "\",\"code\":" << static_cast<int>(diagnostic.type) << ",\"category\":";
+  writeJsonString(m_out, info.category);
+  m_out << ",\"message\":";
+  writeJsonString(m_out, info.message);
+  m_out << ",\"file\":";
+  writeJsonString(m_out, sourceFile);
+  m_out << ",\"line\":" << diagnostic.line << ",\"column\":" << diagnostic.column << "}\n";
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+#include "Diagnostic.h"
+
+/**
+ * @brief Destination of formatted diagnostics, see ErrorHandler::emitDiagnostics.
+ */
+class DiagnosticSink {
+ public:
+  virtual ~DiagnosticSink() = default;
+
+  virtual void write(const Diagnostic& diagnostic, std::string_view sourceFile) = 0;
+};
+
+/**
+ * @brief Human-readable messages, one block per diagnostic.
+ */
+class TextDiagnosticSink : public DiagnosticSink {
+ public:
+  explicit TextDiagnosticSink(std::ostream& out) : m_out{out} {}
+
+  void write(const Diagnostic& diagnostic, std::string_view sourceFile) override;
+
+ private:
+  std::ostream& m_out;
+};
+
+/**
+ * @brief One JSON object per line, for tools consuming the diagnostics.
+ */
+class JsonLinesDiagnosticSink : public DiagnosticSink {
+ public:
+  explicit JsonLinesDiagnosticSink(std::ostream& out) : m_out{out} {}
+
+  void write(const Diagnostic& diagnostic, std::string_view sourceFile) override;
+
+ private:
+  std::ostream& m_out;
+};
+
+/**
+ * @brief Hands the records to a callback, e.g. to collect them in memory when embedding.
+ */
+class CallbackDiagnosticSink : public DiagnosticSink {
+ public:
+  using Callback = std::function<void(const Diagnostic&, std::string_view)>;
+
+  explicit CallbackDiagnosticSink(Callback callback) : m_callback{std::move(callback)} {}
+
+  void write(const Diagnostic& diagnostic, std::string_view sourceFile) override {
+    m_callback(diagnostic, sourceFile);
+  }
+
+ private:
+  Callback m_callback;
+};
+
+std::string formatDiagnostic(const Diagnostic& diagnostic, std::string_view sourceFile);
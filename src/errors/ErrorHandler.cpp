@@ -1,59 +1,77 @@
 #include <iostream>
-#include <sstream>
 
 #include "ErrorHandler.h"
 
 ErrorHandler::ErrorHandler(const int numToleratedErrors)
     : m_numToleratedErrors(numToleratedErrors) {}
 
+ErrorHandler::ErrorHandler(const ErrorPolicy policy, const int numToleratedErrors)
+    : m_policy(policy), m_numToleratedErrors(numToleratedErrors) {}
+
 /**
  * @brief Signals error or warning.
  *
- * @note ErrorLevel::Error is default and makes the program exit immedietely.
- * @note ErrorLevel::Warning makes the program exit if the number of tolerated warnings is
- * exceeded.
+ * @note Nothing is printed here, see emitDiagnostics and dumpErrors.
  */
 void ErrorHandler::operator()(const ErrorType type, const Position& position, ErrorLevel level) {
-  m_numErrors++;
+  if (level == ErrorLevel::Error) m_numErrors++;
   level == ErrorLevel::Error ? handleError(type, position) : handleWarning(type, position);
 }
 
 /**
- * @brief Prints formatted error message and exits.
+ * @brief Records the error. With ErrorPolicy::KeepFirst only the first error is kept.
  */
 void ErrorHandler::handleError(const ErrorType type, const Position& position) {
-  appendErrorMessage(type, position);
-  dumpErrors();
-  exit(1);
+  if (m_policy == ErrorPolicy::KeepFirst && m_keptError) return;
+  m_keptError = true;
+  record(type, position, ErrorLevel::Error);
 }
 
-/*
- * @brief Stores warning information. If number of tolerated warnings is exceeded,
- * prints formatted error message and exits.
- */
 void ErrorHandler::handleWarning(const ErrorType type, const Position& position) {
-  appendErrorMessage(type, position);
-  if (m_numErrors >= m_numToleratedErrors) {
-    dumpErrors();
-    exit(1);
-  }
+  record(type, position, ErrorLevel::Warning);
 }
 
 bool ErrorHandler::hasErrors() const { return m_numErrors > 0; }
 
-void ErrorHandler::dumpErrors() const { std::cerr << m_errorMessages.str(); }
+/**
+ * @brief Whether diagnostics were dropped because the number of tolerated errors was exceeded.
+ * Long running callers may use it to stop early.
+ */
+bool ErrorHandler::limitReached() const { return m_limitReached; }
+
+const std::vector<Diagnostic>& ErrorHandler::diagnostics() const { return m_diagnostics; }
 
-void ErrorHandler::appendErrorMessage(const ErrorType type, const Position& position) {
-  m_errorMessages << formatErrorMessage(type, position);
+std::string_view ErrorHandler::sourceFile(const Diagnostic& diagnostic) const {
+  return m_sourceFiles.at(diagnostic.sourceFile);
 }
 
-std::string ErrorHandler::formatErrorMessage(const ErrorType type, const Position& position) const {
-  std::stringstream message;
+void ErrorHandler::emitDiagnostics(DiagnosticSink& sink) const {
+  for (const auto& diagnostic : m_diagnostics) {
+    sink.write(diagnostic, sourceFile(diagnostic));
+  }
+}
 
-  message << "\n"
-          << "ERROR in line " << position.line << " col " << position.column << " of "
-          << position.sourceFile << "\n"
-          << "WHAT? " << Errors.at(type).first << ": " << Errors.at(type).second << "\n";
+void ErrorHandler::dumpErrors() const {
+  TextDiagnosticSink sink{std::cerr};
+  emitDiagnostics(sink);
+}
+
+void ErrorHandler::record(const ErrorType type, const Position& position, ErrorLevel level) {
+  if (static_cast<int>(m_diagnostics.size()) >= m_numToleratedErrors) {
+    m_limitReached = true;
+    return;
+  }
+  m_diagnostics.push_back(
+      {type, level, internSourceFile(position.sourceFile), position.line, position.column});
+}
 
-  return message.str();
+/**
+ * @brief Diagnostics mostly come from one file at a time, the last one is checked first.
+ */
+std::uint32_t ErrorHandler::internSourceFile(const std::string& sourceFile) {
+  for (std::size_t i = m_sourceFiles.size(); i > 0; i--) {
+    if (m_sourceFiles[i - 1] == sourceFile) return static_cast<std::uint32_t>(i - 1);
+  }
+  m_sourceFiles.push_back(sourceFile);
+  return static_cast<std::uint32_t>(m_sourceFiles.size() - 1);
 }
@@ -1,13 +1,26 @@
 #pragma once
 
-#include <sstream>
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <vector>
 
+#include "Diagnostic.h"
+#include "DiagnosticSink.h"
 #include "ErrorType.h"
 #include "Position.h"
 
-enum class ErrorLevel { Error, Warning };
-
+/**
+ * @brief KeepFirst records only the first error, the ones after it are usually its follow-ups.
+ * Collect records every error, so that a recovering parser can report all of them in one run.
+ * Either way at most the number of tolerated errors is recorded.
+ */
+enum class ErrorPolicy { KeepFirst, Collect };
+
+/**
+ * @brief Records diagnostics without ever terminating the process. Callers check hasErrors() and
+ * write the records to a DiagnosticSink when they are done, formatting happens only then.
+ */
 class ErrorHandler {
  public:
   ErrorHandler(const ErrorHandler&) = delete;
@@ -16,23 +29,35 @@ class ErrorHandler {
   ErrorHandler& operator=(ErrorHandler&&) = delete;
 
   ErrorHandler(int numToleratedErrors);
+  ErrorHandler(ErrorPolicy policy, int numToleratedErrors);
   ErrorHandler() = default;
-  ~ErrorHandler() = default;
+  virtual ~ErrorHandler() = default;
 
   void operator()(const ErrorType type, const Position& position,
                   ErrorLevel level = ErrorLevel::Error);
 
+  bool hasErrors() const;
+  bool limitReached() const;
+  const std::vector<Diagnostic>& diagnostics() const;
+  std::string_view sourceFile(const Diagnostic& diagnostic) const;
+
+  void emitDiagnostics(DiagnosticSink& sink) const;
+  void dumpErrors() const;
+
  protected:
   virtual void handleError(const ErrorType type, const Position& position);
   virtual void handleWarning(const ErrorType type, const Position& position);
 
  private:
-  bool hasErrors() const;
-  void dumpErrors() const;
-  void appendErrorMessage(const ErrorType type, const Position& position);
-  std::string formatErrorMessage(const ErrorType type, const Position& position) const;
+  void record(const ErrorType type, const Position& position, ErrorLevel level);
+  std::uint32_t internSourceFile(const std::string& sourceFile);
 
+  const ErrorPolicy m_policy = ErrorPolicy::KeepFirst;
   int m_numErrors = 0;
   const int m_numToleratedErrors = 10;
-  std::stringstream m_errorMessages;
+  bool m_keptError = false;
+  bool m_limitReached = false;
+
+  std::vector<Diagnostic> m_diagnostics;
+  std::vector<std::string> m_sourceFiles;
 };
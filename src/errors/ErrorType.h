@@ -1,7 +1,8 @@
 #pragma once
 
-#include <string>
-#include <unordered_map>
+#include <array>
+#include <cstddef>
+#include <string_view>
 
 enum class ErrorType {
   // Lexical Errors
@@ -13,6 +14,9 @@ enum class ErrorType {
 
   /* ------------------------------ Syntax Errors ----------------------------- */
 
+  // Program
+  EXPECTED_DEFINITION,
+
   // Variable Definition
   VARDEF_EXPECTED_IDENTIFIER,
   VARDEF_EXPECTED_COLON,
@@ -132,19 +136,53 @@ enum class ErrorType {
   FNPARAM_REDEFINITION,
   OBJECTMEMBER_REDEFINITION,
   VARIANTMATCHCASE_REDEFINITION,
+  UNDEFINED_IDENTIFIER,
+
+  // Type Errors
+  UNKNOWN_TYPE,
+  EXPECTED_VALUE,
+  TYPE_MISMATCH,
+  INVALID_OPERAND_TYPES,
+  INVALID_CAST,
+  NOT_CALLABLE,
+  ARGUMENT_COUNT_MISMATCH,
+  UNKNOWN_MEMBER,
+  INVALID_VARIANT_ACCESS,
+  INVALID_MATCH_CASE,
+  NON_EXHAUSTIVE_MATCH,
+  NOT_ASSIGNABLE,
+  CONST_ASSIGNMENT,
+  INVALID_IO_OPERAND,
+
+  // Constant Evaluation Errors
+  DIVISION_BY_ZERO,
+  INTEGER_OVERFLOW,
 
   // Internal Errors
   TOKEN_INVARIANT_VIOLATION,
+
+  // Number of error types, must stay last
+  ERROR_TYPE_COUNT,
 };
 
-const auto LEXICAL_ERROR = std::string("Lexical Error");
-const auto SYNTAX_ERROR = std::string("Syntax Error");
-const auto SEMANTIC_ERROR = std::string("Semantic Error");
-const auto INTERNAL_ERROR = std::string("Internal Error");
+constexpr std::string_view LEXICAL_ERROR = "Lexical Error";
+constexpr std::string_view SYNTAX_ERROR = "Syntax Error";
+constexpr std::string_view SEMANTIC_ERROR = "Semantic Error";
+constexpr std::string_view INTERNAL_ERROR = "Internal Error";
 
-using ErrorInfo = std::pair<std::string, std::string>;  // pairs of <ErrorTypeStr, ErrorMsg>
+struct ErrorInfo {
+  std::string_view category;
+  std::string_view message;
+};
 
-static const std::unordered_map<ErrorType, ErrorInfo> Errors = {
+namespace detail {
+
+struct ErrorTableEntry {
+  ErrorType type;
+  ErrorInfo info;
+};
+
+inline constexpr ErrorTableEntry ERROR_TABLE_ENTRIES[] = {
 
     /* ----------------------------- Internal Errors ---------------------------- */
 
@@ -163,6 +201,10 @@ static const std::unordered_map<ErrorType, ErrorInfo> Errors = {
 
     /* ------------------------------ Syntax Errors ----------------------------- */
 
+    // Program
+    {ErrorType::EXPECTED_DEFINITION,
+     {SYNTAX_ERROR, "Expected definition (var, const, struct, variant or fn)!"}},
+
     // Variable Definition
     {ErrorType::VARDEF_EXPECTED_IDENTIFIER,
      {SYNTAX_ERROR, "Expected identifier in variable definition!"}},
@@ -253,6 +295,8 @@ static const std::unordered_map<ErrorType, ErrorInfo> Errors = {
      {SYNTAX_ERROR, "Missing closing parenthesis in cast expression!"}},
 
     // Paren Expression
+    {ErrorType::PARENEXPR_EXPECTED_EXPRESSION,
+     {SYNTAX_ERROR, "Expected expression in parenthesized expression!"}},
     {ErrorType::PARENEXPR_EXPECTED_RPAREN,
      {SYNTAX_ERROR, "Missing closing parenthesis in parenthesized expression!"}},
 
@@ -342,4 +386,68 @@ static const std::unordered_map<ErrorType, ErrorInfo> Errors = {
     {ErrorType::OBJECTMEMBER_REDEFINITION, {SEMANTIC_ERROR, "Object member redefinition!"}},
     {ErrorType::VARIANTTYPE_REDEFINITION, {SEMANTIC_ERROR, "Variant type redefinition!"}},
     {ErrorType::FNPARAM_REDEFINITION, {SEMANTIC_ERROR, "Function parameter redefinition!"}},
+    {ErrorType::UNDEFINED_IDENTIFIER,
+     {SEMANTIC_ERROR, "Use of undefined identifier, no definition with that name is in scope!"}},
+
+    // Type Errors
+    {ErrorType::UNKNOWN_TYPE,
+     {SEMANTIC_ERROR, "Unknown type, no type with that name is in scope!"}},
+    {ErrorType::EXPECTED_VALUE, {SEMANTIC_ERROR, "Expected a value, found the name of a type!"}},
+    {ErrorType::TYPE_MISMATCH,
+     {SEMANTIC_ERROR, "Type mismatch, the value does not have the expected type!"}},
+    {ErrorType::INVALID_OPERAND_TYPES,
+     {SEMANTIC_ERROR, "The operator can not be applied to operands of these types!"}},
+    {ErrorType::INVALID_CAST,
+     {SEMANTIC_ERROR, "Invalid cast, the value can not be converted to that type!"}},
+    {ErrorType::NOT_CALLABLE, {SEMANTIC_ERROR, "Called value is not a function!"}},
+    {ErrorType::ARGUMENT_COUNT_MISMATCH,
+     {SEMANTIC_ERROR, "Wrong number of arguments in function call!"}},
+    {ErrorType::UNKNOWN_MEMBER, {SEMANTIC_ERROR, "Accessed member does not exist in the struct!"}},
+    {ErrorType::INVALID_VARIANT_ACCESS,
+     {SEMANTIC_ERROR, "Variant access requires a variant value holding the accessed type!"}},
+    {ErrorType::INVALID_MATCH_CASE,
+     {SEMANTIC_ERROR, "Match case type is not one of the types of the matched variant!"}},
+    {ErrorType::NON_EXHAUSTIVE_MATCH,
+     {SEMANTIC_ERROR, "Non-exhaustive match, every type of the variant needs a case!"}},
+    {ErrorType::NOT_ASSIGNABLE,
+     {SEMANTIC_ERROR, "Only variables and their members can be assigned to!"}},
+    {ErrorType::CONST_ASSIGNMENT,
+     {SEMANTIC_ERROR, "Constants and const parameters can not be assigned to!"}},
+    {ErrorType::INVALID_IO_OPERAND,
+     {SEMANTIC_ERROR, "Only values of primitive types can be read or written!"}},
+
+    // Constant Evaluation Errors
+    {ErrorType::DIVISION_BY_ZERO, {SEMANTIC_ERROR, "Division by zero in constant expression!"}},
+    {ErrorType::INTEGER_OVERFLOW,
+     {SEMANTIC_ERROR, "Constant expression overflows the range of int!"}},
 };
+
+constexpr std::size_t NUM_ERROR_TYPES = static_cast<std::size_t>(ErrorType::ERROR_TYPE_COUNT);
+
+constexpr std::array<ErrorInfo, NUM_ERROR_TYPES> buildErrorTable() {
+  std::array<ErrorInfo, NUM_ERROR_TYPES> table{};
+  for (const auto& entry : ERROR_TABLE_ENTRIES) {
+    table[static_cast<std::size_t>(entry.type)] = entry.info;
+  }
+  return table;
+}
+
+constexpr bool hasEveryErrorType(const std::array<ErrorInfo, NUM_ERROR_TYPES>& table) {
+  for (const auto& info : table) {
+    if (info.message.empty()) return false;
+  }
+  return std::size(ERROR_TABLE_ENTRIES) == NUM_ERROR_TYPES;
+}
+
+}  // namespace detail
+
+/**
+ * @brief Category and message of every error type, indexed by the ErrorType value.
+ */
+inline constexpr auto ERROR_TABLE = detail::buildErrorTable();
+
+static_assert(detail::hasEveryErrorType(ERROR_TABLE), "Every ErrorType needs exactly one entry");
+
+constexpr const ErrorInfo& errorInfo(ErrorType type) {
+  return ERROR_TABLE[static_cast<std::size_t>(type)];
+}
@@ -32,6 +32,18 @@ void CharReaderBase::setCurrentFilename(const std::string& filename) {
 }
 std::string CharReaderBase::getCurrentFilename() const { return m_position.sourceFile; }
 
+/**
+ * @brief Lets implementors start tracking from a position other than the beginning of the
+ * file, e.g. when reading a fragment that was cut out of a bigger source.
+ *
+ * @param line - line of the last character preceding the fragment
+ * @param column - column of the last character preceding the fragment
+ */
+void CharReaderBase::setCurrentPosition(int line, int column) {
+  m_position.line = line;
+  m_position.column = column;
+}
+
 /**
  * @brief Gets last consumed character.
  * Before consuming first character, returns NO_CHAR_YET.
@@ -38,6 +38,7 @@ class CharReaderBase {
  protected:
   void setCurrentFilename(const std::string& filename);
   std::string getCurrentFilename() const;
+  void setCurrentPosition(int line, int column);
 
  private:
   /**
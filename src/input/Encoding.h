@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+
+/**
+ * @brief Text read from a source file back in its original encoding. The readers widen every
+ * byte of the file to a wchar_t (the streams use the classic locale), so identifiers and literals
+ * are narrowed byte by byte.
+ */
+inline std::string sourceText(const std::wstring& text) {
+  std::string bytes;
+  bytes.reserve(text.size());
+  for (wchar_t c : text) bytes += static_cast<char>(c);
+  return bytes;
+}
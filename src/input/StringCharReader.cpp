@@ -4,7 +4,12 @@ StringCharReader::StringCharReader(const std::wstring& str) : m_stream{str} {
   setCurrentFilename(getInputFilename());
 }
 
-std::string StringCharReader::getInputFilename() const { return std::string("<custom string>"); }
+StringCharReader::StringCharReader(const std::wstring& str, int firstLine, int firstColumn)
+    : StringCharReader{str} {
+  setCurrentPosition(firstLine, firstColumn);
+}
+
+std::string StringCharReader::getInputFilename() const { return STRING_INPUT_FILENAME; }
 
 void StringCharReader::load(const std::wstring& str) { m_stream = std::wistringstream{str}; }
 
@@ -4,10 +4,14 @@
 
 #include "CharReaderBase.h"
 
+// Source file name of the positions read from strings
+const char* const STRING_INPUT_FILENAME = "<custom string>";
+
 class StringCharReader : public CharReaderBase {
  public:
   StringCharReader() = delete;
   StringCharReader(const std::wstring& str);
+  StringCharReader(const std::wstring& str, int firstLine, int firstColumn);
 
   std::string getInputFilename() const override;
 
@@ -0,0 +1,216 @@
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <unordered_map>
+
+#include "ASTUtils.h"
+#include "Casting.h"
+#include "CompileTimeEvaluation.h"
+#include "ConstantFolding.h"
+#include "RecursiveASTVisitor.h"
+
+namespace {
+
+// Literals and objects of them, what materialize() builds
+bool isMaterialized(Expression& expr) {
+  if (literalValue(expr).has_value()) return true;
+  if (!isa<Object>(expr)) return false;
+
+  bool materialized = true;
+  forEachChild(expr, [&](std::unique_ptr<Expression>& child) {
+    materialized = materialized && isMaterialized(*child);
+  });
+  return materialized;
+}
+
+bool containsCall(Expression& expr) {
+  if (auto functional = dyn_cast<FunctionalExpression>(&expr)) {
+    if (isa<FnCallPostfix>(functional->postfix.get())) return true;
+  }
+  bool found = false;
+  forEachChild(expr, [&](std::unique_ptr<Expression>& child) {
+    found = found || containsCall(*child);
+  });
+  return found;
+}
+
+/**
+ * @brief Replaces global initializers and the maximal constant expressions with calls in function
+ * bodies by their value. Expressions are reached through the statements owning them and replaced
+ * top-down, the subexpressions of those that can not be evaluated are tried on their own.
+ */
+class CompileTimeEvaluator : public RecursiveASTVisitor<CompileTimeEvaluator> {
+ public:
+  CompileTimeEvaluator(Program& program, EvaluationLimits limits)
+      : m_program{program}, m_evaluator{program, limits} {
+    for (auto& [name, definition] : program.definitions) {
+      if (definition->storage.kind == Storage::Kind::Global) {
+        m_globals.emplace(definition->storage.slot, definition.get());
+      }
+    }
+  }
+
+  CompileTimeStats run() {
+    // Globals in the order of definition, as they are initialized
+    std::vector<Definition*> globals;
+    for (auto& [slot, definition] : m_globals) globals.push_back(definition);
+    std::sort(globals.begin(), globals.end(), [](const auto* lhs, const auto* rhs) {
+      return lhs->storage.slot < rhs->storage.slot;
+    });
+    for (auto* definition : globals) {
+      if (auto varDef = dyn_cast<VarDef>(definition)) initializer(varDef->value);
+      if (auto constDef = dyn_cast<ConstDef>(definition)) initializer(constDef->value);
+    }
+
+    traverse(m_program);
+    m_stats.exhaustedLimits = m_evaluator.exhaustedLimits();
+    m_stats.memoization = m_evaluator.memoStats();
+    return m_stats;
+  }
+
+  template <typename Node>
+  bool visit(Node& node) {
+    if constexpr (std::is_base_of_v<Expression, Node>) {
+      return false;
+    } else {
+      roots(node);
+      return true;
+    }
+  }
+
+ private:
+  /* ------------------------ Top-level expressions ------------------------ */
+
+  void roots(ASTNode&) {}
+  void roots(VarDef& def) {
+    if (def.storage.kind == Storage::Kind::Local) evaluate(def.value, true);
+  }
+  void roots(ConstDef& def) {
+    if (def.storage.kind == Storage::Kind::Local) evaluate(def.value, true);
+  }
+  void roots(ExpressionStmt& stmt) {
+    forEachChild(*stmt.expr, [this](std::unique_ptr<Expression>& child) { evaluate(child); });
+  }
+  void roots(AssignmentStmt& stmt) { evaluate(stmt.rhs, true); }
+  void roots(StdoutInsertionStmt& stmt) {
+    for (auto& expr : stmt.expressions) evaluate(expr);
+  }
+  void roots(VariantMatchStmt& stmt) { evaluate(stmt.expr); }
+  void roots(IfStmt& stmt) { evaluate(stmt.condition); }
+  void roots(Elif& elif) { evaluate(elif.condition); }
+  void roots(Range& range) {
+    evaluate(range.start);
+    evaluate(range.end);
+  }
+  void roots(WhileStmt& stmt) { evaluate(stmt.condition); }
+  void roots(ReturnStmt& stmt) {
+    if (stmt.expr != nullptr) evaluate(stmt.expr, true);
+  }
+
+  /* ------------------------------ Evaluation ----------------------------- */
+
+  void initializer(std::unique_ptr<Expression>& slot) {
+    if (isMaterialized(*slot)) return;
+    if (replace(slot, true)) {
+      m_stats.evaluatedInitializers++;
+    } else {
+      forEachChild(*slot, [this](std::unique_ptr<Expression>& child) { evaluate(child); });
+    }
+  }
+
+  // `converted` if the context converts the value to the type it expects, see replace()
+  void evaluate(std::unique_ptr<Expression>& slot, bool converted = false) {
+    if (containsCall(*slot) && isClosed(*slot) && replace(slot, converted)) {
+      m_stats.evaluatedCalls++;
+      return;
+    }
+    forEachChild(*slot, [this](std::unique_ptr<Expression>& child) { evaluate(child); });
+  }
+
+  // A variant is materialized as the alternative it holds, it can only replace an expression of
+  // its type where the context converts the alternative back into the variant
+  bool replace(std::unique_ptr<Expression>& slot, bool converted) {
+    if (!converted && m_program.types[slot->typeId].kind == TypeKind::Variant) return false;
+
+    auto value = m_evaluator.evaluate(*slot);
+    if (!value.has_value()) return false;
+
+    auto expr = materialize(*value, slot->position, m_program.types);
+    if (expr == nullptr) return false;
+    slot = std::move(expr);
+    return true;
+  }
+
+  // Whether the expression refers to no variables, only to consts and functions
+  bool isClosed(Expression& expr) {
+    if (auto identifier = dyn_cast<IdentifierExpr>(&expr)) {
+      if (identifier->storage.kind != Storage::Kind::Global) return false;
+      auto it = m_globals.find(identifier->storage.slot);
+      return it != m_globals.end() && (isa<ConstDef>(it->second) || isa<FnDef>(it->second));
+    }
+    bool closed = true;
+    forEachChild(expr, [&](std::unique_ptr<Expression>& child) {
+      closed = closed && isClosed(*child);
+    });
+    return closed;
+  }
+
+  Program& m_program;
+  Evaluator m_evaluator;
+  std::unordered_map<std::uint32_t, Definition*> m_globals;  // By global slot
+
+  CompileTimeStats m_stats;
+};
+
+}  // namespace
+
+std::unique_ptr<Expression> materialize(const Value& value, const Position& position,
+                                        const TypeTable& types) {
+  if (auto structValue = std::get_if<StructValue>(&value.data)) {
+    const auto& type = types[structValue->type];
+    const auto& members = type.members;
+    if (structValue->fields.size() != type.width) return nullptr;
+
+    Object::Members objectMembers;
+    for (std::size_t i = 0; i < members.size(); i++) {
+      auto field = memberValue(*structValue, type.offsets[i], members[i].type, types);
+      auto member = materialize(field, position, types);
+      if (member == nullptr) return nullptr;
+      objectMembers.emplace(members[i].name,
+                            ObjectMember{Identifier{members[i].name}, std::move(member)});
+    }
+    auto object = std::make_unique<Object>(Position{position}, std::move(objectMembers));
+    object->typeId = structValue->type;
+    return object;
+  }
+
+  if (auto variantValue = std::get_if<VariantValue>(&value.data)) {
+    return materialize(variantValue->value(), position, types);
+  }
+
+  return std::visit(
+      [&](const auto& data) -> std::unique_ptr<Expression> {
+        using T = std::decay_t<decltype(data)>;
+        if constexpr (std::is_constructible_v<ConstantValue, const T&> &&
+                      !std::is_same_v<T, std::monostate>) {
+          return makeLiteral(ConstantValue{data}, position);
+        } else {
+          return nullptr;
+        }
+      },
+      value.data);
+}
+
+CompileTimeStats evaluateAtCompileTime(Program& program, EvaluationLimits limits) {
+  return CompileTimeEvaluator{program, limits}.run();
+}
+
+void printCompileTimeStats(std::ostream& out, const CompileTimeStats& stats) {
+  const auto& memo = stats.memoization;
+  out << "Compile time evaluation\n";
+  out << "  " << stats.evaluatedInitializers << " initializers, " << stats.evaluatedCalls
+      << " calls evaluated, " << stats.exhaustedLimits << " gave up on the limits\n";
+  out << "  memoization: " << memo.hits << " hits, " << memo.misses << " misses, "
+      << memo.evictions << " evictions, " << std::round(memo.hitRate() * 1000) / 10
+      << "% hit rate\n";
+}
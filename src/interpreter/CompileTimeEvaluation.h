@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <ostream>
+
+#include "Evaluator.h"
+#include "Program.h"
+
+/**
+ * @brief Builds the expression denoting the value: a literal for primitives, an object of
+ * materialized members for structs and the held value for variants, typed as its alternative and
+ * so only in place where it is converted to the variant. Functions and uninitialized values have
+ * no expression, nullptr is returned for them.
+ */
+std::unique_ptr<Expression> materialize(const Value& value, const Position& position,
+                                        const TypeTable& types);
+
+struct CompileTimeStats {
+  std::size_t evaluatedInitializers = 0;  // Global initializers replaced by their value
+  std::size_t evaluatedCalls = 0;         // Expressions with calls replaced by their value
+  std::size_t exhaustedLimits = 0;        // Evaluations given up on reaching the limits
+  MemoStats memoization;                  // Pure calls answered by an earlier result
+};
+
+/**
+ * @brief Evaluates the initializers of global variables and consts and every expression in a
+ * function body that calls functions but refers to no variables, replacing them with their
+ * materialized value. See Evaluator for what can be evaluated, anything else is left as is.
+ *
+ * The program must be type-checked and its names resolved.
+ */
+CompileTimeStats evaluateAtCompileTime(Program& program, EvaluationLimits limits = {});
+
+void printCompileTimeStats(std::ostream& out, const CompileTimeStats& stats);
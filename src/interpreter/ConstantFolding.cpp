@@ -0,0 +1,391 @@
+#include <climits>
+#include <cmath>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+#include "Casting.h"
+#include "ConstantFolding.h"
+#include "RecursiveASTVisitor.h"
+#include "Types.h"
+
+namespace {
+
+template <typename T>
+std::optional<bool> compare(Operator op, const T& lhs, const T& rhs) {
+  switch (op) {
+    case Operator::Eq:
+      return lhs == rhs;
+    case Operator::Neq:
+      return lhs != rhs;
+    case Operator::Lt:
+      return lhs < rhs;
+    case Operator::Gt:
+      return lhs > rhs;
+    case Operator::Leq:
+      return lhs <= rhs;
+    case Operator::Geq:
+      return lhs >= rhs;
+    default:
+      return std::nullopt;
+  }
+}
+
+FoldResult comparison(Operator op, const auto& lhs, const auto& rhs) {
+  if (auto result = compare(op, lhs, rhs)) return {*result};
+  return {};
+}
+
+FoldResult foldInts(Operator op, int lhs, int rhs) {
+  int result;
+  switch (op) {
+    case Operator::Add:
+      if (__builtin_add_overflow(lhs, rhs, &result)) return {{}, ErrorType::INTEGER_OVERFLOW};
+      return {result};
+    case Operator::Sub:
+      if (__builtin_sub_overflow(lhs, rhs, &result)) return {{}, ErrorType::INTEGER_OVERFLOW};
+      return {result};
+    case Operator::Mul:
+      if (__builtin_mul_overflow(lhs, rhs, &result)) return {{}, ErrorType::INTEGER_OVERFLOW};
+      return {result};
+    case Operator::Div:
+    case Operator::Mod:
+      if (rhs == 0) return {{}, ErrorType::DIVISION_BY_ZERO};
+      if (lhs == INT_MIN && rhs == -1) return {{}, ErrorType::INTEGER_OVERFLOW};
+      return {op == Operator::Div ? lhs / rhs : lhs % rhs};
+    default:
+      return comparison(op, lhs, rhs);
+  }
+}
+
+FoldResult foldFloats(Operator op, float lhs, float rhs) {
+  switch (op) {
+    case Operator::Add:
+      return {lhs + rhs};
+    case Operator::Sub:
+      return {lhs - rhs};
+    case Operator::Mul:
+      return {lhs * rhs};
+    case Operator::Div:
+      if (rhs == 0.0f) return {{}, ErrorType::DIVISION_BY_ZERO};
+      return {lhs / rhs};
+    case Operator::Mod:
+      return {};
+    default:
+      return comparison(op, lhs, rhs);
+  }
+}
+
+FoldResult foldBools(Operator op, bool lhs, bool rhs) {
+  switch (op) {
+    case Operator::And:
+      return {lhs && rhs};
+    case Operator::Or:
+      return {lhs || rhs};
+    case Operator::Eq:
+    case Operator::Neq:
+      return comparison(op, lhs, rhs);
+    default:
+      return {};
+  }
+}
+
+FoldResult foldStrings(Operator op, const std::wstring& lhs, const std::wstring& rhs) {
+  switch (op) {
+    case Operator::Add:
+      return {lhs + rhs};
+    case Operator::Eq:
+    case Operator::Neq:
+      return comparison(op, lhs, rhs);
+    default:
+      return {};
+  }
+}
+
+/**
+ * @brief Replaces operators over literals with the literal they evaluate to, see foldConstants.
+ * Expressions are reached through the statements owning them and folded recursively, as folding
+ * replaces the owning slots.
+ */
+class ConstantFolder : public RecursiveASTVisitor<ConstantFolder> {
+ public:
+  ConstantFolder(Program& program, ErrorHandler& errorHandler)
+      : m_program{program}, m_errorHandler{errorHandler} {}
+
+  FoldingStats run() {
+    for (auto& [name, definition] : m_program.definitions) {
+      auto constDef = dyn_cast<ConstDef>(definition.get());
+      if (constDef != nullptr && constDef->storage.kind == Storage::Kind::Global) {
+        m_constants.emplace(constDef->storage.slot, Constant{constDef});
+      }
+    }
+    traverse(m_program);
+    return m_stats;
+  }
+
+  template <typename Node>
+  bool visit(Node& node) {
+    if constexpr (std::is_base_of_v<Expression, Node>) {
+      return false;
+    } else {
+      roots(node);
+      return true;
+    }
+  }
+
+ private:
+  enum class State : std::uint8_t { Unfolded, Folding, Folded };
+
+  struct Constant {
+    ConstDef* def;
+    State state = State::Unfolded;
+  };
+
+  /* ------------------------ Top-level expressions ------------------------ */
+
+  void roots(ASTNode&) {}
+  void roots(VarDef& def) { fold(def.value); }
+  void roots(ConstDef& def) {
+    if (auto constant = globalConstant(def.storage)) {
+      foldConstant(*constant);
+    } else {
+      fold(def.value);
+    }
+  }
+  void roots(ExpressionStmt& stmt) { fold(stmt.expr); }
+  void roots(AssignmentStmt& stmt) { fold(stmt.rhs); }
+  void roots(StdoutInsertionStmt& stmt) {
+    for (auto& expr : stmt.expressions) fold(expr);
+  }
+  void roots(VariantMatchStmt& stmt) { fold(stmt.expr); }
+  void roots(IfStmt& stmt) { fold(stmt.condition); }
+  void roots(Elif& elif) { fold(elif.condition); }
+  void roots(Range& range) {
+    fold(range.start);
+    fold(range.end);
+  }
+  void roots(WhileStmt& stmt) { fold(stmt.condition); }
+  void roots(ReturnStmt& stmt) { fold(stmt.expr); }
+
+  /* -------------------------------- Folding ------------------------------ */
+
+  void fold(std::unique_ptr<Expression>& slot) {
+    if (slot == nullptr) return;
+
+    if (auto binary = dyn_cast<BinaryExpression>(slot.get())) {
+      fold(binary->lhs);
+      auto lhs = literalValue(*binary->lhs);
+      if (isShortCircuit(*binary)) {
+        if (decides(*binary, lhs)) {
+          slot = std::move(binary->lhs);
+          m_stats.foldedExpressions++;
+          return;
+        }
+        foldShortCircuited(binary->rhs, lhs.has_value());
+      } else {
+        fold(binary->rhs);
+      }
+      auto rhs = literalValue(*binary->rhs);
+      if (lhs && rhs && binary->op) replace(slot, foldBinary(*binary->op, *lhs, *rhs));
+    } else if (auto unary = dyn_cast<UnaryExpression>(slot.get())) {
+      fold(unary->expr);
+      auto operand = literalValue(*unary->expr);
+      if (operand && unary->op) replace(slot, foldUnary(*unary->op, *operand));
+    } else if (auto castExpr = dyn_cast<CastExpr>(slot.get())) {
+      fold(castExpr->expr);
+      if (auto operand = literalValue(*castExpr->expr)) {
+        replace(slot, foldCast(castExpr->type, *operand));
+      }
+    } else if (auto paren = dyn_cast<ParenExpr>(slot.get())) {
+      fold(paren->expr);
+      if (literalValue(*paren->expr)) {
+        slot = std::move(paren->expr);
+        m_stats.foldedExpressions++;
+      }
+    } else if (auto identifier = dyn_cast<IdentifierExpr>(slot.get())) {
+      if (auto value = constantValue(identifier->storage)) {
+        slot = makeLiteral(*value, identifier->position);
+        m_stats.propagatedConstants++;
+      }
+    } else if (auto functional = dyn_cast<FunctionalExpression>(slot.get())) {
+      fold(functional->expr);
+      if (auto call = dyn_cast<FnCallPostfix>(functional->postfix.get())) {
+        for (auto& arg : call->args) fold(arg);
+      }
+    } else if (auto object = dyn_cast<Object>(slot.get())) {
+      for (auto& [name, member] : object->members) fold(member.value);
+    }
+  }
+
+  static bool isShortCircuit(const BinaryExpression& expr) {
+    return expr.op == Operator::And || expr.op == Operator::Or;
+  }
+
+  // Whether the left operand of `and` or `or` is the result, the right one is then never evaluated
+  static bool decides(const BinaryExpression& expr, const std::optional<ConstantValue>& lhs) {
+    auto value = lhs.has_value() ? std::get_if<bool>(&*lhs) : nullptr;
+    return value != nullptr && *value == (expr.op == Operator::Or);
+  }
+
+  // The right operand of `and` and `or` may not be evaluated unless the left one is a literal,
+  // errors in it are only reported then
+  void foldShortCircuited(std::unique_ptr<Expression>& slot, bool evaluated) {
+    auto reportErrors = std::exchange(m_reportErrors, m_reportErrors && evaluated);
+    fold(slot);
+    m_reportErrors = reportErrors;
+  }
+
+  // Operators raising an error are left unfolded, whether or not it is reported
+  void replace(std::unique_ptr<Expression>& slot, FoldResult&& result) {
+    if (result.error.has_value()) {
+      if (m_reportErrors) m_errorHandler(*result.error, slot->position);
+    } else if (result.value.has_value()) {
+      slot = makeLiteral(*result.value, slot->position);
+      m_stats.foldedExpressions++;
+    }
+  }
+
+  /* ------------------------------- Constants ----------------------------- */
+
+  Constant* globalConstant(const Storage& storage) {
+    if (storage.kind != Storage::Kind::Global) return nullptr;
+    auto it = m_constants.find(storage.slot);
+    return it != m_constants.end() ? &it->second : nullptr;
+  }
+
+  // Consts are folded on their first use, so they may refer to consts defined after them
+  void foldConstant(Constant& constant) {
+    if (constant.state != State::Unfolded) return;
+    constant.state = State::Folding;
+    fold(constant.def->value);
+    constant.state = State::Folded;
+  }
+
+  // Only literals of the declared type are propagated, e.g. not an int into a variant const
+  std::optional<ConstantValue> constantValue(const Storage& storage) {
+    auto constant = globalConstant(storage);
+    if (constant == nullptr) return std::nullopt;
+    foldConstant(*constant);
+    if (constant->state != State::Folded) return std::nullopt;
+
+    auto value = literalValue(*constant->def->value);
+    auto declared = m_program.types.primitive(constant->def->type);
+    if (!value.has_value() || !declared.has_value() ||
+        *declared != TypeTable::primitive(static_cast<PrimitiveType>(value->index()))) {
+      return std::nullopt;
+    }
+    return value;
+  }
+
+  Program& m_program;
+  ErrorHandler& m_errorHandler;
+
+  std::unordered_map<std::uint32_t, Constant> m_constants;  // By global slot
+  FoldingStats m_stats;
+  bool m_reportErrors = true;
+};
+
+}  // namespace
+
+FoldResult foldBinary(Operator op, const ConstantValue& lhs, const ConstantValue& rhs) {
+  if (lhs.index() != rhs.index()) return {};
+
+  return std::visit(
+      [&](const auto& left) -> FoldResult {
+        using T = std::decay_t<decltype(left)>;
+        const auto& right = std::get<T>(rhs);
+        if constexpr (std::is_same_v<T, int>) {
+          return foldInts(op, left, right);
+        } else if constexpr (std::is_same_v<T, float>) {
+          return foldFloats(op, left, right);
+        } else if constexpr (std::is_same_v<T, bool>) {
+          return foldBools(op, left, right);
+        } else if constexpr (std::is_same_v<T, wchar_t>) {
+          return comparison(op, left, right);
+        } else {
+          return foldStrings(op, left, right);
+        }
+      },
+      lhs);
+}
+
+FoldResult foldUnary(Operator op, const ConstantValue& operand) {
+  if (op == Operator::Not) {
+    if (auto value = std::get_if<bool>(&operand)) return {!*value};
+  } else if (op == Operator::Sub) {
+    if (auto value = std::get_if<int>(&operand)) {
+      if (*value == INT_MIN) return {{}, ErrorType::INTEGER_OVERFLOW};
+      return {-*value};
+    }
+    if (auto value = std::get_if<float>(&operand)) return {-*value};
+  }
+  return {};
+}
+
+/**
+ * @brief Folds the casts accepted by the TypeChecker, except those of floats and bools to strings
+ * whose formatting is up to the interpreter.
+ */
+FoldResult foldCast(PrimitiveType type, const ConstantValue& operand) {
+  if (static_cast<std::size_t>(type) == operand.index()) return {operand};
+
+  if (auto value = std::get_if<int>(&operand)) {
+    switch (type) {
+      case PrimitiveType::Float:
+        return {static_cast<float>(*value)};
+      case PrimitiveType::Bool:
+        return {*value != 0};
+      case PrimitiveType::Char:
+        return {static_cast<wchar_t>(*value)};
+      case PrimitiveType::String:
+        return {std::to_wstring(*value)};
+      default:
+        return {};
+    }
+  }
+  if (auto value = std::get_if<float>(&operand); value && type == PrimitiveType::Int) {
+    if (!(*value >= static_cast<float>(INT_MIN) && *value < -static_cast<float>(INT_MIN))) {
+      return {{}, ErrorType::INTEGER_OVERFLOW};
+    }
+    return {static_cast<int>(*value)};
+  }
+  if (auto value = std::get_if<bool>(&operand); value && type == PrimitiveType::Int) {
+    return {static_cast<int>(*value)};
+  }
+  if (auto value = std::get_if<wchar_t>(&operand)) {
+    if (type == PrimitiveType::Int) return {static_cast<int>(*value)};
+    if (type == PrimitiveType::String) return {std::wstring(1, *value)};
+  }
+  return {};
+}
+
+std::optional<ConstantValue> literalValue(const Expression& expr) {
+  switch (expr.kind) {
+    case NodeKind::IntLiteral:
+      return cast<Literal<int>>(expr).value;
+    case NodeKind::FloatLiteral:
+      return cast<Literal<float>>(expr).value;
+    case NodeKind::BoolLiteral:
+      return cast<Literal<bool>>(expr).value;
+    case NodeKind::CharLiteral:
+      return cast<Literal<wchar_t>>(expr).value;
+    case NodeKind::StringLiteral:
+      return cast<Literal<std::wstring>>(expr).value;
+    default:
+      return std::nullopt;
+  }
+}
+
+std::unique_ptr<Expression> makeLiteral(const ConstantValue& value, Position position) {
+  auto literal = std::visit(
+      [&](auto copy) -> std::unique_ptr<Expression> {
+        return std::make_unique<Literal<decltype(copy)>>(std::move(position), std::move(copy));
+      },
+      value);
+  literal->typeId = TypeTable::primitive(static_cast<PrimitiveType>(value.index()));
+  return literal;
+}
+
+FoldingStats foldConstants(Program& program, ErrorHandler& errorHandler) {
+  return ConstantFolder{program, errorHandler}.run();
+}
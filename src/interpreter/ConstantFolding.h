@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <variant>
+
+#include "ErrorHandler.h"
+#include "Expression.h"
+#include "Program.h"
+
+/**
+ * @brief Value of a primitive literal, in the order of PrimitiveType.
+ */
+using ConstantValue = std::variant<int, float, bool, wchar_t, std::wstring>;
+
+/**
+ * @brief Outcome of evaluating an operation on constants: its value, the error it raises, or
+ * neither if it is not defined for the operands (left to the TypeChecker to report).
+ */
+struct FoldResult {
+  std::optional<ConstantValue> value = std::nullopt;
+  std::optional<ErrorType> error = std::nullopt;
+};
+
+FoldResult foldBinary(Operator op, const ConstantValue& lhs, const ConstantValue& rhs);
+FoldResult foldUnary(Operator op, const ConstantValue& operand);
+FoldResult foldCast(PrimitiveType type, const ConstantValue& operand);
+
+// Value of the expression if it is a literal
+std::optional<ConstantValue> literalValue(const Expression& expr);
+std::unique_ptr<Expression> makeLiteral(const ConstantValue& value, Position position);
+
+struct FoldingStats {
+  std::size_t foldedExpressions = 0;    // Operators, casts and parentheses replaced by literals
+  std::size_t propagatedConstants = 0;  // Uses of const globals replaced by their value
+};
+
+/**
+ * @brief Replaces every operator, cast and parenthesized expression whose operands are literals
+ * with the literal it evaluates to, bottom-up, so whole constant subtrees collapse into one node.
+ * Uses of const globals of a primitive type whose value folds to a literal are replaced by that
+ * literal, so they fold further at the use site.
+ *
+ * Evaluation errors (division by zero, int overflow) are reported at the operator and leave it
+ * unfolded. Assignment and stdin targets are left alone.
+ *
+ * Const uses are recognized by their Storage, so the pass belongs after the ScopeChecker and
+ * before the expressions are deduplicated, as it does not look into shared subtrees.
+ */
+FoldingStats foldConstants(Program& program, ErrorHandler& errorHandler);
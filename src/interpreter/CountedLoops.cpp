@@ -0,0 +1,79 @@
+#include <optional>
+#include <unordered_map>
+
+#include "Casting.h"
+#include "ConstantFolding.h"
+#include "CountedLoops.h"
+#include "RecursiveASTVisitor.h"
+
+namespace {
+
+class CountedLoops : public RecursiveASTVisitor<CountedLoops> {
+ public:
+  explicit CountedLoops(Program& program) {
+    for (auto& [name, definition] : program.definitions) {
+      auto constDef = dyn_cast<ConstDef>(definition.get());
+      if (constDef != nullptr && constDef->storage.kind == Storage::Kind::Global) {
+        m_consts.emplace(constDef->storage.slot, constDef);
+      }
+    }
+  }
+
+  CountedLoopReport report;
+
+  void visit(ForStmt& stmt) {
+    report.loops++;
+    auto first = bound(*stmt.range.start);
+    auto last = bound(*stmt.range.end);
+    if (!first.has_value() || !last.has_value()) return;
+
+    report.resolved++;
+    if (*first == *last) {
+      stmt.direction = RangeDirection::Empty;
+    } else {
+      stmt.direction = *first < *last ? RangeDirection::Ascending : RangeDirection::Descending;
+    }
+  }
+
+ private:
+  std::optional<int> bound(const Expression& expr) const {
+    if (auto paren = dyn_cast<ParenExpr>(&expr)) return bound(*paren->expr);
+    if (auto shared = dyn_cast<SharedExpr>(&expr)) return bound(*shared->expr);
+
+    if (auto unary = dyn_cast<UnaryExpression>(&expr)) {
+      auto operand = bound(*unary->expr);
+      if (!operand.has_value() || unary->op != Operator::Sub) return std::nullopt;
+      auto result = foldUnary(Operator::Sub, *operand);
+      if (!result.value.has_value()) return std::nullopt;  // Overflow, left to the runtime
+      return std::get<int>(*result.value);
+    }
+
+    // Consts are not followed further, their initializers may refer to each other
+    const auto* value = &expr;
+    if (auto identifier = dyn_cast<IdentifierExpr>(&expr)) {
+      if (identifier->storage.kind != Storage::Kind::Global) return std::nullopt;
+      auto it = m_consts.find(identifier->storage.slot);
+      if (it == m_consts.end()) return std::nullopt;
+      value = it->second->value.get();
+    }
+    auto literal = literalValue(*value);
+    if (!literal.has_value() || !std::holds_alternative<int>(*literal)) return std::nullopt;
+    return std::get<int>(*literal);
+  }
+
+  std::unordered_map<std::uint32_t, const ConstDef*> m_consts;  // By global slot
+};
+
+}  // namespace
+
+CountedLoopReport specializeCountedLoops(Program& program) {
+  CountedLoops loops{program};
+  loops.traverse(program);
+  return loops.report;
+}
+
+void printCountedLoopReport(std::ostream& out, const CountedLoopReport& report) {
+  out << "Counted loops\n";
+  out << "  " << report.resolved << " of " << report.loops
+      << " range loops with the direction resolved\n";
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+
+#include "Program.h"
+
+struct CountedLoopReport {
+  std::size_t loops = 0;     // Range loops in the program
+  std::size_t resolved = 0;  // Of them, with the direction known before they run
+};
+
+/**
+ * @brief Resolves the direction of the range loops whose bounds are int constants: literals,
+ * negated literals and consts initialized with those (ForStmt::direction). Loops with equal
+ * bounds are marked as empty. The Evaluator runs a resolved loop without comparing its bounds
+ * and skips an empty one altogether, the bounds of the others are compared once per loop.
+ *
+ * The program must be type-checked and its names resolved. Consts initialized by expressions are
+ * recognized only once evaluateAtCompileTime() replaced those by their value.
+ */
+CountedLoopReport specializeCountedLoops(Program& program);
+
+void printCountedLoopReport(std::ostream& out, const CountedLoopReport& report);
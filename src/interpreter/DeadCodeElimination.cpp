@@ -0,0 +1,199 @@
+#include <algorithm>
+#include <numeric>
+#include <string>
+#include <unordered_set>
+
+#include "ASTUtils.h"
+#include "Casting.h"
+#include "DeadCodeElimination.h"
+#include "Encoding.h"
+#include "RecursiveASTVisitor.h"
+
+namespace {
+
+bool leavesBlock(const Statement& stmt);
+
+bool leavesBlock(const BlockStmt& block) {
+  return std::any_of(block.statements.begin(), block.statements.end(),
+                     [](const auto& stmt) { return leavesBlock(*stmt); });
+}
+
+// Whether control never reaches the statement following this one
+bool leavesBlock(const Statement& stmt) {
+  if (isa<ReturnStmt>(stmt) || isa<BreakStmt>(stmt) || isa<ContinueStmt>(stmt)) return true;
+  if (auto block = dyn_cast<BlockStmt>(&stmt)) return leavesBlock(*block);
+  if (auto ifStmt = dyn_cast<IfStmt>(&stmt)) {
+    if (ifStmt->elseClause == nullptr) return false;
+    return leavesBlock(ifStmt->block) && leavesBlock(ifStmt->elseClause->block) &&
+           std::all_of(ifStmt->elifs.begin(), ifStmt->elifs.end(),
+                       [](const Elif& elif) { return leavesBlock(elif.block); });
+  }
+  return false;
+}
+
+class CallFinder : public RecursiveASTVisitor<CallFinder> {
+ public:
+  bool found = false;
+
+  void visit(FnCallPostfix&) { found = true; }
+};
+
+bool containsCall(Expression& expr) {
+  CallFinder finder;
+  finder.traverseNode(expr);
+  return finder.found;
+}
+
+/**
+ * @brief Marks the definitions reachable from the roots, a worklist of definitions whose uses of
+ * globals and types are not looked at yet. Function bodies are pruned before they are looked at,
+ * so uses in unreachable statements keep nothing alive.
+ */
+class ReachabilityMarker : public RecursiveASTVisitor<ReachabilityMarker> {
+ public:
+  ReachabilityMarker(Program& program, DeadCodeReport& report)
+      : m_program{program}, m_globals(program.globalCount, nullptr), m_report{report} {
+    for (auto& [name, definition] : program.definitions) {
+      if (definition->storage.kind == Storage::Kind::Global &&
+          definition->storage.slot < m_globals.size()) {
+        m_globals[definition->storage.slot] = definition.get();
+      }
+    }
+  }
+
+  void run() {
+    for (auto& [name, definition] : m_program.definitions) {
+      if (name == L"main") mark(definition.get());
+      if (auto varDef = dyn_cast<VarDef>(definition.get());
+          varDef && containsCall(*varDef->value)) {
+        mark(varDef);
+      }
+      if (auto constDef = dyn_cast<ConstDef>(definition.get());
+          constDef && containsCall(*constDef->value)) {
+        mark(constDef);
+      }
+    }
+
+    while (!m_worklist.empty()) {
+      auto* definition = m_worklist.back();
+      m_worklist.pop_back();
+      traverseNode(*definition);
+    }
+  }
+
+  bool isReachable(const Definition* definition) const { return m_reachable.contains(definition); }
+
+  /* ------------------------------ Uses of types ----------------------------- */
+
+  void visit(VarDef& def) { markType(def.type); }
+  void visit(ConstDef& def) { markType(def.type); }
+  void visit(StructMember& member) { markType(member.type); }
+  void visit(VariantDef& def) {
+    for (auto& type : def.types) markType(type);
+  }
+  void visit(FnDef& def) { markType(def.returnType); }
+  void visit(FnParam& param) { markType(param.type); }
+  void visit(VariantMatchCase& matchCase) { markType(matchCase.variant); }
+  void visit(VariantAccessPostfix& postfix) { markType(postfix.variant); }
+
+  /* ----------------------------- Uses of globals ---------------------------- */
+
+  void visit(IdentifierExpr& expr) {
+    if (expr.storage.kind == Storage::Kind::Global && expr.storage.slot < m_globals.size()) {
+      if (auto* definition = m_globals[expr.storage.slot]) mark(definition);
+    }
+  }
+
+  /* ----------------------------- Unreachable code --------------------------- */
+
+  // Nested blocks are pruned when the traversal gets to them
+  void visit(BlockStmt& block) {
+    auto& statements = block.statements;
+    auto last = std::find_if(statements.begin(), statements.end(),
+                             [](const auto& stmt) { return leavesBlock(*stmt); });
+    if (last == statements.end() || last + 1 == statements.end()) return;
+
+    auto first = last + 1;
+    m_report.statements.push_back(
+        PrunedStatements{(*first)->position, static_cast<std::size_t>(statements.end() - first)});
+    statements.erase(first, statements.end());
+  }
+
+ private:
+  void mark(Definition* definition) {
+    if (m_reachable.insert(definition).second) m_worklist.push_back(definition);
+  }
+
+  void markType(const TypeIdentifier& type) {
+    auto it = m_program.definitions.find(type);
+    if (it == m_program.definitions.end()) return;
+    if (isa<StructDef>(*it->second) || isa<VariantDef>(*it->second)) mark(it->second.get());
+  }
+
+  Program& m_program;
+  std::vector<Definition*> m_globals;  // By global slot
+
+  std::unordered_set<const Definition*> m_reachable;
+  std::vector<Definition*> m_worklist;
+
+  DeadCodeReport& m_report;
+};
+
+const char* keyword(NodeKind kind) {
+  switch (kind) {
+    case NodeKind::VarDef:
+      return "var";
+    case NodeKind::ConstDef:
+      return "const";
+    case NodeKind::StructDef:
+      return "struct";
+    case NodeKind::VariantDef:
+      return "variant";
+    case NodeKind::FnDef:
+      return "fn";
+    default:
+      return "definition";
+  }
+}
+
+}  // namespace
+
+std::size_t DeadCodeReport::prunedStatements() const {
+  return std::accumulate(statements.begin(), statements.end(), std::size_t{0},
+                         [](std::size_t sum, const auto& pruned) { return sum + pruned.count; });
+}
+
+DeadCodeReport eliminateDeadCode(Program& program) {
+  DeadCodeReport report;
+  ReachabilityMarker marker{program, report};
+  marker.run();
+
+  std::erase_if(program.definitions, [&](const auto& entry) {
+    auto& [name, definition] = entry;
+    if (marker.isReachable(definition.get())) return false;
+    report.definitions.push_back(
+        RemovedDefinition{definition->kind, definition->name, definition->position});
+    return true;
+  });
+
+  std::sort(report.definitions.begin(), report.definitions.end(),
+            [](const auto& lhs, const auto& rhs) { return precedes(lhs.position, rhs.position); });
+  std::sort(report.statements.begin(), report.statements.end(),
+            [](const auto& lhs, const auto& rhs) { return precedes(lhs.position, rhs.position); });
+  return report;
+}
+
+void printDeadCodeReport(std::ostream& out, const DeadCodeReport& report) {
+  out << "Dead code\n";
+  for (const auto& definition : report.definitions) {
+    out << "  removed " << keyword(definition.kind) << " " << sourceText(definition.name)
+        << " (line " << definition.position.line << " col " << definition.position.column << ")\n";
+  }
+  for (const auto& pruned : report.statements) {
+    out << "  pruned " << pruned.count << " unreachable statement"
+        << (pruned.count == 1 ? "" : "s") << " (line " << pruned.position.line << " col "
+        << pruned.position.column << ")\n";
+  }
+  out << "  total: " << report.definitions.size() << " definitions, "
+      << report.prunedStatements() << " statements\n";
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+#include "Program.h"
+
+struct RemovedDefinition {
+  NodeKind kind;
+  Identifier name;
+  Position position;
+};
+
+// Statements after a return, break or continue at the end of a block
+struct PrunedStatements {
+  Position position;  // Of the first one
+  std::size_t count = 0;
+};
+
+struct DeadCodeReport {
+  std::vector<RemovedDefinition> definitions;  // In the order of the source
+  std::vector<PrunedStatements> statements;
+
+  std::size_t prunedStatements() const;
+};
+
+/**
+ * @brief Removes the global definitions the program can not reach and the statements that can
+ * never run.
+ *
+ * A definition is reachable from `main` through the call graph and the uses of globals and types:
+ * the identifiers of a reachable function or initializer, the types of its definitions and
+ * parameters and the types the reachable structs and variants consist of. Globals whose initializer
+ * calls a function are kept as well, as the call runs on startup whether the global is used or not.
+ *
+ * Within the bodies of the reachable functions, the statements following one that always leaves
+ * the block (return, break, continue, or an if whose branches all do) are dropped.
+ *
+ * Global uses are recognized by their Storage, so the pass belongs after the ScopeChecker. It also
+ * runs after the TypeChecker, which reports the errors of unreachable code as well, and before
+ * the later stages, which then have less to look at.
+ */
+DeadCodeReport eliminateDeadCode(Program& program);
+
+void printDeadCodeReport(std::ostream& out, const DeadCodeReport& report);
@@ -0,0 +1,580 @@
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+#include "ASTDispatch.h"
+#include "ASTUtils.h"
+#include "ConstantFolding.h"
+#include "Evaluator.h"
+
+namespace {
+
+std::optional<ConstantValue> constantOf(const Value& value) {
+  return std::visit(
+      [](const auto& data) -> std::optional<ConstantValue> {
+        using T = std::decay_t<decltype(data)>;
+        if constexpr (std::is_constructible_v<ConstantValue, const T&> &&
+                      !std::is_same_v<T, std::monostate>) {
+          return ConstantValue{data};
+        } else {
+          return std::nullopt;
+        }
+      },
+      value.data);
+}
+
+// Key of a memoized call, if all of its arguments are primitive
+std::optional<std::vector<ConstantValue>> memoKey(const std::vector<Value>& args) {
+  std::vector<ConstantValue> key;
+  key.reserve(args.size());
+  for (const auto& arg : args) {
+    const auto* value = &arg;
+    if (auto reference = std::get_if<ConstReference>(&arg.data)) value = reference->value;
+    auto constant = constantOf(*value);
+    if (!constant.has_value()) return std::nullopt;
+    key.push_back(std::move(*constant));
+  }
+  return key;
+}
+
+/**
+ * @brief The expression a chain of member accesses starts from, and the offset of the accessed
+ * member among its fields: nested structs are stored inline, so the offsets add up.
+ */
+std::pair<const Expression*, std::uint32_t> memberChain(const FunctionalExpression& expr) {
+  const Expression* base = &expr;
+  std::uint32_t offset = 0;
+  while (true) {
+    if (auto paren = dyn_cast<ParenExpr>(base)) {
+      base = paren->expr.get();
+    } else if (auto shared = dyn_cast<SharedExpr>(base)) {
+      base = shared->expr;
+    } else if (auto functional = dyn_cast<FunctionalExpression>(base);
+               functional != nullptr && isa<MemberAccessPostfix>(functional->postfix.get())) {
+      offset += cast<MemberAccessPostfix>(*functional->postfix).offset;
+      base = functional->expr.get();
+    } else {
+      return {base, offset};
+    }
+  }
+}
+
+Value valueOf(ConstantValue&& constant) {
+  return std::visit([](auto&& data) { return Value{std::move(data)}; }, std::move(constant));
+}
+
+}  // namespace
+
+Evaluator::Evaluator(const Program& program, EvaluationLimits limits)
+    : m_types{program.types}, m_limits{limits}, m_globals(program.globalCount, nullptr) {
+  for (const auto& [name, definition] : program.definitions) {
+    const auto& storage = definition->storage;
+    if (storage.kind == Storage::Kind::Global && storage.slot < m_globals.size()) {
+      m_globals[storage.slot] = definition.get();
+    }
+  }
+  if (limits.memoEntries > 0) m_memo.emplace(limits.memoEntries);
+}
+
+std::optional<Value> Evaluator::evaluate(const Expression& expr) {
+  m_steps = 0;
+  m_callDepth = 0;
+  try {
+    return evaluate(expr, nullptr);
+  } catch (const Aborted& aborted) {
+    if (aborted.limitReached) m_exhaustedLimits++;
+    return std::nullopt;
+  }
+}
+
+void Evaluator::step() {
+  if (++m_steps > m_limits.steps) abort(true);
+}
+
+/* ------------------------------- Expressions ------------------------------ */
+
+Value Evaluator::evaluate(const Expression& expr, Frame* frame) {
+  step();
+  return dispatch(expr, [&](const auto& node) { return evaluateNode(node, frame); });
+}
+
+Value Evaluator::evaluateNode(const BinaryExpression& expr, Frame* frame) {
+  if (!expr.op.has_value()) abort();
+
+  // Only the taken operand is evaluated, it may be the one that can not be
+  if (*expr.op == Operator::And || *expr.op == Operator::Or) {
+    bool lhs = condition(*expr.lhs, frame);
+    if (lhs == (*expr.op == Operator::Or)) return lhs;
+    return condition(*expr.rhs, frame);
+  }
+
+  auto lhs = constantOf(evaluate(*expr.lhs, frame));
+  auto rhs = constantOf(evaluate(*expr.rhs, frame));
+  if (!lhs.has_value() || !rhs.has_value()) abort();
+
+  auto result = foldBinary(*expr.op, *lhs, *rhs);
+  if (!result.value.has_value()) abort();
+  return valueOf(std::move(*result.value));
+}
+
+Value Evaluator::evaluateNode(const UnaryExpression& expr, Frame* frame) {
+  auto operand = constantOf(evaluate(*expr.expr, frame));
+  if (!operand.has_value() || !expr.op.has_value()) abort();
+
+  auto result = foldUnary(*expr.op, *operand);
+  if (!result.value.has_value()) abort();
+  return valueOf(std::move(*result.value));
+}
+
+// A member of a local is copied on its own, not together with the rest of the struct
+Value Evaluator::evaluateNode(const FunctionalExpression& expr, Frame* frame) {
+  if (isa<MemberAccessPostfix>(expr.postfix.get())) {
+    auto [base, offset] = memberChain(expr);
+    if (const auto* value = place(*base, frame)) return member(*value, *base, offset, expr.typeId);
+    return member(evaluate(*base, frame), *base, offset, expr.typeId);
+  }
+
+  auto operand = evaluate(*expr.expr, frame);
+
+  if (auto call = dyn_cast<FnCallPostfix>(expr.postfix.get())) {
+    auto function = std::get_if<FunctionValue>(&operand.data);
+    if (function == nullptr) abort();
+
+    const auto& params = parameters(*function->def);
+    std::vector<Value> args;
+    for (std::size_t i = 0; i < call->args.size(); i++) {
+      const auto& arg = *call->args[i];
+      const auto* argument = i < params.size() ? constArgument(*params[i], arg, frame) : nullptr;
+      args.push_back(argument != nullptr ? ConstReference{argument} : evaluate(arg, frame));
+    }
+    return this->call(*function, std::move(args));
+  }
+
+  auto& access = cast<VariantAccessPostfix>(*expr.postfix);
+  auto variantValue = std::get_if<VariantValue>(&operand.data);
+  if (variantValue == nullptr || variantValue->tag != access.tag) abort();
+  return variantValue->release();
+}
+
+Value Evaluator::evaluateNode(const IdentifierExpr& expr, Frame* frame) {
+  if (expr.storage.kind == Storage::Kind::Global) return global(expr.storage.slot);
+
+  auto& value = local(expr.storage, frame);
+  if (std::holds_alternative<std::monostate>(value.data)) abort();
+  if (auto reference = std::get_if<ConstReference>(&value.data)) return *reference->value;
+  if (!expr.isLastUse) return value;
+
+  // Nothing reads the local before it is written again
+  m_movedValues++;
+  return std::exchange(value, Value{});
+}
+
+template <typename T>
+Value Evaluator::evaluateNode(const Literal<T>& expr, Frame*) {
+  return expr.value;
+}
+
+// Fields follow the layout of the struct type the object was converted to
+Value Evaluator::evaluateNode(const Object& expr, Frame* frame) {
+  const auto& type = m_types[expr.typeId];
+  if (type.kind != TypeKind::Struct || type.members.size() != expr.members.size()) abort();
+
+  StructValue result{expr.typeId, {}};
+  result.fields.reserve(type.width);
+  for (const auto& member : type.members) {
+    auto it = expr.members.find(member.name);
+    if (it == expr.members.end()) abort();
+    auto value = convert(evaluate(*it->second.value, frame), member.type);
+    if (m_types[member.type].kind != TypeKind::Struct) {
+      result.fields.push_back(std::move(value));
+      continue;
+    }
+
+    auto nested = std::get_if<StructValue>(&value.data);
+    if (nested == nullptr || nested->type != member.type) abort();
+    std::move(nested->fields.begin(), nested->fields.end(), std::back_inserter(result.fields));
+  }
+  return result;
+}
+
+Value Evaluator::evaluateNode(const ParenExpr& expr, Frame* frame) {
+  return evaluate(*expr.expr, frame);
+}
+
+Value Evaluator::evaluateNode(const CastExpr& expr, Frame* frame) {
+  auto operand = constantOf(evaluate(*expr.expr, frame));
+  if (!operand.has_value()) abort();
+
+  auto result = foldCast(expr.type, *operand);
+  if (!result.value.has_value()) abort();
+  return valueOf(std::move(*result.value));
+}
+
+Value Evaluator::evaluateNode(const SharedExpr& expr, Frame* frame) {
+  return evaluate(*expr.expr, frame);
+}
+
+// Like call(), but the body runs in the frame it was inlined into
+Value Evaluator::evaluateNode(const InlinedCall& expr, Frame* frame) {
+  if (frame == nullptr) abort();
+
+  std::vector<Value> args;
+  for (const auto& arg : expr.args) args.push_back(evaluate(*arg, frame));
+  for (std::size_t i = 0; i < expr.parameters.size(); i++) {
+    const auto& parameter = expr.parameters[i];
+    local(parameter.storage, frame) = convert(std::move(args[i]), parameter.typeId);
+  }
+
+  if (execute(expr.body, frame) != Flow::Return) abort();
+  return convert(std::move(m_returnValue), expr.typeId);
+}
+
+template <typename Node>
+Value Evaluator::evaluateNode(const Node&, Frame*) {
+  throw std::logic_error("Expected an expression!");
+}
+
+Value Evaluator::call(const FunctionValue& function, std::vector<Value>&& args) {
+  const auto& def = *function.def;
+  const auto& params = parameters(def);
+  if (args.size() != params.size()) abort();
+  if (m_callDepth >= m_limits.callDepth) abort(true);
+
+  std::optional<std::vector<ConstantValue>> key;
+  if (m_memo.has_value() && def.isPure) key = memoKey(args);
+  if (key.has_value()) {
+    if (const auto* result = m_memo->find(def, *key)) return *result;
+  }
+
+  Frame frame{std::vector<Value>(def.localCount), function.enclosing};
+  for (std::size_t i = 0; i < params.size(); i++) {
+    frame.slots.at(params[i]->storage.slot) = convert(std::move(args[i]), params[i]->typeId);
+  }
+
+  m_callDepth++;
+  auto flow = execute(def.body, &frame);
+  m_callDepth--;
+  if (flow != Flow::Return) abort();
+
+  auto result = convert(std::move(m_returnValue), m_types[def.typeId].result);
+  if (key.has_value() && !std::holds_alternative<FunctionValue>(result.data)) {
+    m_memo->insert(def, std::move(*key), result);
+  }
+  return result;
+}
+
+/* ------------------------------- Statements ------------------------------- */
+
+Evaluator::Flow Evaluator::execute(const Statement& stmt, Frame* frame) {
+  step();
+  return dispatch(stmt, [&](const auto& node) { return executeNode(node, frame); });
+}
+
+Evaluator::Flow Evaluator::executeNode(const BlockStmt& stmt, Frame* frame) {
+  for (const auto& statement : stmt.statements) {
+    if (auto flow = execute(*statement, frame); flow != Flow::Normal) return flow;
+  }
+  return Flow::Normal;
+}
+
+Evaluator::Flow Evaluator::executeNode(const ExpressionStmt& stmt, Frame* frame) {
+  evaluate(*stmt.expr, frame);
+  return Flow::Normal;
+}
+
+// The value is evaluated first, it may not be assigned if the target can not be
+Evaluator::Flow Evaluator::executeNode(const AssignmentStmt& stmt, Frame* frame) {
+  auto value = convert(evaluate(*stmt.rhs, frame), stmt.lhs->typeId);
+  assign(*stmt.lhs, std::move(value), frame);
+  return Flow::Normal;
+}
+
+Evaluator::Flow Evaluator::executeNode(const VariantMatchStmt& stmt, Frame* frame) {
+  auto value = evaluate(*stmt.expr, frame);
+  auto variantValue = std::get_if<VariantValue>(&value.data);
+  if (variantValue == nullptr || variantValue->tag >= stmt.jumpTable.size()) abort();
+
+  // Missing cases are left to the runtime, only ill-typed matches have them
+  const auto* matchCase = stmt.jumpTable[variantValue->tag];
+  if (matchCase == nullptr) abort();
+  return execute(matchCase->block, frame);
+}
+
+Evaluator::Flow Evaluator::executeNode(const IfStmt& stmt, Frame* frame) {
+  if (stmt.switchTable != nullptr) {
+    auto branch = switchBranch(stmt, frame);
+    if (branch == 1) return execute(stmt.block, frame);
+    if (branch > 1) return execute(stmt.elifs.at(branch - 2).block, frame);
+    if (stmt.elseClause != nullptr) return execute(stmt.elseClause->block, frame);
+    return Flow::Normal;
+  }
+
+  if (condition(*stmt.condition, frame)) return execute(stmt.block, frame);
+  for (const auto& elif : stmt.elifs) {
+    if (condition(*elif.condition, frame)) return execute(elif.block, frame);
+  }
+  if (stmt.elseClause != nullptr) return execute(stmt.elseClause->block, frame);
+  return Flow::Normal;
+}
+
+// Descending when the range starts above its end, the end is excluded either way. The bounds are
+// evaluated and the direction resolved once, or not at all if specializeCountedLoops() did. The
+// counter is a plain int written into the slot of the loop variable, which stays an int
+Evaluator::Flow Evaluator::executeNode(const ForStmt& stmt, Frame* frame) {
+  if (stmt.direction == RangeDirection::Empty) return Flow::Normal;
+
+  auto start = evaluate(*stmt.range.start, frame);
+  auto end = evaluate(*stmt.range.end, frame);
+  auto first = std::get_if<int>(&start.data);
+  auto last = std::get_if<int>(&end.data);
+  if (first == nullptr || last == nullptr) abort();
+
+  int direction = *first <= *last ? 1 : -1;
+  if (stmt.direction != RangeDirection::Unresolved) {
+    direction = stmt.direction == RangeDirection::Ascending ? 1 : -1;
+  }
+
+  auto& variable = local(stmt.storage, frame);
+  variable = *first;
+  auto& counter = std::get<int>(variable.data);
+  for (int i = *first; i != *last; i += direction) {
+    counter = i;
+    auto flow = execute(stmt.block, frame);
+    if (flow == Flow::Break) break;
+    if (flow == Flow::Return) return flow;
+  }
+  return Flow::Normal;
+}
+
+Evaluator::Flow Evaluator::executeNode(const WhileStmt& stmt, Frame* frame) {
+  while (condition(*stmt.condition, frame)) {
+    auto flow = execute(stmt.block, frame);
+    if (flow == Flow::Break) break;
+    if (flow == Flow::Return) return flow;
+  }
+  return Flow::Normal;
+}
+
+Evaluator::Flow Evaluator::executeNode(const ContinueStmt&, Frame*) { return Flow::Continue; }
+
+Evaluator::Flow Evaluator::executeNode(const BreakStmt&, Frame*) { return Flow::Break; }
+
+Evaluator::Flow Evaluator::executeNode(const ReturnStmt& stmt, Frame* frame) {
+  m_returnValue = stmt.expr != nullptr ? evaluate(*stmt.expr, frame) : Value{};
+  return Flow::Return;
+}
+
+Evaluator::Flow Evaluator::executeNode(const VarDef& def, Frame* frame) {
+  auto value = convert(evaluate(*def.value, frame), def.typeId);
+  local(def.storage, frame) = std::move(value);
+  return Flow::Normal;
+}
+
+Evaluator::Flow Evaluator::executeNode(const ConstDef& def, Frame* frame) {
+  auto value = convert(evaluate(*def.value, frame), def.typeId);
+  local(def.storage, frame) = std::move(value);
+  return Flow::Normal;
+}
+
+Evaluator::Flow Evaluator::executeNode(const FnDef& def, Frame* frame) {
+  local(def.storage, frame) = FunctionValue{&def, frame};
+  frame->captured = true;
+  return Flow::Normal;
+}
+
+// Struct and variant definitions have no effect, stdin and stdout are never evaluated
+template <typename Node>
+Evaluator::Flow Evaluator::executeNode(const Node&, Frame*) {
+  if constexpr (std::is_same_v<Node, StructDef> || std::is_same_v<Node, VariantDef>) {
+    return Flow::Normal;
+  } else if constexpr (std::is_base_of_v<Statement, Node>) {
+    abort();
+  } else {
+    throw std::logic_error("Expected a statement!");
+  }
+}
+
+/* --------------------------------- Storage -------------------------------- */
+
+Value& Evaluator::local(const Storage& storage, Frame* frame) {
+  if (storage.kind != Storage::Kind::Local) abort();
+  for (auto depth = storage.depth; depth > 0 && frame != nullptr; depth--) {
+    frame = frame->enclosing;
+  }
+  if (frame == nullptr || storage.slot >= frame->slots.size()) abort();
+  return frame->slots[storage.slot];
+}
+
+// Only locals and their members are written, globals are state of the running program
+Value& Evaluator::reference(const Expression& expr, Frame* frame) {
+  if (auto identifier = dyn_cast<IdentifierExpr>(&expr)) return local(identifier->storage, frame);
+  if (auto shared = dyn_cast<SharedExpr>(&expr)) return reference(*shared->expr, frame);
+
+  auto functional = dyn_cast<FunctionalExpression>(&expr);
+  if (functional == nullptr || !isa<MemberAccessPostfix>(functional->postfix.get())) abort();
+
+  // The first of the fields of a nested struct
+  auto [base, offset] = memberChain(*functional);
+  auto structValue = std::get_if<StructValue>(&reference(*base, frame).data);
+  if (structValue == nullptr || structValue->type != base->typeId ||
+      offset >= structValue->fields.size() ||
+      offset + m_types.width(expr.typeId) > structValue->fields.size()) {
+    abort();
+  }
+  return structValue->fields[offset];
+}
+
+// A nested struct is stored inline, each of its fields is assigned
+void Evaluator::assign(const Expression& target, Value&& value, Frame* frame) {
+  auto& first = reference(target, frame);
+  if (m_types[target.typeId].kind != TypeKind::Struct || !isa<FunctionalExpression>(target)) {
+    first = std::move(value);
+    return;
+  }
+
+  auto structValue = std::get_if<StructValue>(&value.data);
+  if (structValue == nullptr || structValue->type != target.typeId) abort();
+  std::move(structValue->fields.begin(), structValue->fields.end(), &first);
+}
+
+/**
+ * @brief The value a local of the running frame, or a member of one, holds in place. Locals bound
+ * to a const argument resolve to the argument.
+ */
+const Value* Evaluator::place(const Expression& expr, Frame* frame) {
+  const Value* value = nullptr;
+  if (auto identifier = dyn_cast<IdentifierExpr>(&expr)) {
+    const auto& storage = identifier->storage;
+    if (frame == nullptr || storage.kind != Storage::Kind::Local || storage.depth != 0 ||
+        storage.slot >= frame->slots.size()) {
+      return nullptr;
+    }
+    value = &frame->slots[storage.slot];
+  } else if (auto paren = dyn_cast<ParenExpr>(&expr)) {
+    return place(*paren->expr, frame);
+  } else if (auto functional = dyn_cast<FunctionalExpression>(&expr)) {
+    // Nested structs have no value of their own to point to
+    if (!isa<MemberAccessPostfix>(functional->postfix.get()) ||
+        m_types[expr.typeId].kind == TypeKind::Struct) {
+      return nullptr;
+    }
+    auto [base, offset] = memberChain(*functional);
+    const auto* operand = place(*base, frame);
+    auto structValue = operand != nullptr ? std::get_if<StructValue>(&operand->data) : nullptr;
+    if (structValue == nullptr || structValue->type != base->typeId ||
+        offset >= structValue->fields.size()) {
+      return nullptr;
+    }
+    value = &structValue->fields[offset];
+  } else {
+    return nullptr;
+  }
+
+  if (auto reference = std::get_if<ConstReference>(&value->data)) value = reference->value;
+  return std::holds_alternative<std::monostate>(value->data) ? nullptr : value;
+}
+
+/**
+ * @brief The caller's value a const parameter is bound to instead of a copy of it, if the argument
+ * is a local (or a member of one) of a type worth not copying. Nothing but functions defined in
+ * the caller's frame could write the local while the call runs, it is copied if there are any.
+ */
+const Value* Evaluator::constArgument(const FnParam& param, const Expression& arg, Frame* frame) {
+  if (!param.isConst || frame == nullptr || frame->captured) return nullptr;
+  auto kind = m_types[param.typeId].kind;
+  if (kind != TypeKind::String && kind != TypeKind::Struct && kind != TypeKind::Variant) {
+    return nullptr;
+  }
+
+  const auto* value = place(arg, frame);
+  if (value == nullptr || typeOf(*value) != param.typeId) return nullptr;
+  m_referencedArguments++;
+  return value;
+}
+
+Value Evaluator::global(std::uint32_t slot) {
+  const auto* definition = slot < m_globals.size() ? m_globals[slot] : nullptr;
+  if (auto fnDef = dyn_cast_or_null<FnDef>(definition)) return FunctionValue{fnDef, nullptr};
+
+  auto constDef = dyn_cast_or_null<ConstDef>(definition);
+  if (constDef == nullptr) abort();
+
+  auto& constant = m_constants[slot];
+  if (constant.state == State::Unevaluated) {
+    constant.state = State::Evaluating;
+    try {
+      constant.value = convert(evaluate(*constDef->value, nullptr), constDef->typeId);
+      constant.state = State::Evaluated;
+    } catch (const Aborted& aborted) {
+      // Reaching the limits says nothing about the const itself
+      constant.state = aborted.limitReached ? State::Unevaluated : State::Failed;
+      throw;
+    }
+  }
+  if (constant.state != State::Evaluated) abort();
+  return constant.value;
+}
+
+/**
+ * @brief The member of the type at the offset in the struct value `base` evaluated to.
+ */
+Value Evaluator::member(const Value& value, const Expression& base, std::uint32_t offset,
+                        TypeId type) const {
+  auto structValue = std::get_if<StructValue>(&value.data);
+  if (structValue == nullptr || structValue->type != base.typeId ||
+      offset + m_types.width(type) > structValue->fields.size()) {
+    abort();
+  }
+  return memberValue(*structValue, offset, type, m_types);
+}
+
+/**
+ * @brief Applies the implicit conversion of a value into a variant holding its type.
+ */
+Value Evaluator::convert(Value&& value, TypeId type) const {
+  if (type == ERROR_TYPE || m_types[type].kind != TypeKind::Variant) return std::move(value);
+
+  auto alternative = typeOf(value);
+  if (alternative == type) return std::move(value);
+  auto tag = m_types.tag(type, alternative);
+  if (!tag.has_value()) abort();
+  return VariantValue{type, *tag, std::move(value)};
+}
+
+// The compared expression is evaluated once, see lowerSwitches()
+std::uint32_t Evaluator::switchBranch(const IfStmt& stmt, Frame* frame) {
+  auto subject = evaluate(*cast<BinaryExpression>(*stmt.condition).lhs, frame);
+  int constant;
+  if (auto integer = std::get_if<int>(&subject.data)) {
+    constant = *integer;
+  } else if (auto character = std::get_if<wchar_t>(&subject.data)) {
+    constant = static_cast<int>(*character);
+  } else {
+    abort();
+  }
+
+  const auto& table = *stmt.switchTable;
+  if (!table.dense.empty()) {
+    auto index = static_cast<long long>(constant) - table.min;
+    if (index < 0 || index >= static_cast<long long>(table.dense.size())) return 0;
+    return table.dense[static_cast<std::size_t>(index)];
+  }
+  auto it = std::lower_bound(table.sparse.begin(), table.sparse.end(), constant,
+                             [](const auto& entry, int value) { return entry.first < value; });
+  return it != table.sparse.end() && it->first == constant ? it->second : 0;
+}
+
+bool Evaluator::condition(const Expression& expr, Frame* frame) {
+  auto value = evaluate(expr, frame);
+  auto result = std::get_if<bool>(&value.data);
+  if (result == nullptr) abort();
+  return *result;
+}
+
+// In the order they are written in, as the arguments are passed
+const std::vector<const FnParam*>& Evaluator::parameters(const FnDef& def) {
+  auto [it, inserted] = m_parameters.try_emplace(&def);
+  if (inserted) it->second = parametersInOrder(def);
+  return it->second;
+}
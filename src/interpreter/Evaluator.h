@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "MemoCache.h"
+#include "Program.h"
+#include "Value.h"
+
+/**
+ * @brief Local variables of a running function, indexed by Storage::slot.
+ */
+struct Frame {
+  std::vector<Value> slots;
+  Frame* enclosing;       // Frame of the function the running one is defined in, if it is local
+  bool captured = false;  // A function was defined in it, calling it may write the slots
+};
+
+struct EvaluationLimits {
+  std::size_t steps = 100000;  // Expressions evaluated and statements executed per evaluation
+  std::size_t callDepth = 200;
+  std::size_t memoEntries = 0;  // Results of pure calls kept for reuse, none are if 0
+};
+
+/**
+ * @brief Tree-walking evaluator for compile time. Runs type-checked programs whose names are
+ * resolved to Storage, but gives up on anything that depends on or changes the state of the
+ * running program: stdin and stdout, reads and writes of global variables and locals of frames
+ * that do not exist yet. It also gives up on runtime errors (e.g. division by zero, a variant
+ * holding another type) and when the limits are reached, so compilation can not hang. Whatever
+ * it gives up on is left to be evaluated at runtime.
+ *
+ * Const globals are evaluated on their first use. Calls of pure functions (see PurityAnalysis)
+ * with primitive arguments are memoized if `memoEntries` is set: a call with the arguments of an
+ * earlier one returns its result without running the body again.
+ */
+class Evaluator {
+ public:
+  explicit Evaluator(const Program& program, EvaluationLimits limits = {});
+  ~Evaluator() = default;
+
+  Evaluator(const Evaluator&) = delete;
+  Evaluator(Evaluator&&) = delete;
+  Evaluator& operator=(const Evaluator&) = delete;
+  Evaluator& operator=(Evaluator&&) = delete;
+
+  /**
+   * @brief Evaluates the expression outside of any function.
+   * @return Its value, or nullopt if it can not be evaluated at compile time.
+   */
+  std::optional<Value> evaluate(const Expression& expr);
+
+  // Number of evaluations given up because the limits were reached
+  std::size_t exhaustedLimits() const { return m_exhaustedLimits; }
+
+  // Number of values moved out of locals at their last use instead of copied
+  std::size_t movedValues() const { return m_movedValues; }
+
+  // Number of const parameters bound to the caller's value instead of a copy of it
+  std::size_t referencedArguments() const { return m_referencedArguments; }
+
+  MemoStats memoStats() const { return m_memo.has_value() ? m_memo->stats() : MemoStats{}; }
+
+ private:
+  enum class Flow : std::uint8_t { Normal, Break, Continue, Return };
+  enum class State : std::uint8_t { Unevaluated, Evaluating, Evaluated, Failed };
+
+  struct Aborted {
+    bool limitReached;
+  };
+
+  struct Constant {
+    State state = State::Unevaluated;
+    Value value;
+  };
+
+  [[noreturn]] void abort(bool limitReached = false) const { throw Aborted{limitReached}; }
+  void step();
+
+  /* ------------------------------ Expressions ----------------------------- */
+
+  Value evaluate(const Expression& expr, Frame* frame);
+
+  Value evaluateNode(const BinaryExpression& expr, Frame* frame);
+  Value evaluateNode(const UnaryExpression& expr, Frame* frame);
+  Value evaluateNode(const FunctionalExpression& expr, Frame* frame);
+  Value evaluateNode(const IdentifierExpr& expr, Frame* frame);
+  template <typename T>
+  Value evaluateNode(const Literal<T>& expr, Frame* frame);
+  Value evaluateNode(const Object& expr, Frame* frame);
+  Value evaluateNode(const ParenExpr& expr, Frame* frame);
+  Value evaluateNode(const CastExpr& expr, Frame* frame);
+  Value evaluateNode(const SharedExpr& expr, Frame* frame);
+  Value evaluateNode(const InlinedCall& expr, Frame* frame);
+  template <typename Node>
+  Value evaluateNode(const Node& node, Frame* frame);
+
+  Value call(const FunctionValue& function, std::vector<Value>&& args);
+
+  /* ------------------------------- Statements ----------------------------- */
+
+  Flow execute(const Statement& stmt, Frame* frame);
+
+  Flow executeNode(const BlockStmt& stmt, Frame* frame);
+  Flow executeNode(const ExpressionStmt& stmt, Frame* frame);
+  Flow executeNode(const AssignmentStmt& stmt, Frame* frame);
+  Flow executeNode(const VariantMatchStmt& stmt, Frame* frame);
+  Flow executeNode(const IfStmt& stmt, Frame* frame);
+  Flow executeNode(const ForStmt& stmt, Frame* frame);
+  Flow executeNode(const WhileStmt& stmt, Frame* frame);
+  Flow executeNode(const ContinueStmt& stmt, Frame* frame);
+  Flow executeNode(const BreakStmt& stmt, Frame* frame);
+  Flow executeNode(const ReturnStmt& stmt, Frame* frame);
+  Flow executeNode(const VarDef& def, Frame* frame);
+  Flow executeNode(const ConstDef& def, Frame* frame);
+  Flow executeNode(const FnDef& def, Frame* frame);
+  template <typename Node>
+  Flow executeNode(const Node& node, Frame* frame);
+
+  /* -------------------------------- Storage ------------------------------- */
+
+  Value& local(const Storage& storage, Frame* frame);
+  Value& reference(const Expression& expr, Frame* frame);
+  void assign(const Expression& target, Value&& value, Frame* frame);
+  const Value* place(const Expression& expr, Frame* frame);
+  const Value* constArgument(const FnParam& param, const Expression& arg, Frame* frame);
+  Value global(std::uint32_t slot);
+
+  Value member(const Value& value, const Expression& base, std::uint32_t offset,
+               TypeId type) const;
+  Value convert(Value&& value, TypeId type) const;
+  bool condition(const Expression& expr, Frame* frame);
+  std::uint32_t switchBranch(const IfStmt& stmt, Frame* frame);
+  const std::vector<const FnParam*>& parameters(const FnDef& def);
+
+  const TypeTable& m_types;
+  EvaluationLimits m_limits;
+
+  std::vector<const Definition*> m_globals;  // By global slot
+  std::unordered_map<std::uint32_t, Constant> m_constants;
+  std::unordered_map<const FnDef*, std::vector<const FnParam*>> m_parameters;
+  std::optional<MemoCache> m_memo;
+
+  std::size_t m_steps = 0;
+  std::size_t m_callDepth = 0;
+  std::size_t m_exhaustedLimits = 0;
+  std::size_t m_movedValues = 0;
+  std::size_t m_referencedArguments = 0;
+  Value m_returnValue;
+};
@@ -0,0 +1,371 @@
+#include <algorithm>
+#include <numeric>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#include "ASTClone.h"
+#include "ASTUtils.h"
+#include "Casting.h"
+#include "Encoding.h"
+#include "Inlining.h"
+#include "RecursiveASTVisitor.h"
+
+namespace {
+
+// Executed by every call but not by an inlined body: the call itself, setting up and tearing down
+// the frame and passing the result back
+constexpr std::size_t CALL_INSTRUCTIONS = 4;
+
+bool isOwnLocal(const Storage& storage) {
+  return storage.kind == Storage::Kind::Local && storage.depth == 0;
+}
+
+class NodeCounter : public RecursiveASTVisitor<NodeCounter> {
+ public:
+  std::size_t count = 0;
+
+  template <typename Node>
+  void visit(Node&) {
+    count++;
+  }
+};
+
+class FunctionFinder : public RecursiveASTVisitor<FunctionFinder> {
+ public:
+  bool found = false;
+
+  void visit(FnDef&) { found = true; }
+};
+
+/**
+ * @brief Slots of its own frame a function body writes to: assignment and stdin targets, loop
+ * variables and the parameters of the calls inlined into it.
+ */
+class WrittenSlots : public RecursiveASTVisitor<WrittenSlots> {
+ public:
+  std::unordered_set<std::uint32_t> slots;
+
+  void visit(AssignmentStmt& stmt) { target(*stmt.lhs); }
+  void visit(StdinExtractionStmt& stmt) {
+    for (auto& expr : stmt.expressions) target(*expr);
+  }
+  void visit(ForStmt& stmt) { slots.insert(stmt.storage.slot); }
+  void visit(InlinedCall& call) {
+    for (auto& parameter : call.parameters) slots.insert(parameter.storage.slot);
+  }
+
+ private:
+  // Writing a member writes the variable holding the struct
+  void target(Expression& expr) {
+    if (auto identifier = dyn_cast<IdentifierExpr>(&expr)) {
+      if (isOwnLocal(identifier->storage)) slots.insert(identifier->storage.slot);
+    } else if (auto functional = dyn_cast<FunctionalExpression>(&expr)) {
+      target(*functional->expr);
+    } else if (auto shared = dyn_cast<SharedExpr>(&expr)) {
+      target(*shared->expr);
+    } else if (auto paren = dyn_cast<ParenExpr>(&expr)) {
+      target(*paren->expr);
+    }
+  }
+};
+
+/**
+ * @brief Moves the locals of a copied callee body past the slots the caller's frame already has.
+ * Uses of parameters bound to a local of the caller are redirected to that local instead.
+ */
+class Relocator : public RecursiveASTVisitor<Relocator> {
+ public:
+  Relocator(std::uint32_t offset, const std::unordered_map<std::uint32_t, Storage>& bound)
+      : m_offset{offset}, m_bound{bound} {}
+
+  void visit(Definition& def) { relocate(def.storage); }
+  void visit(ForStmt& stmt) { relocate(stmt.storage); }
+  void visit(InlinedCall& call) {
+    for (auto& parameter : call.parameters) relocate(parameter.storage);
+  }
+  void visit(IdentifierExpr& expr) {
+    if (isOwnLocal(expr.storage)) {
+      if (auto it = m_bound.find(expr.storage.slot); it != m_bound.end()) {
+        expr.storage = it->second;
+        return;
+      }
+    }
+    relocate(expr.storage);
+  }
+
+ private:
+  void relocate(Storage& storage) const {
+    if (isOwnLocal(storage)) storage.slot += m_offset;
+  }
+
+  std::uint32_t m_offset;
+  const std::unordered_map<std::uint32_t, Storage>& m_bound;
+};
+
+class Inliner : public RecursiveASTVisitor<Inliner> {
+ public:
+  Inliner(Program& program, InliningOptions options)
+      : m_program{program}, m_options{options}, m_functions(program.globalCount, nullptr) {
+    for (auto& [name, definition] : program.definitions) {
+      const auto& storage = definition->storage;
+      if (storage.kind == Storage::Kind::Global && storage.slot < m_functions.size()) {
+        m_functions[storage.slot] = dyn_cast<FnDef>(definition.get());
+      }
+    }
+  }
+
+  InliningReport run() {
+    traverse(m_program);
+    return m_report;
+  }
+
+  using RecursiveASTVisitor::traverse;
+
+  // The range is evaluated once, before the loop
+  void traverse(ForStmt& stmt) {
+    traverse(stmt.range);
+    loop([&] { traverse(stmt.block); });
+  }
+
+  void traverse(WhileStmt& stmt) {
+    loop([&] {
+      root(stmt.condition);
+      traverse(stmt.block);
+    });
+  }
+
+  template <typename Node>
+  bool visit(Node& node) {
+    if constexpr (std::is_base_of_v<Expression, Node>) {
+      return false;
+    } else {
+      if (!m_frames.empty()) roots(node);
+      return true;
+    }
+  }
+
+  bool visit(FnDef& def) {
+    m_frames.push_back({&def});
+    return true;
+  }
+  void postVisit(FnDef&) { m_frames.pop_back(); }
+
+ private:
+  struct Frame {
+    FnDef* function;
+    std::size_t loops = 0;  // Around the traversed code
+  };
+
+  /* ------------------------ Top-level expressions ------------------------ */
+
+  void roots(ASTNode&) {}
+  void roots(VarDef& def) { root(def.value); }
+  void roots(ConstDef& def) { root(def.value); }
+  void roots(ExpressionStmt& stmt) { root(stmt.expr); }
+  void roots(AssignmentStmt& stmt) { root(stmt.rhs); }
+  void roots(StdoutInsertionStmt& stmt) {
+    for (auto& expr : stmt.expressions) root(expr);
+  }
+  void roots(VariantMatchStmt& stmt) { root(stmt.expr); }
+  void roots(IfStmt& stmt) { root(stmt.condition); }
+  void roots(Elif& elif) { root(elif.condition); }
+  void roots(Range& range) {
+    root(range.start);
+    root(range.end);
+  }
+  void roots(ReturnStmt& stmt) {
+    if (stmt.expr != nullptr) root(stmt.expr);
+  }
+
+  template <typename Body>
+  void loop(Body&& body) {
+    if (!m_frames.empty()) m_frames.back().loops++;
+    body();
+    if (!m_frames.empty()) m_frames.back().loops--;
+  }
+
+  /* ------------------------------- Inlining ------------------------------ */
+
+  // Arguments are inlined into before the call, the inlined body after it
+  void root(std::unique_ptr<Expression>& slot) {
+    forEachChild(*slot, [this](std::unique_ptr<Expression>& child) { root(child); });
+
+    if (auto* callee = inlinable(*slot)) inlineCall(slot, *callee);
+    if (auto inlined = dyn_cast<InlinedCall>(slot.get())) {
+      auto it = m_program.definitions.find(inlined->callee);
+      m_inlined.push_back(it != m_program.definitions.end() ? it->second.get() : nullptr);
+      traverse(inlined->body);
+      m_inlined.pop_back();
+    }
+  }
+
+  // The global function the expression calls, if it may be inlined
+  FnDef* inlinable(Expression& expr) {
+    auto functional = dyn_cast<FunctionalExpression>(&expr);
+    if (functional == nullptr) return nullptr;
+    auto call = dyn_cast<FnCallPostfix>(functional->postfix.get());
+    auto identifier = dyn_cast<IdentifierExpr>(functional->expr.get());
+    if (call == nullptr || identifier == nullptr) return nullptr;
+    if (identifier->storage.kind != Storage::Kind::Global) return nullptr;
+    if (identifier->storage.slot >= m_functions.size()) return nullptr;
+
+    auto* callee = m_functions[identifier->storage.slot];
+    if (callee == nullptr || call->args.size() != callee->parameters.size()) return nullptr;
+    if (definesFunctions(*callee)) return nullptr;
+
+    auto caller = m_frames.back().function;
+    auto copies = std::count(m_inlined.begin(), m_inlined.end(), callee) + (caller == callee);
+    if (static_cast<std::size_t>(copies) > m_options.recursionDepth) return nullptr;
+    return callee;
+  }
+
+  void inlineCall(std::unique_ptr<Expression>& slot, FnDef& callee) {
+    auto& frame = m_frames.back();
+    auto& call = cast<FnCallPostfix>(*cast<FunctionalExpression>(*slot).postfix);
+
+    auto params = parametersInOrder(std::as_const(callee));
+
+    // Locals of the caller the callee only reads are used in place, the others are copied
+    InlinedCallSite site{frame.function->name, callee.name, slot->position};
+    site.removedInstructions = CALL_INSTRUCTIONS;
+    std::unordered_map<std::uint32_t, Storage> bound;
+    std::vector<std::size_t> copied;
+    WrittenSlots written;
+    written.traverse(callee.body);
+    for (std::size_t i = 0; i < params.size(); i++) {
+      auto arg = dyn_cast<IdentifierExpr>(call.args[i].get());
+      if (arg != nullptr && isOwnLocal(arg->storage) && arg->typeId == params[i]->typeId &&
+          !written.slots.contains(params[i]->storage.slot) &&
+          !definesFunctions(*frame.function)) {
+        bound.emplace(params[i]->storage.slot, arg->storage);
+        site.elidedCopies++;
+        site.removedInstructions += copyCost(params[i]->typeId);
+      } else {
+        copied.push_back(i);
+      }
+    }
+
+    site.addedNodes = size(callee);
+    auto& growth = m_growth[frame.function];
+    if (growth + site.addedNodes > m_options.maxGrowth) return;
+    if (site.addedNodes > m_options.alwaysInlineSize &&
+        (site.addedNodes > m_options.maxInlineSize ||
+         site.removedInstructions * frequency() < site.addedNodes)) {
+      return;
+    }
+
+    // Copied before the arguments are moved out of the call, it may be in the callee itself
+    auto body = cloneBlock(callee.body);
+    auto offset = frame.function->localCount;
+    Relocator{offset, bound}.traverse(body);
+    frame.function->localCount += callee.localCount;
+
+    std::vector<InlinedParameter> parameters;
+    InlinedCall::Arguments args;
+    for (auto i : copied) {
+      const auto& param = *params[i];
+      parameters.push_back(
+          {param.name, Storage{Storage::Kind::Local, 0, param.storage.slot + offset},
+           param.typeId});
+      args.push_back(std::move(call.args[i]));
+    }
+
+    auto inlined = std::make_unique<InlinedCall>(Position{slot->position}, Identifier{callee.name},
+                                                 std::move(parameters), std::move(args),
+                                                 std::move(body));
+    inlined->typeId = slot->typeId;
+    slot = std::move(inlined);
+
+    growth += site.addedNodes;
+    m_sizes.erase(frame.function);
+    m_report.calls.push_back(std::move(site));
+  }
+
+  /* ------------------------------ Cost model ----------------------------- */
+
+  std::size_t size(FnDef& def) {
+    if (auto it = m_sizes.find(&def); it != m_sizes.end()) return it->second;
+    NodeCounter counter;
+    counter.traverse(def.body);
+    return m_sizes[&def] = counter.count;
+  }
+
+  // Expected executions of the call per execution of the caller, saturating
+  std::size_t frequency() const {
+    std::size_t frequency = 1;
+    for (std::size_t i = 0; i < m_frames.back().loops; i++) {
+      if (frequency > m_options.maxInlineSize) break;
+      frequency *= m_options.loopWeight;
+    }
+    return frequency;
+  }
+
+  // Instructions copying a value of the type
+  std::size_t copyCost(TypeId type) const {
+    const auto& info = m_program.types[type];
+    switch (info.kind) {
+      case TypeKind::String:
+        return 2;
+      case TypeKind::Struct:
+        return std::accumulate(
+            info.members.begin(), info.members.end(), std::size_t{0},
+            [&](std::size_t sum, const StructField& field) { return sum + copyCost(field.type); });
+      case TypeKind::Variant: {
+        std::size_t largest = 0;
+        for (auto alternative : info.alternatives) {
+          largest = std::max(largest, copyCost(alternative));
+        }
+        return 1 + largest;
+      }
+      default:
+        return 1;
+    }
+  }
+
+  bool definesFunctions(FnDef& def) {
+    if (auto it = m_definesFunctions.find(&def); it != m_definesFunctions.end()) return it->second;
+    FunctionFinder finder;
+    finder.traverse(def.body);
+    return m_definesFunctions[&def] = finder.found;
+  }
+
+  Program& m_program;
+  InliningOptions m_options;
+  std::vector<FnDef*> m_functions;  // By global slot
+
+  std::vector<Frame> m_frames;
+  std::vector<const Definition*> m_inlined;  // Callees of the inlined bodies being traversed
+
+  std::unordered_map<const FnDef*, std::size_t> m_sizes;
+  std::unordered_map<const FnDef*, std::size_t> m_growth;
+  std::unordered_map<const FnDef*, bool> m_definesFunctions;
+
+  InliningReport m_report;
+};
+
+}  // namespace
+
+std::size_t InliningReport::removedInstructions() const {
+  return std::accumulate(calls.begin(), calls.end(), std::size_t{0},
+                         [](std::size_t sum, const auto& call) {
+                           return sum + call.removedInstructions;
+                         });
+}
+
+InliningReport inlineCalls(Program& program, InliningOptions options) {
+  return Inliner{program, options}.run();
+}
+
+void printInliningReport(std::ostream& out, const InliningReport& report) {
+  out << "Inlining\n";
+  for (const auto& call : report.calls) {
+    out << "  " << sourceText(call.callee) << " into " << sourceText(call.caller) << " (line "
+        << call.position.line << " col " << call.position.column
+        << "): " << call.removedInstructions << " instructions removed, " << call.elidedCopies
+        << " copies elided, " << call.addedNodes << " nodes added\n";
+  }
+  out << "  total: " << report.calls.size() << " calls, " << report.removedInstructions()
+      << " instructions removed\n";
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+#include "Program.h"
+
+/**
+ * @brief Cost model of the inliner. The size of a function is the number of nodes of its body.
+ * The benefit of inlining a call is the call overhead it removes, times the expected frequency of
+ * the call: `loopWeight` to the power of the number of loops around it.
+ */
+struct InliningOptions {
+  std::size_t alwaysInlineSize = 12;  // Callees at most this big are inlined at every call site
+  std::size_t maxInlineSize = 120;    // Callees larger than this are never inlined
+  std::size_t loopWeight = 8;         // Iterations assumed for every loop
+  std::size_t maxGrowth = 400;        // Nodes a function may grow by in total
+  std::size_t recursionDepth = 1;     // Copies of a function allowed within its own body
+};
+
+struct InlinedCallSite {
+  Identifier caller;
+  Identifier callee;
+  Position position;
+  std::size_t removedInstructions = 0;  // Estimated per execution of the call
+  std::size_t elidedCopies = 0;         // Arguments bound to the caller's locals
+  std::size_t addedNodes = 0;
+};
+
+struct InliningReport {
+  std::vector<InlinedCallSite> calls;  // In the order they were inlined
+
+  std::size_t removedInstructions() const;
+};
+
+/**
+ * @brief Replaces calls of global functions by an InlinedCall holding a copy of the callee's
+ * body, whose locals are moved to unused slots of the caller's frame. As names are already
+ * resolved to slots, callee locals can not capture or shadow the caller's, and returns from any
+ * depth of the copied body end only the InlinedCall.
+ *
+ * A call is inlined if the callee is small, or if the benefit of the cost model outweighs its
+ * size and the caller stays within its growth budget. Calls inside inlined bodies are considered
+ * too, a function is copied into itself at most `recursionDepth` times. Callees defining nested
+ * functions are not inlined, their frames would change under them.
+ *
+ * Removed per call are the call itself, setting up and tearing down the frame and passing the
+ * result; arguments that are locals of the caller never written by the callee are no longer
+ * copied either, the callee uses the caller's local directly.
+ *
+ * The program must be type-checked and its names resolved, and not be checked again afterwards.
+ */
+InliningReport inlineCalls(Program& program, InliningOptions options = {});
+
+void printInliningReport(std::ostream& out, const InliningReport& report);
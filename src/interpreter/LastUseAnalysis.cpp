@@ -0,0 +1,363 @@
+#include <cstdint>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ASTDispatch.h"
+#include "LastUseAnalysis.h"
+#include "RecursiveASTVisitor.h"
+
+namespace {
+
+enum class Site : std::uint8_t { Argument, Return, Assignment };
+
+class FunctionCollector : public RecursiveASTVisitor<FunctionCollector> {
+ public:
+  std::vector<FnDef*> functions;
+
+  void visit(FnDef& def) { functions.push_back(&def); }
+};
+
+bool definesFunctions(FnDef& def) {
+  FunctionCollector collector;
+  collector.traverse(def.body);
+  return !collector.functions.empty();
+}
+
+/**
+ * @brief Backward liveness analysis of the own locals of a function, over its structured control
+ * flow. Each node is transferred from the locals live after it to the locals live before it,
+ * visiting its children in the reverse order the evaluator runs them. Loops are iterated until
+ * their live sets no longer grow; every mark is overwritten on each iteration, so the ones left
+ * are those of the fixed point.
+ */
+class LivenessAnalysis {
+  using Live = std::vector<bool>;
+
+ public:
+  explicit LivenessAnalysis(const TypeTable& types) : m_types{types} {}
+
+  void analyze(FnDef& def) {
+    Live live(def.localCount, false);
+    m_returnLive = live;
+    block(def.body, live);
+  }
+
+  LastUseReport report() const {
+    LastUseReport report;
+    for (const auto& [expr, site] : m_sites) {
+      if (!expr->isLastUse) continue;
+      if (site == Site::Argument) report.arguments++;
+      if (site == Site::Return) report.returns++;
+      if (site == Site::Assignment) report.assignments++;
+    }
+    return report;
+  }
+
+ private:
+  /* ------------------------------- Statements ----------------------------- */
+
+  void transfer(BlockStmt& stmt, Live& live) { block(stmt, live); }
+
+  void transfer(ExpressionStmt& stmt, Live& live) { expression(*stmt.expr, live); }
+
+  // The value is evaluated before the target
+  void transfer(AssignmentStmt& stmt, Live& live) {
+    target(*stmt.lhs, live);
+    source(*stmt.rhs, Site::Assignment, live);
+  }
+
+  void transfer(StdinExtractionStmt& stmt, Live& live) {
+    for (auto it = stmt.expressions.rbegin(); it != stmt.expressions.rend(); ++it) {
+      target(**it, live);
+    }
+  }
+
+  void transfer(StdoutInsertionStmt& stmt, Live& live) {
+    for (auto it = stmt.expressions.rbegin(); it != stmt.expressions.rend(); ++it) {
+      expression(**it, live);
+    }
+  }
+
+  void transfer(VariantMatchStmt& stmt, Live& live) {
+    Live cases = live;
+    for (auto& [variant, matchCase] : stmt.cases) {
+      Live caseLive = live;
+      block(matchCase.block, caseLive);
+      join(cases, caseLive);
+    }
+    live = std::move(cases);
+    expression(*stmt.expr, live);
+  }
+
+  void transfer(IfStmt& stmt, Live& live) {
+    Live next = live;
+    if (stmt.elseClause != nullptr) block(stmt.elseClause->block, next);
+    for (auto it = stmt.elifs.rbegin(); it != stmt.elifs.rend(); ++it) {
+      next = branch(*it->condition, it->block, live, std::move(next));
+    }
+    live = branch(*stmt.condition, stmt.block, live, std::move(next));
+  }
+
+  // The range is evaluated once before the loop, the variable is set before each iteration
+  void transfer(ForStmt& stmt, Live& live) {
+    loop(live, [&](Live& iteration, const Live& exit) {
+      block(stmt.block, iteration);
+      kill(stmt.storage, iteration);
+      join(iteration, exit);
+    });
+    expression(*stmt.range.end, live);
+    expression(*stmt.range.start, live);
+  }
+
+  void transfer(WhileStmt& stmt, Live& live) {
+    loop(live, [&](Live& iteration, const Live& exit) {
+      block(stmt.block, iteration);
+      join(iteration, exit);
+      expression(*stmt.condition, iteration);
+    });
+  }
+
+  void transfer(ContinueStmt&, Live& live) { live = *m_continueLive; }
+
+  void transfer(BreakStmt&, Live& live) { live = *m_breakLive; }
+
+  void transfer(ReturnStmt& stmt, Live& live) {
+    live = m_returnLive;
+    if (stmt.expr != nullptr) source(*stmt.expr, Site::Return, live);
+  }
+
+  void transfer(VarDef& def, Live& live) {
+    kill(def.storage, live);
+    source(*def.value, Site::Assignment, live);
+  }
+
+  void transfer(ConstDef& def, Live& live) {
+    kill(def.storage, live);
+    source(*def.value, Site::Assignment, live);
+  }
+
+  // Nested functions are analyzed on their own, type definitions have no effect
+  void transfer(FnDef& def, Live& live) { kill(def.storage, live); }
+  void transfer(StructDef&, Live&) {}
+  void transfer(VariantDef&, Live&) {}
+
+  /* ------------------------------ Expressions ----------------------------- */
+
+  // Only the taken operand of `and` and `or` is evaluated
+  void transfer(BinaryExpression& expr, Live& live) {
+    if (expr.op == Operator::And || expr.op == Operator::Or) {
+      Live rhs = live;
+      expression(*expr.rhs, rhs);
+      join(live, rhs);
+    } else {
+      expression(*expr.rhs, live);
+    }
+    expression(*expr.lhs, live);
+  }
+
+  void transfer(UnaryExpression& expr, Live& live) { expression(*expr.expr, live); }
+
+  // An argument may be bound to a const parameter instead of copied (see Evaluator), the local
+  // holding it must then keep its value while the arguments after it are evaluated
+  void transfer(FunctionalExpression& expr, Live& live) {
+    if (auto call = dyn_cast<FnCallPostfix>(expr.postfix.get())) {
+      const Live bound = m_bound;
+      for (std::size_t i = call->args.size(); i-- > 0;) {
+        for (std::size_t j = 0; j < i; j++) {
+          if (auto local = boundLocal(*call->args[j])) slot(local->storage, m_bound) = true;
+        }
+        source(*call->args[i], Site::Argument, live);
+        m_bound = bound;
+      }
+    }
+    expression(*expr.expr, live);
+  }
+
+  void transfer(IdentifierExpr& expr, Live& live) {
+    if (isOwnLocal(expr.storage)) slot(expr.storage, live) = true;
+  }
+
+  template <typename T>
+  void transfer(Literal<T>&, Live&) {}
+
+  // Members are only read, the order they are evaluated in does not matter
+  void transfer(Object& expr, Live& live) {
+    for (auto& [name, member] : expr.members) expression(*member.value, live);
+  }
+
+  void transfer(ParenExpr& expr, Live& live) { expression(*expr.expr, live); }
+
+  void transfer(CastExpr& expr, Live& live) { expression(*expr.expr, live); }
+
+  void transfer(SharedExpr& expr, Live& live) { expression(*expr.expr, live); }
+
+  // Returns from the body end the inlined call only, its loops are its own
+  void transfer(InlinedCall& expr, Live& live) {
+    auto returnLive = std::exchange(m_returnLive, live);
+    auto breakLive = std::exchange(m_breakLive, nullptr);
+    auto continueLive = std::exchange(m_continueLive, nullptr);
+    block(expr.body, live);
+    m_returnLive = std::move(returnLive);
+    m_breakLive = breakLive;
+    m_continueLive = continueLive;
+
+    for (const auto& parameter : expr.parameters) kill(parameter.storage, live);
+    for (auto it = expr.args.rbegin(); it != expr.args.rend(); ++it) {
+      source(**it, Site::Argument, live);
+    }
+  }
+
+  template <typename Node>
+  void transfer(Node&, Live&) {
+    throw std::logic_error("Unexpected node in a function body!");
+  }
+
+  static bool isOwnLocal(const Storage& storage) {
+    return storage.kind == Storage::Kind::Local && storage.depth == 0;
+  }
+
+  static void join(Live& live, const Live& other) {
+    for (std::size_t i = 0; i < other.size(); i++) {
+      if (other[i]) slot(i, live) = true;
+    }
+  }
+
+  static Live::reference slot(std::size_t slot, Live& live) {
+    if (slot >= live.size()) live.resize(slot + 1, false);
+    return live[slot];
+  }
+
+  static Live::reference slot(const Storage& storage, Live& live) {
+    return slot(storage.slot, live);
+  }
+
+  static void kill(const Storage& storage, Live& live) {
+    if (isOwnLocal(storage)) slot(storage, live) = false;
+  }
+
+  void statement(Statement& stmt, Live& live) {
+    dispatch(stmt, [&](auto& node) { transfer(node, live); });
+  }
+
+  void expression(Expression& expr, Live& live) {
+    dispatch(expr, [&](auto& node) { transfer(node, live); });
+  }
+
+  void block(BlockStmt& stmt, Live& live) {
+    for (auto it = stmt.statements.rbegin(); it != stmt.statements.rend(); ++it) {
+      statement(**it, live);
+    }
+  }
+
+  // Locals live before the condition of an if or elif, given those live after its block and
+  // those live before the next branch
+  Live branch(Expression& condition, BlockStmt& stmt, const Live& after, Live&& next) {
+    Live live = after;
+    block(stmt, live);
+    join(live, next);
+    expression(condition, live);
+    return live;
+  }
+
+  /**
+   * @brief Replaces the locals live after a loop by those live before it. `iteration` transfers
+   * the locals live at the head of the next iteration back to the head of this one, also adding
+   * those live at the exit where the loop may end. Starts from no live locals, so the live sets
+   * only grow until they reach the smallest fixed point.
+   */
+  template <typename Iteration>
+  void loop(Live& live, Iteration&& iteration) {
+    const Live exit = live;
+    Live head(exit.size(), false);
+    auto breakLive = std::exchange(m_breakLive, &exit);
+    auto continueLive = std::exchange(m_continueLive, &head);
+    while (true) {
+      Live next = head;
+      iteration(next, exit);
+      if (next == head) break;
+      head = std::move(next);
+    }
+    m_breakLive = breakLive;
+    m_continueLive = continueLive;
+    live = std::move(head);
+  }
+
+  // Writing a member reads the rest of the struct, only writing the whole local ends its value
+  void target(Expression& expr, Live& live) {
+    if (auto identifier = dyn_cast<IdentifierExpr>(&expr)) {
+      kill(identifier->storage, live);
+    } else if (auto paren = dyn_cast<ParenExpr>(&expr)) {
+      target(*paren->expr, live);
+    } else {
+      expression(expr, live);
+    }
+  }
+
+  // A local whose value is copied: marked if it is not live afterwards, nor bound to a parameter
+  void source(Expression& expr, Site site, Live& live) {
+    Expression* inner = &expr;
+    while (auto paren = dyn_cast<ParenExpr>(inner)) inner = paren->expr.get();
+
+    auto identifier = dyn_cast<IdentifierExpr>(inner);
+    if (identifier != nullptr && isOwnLocal(identifier->storage) && isMovable(identifier->typeId)) {
+      identifier->isLastUse =
+          !slot(identifier->storage, live) && !slot(identifier->storage, m_bound);
+      m_sites[identifier] = site;
+    }
+    expression(expr, live);
+  }
+
+  // The own local an argument names, or names a member of, if it can be bound to a parameter
+  static IdentifierExpr* boundLocal(Expression& arg) {
+    Expression* inner = &arg;
+    while (true) {
+      if (auto paren = dyn_cast<ParenExpr>(inner)) {
+        inner = paren->expr.get();
+      } else if (auto shared = dyn_cast<SharedExpr>(inner)) {
+        inner = shared->expr;
+      } else if (auto functional = dyn_cast<FunctionalExpression>(inner);
+                 functional != nullptr && isa<MemberAccessPostfix>(functional->postfix.get())) {
+        inner = functional->expr.get();
+      } else {
+        break;
+      }
+    }
+    auto identifier = dyn_cast<IdentifierExpr>(inner);
+    return identifier != nullptr && isOwnLocal(identifier->storage) ? identifier : nullptr;
+  }
+
+  bool isMovable(TypeId type) const {
+    if (type == ERROR_TYPE || type >= m_types.size()) return false;
+    auto kind = m_types[type].kind;
+    return kind == TypeKind::String || kind == TypeKind::Struct || kind == TypeKind::Variant;
+  }
+
+  const TypeTable& m_types;
+  Live m_returnLive;
+  Live m_bound;  // Locals bound to parameters of calls whose arguments are being evaluated
+  const Live* m_breakLive = nullptr;
+  const Live* m_continueLive = nullptr;
+  std::unordered_map<IdentifierExpr*, Site> m_sites;
+};
+
+}  // namespace
+
+LastUseReport markLastUses(Program& program) {
+  FunctionCollector collector;
+  collector.traverse(program);
+
+  LivenessAnalysis analysis{program.types};
+  for (auto* def : collector.functions) {
+    if (!definesFunctions(*def)) analysis.analyze(*def);
+  }
+  return analysis.report();
+}
+
+void printLastUseReport(std::ostream& out, const LastUseReport& report) {
+  out << "Last uses\n";
+  out << "  " << report.arguments << " arguments, " << report.returns << " returns, "
+      << report.assignments << " assignments moved\n";
+  out << "  total: " << report.avoidedCopies() << " copies avoided\n";
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+
+#include "Program.h"
+
+struct LastUseReport {
+  std::size_t arguments = 0;    // Locals passed to a call or an inlined call
+  std::size_t returns = 0;      // Locals returned
+  std::size_t assignments = 0;  // Locals assigned or used to initialize a variable
+
+  std::size_t avoidedCopies() const { return arguments + returns + assignments; }
+};
+
+/**
+ * @brief Liveness analysis of the locals of every function. A string, struct or variant local
+ * that is passed as an argument, returned or assigned, and never read again before it is
+ * overwritten or its frame ends, is marked as its last use (IdentifierExpr::isLastUse): its value
+ * can be moved out of the slot instead of copied. Nothing can read the slot afterwards, so the
+ * copying semantics of the program are kept.
+ *
+ * Functions defining nested functions are left alone, their locals may be read by the nested
+ * functions at any call.
+ *
+ * The program must be type-checked and its names resolved. Run it after any pass that moves or
+ * copies code around (e.g. inlining), the marks are only valid where they were computed.
+ */
+LastUseReport markLastUses(Program& program);
+
+void printLastUseReport(std::ostream& out, const LastUseReport& report);
@@ -0,0 +1,394 @@
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "ASTClone.h"
+#include "ASTUtils.h"
+#include "Casting.h"
+#include "LoopInvariantCodeMotion.h"
+#include "RecursiveASTVisitor.h"
+
+namespace {
+
+using Globals = std::unordered_map<std::uint32_t, Definition*>;  // By global slot
+
+Definition* global(const Globals& globals, const Storage& storage) {
+  if (storage.kind != Storage::Kind::Global) return nullptr;
+  auto it = globals.find(storage.slot);
+  return it != globals.end() ? it->second : nullptr;
+}
+
+// The global function called, null for local functions and function values
+FnDef* callee(const Globals& globals, FunctionalExpression& expr) {
+  auto identifier = dyn_cast<IdentifierExpr>(expr.expr.get());
+  return identifier != nullptr ? dyn_cast_or_null<FnDef>(global(globals, identifier->storage))
+                               : nullptr;
+}
+
+/**
+ * @brief Variables a piece of code writes: slots of the frame it runs in and global variables,
+ * and the global functions it calls. Functions defined in it are part of it, writes to their own
+ * frames are not counted.
+ */
+class Writes : public RecursiveASTVisitor<Writes> {
+ public:
+  explicit Writes(const Globals& globals) : m_globals{globals} {}
+
+  std::unordered_set<std::uint32_t> locals;
+  std::unordered_set<std::uint32_t> globals;
+  std::unordered_set<FnDef*> callees;
+  bool callsUnknown = false;  // Local functions or function values, they could write anything
+
+  void visit(AssignmentStmt& stmt) { target(*stmt.lhs); }
+  void visit(StdinExtractionStmt& stmt) {
+    for (auto& expr : stmt.expressions) target(*expr);
+  }
+  void visit(VarDef& def) { write(def.storage); }
+  void visit(ConstDef& def) { write(def.storage); }
+  void visit(ForStmt& stmt) { write(stmt.storage); }
+  void visit(InlinedCall& call) {
+    for (auto& parameter : call.parameters) write(parameter.storage);
+  }
+  void visit(FnDef& def) {
+    write(def.storage);
+    m_nesting++;
+  }
+  void postVisit(FnDef&) { m_nesting--; }
+
+  void visit(FunctionalExpression& expr) {
+    if (!isa<FnCallPostfix>(expr.postfix.get())) return;
+    if (auto* function = callee(m_globals, expr)) {
+      callees.insert(function);
+    } else {
+      callsUnknown = true;
+    }
+  }
+
+ private:
+  // Writing a member writes the variable holding the struct
+  void target(Expression& expr) {
+    if (auto identifier = dyn_cast<IdentifierExpr>(&expr)) {
+      write(identifier->storage);
+    } else if (auto functional = dyn_cast<FunctionalExpression>(&expr)) {
+      target(*functional->expr);
+    } else if (auto shared = dyn_cast<SharedExpr>(&expr)) {
+      target(*shared->expr);
+    } else if (auto paren = dyn_cast<ParenExpr>(&expr)) {
+      target(*paren->expr);
+    }
+  }
+
+  void write(const Storage& storage) {
+    if (storage.kind == Storage::Kind::Global) {
+      globals.insert(storage.slot);
+    } else if (storage.kind == Storage::Kind::Local && storage.depth == m_nesting) {
+      locals.insert(storage.slot);
+    }
+  }
+
+  const Globals& m_globals;
+  std::uint16_t m_nesting = 0;
+};
+
+/**
+ * @brief Global variables each global function writes, itself or through the functions it calls.
+ */
+class FunctionEffects {
+ public:
+  struct Effects {
+    std::unordered_set<std::uint32_t> globals;
+    bool callsUnknown = false;
+  };
+
+  FunctionEffects(Program& program, const Globals& globals) {
+    std::unordered_map<FnDef*, std::unordered_set<FnDef*>> callees;
+    for (auto& [name, definition] : program.definitions) {
+      auto fnDef = dyn_cast<FnDef>(definition.get());
+      if (fnDef == nullptr) continue;
+      Writes writes{globals};
+      writes.traverse(fnDef->body);
+      m_effects[fnDef] = {std::move(writes.globals), writes.callsUnknown};
+      callees[fnDef] = std::move(writes.callees);
+    }
+
+    // Until the effects of the callees no longer add to any caller's
+    for (bool changed = true; changed;) {
+      changed = false;
+      for (auto& [function, called] : callees) {
+        auto& effects = m_effects[function];
+        for (auto* callee : called) {
+          const auto& calleeEffects = m_effects[callee];
+          for (auto slot : calleeEffects.globals) changed |= effects.globals.insert(slot).second;
+          if (calleeEffects.callsUnknown && !effects.callsUnknown) {
+            effects.callsUnknown = true;
+            changed = true;
+          }
+        }
+      }
+    }
+  }
+
+  const Effects& operator[](FnDef* function) { return m_effects[function]; }
+
+ private:
+  std::unordered_map<FnDef*, Effects> m_effects;
+};
+
+/**
+ * @brief Hoists the invariants of every loop, innermost first: blocks are handled after the
+ * statements in them, so an outer loop sees the preheaders of the loops in its body.
+ */
+class LoopInvariantMotion : public RecursiveASTVisitor<LoopInvariantMotion> {
+ public:
+  explicit LoopInvariantMotion(Program& program)
+      : m_program{program}, m_globals{globalsOf(program)}, m_effects{program, m_globals} {}
+
+  LoopInvariantReport run() {
+    traverse(m_program);
+    return m_report;
+  }
+
+  void visit(FnDef& def) { m_frames.push_back(&def); }
+  void postVisit(FnDef&) { m_frames.pop_back(); }
+
+  void postVisit(BlockStmt& block) {
+    if (m_frames.empty()) return;
+    for (auto& stmt : block.statements) {
+      if (isa<WhileStmt>(*stmt) || isa<ForStmt>(*stmt)) hoist(stmt);
+    }
+  }
+
+ private:
+  /**
+   * @brief What a loop writes, everything its invariants may not read.
+   */
+  struct Loop {
+    std::unordered_set<std::uint32_t> locals;
+    std::unordered_set<std::uint32_t> globals;
+  };
+
+  static Globals globalsOf(Program& program) {
+    Globals globals;
+    for (auto& [name, definition] : program.definitions) {
+      if (definition->storage.kind == Storage::Kind::Global) {
+        globals.emplace(definition->storage.slot, definition.get());
+      }
+    }
+    return globals;
+  }
+
+  /* --------------------------------- Loops -------------------------------- */
+
+  void hoist(std::unique_ptr<Statement>& stmt) {
+    std::unique_ptr<Expression> guard;
+    Writes writes{m_globals};
+    if (auto whileStmt = dyn_cast<WhileStmt>(stmt.get())) {
+      if (!isSideEffectFree(*whileStmt->condition)) return;
+      writes.traverse(*whileStmt);
+    } else {
+      auto& forStmt = cast<ForStmt>(*stmt);
+      if (!isSideEffectFree(*forStmt.range.start) || !isSideEffectFree(*forStmt.range.end)) return;
+      writes.traverse(forStmt.block);
+      writes.locals.insert(forStmt.storage.slot);
+    }
+
+    if (writes.callsUnknown) return;
+    Loop loop{std::move(writes.locals), std::move(writes.globals)};
+    for (auto* function : writes.callees) {
+      const auto& effects = m_effects[function];
+      if (effects.callsUnknown) return;
+      loop.globals.insert(effects.globals.begin(), effects.globals.end());
+    }
+
+    BlockStmt::Statements preheader;
+    if (auto whileStmt = dyn_cast<WhileStmt>(stmt.get())) {
+      guard = cloneExpression(*whileStmt->condition);
+      hoistFrom(whileStmt->condition, loop, preheader);
+      hoistFrom(whileStmt->block, loop, preheader);
+    } else {
+      auto& forStmt = cast<ForStmt>(*stmt);
+      const auto& range = forStmt.range;
+      guard = std::make_unique<BinaryExpression>(Position{forStmt.position},
+                                                 cloneExpression(*range.start), Operator::Neq,
+                                                 cloneExpression(*range.end));
+      guard->typeId = BOOL_TYPE;
+      hoistFrom(forStmt.block, loop, preheader);
+    }
+    if (preheader.empty()) return;
+
+    m_report.loops++;
+    m_report.expressions += preheader.size();
+    auto position = stmt->position;
+    preheader.push_back(std::move(stmt));
+    stmt = std::make_unique<IfStmt>(Position{position}, std::move(guard),
+                                    BlockStmt{Position{position}, std::move(preheader)},
+                                    IfStmt::Elifs{}, nullptr);
+  }
+
+  /**
+   * @brief Hoists from the statements of the body that run on every iteration: up to the first
+   * one that may skip the rest, of which only the expressions evaluated first are considered, and
+   * before the first one with side effects. A hoisted expression that fails, e.g. divides by zero,
+   * then cannot fail ahead of output the loop writes first.
+   */
+  void hoistFrom(BlockStmt& body, const Loop& loop, BlockStmt::Statements& preheader) {
+    for (auto& stmt : body.statements) {
+      auto slots = evaluatedFirst(*stmt);
+      for (auto* slot : slots) {
+        if (!isSideEffectFree(**slot)) return;
+      }
+      for (auto* slot : slots) hoistFrom(*slot, loop, preheader);
+      if (slots.empty() || !isSimple(*stmt)) return;
+    }
+  }
+
+  // Expressions the statement evaluates before it may skip anything, none for input and output
+  static std::vector<std::unique_ptr<Expression>*> evaluatedFirst(Statement& stmt) {
+    if (auto expression = dyn_cast<ExpressionStmt>(&stmt)) return {&expression->expr};
+    if (auto assignment = dyn_cast<AssignmentStmt>(&stmt)) return {&assignment->rhs};
+    if (auto varDef = dyn_cast<VarDef>(&stmt)) return {&varDef->value};
+    if (auto constDef = dyn_cast<ConstDef>(&stmt)) return {&constDef->value};
+    if (auto ifStmt = dyn_cast<IfStmt>(&stmt)) return {&ifStmt->condition};
+    if (auto match = dyn_cast<VariantMatchStmt>(&stmt)) return {&match->expr};
+    if (auto whileStmt = dyn_cast<WhileStmt>(&stmt)) return {&whileStmt->condition};
+    if (auto forStmt = dyn_cast<ForStmt>(&stmt)) {
+      return {&forStmt->range.start, &forStmt->range.end};
+    }
+    if (auto returnStmt = dyn_cast<ReturnStmt>(&stmt); returnStmt != nullptr && returnStmt->expr) {
+      return {&returnStmt->expr};
+    }
+    return {};
+  }
+
+  // Statements always followed by the next one
+  static bool isSimple(const Statement& stmt) {
+    return isa<ExpressionStmt>(stmt) || isa<AssignmentStmt>(stmt) || isa<VarDef>(stmt) ||
+           isa<ConstDef>(stmt);
+  }
+
+  // Replaces the largest invariant subexpressions, the right operand of `and` and `or` is not
+  // always evaluated and shared subtrees are replaced only as a whole
+  void hoistFrom(std::unique_ptr<Expression>& slot, const Loop& loop,
+                 BlockStmt::Statements& preheader) {
+    if (isHoistable(*slot) && isInvariant(*slot, loop)) {
+      preheader.push_back(define(std::move(slot)));
+      slot = use(cast<VarDef>(*preheader.back()));
+      return;
+    }
+
+    if (auto binary = dyn_cast<BinaryExpression>(slot.get())) {
+      hoistFrom(binary->lhs, loop, preheader);
+      if (binary->op != Operator::And && binary->op != Operator::Or) {
+        hoistFrom(binary->rhs, loop, preheader);
+      }
+    } else if (!isa<SharedExpr>(*slot)) {
+      forEachChild(*slot, [&](std::unique_ptr<Expression>& child) {
+        hoistFrom(child, loop, preheader);
+      });
+    }
+  }
+
+  /* ------------------------------ Invariants ------------------------------ */
+
+  // Hoisting saves an evaluation only for operations, and values of functions are not stored
+  bool isHoistable(const Expression& expr) const {
+    if (expr.typeId == ERROR_TYPE || m_program.types[expr.typeId].kind == TypeKind::Function) {
+      return false;
+    }
+    if (auto paren = dyn_cast<ParenExpr>(&expr)) return isHoistable(*paren->expr);
+    return !isa<IdentifierExpr>(expr) && !isa<Object>(expr) && !isa<InlinedCall>(expr) &&
+           !literalLike(expr);
+  }
+
+  static bool literalLike(const Expression& expr) {
+    return isa<Literal<int>>(expr) || isa<Literal<float>>(expr) || isa<Literal<bool>>(expr) ||
+           isa<Literal<wchar_t>>(expr) || isa<Literal<std::wstring>>(expr);
+  }
+
+  bool isInvariant(Expression& expr, const Loop& loop) {
+    if (auto identifier = dyn_cast<IdentifierExpr>(&expr)) {
+      const auto& storage = identifier->storage;
+      if (storage.kind == Storage::Kind::Local) {
+        return storage.depth == 0 && !loop.locals.contains(storage.slot);
+      }
+      auto* definition = global(m_globals, storage);
+      if (definition == nullptr) return false;
+      return !isa<VarDef>(*definition) || !loop.globals.contains(storage.slot);
+    }
+    if (isa<Object>(expr) || isa<InlinedCall>(expr)) return false;
+    if (auto functional = dyn_cast<FunctionalExpression>(&expr)) {
+      if (isa<FnCallPostfix>(functional->postfix.get())) {
+        auto* function = callee(m_globals, *functional);
+        if (function == nullptr || !function->isPure) return false;
+      }
+    }
+    if (auto shared = dyn_cast<SharedExpr>(&expr)) return isInvariant(*shared->expr, loop);
+
+    bool invariant = true;
+    forEachChild(expr, [&](std::unique_ptr<Expression>& child) {
+      invariant = invariant && isInvariant(*child, loop);
+    });
+    return invariant;
+  }
+
+  // Evaluating it again changes nothing: it calls only pure functions
+  bool isSideEffectFree(Expression& expr) {
+    if (isa<InlinedCall>(expr)) return false;
+    if (auto functional = dyn_cast<FunctionalExpression>(&expr)) {
+      if (isa<FnCallPostfix>(functional->postfix.get())) {
+        auto* function = callee(m_globals, *functional);
+        if (function == nullptr || !function->isPure) return false;
+      }
+    }
+    if (auto shared = dyn_cast<SharedExpr>(&expr)) return isSideEffectFree(*shared->expr);
+
+    bool sideEffectFree = true;
+    forEachChild(expr, [&](std::unique_ptr<Expression>& child) {
+      sideEffectFree = sideEffectFree && isSideEffectFree(*child);
+    });
+    return sideEffectFree;
+  }
+
+  /* ------------------------------ Preheaders ------------------------------ */
+
+  // A new local of the frame holding the value, named so it can not clash with the source
+  std::unique_ptr<Statement> define(std::unique_ptr<Expression>&& expr) {
+    auto& function = *m_frames.back();
+    auto name = L"invariant$" + std::to_wstring(function.localCount);
+    auto position = expr->position;
+    auto typeId = expr->typeId;
+
+    auto def = std::make_unique<VarDef>(Position{position}, std::move(name),
+                                        m_program.types.name(typeId), std::move(expr));
+    def->storage = Storage{Storage::Kind::Local, 0, function.localCount++};
+    def->typeId = typeId;
+    return def;
+  }
+
+  static std::unique_ptr<Expression> use(const VarDef& def) {
+    auto identifier = std::make_unique<IdentifierExpr>(Position{def.value->position},
+                                                       Identifier{def.name});
+    identifier->storage = def.storage;
+    identifier->typeId = def.typeId;
+    return identifier;
+  }
+
+  Program& m_program;
+  Globals m_globals;
+  FunctionEffects m_effects;
+  std::vector<FnDef*> m_frames;
+  LoopInvariantReport m_report;
+};
+
+}  // namespace
+
+LoopInvariantReport hoistLoopInvariants(Program& program) {
+  return LoopInvariantMotion{program}.run();
+}
+
+void printLoopInvariantReport(std::ostream& out, const LoopInvariantReport& report) {
+  out << "Loop invariants\n";
+  out << "  " << report.expressions << " expressions hoisted out of " << report.loops
+      << " loops\n";
+}
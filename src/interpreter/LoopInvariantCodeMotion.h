@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+
+#include "Program.h"
+
+struct LoopInvariantReport {
+  std::size_t loops = 0;        // Loops given a preheader
+  std::size_t expressions = 0;  // Expressions hoisted into the preheaders
+};
+
+/**
+ * @brief Hoists the loop-invariant expressions of while and for loops into a preheader: new
+ * locals initialized right before the loop, read by the loop instead of the expressions.
+ *
+ * An expression is invariant if it reads only locals of its own frame not written in the loop,
+ * consts, and global variables written neither in the loop nor by any function it calls. It may
+ * call pure functions (see PurityAnalysis) but build no objects. A write to a member writes the
+ * whole variable holding it, as does reading a value from stdin into it. Loops calling local
+ * functions or function values are left alone, those could write anything.
+ *
+ * Only the expressions evaluated on every iteration are hoisted: those of the condition and of
+ * the statements of the body before the first one that may skip the rest of it or that has side
+ * effects, such as input, output or a call of an impure function. The preheader is guarded to run
+ * only if the loop runs at least once, so nothing is evaluated that would not be otherwise; loops
+ * without a side-effect free condition or range are left alone.
+ *
+ * The program must be type-checked, its names resolved and its pure functions marked.
+ */
+LoopInvariantReport hoistLoopInvariants(Program& program);
+
+void printLoopInvariantReport(std::ostream& out, const LoopInvariantReport& report);
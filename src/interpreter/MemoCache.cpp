@@ -0,0 +1,49 @@
+#include <functional>
+
+#include "MemoCache.h"
+
+namespace {
+
+std::size_t combine(std::size_t seed, std::size_t value) {
+  return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+}
+
+}  // namespace
+
+std::size_t MemoCache::KeyHash::operator()(const Key& key) const {
+  auto hash = std::hash<const FnDef*>{}(key.function);
+  for (const auto& arg : key.args) hash = combine(hash, std::hash<ConstantValue>{}(arg));
+  return hash;
+}
+
+const Value* MemoCache::find(const FnDef& function, const std::vector<ConstantValue>& args) {
+  auto it = m_index.find(Key{&function, args});
+  if (it == m_index.end()) {
+    m_stats.misses++;
+    return nullptr;
+  }
+
+  m_stats.hits++;
+  m_entries.splice(m_entries.begin(), m_entries, it->second);
+  return &it->second->result;
+}
+
+void MemoCache::insert(const FnDef& function, std::vector<ConstantValue>&& args,
+                       const Value& result) {
+  if (m_capacity == 0) return;
+
+  Key key{&function, std::move(args)};
+  if (auto it = m_index.find(key); it != m_index.end()) {
+    it->second->result = result;
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    return;
+  }
+
+  if (m_entries.size() >= m_capacity) {
+    m_index.erase(m_entries.back().key);
+    m_entries.pop_back();
+    m_stats.evictions++;
+  }
+  m_entries.push_front({key, result});
+  m_index.emplace(std::move(key), m_entries.begin());
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "ConstantFolding.h"
+#include "Value.h"
+
+struct MemoStats {
+  std::size_t hits = 0;
+  std::size_t misses = 0;
+  std::size_t evictions = 0;
+
+  double hitRate() const {
+    auto lookups = hits + misses;
+    return lookups == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(lookups);
+  }
+};
+
+/**
+ * @brief Results of calls of pure functions by their primitive arguments, holding at most
+ * `capacity` of them. When full, the least recently used result is evicted.
+ */
+class MemoCache {
+ public:
+  explicit MemoCache(std::size_t capacity) : m_capacity{capacity} {}
+  ~MemoCache() = default;
+
+  MemoCache(const MemoCache&) = delete;
+  MemoCache(MemoCache&&) = delete;
+  MemoCache& operator=(const MemoCache&) = delete;
+  MemoCache& operator=(MemoCache&&) = delete;
+
+  /**
+   * @brief The result of the earlier call with the same arguments, counted as a hit or a miss.
+   * @return nullptr if there is none, the pointer is valid until the next insert().
+   */
+  const Value* find(const FnDef& function, const std::vector<ConstantValue>& args);
+  void insert(const FnDef& function, std::vector<ConstantValue>&& args, const Value& result);
+
+  std::size_t size() const { return m_entries.size(); }
+  const MemoStats& stats() const { return m_stats; }
+
+ private:
+  struct Key {
+    const FnDef* function;
+    std::vector<ConstantValue> args;
+
+    bool operator==(const Key& other) const = default;
+  };
+
+  struct KeyHash {
+    std::size_t operator()(const Key& key) const;
+  };
+
+  struct Entry {
+    Key key;
+    Value result;
+  };
+
+  std::size_t m_capacity;
+  std::list<Entry> m_entries;  // Most recently used first
+  std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> m_index;
+  MemoStats m_stats;
+};
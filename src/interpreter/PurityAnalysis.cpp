@@ -0,0 +1,105 @@
+#include <unordered_map>
+#include <vector>
+
+#include "Casting.h"
+#include "PurityAnalysis.h"
+#include "RecursiveASTVisitor.h"
+
+namespace {
+
+/**
+ * @brief Finds what makes a single function impure on its own and the global functions it calls.
+ * Functions defined in it are part of it, names they resolve to its frame are its own locals.
+ */
+class Effects : public RecursiveASTVisitor<Effects> {
+ public:
+  explicit Effects(const std::unordered_map<std::uint32_t, Definition*>& globals)
+      : m_globals{globals} {}
+
+  bool impure = false;
+  std::vector<FnDef*> callees;
+
+  void analyze(FnDef& def) { traverse(def.body); }
+
+  void visit(StdinExtractionStmt&) { impure = true; }
+  void visit(StdoutInsertionStmt&) { impure = true; }
+
+  void visit(FnDef&) { m_nesting++; }
+  void postVisit(FnDef&) { m_nesting--; }
+
+  void visit(IdentifierExpr& expr) {
+    const auto& storage = expr.storage;
+    if (storage.kind == Storage::Kind::Local) {
+      if (storage.depth > m_nesting) impure = true;
+    } else if (dyn_cast_or_null<VarDef>(global(storage)) != nullptr) {
+      impure = true;
+    }
+  }
+
+  void visit(FunctionalExpression& expr) {
+    auto call = dyn_cast<FnCallPostfix>(expr.postfix.get());
+    if (call == nullptr) return;
+
+    // Local functions and function values could be anything
+    auto identifier = dyn_cast<IdentifierExpr>(expr.expr.get());
+    auto callee = identifier != nullptr && identifier->storage.kind == Storage::Kind::Global
+                      ? dyn_cast_or_null<FnDef>(global(identifier->storage))
+                      : nullptr;
+    if (callee == nullptr) {
+      impure = true;
+    } else {
+      callees.push_back(callee);
+    }
+  }
+
+ private:
+  Definition* global(const Storage& storage) const {
+    auto it = m_globals.find(storage.slot);
+    return it != m_globals.end() ? it->second : nullptr;
+  }
+
+  const std::unordered_map<std::uint32_t, Definition*>& m_globals;
+  std::uint32_t m_nesting = 0;
+};
+
+}  // namespace
+
+// Functions are pure until an impure one is found, impurity spreads from callees to callers
+PurityReport markPureFunctions(Program& program) {
+  std::unordered_map<std::uint32_t, Definition*> globals;
+  std::vector<FnDef*> functions;
+  for (auto& [name, definition] : program.definitions) {
+    if (definition->storage.kind == Storage::Kind::Global) {
+      globals.emplace(definition->storage.slot, definition.get());
+    }
+    if (auto fnDef = dyn_cast<FnDef>(definition.get())) functions.push_back(fnDef);
+  }
+
+  std::unordered_map<FnDef*, std::vector<FnDef*>> callers;
+  std::vector<FnDef*> impure;
+  for (auto* function : functions) {
+    Effects effects{globals};
+    effects.analyze(*function);
+    for (auto* callee : effects.callees) callers[callee].push_back(function);
+
+    function->isPure = !effects.impure;
+    if (effects.impure) impure.push_back(function);
+  }
+
+  while (!impure.empty()) {
+    auto* function = impure.back();
+    impure.pop_back();
+    for (auto* caller : callers[function]) {
+      if (caller->isPure) {
+        caller->isPure = false;
+        impure.push_back(caller);
+      }
+    }
+  }
+
+  PurityReport report{functions.size(), 0};
+  for (auto* function : functions) {
+    if (function->isPure) report.pure++;
+  }
+  return report;
+}
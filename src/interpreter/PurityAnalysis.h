@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+
+#include "Program.h"
+
+struct PurityReport {
+  std::size_t functions = 0;
+  std::size_t pure = 0;
+};
+
+/**
+ * @brief Marks the functions whose result depends only on their arguments and which have no
+ * effect besides returning it (FnDef::isPure). Pure functions:
+ *  - read from stdin and write to stdout nowhere,
+ *  - neither read nor write global variables (consts and functions are fine),
+ *  - do not reach into the frames of the functions they are defined in,
+ *  - call only global functions that are pure themselves.
+ * Recursion is assumed to be pure until a function of the cycle is found not to be.
+ *
+ * The program must be type-checked and its names resolved.
+ */
+PurityReport markPureFunctions(Program& program);
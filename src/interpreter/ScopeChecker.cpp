@@ -1,47 +1,136 @@
+#include <algorithm>
+
+#include "ASTUtils.h"
+#include "ScopeChecker.h"
 
 ScopeChecker::ScopeChecker(ErrorHandler& errorHandler) : m_errorHandler{errorHandler} {}
 
-// void ScopeChecker::visit(Program& program) {}
-
-// void ScopeChecker::visit(Definition& def) {}
-// void ScopeChecker::visit(VarDef& def) {}
-// void ScopeChecker::visit(ConstDef& def) {}
-// void ScopeChecker::visit(StructDef& def) {}
-// void ScopeChecker::visit(VariantDef& def) {}
-// void ScopeChecker::visit(FnDef& def) {}
-
-// void ScopeChecker::visit(Expression& expr) {}
-// void ScopeChecker::visit(BinaryExpression& expr) {}
-// void ScopeChecker::visit(UnaryExpression& expr) {}
-// void ScopeChecker::visit(FunctionalExpression& expr) {}
-// void ScopeChecker::visit(FunctionalExpression::Postfix& postfix) {}
-// void ScopeChecker::visit(MemberAccess::Postfix& postfix) {}
-// void ScopeChecker::visit(VariantAccess::Postfix& postfix) {}
-// void ScopeChecker::visit(FnCall::Postfix& postfix) {}
-// void ScopeChecker::visit(PrimaryExpression& expr) {}
-// void ScopeChecker::visit(IdentifierExpr& expr) {}
-// void ScopeChecker::visit(Literal<int>& expr) {}
-// void ScopeChecker::visit(Literal<float>& expr) {}
-// void ScopeChecker::visit(Literal<bool>& expr) {}
-// void ScopeChecker::visit(Literal<wchar_t>& expr) {}
-// void ScopeChecker::visit(Literal<std::wstring>& expr) {}
-// void ScopeChecker::visit(Object& expr) {}
-// void ScopeChecker::visit(ParenExpr& expr) {}
-// void ScopeChecker::visit(CastExpr& expr) {}
-
-// void ScopeChecker::visit(Statement& stmt) {}
-// void ScopeChecker::visit(BlockStmt& stmt) {}
-// void ScopeChecker::visit(AssignmentStmt& stmt) {}
-// void ScopeChecker::visit(StdinExtractionStmt& stmt) {}
-// void ScopeChecker::visit(StdoutInsertionStmt& stmt) {}
-// void ScopeChecker::visit(VariantMatchStmt& stmt) {}
-// void ScopeChecker::visit(VariantMatchStmt::Case& stmt) {}
-// void ScopeChecker::visit(IfStmt& stmt) {}
-// void ScopeChecker::visit(IfStmt::Elif& stmt) {}
-// void ScopeChecker::visit(IfStmt::Else& stmt) {}
-// void ScopeChecker::visit(ForStmt& stmt) {}
-// void ScopeChecker::visit(ForStmt::Range& stmt) {}
-// void ScopeChecker::visit(WhileStmt& stmt) {}
-// void ScopeChecker::visit(ContinueStmt& stmt) {}
-// void ScopeChecker::visit(BreakStmt& stmt) {}
-// void ScopeChecker::visit(ReturnStmt& stmt) {}
\ No newline at end of file
+void ScopeChecker::check(Program& program) { traverse(program); }
+
+/* ----------------------------- Global scope ------------------------------- */
+
+// Globals are numbered in the order of their definitions
+void ScopeChecker::visit(Program& program) {
+  m_globalCount = 0;
+  enterScope();
+
+  std::vector<Definition*> definitions;
+  for (auto& [name, definition] : program.definitions) definitions.push_back(definition.get());
+  for (auto* definition : inSourceOrder(std::move(definitions))) {
+    definition->storage = declare(definition->name, definition->position);
+  }
+}
+
+void ScopeChecker::postVisit(Program& program) {
+  exitScope();
+  program.globalCount = m_globalCount;
+}
+
+/* ------------------------------ Definitions ------------------------------- */
+
+void ScopeChecker::visit(StructDef& def) { declareLocal(def); }
+
+void ScopeChecker::visit(VariantDef& def) { declareLocal(def); }
+
+// Declared before the body is checked, so the function may call itself. Parameters take the first
+// slots of the new frame in the order they are written in.
+void ScopeChecker::visit(FnDef& def) {
+  declareLocal(def);
+  m_frames.emplace_back();
+  enterScope();
+
+  for (auto* param : parametersInOrder(def)) param->storage = declare(param->name, param->position);
+}
+
+void ScopeChecker::postVisit(FnDef& def) {
+  exitScope();
+  def.localCount = m_frames.back().localCount;
+  m_frames.pop_back();
+}
+
+// Declared after the value is checked, `var x: int = x;` does not see itself
+void ScopeChecker::postVisit(VarDef& def) { declareLocal(def); }
+
+void ScopeChecker::postVisit(ConstDef& def) { declareLocal(def); }
+
+/* ------------------------------- Statements ------------------------------- */
+
+void ScopeChecker::visit(BlockStmt&) { enterScope(); }
+
+void ScopeChecker::postVisit(BlockStmt&) { exitScope(); }
+
+// The range is evaluated outside of the loop, the iterator is visible only in the loop body
+void ScopeChecker::traverse(ForStmt& stmt) {
+  traverse(stmt.range);
+
+  enterScope();
+  stmt.storage = declare(stmt.identifier, stmt.position);
+  traverse(stmt.block);
+  exitScope();
+}
+
+/* ------------------------------- Expressions ------------------------------ */
+
+void ScopeChecker::visit(IdentifierExpr& expr) {
+  expr.storage = resolve(expr.name);
+  if (expr.storage.kind == Storage::Kind::Unresolved) {
+    m_errorHandler(ErrorType::UNDEFINED_IDENTIFIER, expr.position);
+  }
+}
+
+/* --------------------------------- Utils ---------------------------------- */
+
+/**
+ * @brief Slots of the locals declared in a scope are free again once it is left.
+ */
+void ScopeChecker::enterScope() {
+  m_stack.enterScope();
+  m_scopeSlots.push_back(m_frames.empty() ? 0 : m_frames.back().nextSlot);
+}
+
+void ScopeChecker::exitScope() {
+  m_stack.exitScope();
+  if (!m_frames.empty()) m_frames.back().nextSlot = m_scopeSlots.back();
+  m_scopeSlots.pop_back();
+}
+
+Storage ScopeChecker::declare(const Identifier& name, const Position& position) {
+  auto frame = static_cast<std::uint16_t>(m_frames.size());
+  auto declaration = m_frames.empty()
+                         ? Declaration{Storage::Kind::Global, frame, m_globalCount}
+                         : Declaration{Storage::Kind::Local, frame, m_frames.back().nextSlot};
+
+  if (!m_stack.insert(name, Declaration{declaration}).second) {
+    m_errorHandler(ErrorType::REDEFINITION, position);
+    return {};
+  }
+
+  if (declaration.kind == Storage::Kind::Global) {
+    m_globalCount++;
+  } else {
+    auto& current = m_frames.back();
+    current.nextSlot++;
+    current.localCount = std::max(current.localCount, current.nextSlot);
+  }
+  return {declaration.kind, 0, declaration.slot};
+}
+
+/**
+ * @brief Global definitions are all declared upfront when entering the program.
+ */
+void ScopeChecker::declareLocal(Definition& def) {
+  if (m_stack.depth() > 1) {
+    def.storage = declare(def.name, def.position);
+  }
+}
+
+Storage ScopeChecker::resolve(const Identifier& name) const {
+  const auto* declaration = m_stack.find(name);
+  if (declaration == nullptr) return {};
+  if (declaration->kind == Storage::Kind::Global) {
+    return {Storage::Kind::Global, 0, declaration->slot};
+  }
+
+  auto depth = static_cast<std::uint16_t>(m_frames.size() - declaration->frame);
+  return {Storage::Kind::Local, depth, declaration->slot};
+}
@@ -1,58 +1,71 @@
 #pragma once
 
-#include <variant>
+#include <cstdint>
+#include <vector>
 
 #include "ErrorHandler.h"
+#include "RecursiveASTVisitor.h"
 #include "ScopedTable.h"
 
-class ScopeChecker : public ASTVisitor {
+/**
+ * @brief Checks that every identifier is defined before use and that no name is defined twice in
+ * the same scope. Global definitions are visible everywhere, local ones from the point of their
+ * definition until the end of the enclosing block. Inner scopes may shadow outer names.
+ *
+ * Resolves names to their Storage on the way: definitions, parameters, loop variables and every
+ * IdentifierExpr (including assignment targets) are annotated, each FnDef records the size of its
+ * frame and the Program the number of globals. Locals of sibling blocks share slots.
+ */
+class ScopeChecker : public RecursiveASTVisitor<ScopeChecker> {
  public:
   ScopeChecker(ErrorHandler& errorHandler);
 
-  void visit(Program& program) override;
-
-  void visit(VarDef& def) override;
-  void visit(ConstDef& def) override;
-  void visit(StructDef& def) override;
-  void visit(VariantDef& def) override;
-  void visit(FnDef& def) override;
-
-  void visit(BinaryExpression& expr) override;
-  void visit(UnaryExpression& expr) override;
-  void visit(FunctionalExpression& expr) override;
-  void visit(FunctionalExpression::Postfix& postfix) override;
-  void visit(MemberAccess::Postfix& postfix) override;
-  void visit(VariantAccess::Postfix& postfix) override;
-  void visit(FnCall::Postfix& postfix) override;
-  void visit(PrimaryExpression& expr) override;
-  void visit(IdentifierExpr& expr) override;
-  void visit(Literal<int>& expr) override;
-  void visit(Literal<float>& expr) override;
-  void visit(Literal<bool>& expr) override;
-  void visit(Literal<wchar_t>& expr) override;
-  void visit(Literal<std::wstring>& expr) override;
-  void visit(Object& expr) override;
-  void visit(ParenExpr& expr) override;
-  void visit(CastExpr& expr) override;
-
-  void visit(BlockStmt& stmt) override;
-  void visit(AssignmentStmt& stmt) override;
-  void visit(StdinExtractionStmt& stmt) override;
-  void visit(StdoutInsertionStmt& stmt) override;
-  void visit(VariantMatchStmt& stmt) override;
-  void visit(VariantMatchStmt::Case& stmt) override;
-  void visit(IfStmt& stmt) override;
-  void visit(IfStmt::Elif& stmt) override;
-  void visit(IfStmt::Else& stmt) override;
-  void visit(ForStmt& stmt) override;
-  void visit(ForStmt::Range& stmt) override;
-  void visit(WhileStmt& stmt) override;
-  void visit(ContinueStmt& stmt) override;
-  void visit(BreakStmt& stmt) override;
-  void visit(ReturnStmt& stmt) override;
+  void check(Program& program);
+
+  using RecursiveASTVisitor::traverse;
+  void traverse(ForStmt& stmt);
 
  private:
-  ScopedTable<std::monostate> m_stack;
+  friend class RecursiveASTVisitor<ScopeChecker>;
+
+  struct Declaration {
+    Storage::Kind kind;
+    std::uint16_t frame;  // Nesting level of the declaring function
+    std::uint32_t slot;
+  };
+
+  struct Frame {
+    std::uint32_t nextSlot = 0;
+    std::uint32_t localCount = 0;
+  };
+
+  void visit(Program& program);
+  void postVisit(Program& program);
+
+  void visit(StructDef& def);
+  void visit(VariantDef& def);
+  void visit(FnDef& def);
+  void postVisit(FnDef& def);
+  void postVisit(VarDef& def);
+  void postVisit(ConstDef& def);
+
+  void visit(BlockStmt& stmt);
+  void postVisit(BlockStmt& stmt);
+
+  void visit(IdentifierExpr& expr);
+
+  void enterScope();
+  void exitScope();
+
+  Storage declare(const Identifier& name, const Position& position);
+  void declareLocal(Definition& def);
+  Storage resolve(const Identifier& name) const;
+
+  ScopedTable<Declaration> m_stack;
+
+  std::vector<Frame> m_frames;
+  std::vector<std::uint32_t> m_scopeSlots;  // Next free slot when each scope was entered
+  std::uint32_t m_globalCount = 0;
 
   ErrorHandler& m_errorHandler;
 };
@@ -1,12 +1,27 @@
 #pragma once
 
-#include <stack>
-#include <unordered_map>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
 
+#include "ASTNode.h"
+
+/**
+ * @brief Symbol table with nested scopes, stored flat: a single open-addressing table holds every
+ * name ever inserted (the name is interned once, its hash is kept), each entry points to the
+ * innermost binding of the name. Bindings form an undo log in the order of insertion, each one
+ * remembering the binding it shadows, so leaving a scope pops only the bindings made in it.
+ *
+ * Lookups hash the name once no matter how deeply scopes nest. Pointers to values stay valid until
+ * the next insert.
+ */
 template <typename T>
 class ScopedTable {
  public:
-  ScopedTable() = default;
+  ScopedTable() : m_entries(INITIAL_CAPACITY) {}
   ~ScopedTable() = default;
 
   ScopedTable(const ScopedTable&) = delete;
@@ -14,33 +29,119 @@ class ScopedTable {
   ScopedTable& operator=(const ScopedTable&) = delete;
   ScopedTable& operator=(ScopedTable&&) = delete;
 
-  void enterScope() noexcept { m_scopes.push(T()); }
+  void enterScope() { m_scopeStarts.push_back(m_bindings.size()); }
 
   void exitScope() {
-    if (!m_scopes.empty()) {
-      m_scopes.pop();
+    if (m_scopeStarts.empty()) {
+      throw std::logic_error("Empty ScopedTable!");
     }
-    throw std::logic_error("Empty ScopedTable!");
-  }
+    auto start = m_scopeStarts.back();
+    m_scopeStarts.pop_back();
 
-  auto insert(const Identifier& id, T&& value) {
-    if (!m_scopes.empty()) {
-      return m_scopes.top().insert({id, std::move(value)});
+    while (m_bindings.size() > start) {
+      auto& binding = m_bindings.back();
+      m_entries[binding.entry].innermost = binding.shadowed;
+      m_bindings.pop_back();
     }
-    throw std::logic_error("Empty ScopedTable!");
   }
 
-  bool contains(const Identifier& id) const noexcept {
-    for (auto it = m_scopes.crbegin(); it != m_scopes.crend(); ++it) {
-      if (it->contains(id)) {
-        return true;
-      }
+  /**
+   * @return The value bound to `id` in the current scope and whether it was inserted, like
+   * std::unordered_map::insert.
+   */
+  std::pair<T*, bool> insert(const Identifier& id, T&& value) {
+    if (m_scopeStarts.empty()) {
+      throw std::logic_error("Empty ScopedTable!");
+    }
+
+    auto entry = intern(id);
+    auto innermost = m_entries[entry].innermost;
+    if (innermost != NONE && innermost >= m_scopeStarts.back()) {
+      return {&m_bindings[innermost].value, false};
     }
-    return false;
+
+    m_bindings.push_back({std::move(value), entry, innermost});
+    m_entries[entry].innermost = static_cast<std::uint32_t>(m_bindings.size() - 1);
+    return {&m_bindings.back().value, true};
   }
 
+  bool contains(const Identifier& id) const noexcept { return find(id) != nullptr; }
+
+  /**
+   * @brief Finds the value of the innermost declaration of `id`.
+   */
+  const T* find(const Identifier& id) const noexcept {
+    auto entry = lookup(id, hashOf(id));
+    if (!m_entries[entry].occupied || m_entries[entry].innermost == NONE) return nullptr;
+    return &m_bindings[m_entries[entry].innermost].value;
+  }
+
+  std::size_t depth() const noexcept { return m_scopeStarts.size(); }
+
  private:
-  using Scope = std::unordered_map<Identifier, T>;
+  static constexpr std::uint32_t NONE = UINT32_MAX;
+  static constexpr std::size_t INITIAL_CAPACITY = 64;  // Power of two
+
+  struct Entry {
+    Identifier name;
+    std::size_t hash = 0;
+    std::uint32_t innermost = NONE;  // Index of the binding in scope, if any
+    bool occupied = false;
+  };
+
+  struct Binding {
+    T value;
+    std::uint32_t entry;
+    std::uint32_t shadowed;  // Binding of the same name in an enclosing scope
+  };
+
+  static std::size_t hashOf(const Identifier& id) noexcept {
+    return std::hash<std::wstring_view>{}(id);
+  }
+
+  // Index of the entry of `id`, or of the free entry where it belongs
+  std::size_t lookup(const Identifier& id, std::size_t hash) const noexcept {
+    auto mask = m_entries.size() - 1;
+    for (auto index = hash & mask;; index = (index + 1) & mask) {
+      const auto& entry = m_entries[index];
+      if (!entry.occupied || (entry.hash == hash && entry.name == id)) return index;
+    }
+  }
+
+  std::uint32_t intern(const Identifier& id) {
+    auto hash = hashOf(id);
+    auto index = lookup(id, hash);
+    if (m_entries[index].occupied) return static_cast<std::uint32_t>(index);
+
+    // Keeps the load factor at most 1/2
+    if (2 * (m_names + 1) > m_entries.size()) {
+      grow();
+      index = lookup(id, hash);
+    }
+    m_entries[index] = Entry{id, hash, NONE, true};
+    m_names++;
+    return static_cast<std::uint32_t>(index);
+  }
+
+  void grow() {
+    std::vector<Entry> entries(2 * m_entries.size());
+    std::vector<std::uint32_t> moved(m_entries.size(), NONE);
+    auto mask = entries.size() - 1;
+
+    for (std::size_t i = 0; i < m_entries.size(); i++) {
+      if (!m_entries[i].occupied) continue;
+      auto index = m_entries[i].hash & mask;
+      while (entries[index].occupied) index = (index + 1) & mask;
+      entries[index] = std::move(m_entries[i]);
+      moved[i] = static_cast<std::uint32_t>(index);
+    }
+    for (auto& binding : m_bindings) binding.entry = moved[binding.entry];
+    m_entries = std::move(entries);
+  }
+
+  std::vector<Entry> m_entries;
+  std::size_t m_names = 0;
 
-  std::stack<Scope> m_scopes;
+  std::vector<Binding> m_bindings;
+  std::vector<std::size_t> m_scopeStarts;  // Number of bindings when each scope was entered
 };
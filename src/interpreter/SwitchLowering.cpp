@@ -0,0 +1,122 @@
+#include <algorithm>
+#include <optional>
+#include <vector>
+
+#include "Casting.h"
+#include "ConstantFolding.h"
+#include "ExpressionDeduplication.h"
+#include "RecursiveASTVisitor.h"
+#include "SwitchLowering.h"
+
+namespace {
+
+constexpr std::size_t MIN_BRANCHES = 3;
+
+/**
+ * @brief A condition of the chain, `subject == constant` or `constant == subject`.
+ */
+struct Comparison {
+  std::unique_ptr<Expression>* condition;  // With the parentheses around it stripped
+  Expression* subject;
+  int constant;
+};
+
+class SwitchLowering : public RecursiveASTVisitor<SwitchLowering> {
+ public:
+  SwitchReport report;
+
+  void postVisit(IfStmt& stmt) {
+    std::vector<Comparison> comparisons;
+    if (!collect(stmt.condition, comparisons)) return;
+    for (auto& elif : stmt.elifs) {
+      if (!collect(elif.condition, comparisons)) return;
+    }
+    if (comparisons.size() < MIN_BRANCHES) return;
+
+    const auto& subject = *comparisons.front().subject;
+    if (!isPureExpression(subject)) return;
+    if (subject.typeId != INT_TYPE && subject.typeId != CHAR_TYPE) return;
+
+    std::vector<std::pair<int, std::uint32_t>> branches;
+    for (std::uint32_t i = 0; i < comparisons.size(); i++) {
+      if (!structurallyEqual(*comparisons[i].subject, subject)) return;
+      branches.emplace_back(comparisons[i].constant, i + 1);
+    }
+    std::sort(branches.begin(), branches.end());
+    auto duplicate = std::adjacent_find(branches.begin(), branches.end(),
+                                        [](auto lhs, auto rhs) { return lhs.first == rhs.first; });
+    if (duplicate != branches.end()) return;
+
+    for (auto& comparison : comparisons) normalize(comparison);
+    stmt.switchTable = table(std::move(branches));
+  }
+
+ private:
+  static bool collect(std::unique_ptr<Expression>& condition, std::vector<Comparison>& into) {
+    auto* slot = &condition;
+    while (auto paren = dyn_cast<ParenExpr>(slot->get())) slot = &paren->expr;
+
+    auto binary = dyn_cast<BinaryExpression>(slot->get());
+    if (binary == nullptr || binary->op != Operator::Eq) return false;
+    if (auto constant = constantOf(*binary->rhs)) {
+      into.push_back({&condition, binary->lhs.get(), *constant});
+    } else if (auto constant = constantOf(*binary->lhs)) {
+      into.push_back({&condition, binary->rhs.get(), *constant});
+    } else {
+      return false;
+    }
+    return true;
+  }
+
+  static std::optional<int> constantOf(const Expression& expr) {
+    auto value = literalValue(expr);
+    if (!value.has_value()) return std::nullopt;
+    if (auto integer = std::get_if<int>(&*value)) return *integer;
+    if (auto character = std::get_if<wchar_t>(&*value)) return static_cast<int>(*character);
+    return std::nullopt;
+  }
+
+  // Into `subject == constant`, without parentheses around it
+  static void normalize(const Comparison& comparison) {
+    auto& condition = *comparison.condition;
+    while (auto paren = dyn_cast<ParenExpr>(condition.get())) {
+      auto typeId = paren->typeId;
+      condition = std::move(paren->expr);
+      condition->typeId = typeId;
+    }
+
+    auto& binary = cast<BinaryExpression>(*condition);
+    if (binary.rhs.get() == comparison.subject) std::swap(binary.lhs, binary.rhs);
+  }
+
+  std::unique_ptr<SwitchTable> table(std::vector<std::pair<int, std::uint32_t>>&& branches) {
+    auto table = std::make_unique<SwitchTable>();
+    auto min = static_cast<long long>(branches.front().first);
+    auto range = static_cast<long long>(branches.back().first) - min + 1;
+
+    if (range <= 2 * static_cast<long long>(branches.size())) {
+      table->min = branches.front().first;
+      table->dense.assign(static_cast<std::size_t>(range), 0);
+      for (auto [constant, branch] : branches) table->dense[constant - min] = branch;
+      report.jumpTables++;
+    } else {
+      table->sparse = std::move(branches);
+      report.binarySearches++;
+    }
+    return table;
+  }
+};
+
+}  // namespace
+
+SwitchReport lowerSwitches(Program& program) {
+  SwitchLowering lowering;
+  lowering.traverse(program);
+  return lowering.report;
+}
+
+void printSwitchReport(std::ostream& out, const SwitchReport& report) {
+  out << "Switches\n";
+  out << "  " << report.jumpTables << " jump tables, " << report.binarySearches
+      << " binary searches\n";
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+
+#include "Program.h"
+
+struct SwitchReport {
+  std::size_t jumpTables = 0;
+  std::size_t binarySearches = 0;
+};
+
+/**
+ * @brief Lowers if statements whose condition and elif conditions all compare one expression with
+ * distinct int or char literals, e.g. `move == 1` ... `move == 9`, so the branch is found with a
+ * single evaluation of the expression (IfStmt::switchTable). The table is dense when the
+ * literals cover at least half of their range, and searched in binary otherwise.
+ *
+ * The compared expression must be pure (see isPureExpression()), so evaluating it once instead of
+ * once per condition changes nothing. Conditions are normalized to `expression == literal`, the
+ * Evaluator reads the expression off the left of the first one. Chains of less than three
+ * comparisons are left alone.
+ *
+ * The program must be type-checked and its names resolved, and no later pass may rewrite the
+ * conditions of the lowered statements.
+ */
+SwitchReport lowerSwitches(Program& program);
+
+void printSwitchReport(std::ostream& out, const SwitchReport& report);
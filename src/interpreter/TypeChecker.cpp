@@ -0,0 +1,479 @@
+#include <algorithm>
+#include <type_traits>
+
+#include "ASTUtils.h"
+#include "TypeChecker.h"
+
+namespace {
+
+/**
+ * @brief Every primitive converts to a string, ints to and from the other primitives except
+ * strings, which are not parsed.
+ */
+bool isCastable(TypeId from, TypeId to) {
+  if (from == to || to == STRING_TYPE) return true;
+  switch (from) {
+    case INT_TYPE:
+      return to == FLOAT_TYPE || to == BOOL_TYPE || to == CHAR_TYPE;
+    case FLOAT_TYPE:
+    case BOOL_TYPE:
+    case CHAR_TYPE:
+      return to == INT_TYPE;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+TypeChecker::TypeChecker(ErrorHandler& errorHandler) : m_errorHandler{errorHandler} {}
+
+void TypeChecker::check(Program& program) { traverse(program); }
+
+/* ----------------------------- Global scope ------------------------------- */
+
+// Global types are declared before any is defined, so they may refer to each other
+void TypeChecker::visit(Program& program) {
+  m_types = &program.types;
+  m_stack.enterScope();
+
+  std::vector<Definition*> definitions;
+  for (auto& [name, definition] : program.definitions) definitions.push_back(definition.get());
+  definitions = inSourceOrder(std::move(definitions));
+
+  for (auto* definition : definitions) declareTypes(*definition);
+  for (auto* definition : definitions) defineTypes(*definition);
+  m_types->layOutStructs();
+  for (auto* definition : definitions) declareValue(*definition);
+}
+
+void TypeChecker::postVisit(Program&) { m_stack.exitScope(); }
+
+/* ------------------------------ Definitions ------------------------------- */
+
+void TypeChecker::visit(StructDef& def) {
+  if (m_stack.depth() > 1) {
+    declareTypes(def);
+    defineTypes(def);
+    m_types->layOutStructs();
+  }
+}
+
+void TypeChecker::visit(VariantDef& def) {
+  if (m_stack.depth() > 1) {
+    declareTypes(def);
+    defineTypes(def);
+  }
+}
+
+// Declared before the body is checked, so the function may call itself
+void TypeChecker::visit(FnDef& def) {
+  if (m_stack.depth() > 1) declareValue(def);
+  m_returnTypes.push_back((*m_types)[def.typeId].result);
+
+  m_stack.enterScope();
+  for (auto& [name, param] : def.parameters) {
+    declare(name, {Symbol::Kind::Value, param.typeId, param.isConst});
+  }
+}
+
+void TypeChecker::postVisit(FnDef&) {
+  m_stack.exitScope();
+  m_returnTypes.pop_back();
+}
+
+// Declared after the value is checked, `var x: int = x;` does not see itself
+void TypeChecker::postVisit(VarDef& def) {
+  bool local = m_stack.depth() > 1;
+  if (local) def.typeId = resolveType(def.type, def.position);
+  expectType(*def.value, def.typeId);
+  if (local) declare(def.name, {Symbol::Kind::Value, def.typeId});
+}
+
+void TypeChecker::postVisit(ConstDef& def) {
+  bool local = m_stack.depth() > 1;
+  if (local) def.typeId = resolveType(def.type, def.position);
+  expectType(*def.value, def.typeId);
+  if (local) declare(def.name, {Symbol::Kind::Value, def.typeId, true});
+}
+
+/* ------------------------------- Statements ------------------------------- */
+
+void TypeChecker::visit(BlockStmt&) { m_stack.enterScope(); }
+
+void TypeChecker::postVisit(BlockStmt&) { m_stack.exitScope(); }
+
+void TypeChecker::postVisit(AssignmentStmt& stmt) {
+  if (!isAssignable(*stmt.lhs)) {
+    m_errorHandler(ErrorType::NOT_ASSIGNABLE, stmt.lhs->position);
+    return;
+  }
+  if (isConst(*stmt.lhs)) {
+    m_errorHandler(ErrorType::CONST_ASSIGNMENT, stmt.lhs->position);
+    return;
+  }
+  expectType(*stmt.rhs, stmt.lhs->typeId);
+}
+
+void TypeChecker::postVisit(StdinExtractionStmt& stmt) {
+  for (auto& expr : stmt.expressions) {
+    if (!isAssignable(*expr)) {
+      m_errorHandler(ErrorType::NOT_ASSIGNABLE, expr->position);
+    } else if (isConst(*expr)) {
+      m_errorHandler(ErrorType::CONST_ASSIGNMENT, expr->position);
+    } else if (expr->typeId != ERROR_TYPE && !m_types->isPrimitive(expr->typeId)) {
+      m_errorHandler(ErrorType::INVALID_IO_OPERAND, expr->position);
+    }
+  }
+}
+
+void TypeChecker::postVisit(StdoutInsertionStmt& stmt) {
+  for (auto& expr : stmt.expressions) {
+    if (expr->typeId != ERROR_TYPE && !m_types->isPrimitive(expr->typeId)) {
+      m_errorHandler(ErrorType::INVALID_IO_OPERAND, expr->position);
+    }
+  }
+}
+
+void TypeChecker::postVisit(VariantMatchStmt& stmt) {
+  auto variant = stmt.expr->typeId;
+  if (variant == ERROR_TYPE) return;
+  if ((*m_types)[variant].kind != TypeKind::Variant) {
+    m_errorHandler(ErrorType::TYPE_MISMATCH, stmt.expr->position);
+    return;
+  }
+
+  // The cases are dispatched on through a table indexed by the tag of the alternative
+  auto& table = stmt.jumpTable;
+  table.assign((*m_types)[variant].alternatives.size(), nullptr);
+  bool resolved = true;
+  for (auto& [name, matchCase] : stmt.cases) {
+    auto type = resolveType(matchCase.variant, matchCase.position);
+    matchCase.typeId = type;
+    auto tag = m_types->tag(variant, type);
+    if (type == ERROR_TYPE) {
+      resolved = false;
+    } else if (!tag.has_value()) {
+      m_errorHandler(ErrorType::INVALID_MATCH_CASE, matchCase.position);
+    } else {
+      matchCase.tag = *tag;
+      table[*tag] = &matchCase;
+    }
+  }
+
+  if (resolved && std::find(table.begin(), table.end(), nullptr) != table.end()) {
+    m_errorHandler(ErrorType::NON_EXHAUSTIVE_MATCH, stmt.position);
+  }
+}
+
+void TypeChecker::postVisit(IfStmt& stmt) { expectType(*stmt.condition, BOOL_TYPE); }
+
+void TypeChecker::postVisit(Elif& elif) { expectType(*elif.condition, BOOL_TYPE); }
+
+void TypeChecker::postVisit(Range& range) {
+  expectType(*range.start, INT_TYPE);
+  expectType(*range.end, INT_TYPE);
+}
+
+// The range is checked outside of the loop, the iterator is visible only in the loop body
+void TypeChecker::traverse(ForStmt& stmt) {
+  traverse(stmt.range);
+
+  m_stack.enterScope();
+  declare(stmt.identifier, {Symbol::Kind::Value, INT_TYPE});
+  traverse(stmt.block);
+  m_stack.exitScope();
+}
+
+void TypeChecker::postVisit(WhileStmt& stmt) { expectType(*stmt.condition, BOOL_TYPE); }
+
+void TypeChecker::postVisit(ReturnStmt& stmt) {
+  auto returnType = m_returnTypes.back();
+  if (stmt.expr != nullptr) {
+    expectType(*stmt.expr, returnType);
+  } else if (returnType != ERROR_TYPE) {
+    m_errorHandler(ErrorType::TYPE_MISMATCH, stmt.position);
+  }
+}
+
+/* ------------------------------- Expressions ------------------------------ */
+
+void TypeChecker::postVisit(BinaryExpression& expr) {
+  auto lhs = expr.lhs->typeId;
+  auto rhs = expr.rhs->typeId;
+  if (lhs == ERROR_TYPE || rhs == ERROR_TYPE || !expr.op.has_value()) return;
+
+  auto result = ERROR_TYPE;
+  if (lhs == rhs) {
+    switch (*expr.op) {
+      case Operator::Add:
+        if (m_types->isNumeric(lhs) || lhs == STRING_TYPE) result = lhs;
+        break;
+      case Operator::Sub:
+      case Operator::Mul:
+      case Operator::Div:
+        if (m_types->isNumeric(lhs)) result = lhs;
+        break;
+      case Operator::Mod:
+        if (lhs == INT_TYPE) result = INT_TYPE;
+        break;
+      case Operator::And:
+      case Operator::Or:
+        if (lhs == BOOL_TYPE) result = BOOL_TYPE;
+        break;
+      case Operator::Eq:
+      case Operator::Neq:
+        if (m_types->isPrimitive(lhs)) result = BOOL_TYPE;
+        break;
+      case Operator::Lt:
+      case Operator::Gt:
+      case Operator::Leq:
+      case Operator::Geq:
+        if (m_types->isNumeric(lhs) || lhs == CHAR_TYPE) result = BOOL_TYPE;
+        break;
+      case Operator::Not:
+        break;
+    }
+  }
+
+  if (result == ERROR_TYPE) m_errorHandler(ErrorType::INVALID_OPERAND_TYPES, expr.position);
+  expr.typeId = result;
+}
+
+void TypeChecker::postVisit(UnaryExpression& expr) {
+  auto operand = expr.expr->typeId;
+  if (operand == ERROR_TYPE || !expr.op.has_value()) return;
+
+  auto result = ERROR_TYPE;
+  if (*expr.op == Operator::Not && operand == BOOL_TYPE) result = BOOL_TYPE;
+  if (*expr.op == Operator::Sub && m_types->isNumeric(operand)) result = operand;
+
+  if (result == ERROR_TYPE) m_errorHandler(ErrorType::INVALID_OPERAND_TYPES, expr.position);
+  expr.typeId = result;
+}
+
+void TypeChecker::postVisit(FunctionalExpression& expr) {
+  if (expr.expr->typeId == ERROR_TYPE) return;
+
+  if (auto call = dyn_cast<FnCallPostfix>(expr.postfix.get())) {
+    expr.typeId = callType(expr, *call);
+  } else if (auto member = dyn_cast<MemberAccessPostfix>(expr.postfix.get())) {
+    expr.typeId = memberType(expr, *member);
+  } else {
+    expr.typeId = variantAccessType(expr, cast<VariantAccessPostfix>(*expr.postfix));
+  }
+}
+
+TypeId TypeChecker::callType(FunctionalExpression& expr, FnCallPostfix& call) {
+  const auto& callee = (*m_types)[expr.expr->typeId];
+  if (callee.kind != TypeKind::Function) {
+    m_errorHandler(ErrorType::NOT_CALLABLE, expr.position);
+    return ERROR_TYPE;
+  }
+
+  if (call.args.size() != callee.parameters.size()) {
+    m_errorHandler(ErrorType::ARGUMENT_COUNT_MISMATCH, call.position);
+  } else {
+    for (std::size_t i = 0; i < call.args.size(); i++) {
+      expectType(*call.args[i], callee.parameters[i]);
+    }
+  }
+  return callee.result;
+}
+
+TypeId TypeChecker::memberType(FunctionalExpression& expr, MemberAccessPostfix& access) {
+  auto structType = expr.expr->typeId;
+  std::optional<std::size_t> index;
+  if ((*m_types)[structType].kind == TypeKind::Struct) {
+    index = m_types->memberIndex(structType, access.member);
+  }
+
+  if (!index.has_value()) {
+    m_errorHandler(ErrorType::UNKNOWN_MEMBER, access.position);
+    return ERROR_TYPE;
+  }
+  access.offset = (*m_types)[structType].offsets[*index];
+  return (*m_types)[structType].members[*index].type;
+}
+
+TypeId TypeChecker::variantAccessType(FunctionalExpression& expr, VariantAccessPostfix& access) {
+  auto variant = expr.expr->typeId;
+  auto type = resolveType(access.variant, access.position);
+  if (type == ERROR_TYPE) return ERROR_TYPE;
+
+  auto tag = (*m_types)[variant].kind == TypeKind::Variant ? m_types->tag(variant, type)
+                                                            : std::nullopt;
+  if (!tag.has_value()) {
+    m_errorHandler(ErrorType::INVALID_VARIANT_ACCESS, access.position);
+  } else {
+    access.tag = *tag;
+  }
+  return type;
+}
+
+void TypeChecker::postVisit(IdentifierExpr& expr) {
+  const auto* symbol = m_stack.find(expr.name);
+  if (symbol == nullptr) return;
+
+  if (symbol->kind == Symbol::Kind::Type) {
+    m_errorHandler(ErrorType::EXPECTED_VALUE, expr.position);
+    return;
+  }
+  expr.typeId = symbol->type;
+}
+
+template <typename T>
+void TypeChecker::postVisit(Literal<T>& expr) {
+  if constexpr (std::is_same_v<T, int>) {
+    expr.typeId = INT_TYPE;
+  } else if constexpr (std::is_same_v<T, float>) {
+    expr.typeId = FLOAT_TYPE;
+  } else if constexpr (std::is_same_v<T, bool>) {
+    expr.typeId = BOOL_TYPE;
+  } else if constexpr (std::is_same_v<T, wchar_t>) {
+    expr.typeId = CHAR_TYPE;
+  } else {
+    expr.typeId = STRING_TYPE;
+  }
+}
+
+void TypeChecker::postVisit(Object& expr) {
+  std::vector<StructField> members;
+  for (auto& [name, member] : expr.members) members.push_back({name, member.value->typeId});
+  expr.typeId = m_types->object(std::move(members));
+}
+
+void TypeChecker::postVisit(ParenExpr& expr) { expr.typeId = expr.expr->typeId; }
+
+void TypeChecker::postVisit(CastExpr& expr) {
+  expr.typeId = TypeTable::primitive(expr.type);
+
+  auto operand = expr.expr->typeId;
+  if (operand == ERROR_TYPE) return;
+  if (!m_types->isPrimitive(operand) || !isCastable(operand, expr.typeId)) {
+    m_errorHandler(ErrorType::INVALID_CAST, expr.position);
+  }
+}
+
+void TypeChecker::postVisit(SharedExpr& expr) { expr.typeId = expr.expr->typeId; }
+
+/* --------------------------------- Utils ---------------------------------- */
+
+void TypeChecker::declareTypes(Definition& def) {
+  if (isa<StructDef>(def)) {
+    def.typeId = m_types->declareStruct(def.name);
+  } else if (isa<VariantDef>(def)) {
+    def.typeId = m_types->declareVariant(def.name);
+  } else {
+    return;
+  }
+  declare(def.name, {Symbol::Kind::Type, def.typeId});
+}
+
+// Struct members are kept in the order of definition
+void TypeChecker::defineTypes(Definition& def) {
+  if (auto structDef = dyn_cast<StructDef>(&def)) {
+    std::vector<StructMember*> members;
+    for (auto& [name, member] : structDef->members) members.push_back(&member);
+
+    std::vector<StructField> fields;
+    for (auto* member : inSourceOrder(std::move(members))) {
+      fields.push_back({member->name, resolveType(member->type, member->position)});
+    }
+    m_types->defineStruct(def.typeId, std::move(fields));
+  } else if (auto variantDef = dyn_cast<VariantDef>(&def)) {
+    std::vector<TypeId> alternatives;
+    for (auto& type : variantDef->types) alternatives.push_back(resolveType(type, def.position));
+    m_types->defineVariant(def.typeId, std::move(alternatives));
+  }
+}
+
+void TypeChecker::declareValue(Definition& def) {
+  if (auto fnDef = dyn_cast<FnDef>(&def)) {
+    def.typeId = functionType(*fnDef);
+    declare(def.name, {Symbol::Kind::Function, def.typeId});
+  } else if (auto varDef = dyn_cast<VarDef>(&def)) {
+    def.typeId = resolveType(varDef->type, def.position);
+    declare(def.name, {Symbol::Kind::Value, def.typeId});
+  } else if (auto constDef = dyn_cast<ConstDef>(&def)) {
+    def.typeId = resolveType(constDef->type, def.position);
+    declare(def.name, {Symbol::Kind::Value, def.typeId, true});
+  }
+}
+
+// Parameters are passed in the order they are written in
+TypeId TypeChecker::functionType(FnDef& def) {
+  std::vector<TypeId> parameterTypes;
+  for (auto* param : parametersInOrder(def)) {
+    param->typeId = resolveType(param->type, param->position);
+    parameterTypes.push_back(param->typeId);
+  }
+  return m_types->function(std::move(parameterTypes), resolveType(def.returnType, def.position));
+}
+
+TypeId TypeChecker::resolveType(const TypeIdentifier& name, const Position& position) {
+  if (auto primitive = m_types->primitive(name)) return *primitive;
+
+  const auto* symbol = m_stack.find(name);
+  if (symbol == nullptr || symbol->kind != Symbol::Kind::Type) {
+    m_errorHandler(ErrorType::UNKNOWN_TYPE, position);
+    return ERROR_TYPE;
+  }
+  return symbol->type;
+}
+
+/**
+ * @brief Converts object literals to the struct type, the other conversions need no annotation.
+ */
+bool TypeChecker::convertible(Expression& expr, TypeId target) {
+  auto source = expr.typeId;
+  if (source == ERROR_TYPE || target == ERROR_TYPE || source == target) return true;
+
+  const auto& type = (*m_types)[target];
+  if (type.kind == TypeKind::Variant) return m_types->hasAlternative(target, source);
+
+  auto object = dyn_cast<Object>(&expr);
+  if (object == nullptr || type.kind != TypeKind::Struct || type.name.empty() ||
+      object->members.size() != type.members.size()) {
+    return false;
+  }
+  for (const auto& field : type.members) {
+    auto member = object->members.find(field.name);
+    if (member == object->members.end() || !convertible(*member->second.value, field.type)) {
+      return false;
+    }
+  }
+  object->typeId = target;
+  return true;
+}
+
+void TypeChecker::expectType(Expression& expr, TypeId target) {
+  if (!convertible(expr, target)) m_errorHandler(ErrorType::TYPE_MISMATCH, expr.position);
+}
+
+bool TypeChecker::isAssignable(const Expression& expr) const {
+  if (auto identifier = dyn_cast<IdentifierExpr>(&expr)) {
+    const auto* symbol = m_stack.find(identifier->name);
+    return symbol == nullptr || symbol->kind == Symbol::Kind::Value;
+  }
+  if (auto functional = dyn_cast<FunctionalExpression>(&expr)) {
+    return isa<MemberAccessPostfix>(functional->postfix.get()) && isAssignable(*functional->expr);
+  }
+  if (auto shared = dyn_cast<SharedExpr>(&expr)) return isAssignable(*shared->expr);
+  return false;
+}
+
+// Members of a const are written through the variable holding them, they are const as well
+bool TypeChecker::isConst(const Expression& expr) const {
+  if (auto identifier = dyn_cast<IdentifierExpr>(&expr)) {
+    const auto* symbol = m_stack.find(identifier->name);
+    return symbol != nullptr && symbol->isConst;
+  }
+  if (auto functional = dyn_cast<FunctionalExpression>(&expr)) return isConst(*functional->expr);
+  if (auto shared = dyn_cast<SharedExpr>(&expr)) return isConst(*shared->expr);
+  return false;
+}
+
+void TypeChecker::declare(const Identifier& name, Symbol&& symbol) {
+  m_stack.insert(name, std::move(symbol));
+}
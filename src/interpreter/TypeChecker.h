@@ -0,0 +1,108 @@
+#pragma once
+
+#include <vector>
+
+#include "ErrorHandler.h"
+#include "RecursiveASTVisitor.h"
+#include "ScopedTable.h"
+#include "Types.h"
+
+/**
+ * @brief Interns every type of the program into `Program::types` and annotates each expression
+ * and definition with its TypeId, checking on the way:
+ *  - definitions, assignments, arguments and returns against the declared types,
+ *  - operands of operators, casts and stdin/stdout operations,
+ *  - member and variant accesses, and that every match handles each type of its variant,
+ *  - that consts and const parameters are never written, neither whole nor their members.
+ *
+ * Values convert implicitly only from a type to a variant holding it and from an object literal
+ * to a struct with the same members, the literal is then annotated with the struct type.
+ *
+ * Meant to run after the ScopeChecker, names it could not resolve are left as ERROR_TYPE without
+ * further reports, as is everything depending on an ill-typed value.
+ */
+class TypeChecker : public RecursiveASTVisitor<TypeChecker> {
+ public:
+  TypeChecker(ErrorHandler& errorHandler);
+
+  void check(Program& program);
+
+  using RecursiveASTVisitor::traverse;
+  void traverse(ForStmt& stmt);
+
+ private:
+  friend class RecursiveASTVisitor<TypeChecker>;
+
+  struct Symbol {
+    enum class Kind : std::uint8_t { Value, Function, Type };
+
+    Kind kind;
+    TypeId type;
+    bool isConst = false;  // Consts and const parameters, neither they nor members are written
+  };
+
+  /* ------------------------------ Definitions ----------------------------- */
+
+  void visit(Program& program);
+  void postVisit(Program& program);
+
+  void visit(StructDef& def);
+  void visit(VariantDef& def);
+  void visit(FnDef& def);
+  void postVisit(FnDef& def);
+  void postVisit(VarDef& def);
+  void postVisit(ConstDef& def);
+
+  /* ------------------------------- Statements ----------------------------- */
+
+  void visit(BlockStmt& stmt);
+  void postVisit(BlockStmt& stmt);
+
+  void postVisit(AssignmentStmt& stmt);
+  void postVisit(StdinExtractionStmt& stmt);
+  void postVisit(StdoutInsertionStmt& stmt);
+  void postVisit(VariantMatchStmt& stmt);
+  void postVisit(IfStmt& stmt);
+  void postVisit(Elif& elif);
+  void postVisit(Range& range);
+  void postVisit(WhileStmt& stmt);
+  void postVisit(ReturnStmt& stmt);
+
+  /* ------------------------------ Expressions ----------------------------- */
+
+  void postVisit(BinaryExpression& expr);
+  void postVisit(UnaryExpression& expr);
+  void postVisit(FunctionalExpression& expr);
+  void postVisit(IdentifierExpr& expr);
+  template <typename T>
+  void postVisit(Literal<T>& expr);
+  void postVisit(Object& expr);
+  void postVisit(ParenExpr& expr);
+  void postVisit(CastExpr& expr);
+  void postVisit(SharedExpr& expr);
+
+  TypeId callType(FunctionalExpression& expr, FnCallPostfix& call);
+  TypeId memberType(FunctionalExpression& expr, MemberAccessPostfix& access);
+  TypeId variantAccessType(FunctionalExpression& expr, VariantAccessPostfix& access);
+
+  /* --------------------------------- Utils -------------------------------- */
+
+  void declareTypes(Definition& def);
+  void defineTypes(Definition& def);
+  void declareValue(Definition& def);
+  TypeId functionType(FnDef& def);
+
+  TypeId resolveType(const TypeIdentifier& name, const Position& position);
+  bool convertible(Expression& expr, TypeId target);
+  void expectType(Expression& expr, TypeId target);
+  bool isAssignable(const Expression& expr) const;
+  bool isConst(const Expression& expr) const;
+
+  void declare(const Identifier& name, Symbol&& symbol);
+
+  TypeTable* m_types = nullptr;
+  ScopedTable<Symbol> m_stack;
+  std::vector<TypeId> m_returnTypes;
+
+  ErrorHandler& m_errorHandler;
+};
@@ -0,0 +1,224 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "Definition.h"
+#include "Types.h"
+
+struct Frame;
+struct Value;
+
+struct StructValue {
+  TypeId type;
+  std::vector<Value> fields;  // Laid out as TypeTable::layOutStructs() describes
+};
+
+#ifndef PROTON_VARIANT_INLINE_SIZE
+#define PROTON_VARIANT_INLINE_SIZE 32
+#endif
+
+// Bytes of the alternatives of variant values held inline, larger ones are held on the heap
+inline constexpr std::size_t VARIANT_INLINE_SIZE = PROTON_VARIANT_INLINE_SIZE;
+
+/**
+ * @brief Value of a variant type, owning the value of the alternative it holds. The alternative
+ * is known by its tag, matching on it is a single comparison or an index into a jump table.
+ *
+ * The value is held inline if its data fits into VARIANT_INLINE_SIZE bytes, so assigning and
+ * copying variants of small alternatives allocates nothing. Variants held by variants are always
+ * held on the heap.
+ */
+struct VariantValue {
+  VariantValue(TypeId type, VariantTag tag, Value&& value);
+  ~VariantValue();
+
+  VariantValue(const VariantValue& other);
+  VariantValue(VariantValue&& other) noexcept;
+  VariantValue& operator=(const VariantValue& other);
+  VariantValue& operator=(VariantValue&& other) noexcept;
+
+  Value value() const;
+  // Moves the value out, leaving the variant holding a moved-from value
+  Value release();
+  bool isInline() const { return m_index != BOXED; }
+
+  TypeId type;
+  VariantTag tag;  // Of the alternative holding the value
+
+ private:
+  static constexpr std::uint8_t BOXED = UINT8_MAX;
+  static constexpr std::size_t STORAGE_SIZE = std::max(VARIANT_INLINE_SIZE, sizeof(Value*));
+
+  template <typename T>
+  static constexpr bool fitsInline = !std::is_same_v<T, VariantValue> &&
+                                     sizeof(T) <= VARIANT_INLINE_SIZE &&
+                                     alignof(T) <= alignof(Value*);
+
+  template <typename Self, typename F>
+  static void visitInline(Self& self, F&& fn);
+  void moveFrom(VariantValue& other) noexcept;
+  void destroy() noexcept;
+
+  std::uint8_t m_index;  // In Value::Data of the value held inline, BOXED if held on the heap
+  alignas(Value*) std::byte m_storage[STORAGE_SIZE];
+};
+
+/**
+ * @brief A function together with the frame of the function it is defined in, if it is local.
+ */
+struct FunctionValue {
+  const FnDef* def;
+  Frame* enclosing;
+};
+
+/**
+ * @brief Value of a const parameter bound to the argument instead of a copy of it. The argument
+ * outlives the call and nothing writes it while the call runs.
+ */
+struct ConstReference {
+  const Value* value;
+};
+
+/**
+ * @brief Value of any type, primitives are held in the order of PrimitiveType. Uninitialized
+ * variables hold std::monostate.
+ */
+struct Value {
+  using Data = std::variant<std::monostate, int, float, bool, wchar_t, std::wstring, StructValue,
+                            VariantValue, FunctionValue, ConstReference>;
+
+  Value() = default;
+  template <typename T>
+    requires(!std::is_same_v<std::decay_t<T>, Value>)
+  Value(T&& data) : data{std::forward<T>(data)} {}
+
+  bool isPrimitive() const { return data.index() >= 1 && data.index() <= 5; }
+
+  Data data;
+};
+
+inline VariantValue::VariantValue(TypeId type, VariantTag tag, Value&& value)
+    : type{type}, tag{tag}, m_index{BOXED} {
+  std::visit(
+      [&](auto&& data) {
+        using T = std::decay_t<decltype(data)>;
+        if constexpr (fitsInline<T>) {
+          new (m_storage) T{std::move(data)};
+          m_index = static_cast<std::uint8_t>(value.data.index());
+        } else {
+          new (m_storage) Value*{new Value{std::move(data)}};
+        }
+      },
+      std::move(value.data));
+}
+
+inline VariantValue::~VariantValue() { destroy(); }
+
+inline VariantValue::VariantValue(const VariantValue& other)
+    : VariantValue{other.type, other.tag, other.value()} {}
+
+inline VariantValue::VariantValue(VariantValue&& other) noexcept
+    : type{other.type}, tag{other.tag}, m_index{other.m_index} {
+  moveFrom(other);
+}
+
+inline VariantValue& VariantValue::operator=(const VariantValue& other) {
+  if (this != &other) *this = VariantValue{other};
+  return *this;
+}
+
+inline VariantValue& VariantValue::operator=(VariantValue&& other) noexcept {
+  if (this == &other) return *this;
+  destroy();
+  type = other.type;
+  tag = other.tag;
+  m_index = other.m_index;
+  moveFrom(other);
+  return *this;
+}
+
+inline Value VariantValue::value() const {
+  if (!isInline()) return **reinterpret_cast<Value* const*>(m_storage);
+  Value result;
+  visitInline(*this, [&](const auto& data) { result = Value{data}; });
+  return result;
+}
+
+inline Value VariantValue::release() {
+  if (!isInline()) return std::move(**reinterpret_cast<Value**>(m_storage));
+  Value result;
+  visitInline(*this, [&](auto& data) { result = Value{std::move(data)}; });
+  return result;
+}
+
+// Calls fn with the value held inline, typed as the alternative of Value::Data it is
+template <typename Self, typename F>
+void VariantValue::visitInline(Self& self, F&& fn) {
+  [&]<std::size_t... I>(std::index_sequence<I...>) {
+    (
+        [&] {
+          using T = std::variant_alternative_t<I, Value::Data>;
+          using Stored = std::conditional_t<std::is_const_v<Self>, const T, T>;
+          if constexpr (fitsInline<T>) {
+            if (self.m_index == I) fn(*std::launder(reinterpret_cast<Stored*>(self.m_storage)));
+          }
+        }(),
+        ...);
+  }(std::make_index_sequence<std::variant_size_v<Value::Data>>{});
+}
+
+// The value of other is moved, other still owns the moved-from value if it is held inline
+inline void VariantValue::moveFrom(VariantValue& other) noexcept {
+  if (!isInline()) {
+    new (m_storage) Value*{std::exchange(*reinterpret_cast<Value**>(other.m_storage), nullptr)};
+    return;
+  }
+  visitInline(other, [&](auto& data) {
+    using T = std::decay_t<decltype(data)>;
+    new (m_storage) T{std::move(data)};
+  });
+}
+
+inline void VariantValue::destroy() noexcept {
+  if (!isInline()) {
+    delete *reinterpret_cast<Value**>(m_storage);
+    return;
+  }
+  visitInline(*this, [](auto& data) {
+    using T = std::decay_t<decltype(data)>;
+    data.~T();
+  });
+}
+
+/**
+ * @brief Copy of the member of type `type` at `offset` among the fields of the struct value, a
+ * nested struct is gathered from the fields it is stored inline in.
+ */
+inline Value memberValue(const StructValue& value, std::uint32_t offset, TypeId type,
+                         const TypeTable& types) {
+  if (types[type].kind != TypeKind::Struct) return value.fields.at(offset);
+  auto first = value.fields.begin() + offset;
+  return StructValue{type, std::vector<Value>(first, first + types.width(type))};
+}
+
+/**
+ * @brief Type of the value, ERROR_TYPE for uninitialized values and functions.
+ */
+inline TypeId typeOf(const Value& value) {
+  if (value.isPrimitive()) {
+    return TypeTable::primitive(static_cast<PrimitiveType>(value.data.index() - 1));
+  }
+  if (auto structValue = std::get_if<StructValue>(&value.data)) return structValue->type;
+  if (auto variantValue = std::get_if<VariantValue>(&value.data)) return variantValue->type;
+  if (auto reference = std::get_if<ConstReference>(&value.data)) return typeOf(*reference->value);
+  return ERROR_TYPE;
+}
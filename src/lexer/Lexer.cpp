@@ -165,7 +165,7 @@ bool Lexer::isAllowedAfterNumber(const wchar_t c) const {
     case L';':
     case L',':
     case L'$':
-    case WEOF:
+    case wchar_t(WEOF):
       isAllowed = true;
       break;
 
@@ -440,7 +440,7 @@ void Lexer::buildOther() {
     case L'}':
       m_token.type = TokenType::RBRACE;
       return;
-    case WEOF:
+    case wchar_t(WEOF):
       m_token.type = TokenType::ETX;
       return;
     default:
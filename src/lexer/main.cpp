@@ -25,5 +25,10 @@ int main(int argc, char** argv) {
   }
   printTokenInfo(token);
 
+  if (errorHandler.hasErrors()) {
+    errorHandler.dumpErrors();
+    return 1;
+  }
+
   return 0;
 }
@@ -1,21 +1,189 @@
-#include "ErrorHandler.h"
-#include "Lexer.h"
-#include "StringCharReader.h"
-#include "lexer_utils.h"
-
-int main() {
-  std::wstring src = L"fn main() -> int { return 1; }";
-  StringCharReader reader(src);
-  ErrorHandler errorHandler;
-
-  Lexer lexer(reader, errorHandler);
-
-  auto token = lexer.getNextToken();
-  while (token.type != TokenType::ETX) {
-    printTokenInfo(token);
-    token = lexer.getNextToken();
-  }
-  printTokenInfo(token);
-
-  return 0;
-}
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+
+#include "ASTStats.h"
+#include "CompileTimeEvaluation.h"
+#include "ConstantFolding.h"
+#include "CountedLoops.h"
+#include "DeadCodeElimination.h"
+#include "DiagnosticSink.h"
+#include "ErrorHandler.h"
+#include "FileCharReader.h"
+#include "Inlining.h"
+#include "LastUseAnalysis.h"
+#include "Lexer.h"
+#include "LoopInvariantCodeMotion.h"
+#include "Parser.h"
+#include "ProgramCache.h"
+#include "PurityAnalysis.h"
+#include "ScopeChecker.h"
+#include "SwitchLowering.h"
+#include "TypeChecker.h"
+
+// Results of pure calls kept with --memoize
+constexpr std::size_t MEMO_ENTRIES = 4096;
+
+struct Options {
+  bool useCache = true;
+  bool jsonDiagnostics = false;
+  bool astStats = false;
+  bool reportDead = false;
+  bool reportInlining = false;
+  bool reportLoopInvariants = false;
+  bool reportLoops = false;
+  bool reportSwitches = false;
+  bool reportMoves = false;
+  bool reportEvaluation = false;
+  bool memoize = false;
+  int maxErrors = 10;
+  std::string sourceFile;
+};
+
+std::optional<Options> parseOptions(int argc, char* argv[]) {
+  Options options;
+
+  int i = 1;
+  for (; i < argc && std::strncmp(argv[i], "--", 2) == 0; i++) {
+    if (std::strcmp(argv[i], "--no-cache") == 0) {
+      options.useCache = false;
+    } else if (std::strcmp(argv[i], "--json-diagnostics") == 0) {
+      options.jsonDiagnostics = true;
+    } else if (std::strcmp(argv[i], "--ast-stats") == 0) {
+      options.astStats = true;
+    } else if (std::strcmp(argv[i], "--report-dead") == 0) {
+      options.reportDead = true;
+    } else if (std::strcmp(argv[i], "--report-inlining") == 0) {
+      options.reportInlining = true;
+    } else if (std::strcmp(argv[i], "--report-licm") == 0) {
+      options.reportLoopInvariants = true;
+    } else if (std::strcmp(argv[i], "--report-loops") == 0) {
+      options.reportLoops = true;
+    } else if (std::strcmp(argv[i], "--report-switches") == 0) {
+      options.reportSwitches = true;
+    } else if (std::strcmp(argv[i], "--report-moves") == 0) {
+      options.reportMoves = true;
+    } else if (std::strcmp(argv[i], "--report-evaluation") == 0) {
+      options.reportEvaluation = true;
+    } else if (std::strcmp(argv[i], "--memoize") == 0) {
+      options.memoize = true;
+    } else if (std::strcmp(argv[i], "--max-errors") == 0 && i + 1 < argc) {
+      options.maxErrors = std::atoi(argv[++i]);
+      if (options.maxErrors <= 0) return std::nullopt;
+    } else {
+      std::cerr << "Unknown option: " << argv[i] << "\n";
+      return std::nullopt;
+    }
+  }
+  if (i >= argc) return std::nullopt;
+  options.sourceFile = argv[i];
+
+  return options;
+}
+
+/**
+ * @brief Loads the program from the AST cache, falling back to lexing and parsing the source
+ * when there is no up to date cache entry.
+ */
+std::optional<Program> loadProgram(const Options& options, ErrorHandler& errorHandler) {
+  std::ifstream file{options.sourceFile, std::ios::binary};
+  if (!file) {
+    std::cerr << "Cannot open source file: " << options.sourceFile << "\n";
+    return std::nullopt;
+  }
+  std::stringstream contents;
+  contents << file.rdbuf();
+  auto source = contents.str();
+
+  ProgramCache cache{ProgramCache::defaultDirectory(), PROTON_VERSION};
+  if (options.useCache) {
+    if (auto program = cache.load(source, options.sourceFile); program.has_value()) return program;
+  }
+
+  FileCharReader reader{options.sourceFile};
+  Lexer lexer{reader, errorHandler};
+  Parser parser{lexer, errorHandler, ParsingMode::Recursive, ErrorRecovery::PanicMode};
+  auto program = parser.parseProgram();
+
+  if (options.useCache && program.has_value()) cache.store(source, *program);
+  return program;
+}
+
+bool reportErrors(const Options& options, ErrorHandler& errorHandler) {
+  if (!errorHandler.hasErrors()) return false;
+
+  if (options.jsonDiagnostics) {
+    JsonLinesDiagnosticSink sink{std::cerr};
+    errorHandler.emitDiagnostics(sink);
+  } else {
+    errorHandler.dumpErrors();
+  }
+  return true;
+}
+
+int main(int argc, char* argv[]) {
+  auto options = parseOptions(argc, argv);
+  if (!options.has_value()) {
+    std::cerr << "Usage: proton [--no-cache] [--max-errors <n>] [--json-diagnostics] "
+                 "[--ast-stats] [--report-dead] [--report-inlining] [--report-licm] "
+                 "[--report-loops] [--report-switches] [--report-moves] [--report-evaluation] "
+                 "[--memoize] <source file> [args...]\n";
+    return 1;
+  }
+
+  // Errors are collected, all of them are printed after the stage reporting them
+  ErrorHandler errorHandler{ErrorPolicy::Collect, options->maxErrors};
+  auto program = loadProgram(*options, errorHandler);
+  if (reportErrors(*options, errorHandler) || !program.has_value()) return 1;
+
+  if (options->astStats) printASTStats(std::cout, collectASTStats(*program));
+
+  ScopeChecker{errorHandler}.check(*program);
+  if (reportErrors(*options, errorHandler)) return 1;
+  TypeChecker{errorHandler}.check(*program);
+  if (reportErrors(*options, errorHandler)) return 1;
+
+  // Dead code is dropped once the whole program is checked, unreachable code must be valid too
+  auto deadCode = eliminateDeadCode(*program);
+  if (options->reportDead) printDeadCodeReport(std::cout, deadCode);
+
+  // Errors of constant expressions, e.g. a division by zero, are reported before anything runs
+  foldConstants(*program, errorHandler);
+  if (reportErrors(*options, errorHandler)) return 1;
+
+  // Compile-time evaluation is the only place proton runs code. It comes before inlining: an
+  // inlined body runs in its caller's frame, so a constant call stops being an expression the
+  // Evaluator can run on its own once it is inlined, and would be left to runtime.
+  markPureFunctions(*program);
+  EvaluationLimits limits;
+  if (options->memoize) limits.memoEntries = MEMO_ENTRIES;
+  auto evaluation = evaluateAtCompileTime(*program, limits);
+  if (options->reportEvaluation) printCompileTimeStats(std::cout, evaluation);
+
+  // The passes below annotate the tree (InlinedCall, hoisted locals, loop directions, switch
+  // tables, last uses) for an Evaluator running the program. proton does not run it, so here they
+  // only show through their --report-* flags; code embedding the Evaluator runs their result.
+  auto inlining = inlineCalls(*program);
+  if (options->reportInlining) printInliningReport(std::cout, inlining);
+
+  // Inlined bodies expose the loop invariants of the callees to their callers
+  auto loopInvariants = hoistLoopInvariants(*program);
+  if (options->reportLoopInvariants) printLoopInvariantReport(std::cout, loopInvariants);
+
+  auto countedLoops = specializeCountedLoops(*program);
+  if (options->reportLoops) printCountedLoopReport(std::cout, countedLoops);
+
+  // Comes after the passes rewriting expressions, the tables rely on the conditions staying put
+  auto switches = lowerSwitches(*program);
+  if (options->reportSwitches) printSwitchReport(std::cout, switches);
+
+  // Last uses are marked once nothing moves code around anymore
+  auto lastUses = markLastUses(*program);
+  if (options->reportMoves) printLastUseReport(std::cout, lastUses);
+
+  return 0;
+}
@@ -0,0 +1,277 @@
+#include <concepts>
+#include <stdexcept>
+
+#include "ASTClone.h"
+#include "ASTDispatch.h"
+
+namespace {
+
+std::unique_ptr<Expression> cloneOptional(const std::unique_ptr<Expression>& expr) {
+  return expr != nullptr ? cloneExpression(*expr) : nullptr;
+}
+
+std::vector<std::unique_ptr<Expression>> cloneAll(
+    const std::vector<std::unique_ptr<Expression>>& expressions) {
+  std::vector<std::unique_ptr<Expression>> clones;
+  clones.reserve(expressions.size());
+  for (const auto& expr : expressions) clones.push_back(cloneExpression(*expr));
+  return clones;
+}
+
+// Copies the annotations of the definition, after it was constructed from the cloned children
+template <typename Def>
+std::unique_ptr<Def> annotated(std::unique_ptr<Def> clone, const Def& original) {
+  clone->storage = original.storage;
+  clone->typeId = original.typeId;
+  return clone;
+}
+
+/* ------------------------------- Expressions ------------------------------ */
+
+std::unique_ptr<Expression> copy(const BinaryExpression& expr) {
+  return std::make_unique<BinaryExpression>(Position{expr.position}, cloneExpression(*expr.lhs),
+                                            expr.op, cloneExpression(*expr.rhs));
+}
+
+std::unique_ptr<Expression> copy(const UnaryExpression& expr) {
+  return std::make_unique<UnaryExpression>(Position{expr.position}, expr.op,
+                                           cloneExpression(*expr.expr));
+}
+
+std::unique_ptr<FunctionalPostfix> copyPostfix(const FunctionalPostfix& postfix) {
+  if (auto call = dyn_cast<FnCallPostfix>(&postfix)) {
+    return std::make_unique<FnCallPostfix>(Position{call->position}, cloneAll(call->args));
+  }
+  if (auto member = dyn_cast<MemberAccessPostfix>(&postfix)) {
+    auto clone = std::make_unique<MemberAccessPostfix>(Position{member->position},
+                                                       Identifier{member->member});
+    clone->offset = member->offset;
+    return clone;
+  }
+  auto& variant = cast<VariantAccessPostfix>(postfix);
+  auto clone = std::make_unique<VariantAccessPostfix>(Position{variant.position},
+                                                      TypeIdentifier{variant.variant});
+  clone->tag = variant.tag;
+  return clone;
+}
+
+std::unique_ptr<Expression> copy(const FunctionalExpression& expr) {
+  return std::make_unique<FunctionalExpression>(
+      Position{expr.position}, cloneExpression(*expr.expr), copyPostfix(*expr.postfix));
+}
+
+std::unique_ptr<Expression> copy(const IdentifierExpr& expr) {
+  auto clone = std::make_unique<IdentifierExpr>(Position{expr.position}, Identifier{expr.name});
+  clone->storage = expr.storage;
+  clone->isLastUse = expr.isLastUse;
+  return clone;
+}
+
+template <typename T>
+std::unique_ptr<Expression> copy(const Literal<T>& expr) {
+  return std::make_unique<Literal<T>>(Position{expr.position}, T{expr.value});
+}
+
+std::unique_ptr<Expression> copy(const Object& expr) {
+  Object::Members members;
+  for (const auto& [name, member] : expr.members) {
+    members.emplace(name, ObjectMember{Identifier{member.name}, cloneExpression(*member.value)});
+  }
+  return std::make_unique<Object>(Position{expr.position}, std::move(members));
+}
+
+std::unique_ptr<Expression> copy(const ParenExpr& expr) {
+  return std::make_unique<ParenExpr>(Position{expr.position}, cloneExpression(*expr.expr));
+}
+
+std::unique_ptr<Expression> copy(const CastExpr& expr) {
+  return std::make_unique<CastExpr>(Position{expr.position}, expr.type,
+                                    cloneExpression(*expr.expr));
+}
+
+std::unique_ptr<Expression> copy(const SharedExpr& expr) {
+  return std::make_unique<SharedExpr>(Position{expr.position}, expr.expr, expr.hash);
+}
+
+std::unique_ptr<Expression> copy(const InlinedCall& expr) {
+  return std::make_unique<InlinedCall>(
+      Position{expr.position}, Identifier{expr.callee},
+      std::vector<InlinedParameter>(expr.parameters), cloneAll(expr.args), cloneBlock(expr.body));
+}
+
+/* ------------------------------- Definitions ------------------------------ */
+
+std::unique_ptr<Statement> copy(const VarDef& def) {
+  return annotated(std::make_unique<VarDef>(Position{def.position}, Identifier{def.name},
+                                            TypeIdentifier{def.type}, cloneExpression(*def.value)),
+                   def);
+}
+
+std::unique_ptr<Statement> copy(const ConstDef& def) {
+  return annotated(std::make_unique<ConstDef>(Position{def.position}, Identifier{def.name},
+                                              TypeIdentifier{def.type},
+                                              cloneExpression(*def.value)),
+                   def);
+}
+
+std::unique_ptr<Statement> copy(const StructDef& def) {
+  StructDef::Members members;
+  for (const auto& [name, member] : def.members) {
+    members.emplace(name, StructMember{Position{member.position}, Identifier{member.name},
+                                       TypeIdentifier{member.type}});
+  }
+  return annotated(
+      std::make_unique<StructDef>(Position{def.position}, Identifier{def.name}, std::move(members)),
+      def);
+}
+
+std::unique_ptr<Statement> copy(const VariantDef& def) {
+  return annotated(std::make_unique<VariantDef>(Position{def.position}, Identifier{def.name},
+                                                VariantDef::Types{def.types}),
+                   def);
+}
+
+std::unique_ptr<Statement> copy(const FnDef& def) {
+  FnDef::Params params;
+  for (const auto& [name, param] : def.parameters) {
+    FnParam clone{Position{param.position}, param.isConst, Identifier{param.name},
+                  TypeIdentifier{param.type}};
+    clone.storage = param.storage;
+    clone.typeId = param.typeId;
+    params.emplace(name, std::move(clone));
+  }
+  auto clone = std::make_unique<FnDef>(Position{def.position}, Identifier{def.name},
+                                       std::move(params), TypeIdentifier{def.returnType},
+                                       cloneBlock(def.body));
+  clone->localCount = def.localCount;
+  clone->isPure = def.isPure;
+  return annotated(std::move(clone), def);
+}
+
+/* ------------------------------- Statements ------------------------------- */
+
+std::unique_ptr<Statement> copy(const BlockStmt& stmt) {
+  return std::make_unique<BlockStmt>(cloneBlock(stmt));
+}
+
+std::unique_ptr<Statement> copy(const ExpressionStmt& stmt) {
+  return std::make_unique<ExpressionStmt>(Position{stmt.position}, cloneExpression(*stmt.expr));
+}
+
+std::unique_ptr<Statement> copy(const AssignmentStmt& stmt) {
+  return std::make_unique<AssignmentStmt>(Position{stmt.position}, cloneExpression(*stmt.lhs),
+                                          cloneExpression(*stmt.rhs));
+}
+
+std::unique_ptr<Statement> copy(const StdinExtractionStmt& stmt) {
+  return std::make_unique<StdinExtractionStmt>(Position{stmt.position},
+                                               cloneAll(stmt.expressions));
+}
+
+std::unique_ptr<Statement> copy(const StdoutInsertionStmt& stmt) {
+  return std::make_unique<StdoutInsertionStmt>(Position{stmt.position},
+                                               cloneAll(stmt.expressions));
+}
+
+std::unique_ptr<Statement> copy(const VariantMatchStmt& stmt) {
+  VariantMatchStmt::Cases cases;
+  for (const auto& [variant, matchCase] : stmt.cases) {
+    VariantMatchCase clone{Position{matchCase.position}, TypeIdentifier{matchCase.variant},
+                           cloneBlock(matchCase.block)};
+    clone.typeId = matchCase.typeId;
+    clone.tag = matchCase.tag;
+    cases.emplace(variant, std::move(clone));
+  }
+  auto clone = std::make_unique<VariantMatchStmt>(Position{stmt.position},
+                                                  cloneExpression(*stmt.expr), std::move(cases));
+
+  // The table points into the cases, the clone's to its own
+  clone->jumpTable.resize(stmt.jumpTable.size(), nullptr);
+  for (std::size_t tag = 0; tag < stmt.jumpTable.size(); tag++) {
+    const auto* matchCase = stmt.jumpTable[tag];
+    if (matchCase != nullptr) clone->jumpTable[tag] = &clone->cases.at(matchCase->variant);
+  }
+  return clone;
+}
+
+std::unique_ptr<Statement> copy(const IfStmt& stmt) {
+  IfStmt::Elifs elifs;
+  for (const auto& elif : stmt.elifs) {
+    elifs.emplace_back(Position{elif.position}, cloneExpression(*elif.condition),
+                       cloneBlock(elif.block));
+  }
+  std::unique_ptr<Else> elseClause;
+  if (stmt.elseClause != nullptr) {
+    elseClause = std::make_unique<Else>(Position{stmt.elseClause->position},
+                                        cloneBlock(stmt.elseClause->block));
+  }
+  auto clone = std::make_unique<IfStmt>(Position{stmt.position}, cloneExpression(*stmt.condition),
+                                        cloneBlock(stmt.block), std::move(elifs),
+                                        std::move(elseClause));
+  if (stmt.switchTable != nullptr) {
+    clone->switchTable = std::make_unique<SwitchTable>(*stmt.switchTable);
+  }
+  return clone;
+}
+
+std::unique_ptr<Statement> copy(const ForStmt& stmt) {
+  Range range{Position{stmt.range.position}, cloneExpression(*stmt.range.start),
+              cloneExpression(*stmt.range.end)};
+  auto clone = std::make_unique<ForStmt>(Position{stmt.position}, Identifier{stmt.identifier},
+                                         std::move(range), cloneBlock(stmt.block));
+  clone->storage = stmt.storage;
+  clone->direction = stmt.direction;
+  return clone;
+}
+
+std::unique_ptr<Statement> copy(const WhileStmt& stmt) {
+  return std::make_unique<WhileStmt>(Position{stmt.position}, cloneExpression(*stmt.condition),
+                                     cloneBlock(stmt.block));
+}
+
+std::unique_ptr<Statement> copy(const ContinueStmt& stmt) {
+  return std::make_unique<ContinueStmt>(Position{stmt.position});
+}
+
+std::unique_ptr<Statement> copy(const BreakStmt& stmt) {
+  return std::make_unique<BreakStmt>(Position{stmt.position});
+}
+
+std::unique_ptr<Statement> copy(const ReturnStmt& stmt) {
+  return std::make_unique<ReturnStmt>(Position{stmt.position}, cloneOptional(stmt.expr));
+}
+
+}  // namespace
+
+std::unique_ptr<Expression> cloneExpression(const Expression& expr) {
+  auto clone = dispatch(expr, [](const auto& node) -> std::unique_ptr<Expression> {
+    if constexpr (requires {
+                    { copy(node) } -> std::convertible_to<std::unique_ptr<Expression>>;
+                  }) {
+      return copy(node);
+    } else {
+      throw std::logic_error("Expected an expression!");
+    }
+  });
+  clone->typeId = expr.typeId;
+  return clone;
+}
+
+std::unique_ptr<Statement> cloneStatement(const Statement& stmt) {
+  return dispatch(stmt, [](const auto& node) -> std::unique_ptr<Statement> {
+    if constexpr (requires {
+                    { copy(node) } -> std::convertible_to<std::unique_ptr<Statement>>;
+                  }) {
+      return copy(node);
+    } else {
+      throw std::logic_error("Expected a statement!");
+    }
+  });
+}
+
+BlockStmt cloneBlock(const BlockStmt& block) {
+  BlockStmt::Statements statements;
+  statements.reserve(block.statements.size());
+  for (const auto& stmt : block.statements) statements.push_back(cloneStatement(*stmt));
+  return BlockStmt{Position{block.position}, std::move(statements)};
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <memory>
+
+#include "Definition.h"
+#include "Expression.h"
+#include "Statement.h"
+
+/**
+ * @brief Deep copies of AST subtrees, together with what the semantic passes annotated them with
+ * (Storage, TypeIds, frame sizes). Shared subtrees are not copied, the copy of a SharedExpr refers
+ * to the same subtree of the Program.
+ */
+std::unique_ptr<Expression> cloneExpression(const Expression& expr);
+std::unique_ptr<Statement> cloneStatement(const Statement& stmt);
+BlockStmt cloneBlock(const BlockStmt& block);
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <stdexcept>
+#include <type_traits>
+
+#include "Casting.h"
+#include "Definition.h"
+#include "Expression.h"
+#include "Program.h"
+#include "Statement.h"
+
+/**
+ * @brief Calls `fn` with `node` cast to its concrete type, selected by a switch on the node kind.
+ * All calls of `fn` must return the same type.
+ */
+template <typename Node, typename Fn>
+decltype(auto) dispatch(Node& node, Fn&& fn) {
+  static_assert(std::is_base_of_v<ASTNode, std::remove_const_t<Node>>, "Expected an AST node");
+
+  detail::CastResult<ASTNode, Node>& base = node;
+
+  switch (node.kind) {
+    case NodeKind::Program:
+      return fn(static_cast<detail::CastResult<Program, Node>&>(base));
+    case NodeKind::VarDef:
+      return fn(static_cast<detail::CastResult<VarDef, Node>&>(base));
+    case NodeKind::ConstDef:
+      return fn(static_cast<detail::CastResult<ConstDef, Node>&>(base));
+    case NodeKind::StructDef:
+      return fn(static_cast<detail::CastResult<StructDef, Node>&>(base));
+    case NodeKind::VariantDef:
+      return fn(static_cast<detail::CastResult<VariantDef, Node>&>(base));
+    case NodeKind::FnDef:
+      return fn(static_cast<detail::CastResult<FnDef, Node>&>(base));
+    case NodeKind::BlockStmt:
+      return fn(static_cast<detail::CastResult<BlockStmt, Node>&>(base));
+    case NodeKind::ExpressionStmt:
+      return fn(static_cast<detail::CastResult<ExpressionStmt, Node>&>(base));
+    case NodeKind::AssignmentStmt:
+      return fn(static_cast<detail::CastResult<AssignmentStmt, Node>&>(base));
+    case NodeKind::StdinExtractionStmt:
+      return fn(static_cast<detail::CastResult<StdinExtractionStmt, Node>&>(base));
+    case NodeKind::StdoutInsertionStmt:
+      return fn(static_cast<detail::CastResult<StdoutInsertionStmt, Node>&>(base));
+    case NodeKind::VariantMatchStmt:
+      return fn(static_cast<detail::CastResult<VariantMatchStmt, Node>&>(base));
+    case NodeKind::IfStmt:
+      return fn(static_cast<detail::CastResult<IfStmt, Node>&>(base));
+    case NodeKind::ForStmt:
+      return fn(static_cast<detail::CastResult<ForStmt, Node>&>(base));
+    case NodeKind::WhileStmt:
+      return fn(static_cast<detail::CastResult<WhileStmt, Node>&>(base));
+    case NodeKind::ContinueStmt:
+      return fn(static_cast<detail::CastResult<ContinueStmt, Node>&>(base));
+    case NodeKind::BreakStmt:
+      return fn(static_cast<detail::CastResult<BreakStmt, Node>&>(base));
+    case NodeKind::ReturnStmt:
+      return fn(static_cast<detail::CastResult<ReturnStmt, Node>&>(base));
+    case NodeKind::BinaryExpression:
+      return fn(static_cast<detail::CastResult<BinaryExpression, Node>&>(base));
+    case NodeKind::UnaryExpression:
+      return fn(static_cast<detail::CastResult<UnaryExpression, Node>&>(base));
+    case NodeKind::FunctionalExpression:
+      return fn(static_cast<detail::CastResult<FunctionalExpression, Node>&>(base));
+    case NodeKind::IdentifierExpr:
+      return fn(static_cast<detail::CastResult<IdentifierExpr, Node>&>(base));
+    case NodeKind::IntLiteral:
+      return fn(static_cast<detail::CastResult<Literal<int>, Node>&>(base));
+    case NodeKind::FloatLiteral:
+      return fn(static_cast<detail::CastResult<Literal<float>, Node>&>(base));
+    case NodeKind::BoolLiteral:
+      return fn(static_cast<detail::CastResult<Literal<bool>, Node>&>(base));
+    case NodeKind::CharLiteral:
+      return fn(static_cast<detail::CastResult<Literal<wchar_t>, Node>&>(base));
+    case NodeKind::StringLiteral:
+      return fn(static_cast<detail::CastResult<Literal<std::wstring>, Node>&>(base));
+    case NodeKind::Object:
+      return fn(static_cast<detail::CastResult<Object, Node>&>(base));
+    case NodeKind::ParenExpr:
+      return fn(static_cast<detail::CastResult<ParenExpr, Node>&>(base));
+    case NodeKind::CastExpr:
+      return fn(static_cast<detail::CastResult<CastExpr, Node>&>(base));
+    case NodeKind::SharedExpr:
+      return fn(static_cast<detail::CastResult<SharedExpr, Node>&>(base));
+    case NodeKind::InlinedCall:
+      return fn(static_cast<detail::CastResult<InlinedCall, Node>&>(base));
+    case NodeKind::FnCallPostfix:
+      return fn(static_cast<detail::CastResult<FnCallPostfix, Node>&>(base));
+    case NodeKind::MemberAccessPostfix:
+      return fn(static_cast<detail::CastResult<MemberAccessPostfix, Node>&>(base));
+    case NodeKind::VariantAccessPostfix:
+      return fn(static_cast<detail::CastResult<VariantAccessPostfix, Node>&>(base));
+    case NodeKind::StructMember:
+      return fn(static_cast<detail::CastResult<StructMember, Node>&>(base));
+    case NodeKind::FnParam:
+      return fn(static_cast<detail::CastResult<FnParam, Node>&>(base));
+    case NodeKind::VariantMatchCase:
+      return fn(static_cast<detail::CastResult<VariantMatchCase, Node>&>(base));
+    case NodeKind::Elif:
+      return fn(static_cast<detail::CastResult<Elif, Node>&>(base));
+    case NodeKind::Else:
+      return fn(static_cast<detail::CastResult<Else, Node>&>(base));
+    case NodeKind::Range:
+      return fn(static_cast<detail::CastResult<Range, Node>&>(base));
+  }
+
+  throw std::logic_error("Unknown node kind!");
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 #include "Position.h"
@@ -7,6 +9,106 @@
 using Identifier = std::wstring;
 using TypeIdentifier = std::wstring;
 
+/**
+ * @brief Discriminator of the concrete node type. Nodes of one category are kept contiguous, so
+ * the abstract categories (Definition, Statement, Expression, ...) are classified with a range
+ * check, see Casting.h.
+ */
+enum class NodeKind : std::uint8_t {
+  Program,
+
+  // Statements
+  FirstStatement,
+  // Definitions
+  FirstDefinition = FirstStatement,
+  VarDef = FirstDefinition,
+  ConstDef,
+  StructDef,
+  VariantDef,
+  FnDef,
+  LastDefinition = FnDef,
+  BlockStmt,
+  ExpressionStmt,
+  AssignmentStmt,
+  StdinExtractionStmt,
+  StdoutInsertionStmt,
+  VariantMatchStmt,
+  IfStmt,
+  ForStmt,
+  WhileStmt,
+  ContinueStmt,
+  BreakStmt,
+  ReturnStmt,
+  LastStatement = ReturnStmt,
+
+  // Expressions
+  FirstExpression,
+  BinaryExpression = FirstExpression,
+  UnaryExpression,
+  FunctionalExpression,
+  // Primary expressions
+  FirstPrimaryExpression,
+  IdentifierExpr = FirstPrimaryExpression,
+  IntLiteral,
+  FloatLiteral,
+  BoolLiteral,
+  CharLiteral,
+  StringLiteral,
+  Object,
+  ParenExpr,
+  CastExpr,
+  LastPrimaryExpression = CastExpr,
+  SharedExpr,
+  InlinedCall,
+  LastExpression = InlinedCall,
+
+  // Functional postfixes
+  FirstFunctionalPostfix,
+  FnCallPostfix = FirstFunctionalPostfix,
+  MemberAccessPostfix,
+  VariantAccessPostfix,
+  LastFunctionalPostfix = VariantAccessPostfix,
+
+  // Parts of definitions and statements
+  StructMember,
+  FnParam,
+  VariantMatchCase,
+  Elif,
+  Else,
+  Range,
+};
+
+constexpr std::size_t NUM_NODE_KINDS = static_cast<std::size_t>(NodeKind::Range) + 1;
+
+/**
+ * @brief Where the value of a named entity lives at run time, filled in by the ScopeChecker.
+ * Globals are numbered in their own index space. Locals are numbered per function frame, `depth`
+ * is the number of function frames between the use and the definition (0 for the own frame).
+ */
+struct Storage {
+  enum class Kind : std::uint8_t { Unresolved, Global, Local };
+
+  Kind kind = Kind::Unresolved;
+  std::uint16_t depth = 0;
+  std::uint32_t slot = 0;
+
+  bool operator==(const Storage &) const = default;
+};
+
+/**
+ * @brief Index of a type in the TypeTable of the program (see Types.h), filled in by the
+ * TypeChecker.
+ */
+using TypeId = std::uint32_t;
+
+constexpr TypeId ERROR_TYPE = 0;  // Not checked yet, or ill-typed
+
+/**
+ * @brief Index of an alternative in the alternatives of its variant type (see TypeTable::tag()),
+ * filled in by the TypeChecker.
+ */
+using VariantTag = std::uint16_t;
+
 /**
  * @brief Base struct for all the AST nodes.
  */
@@ -20,7 +122,8 @@ struct ASTNode {
   ASTNode &operator=(ASTNode &&) = default;
   virtual ~ASTNode() = default;
 
-  ASTNode(Position &&pos) : position{pos} {}
+  ASTNode(NodeKind nodeKind, Position &&pos) : kind{nodeKind}, position{pos} {}
 
+  NodeKind kind;
   Position position;
 };
@@ -0,0 +1,706 @@
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+
+#include "ASTSerializer.h"
+#include "Casting.h"
+
+namespace {
+
+const char AST_MAGIC[4] = {'P', 'A', 'S', 'T'};
+const std::uint8_t NO_OPERATOR = 0xFF;
+
+enum class Tag : std::uint8_t {
+  Null = 0,
+
+  VarDef,
+  ConstDef,
+  StructDef,
+  VariantDef,
+  FnDef,
+
+  BlockStmt,
+  ExpressionStmt,
+  AssignmentStmt,
+  StdinExtractionStmt,
+  StdoutInsertionStmt,
+  VariantMatchStmt,
+  IfStmt,
+  ForStmt,
+  WhileStmt,
+  ContinueStmt,
+  BreakStmt,
+  ReturnStmt,
+
+  BinaryExpression,
+  UnaryExpression,
+  FunctionalExpression,
+  FnCallPostfix,
+  MemberAccessPostfix,
+  VariantAccessPostfix,
+  IdentifierExpr,
+  IntLiteral,
+  FloatLiteral,
+  BoolLiteral,
+  CharLiteral,
+  StringLiteral,
+  Object,
+  ParenExpr,
+  CastExpr,
+};
+
+/* -------------------------------------------------------------------------- */
+/*                                   Writer                                   */
+/* -------------------------------------------------------------------------- */
+
+class Writer {
+ public:
+  std::vector<std::uint8_t> bytes;
+
+  void u8(std::uint8_t value) { bytes.push_back(value); }
+
+  void raw(const void* data, std::size_t size) {
+    auto begin = static_cast<const std::uint8_t*>(data);
+    bytes.insert(bytes.end(), begin, begin + size);
+  }
+
+  void varint(std::uint64_t value) {
+    while (value >= 0x80) {
+      u8(static_cast<std::uint8_t>(value | 0x80));
+      value >>= 7;
+    }
+    u8(static_cast<std::uint8_t>(value));
+  }
+
+  void string(std::string_view str) {
+    varint(str.size());
+    raw(str.data(), str.size());
+  }
+
+  void wstring(const std::wstring& str) {
+    varint(str.size());
+    for (auto c : str) varint(static_cast<std::uint32_t>(c));
+  }
+
+  void tag(Tag tag) { u8(static_cast<std::uint8_t>(tag)); }
+
+  void position(const Position& position) {
+    varint(static_cast<std::uint32_t>(position.line));
+    varint(static_cast<std::uint32_t>(position.column));
+  }
+
+  void op(const std::optional<Operator>& op) {
+    u8(op.has_value() ? static_cast<std::uint8_t>(*op) : NO_OPERATOR);
+  }
+
+  void definition(const Definition& def);
+  void statement(const Statement* stmt);
+  void block(const BlockStmt& block);
+  void expression(const Expression* expr);
+  void expressions(const std::vector<std::unique_ptr<Expression>>& exprs);
+};
+
+void Writer::definition(const Definition& def) {
+  if (auto varDef = dyn_cast<VarDef>(&def)) {
+    tag(Tag::VarDef);
+    position(def.position);
+    wstring(def.name);
+    wstring(varDef->type);
+    expression(varDef->value.get());
+  } else if (auto constDef = dyn_cast<ConstDef>(&def)) {
+    tag(Tag::ConstDef);
+    position(def.position);
+    wstring(def.name);
+    wstring(constDef->type);
+    expression(constDef->value.get());
+  } else if (auto structDef = dyn_cast<StructDef>(&def)) {
+    tag(Tag::StructDef);
+    position(def.position);
+    wstring(def.name);
+    varint(structDef->members.size());
+    for (const auto& [name, member] : structDef->members) {
+      position(member.position);
+      wstring(member.name);
+      wstring(member.type);
+    }
+  } else if (auto variantDef = dyn_cast<VariantDef>(&def)) {
+    tag(Tag::VariantDef);
+    position(def.position);
+    wstring(def.name);
+    varint(variantDef->types.size());
+    for (const auto& type : variantDef->types) wstring(type);
+  } else if (auto fnDef = dyn_cast<FnDef>(&def)) {
+    tag(Tag::FnDef);
+    position(def.position);
+    wstring(def.name);
+    varint(fnDef->parameters.size());
+    for (const auto& [name, param] : fnDef->parameters) {
+      position(param.position);
+      u8(param.isConst);
+      wstring(param.name);
+      wstring(param.type);
+    }
+    wstring(fnDef->returnType);
+    block(fnDef->body);
+  } else {
+    throw std::logic_error("Unknown definition type!");
+  }
+}
+
+void Writer::block(const BlockStmt& block) {
+  position(block.position);
+  varint(block.statements.size());
+  for (const auto& stmt : block.statements) statement(stmt.get());
+}
+
+void Writer::statement(const Statement* stmt) {
+  if (stmt == nullptr) {
+    tag(Tag::Null);
+  } else if (auto def = dyn_cast<Definition>(stmt)) {
+    definition(*def);
+  } else if (auto blockStmt = dyn_cast<BlockStmt>(stmt)) {
+    tag(Tag::BlockStmt);
+    block(*blockStmt);
+  } else if (auto exprStmt = dyn_cast<ExpressionStmt>(stmt)) {
+    tag(Tag::ExpressionStmt);
+    position(stmt->position);
+    expression(exprStmt->expr.get());
+  } else if (auto assignment = dyn_cast<AssignmentStmt>(stmt)) {
+    tag(Tag::AssignmentStmt);
+    position(stmt->position);
+    expression(assignment->lhs.get());
+    expression(assignment->rhs.get());
+  } else if (auto extraction = dyn_cast<StdinExtractionStmt>(stmt)) {
+    tag(Tag::StdinExtractionStmt);
+    position(stmt->position);
+    expressions(extraction->expressions);
+  } else if (auto insertion = dyn_cast<StdoutInsertionStmt>(stmt)) {
+    tag(Tag::StdoutInsertionStmt);
+    position(stmt->position);
+    expressions(insertion->expressions);
+  } else if (auto match = dyn_cast<VariantMatchStmt>(stmt)) {
+    tag(Tag::VariantMatchStmt);
+    position(stmt->position);
+    expression(match->expr.get());
+    varint(match->cases.size());
+    for (const auto& [type, matchCase] : match->cases) {
+      position(matchCase.position);
+      wstring(matchCase.variant);
+      block(matchCase.block);
+    }
+  } else if (auto ifStmt = dyn_cast<IfStmt>(stmt)) {
+    tag(Tag::IfStmt);
+    position(stmt->position);
+    expression(ifStmt->condition.get());
+    block(ifStmt->block);
+    varint(ifStmt->elifs.size());
+    for (const auto& elif : ifStmt->elifs) {
+      position(elif.position);
+      expression(elif.condition.get());
+      block(elif.block);
+    }
+    u8(ifStmt->elseClause != nullptr);
+    if (ifStmt->elseClause != nullptr) {
+      position(ifStmt->elseClause->position);
+      block(ifStmt->elseClause->block);
+    }
+  } else if (auto forStmt = dyn_cast<ForStmt>(stmt)) {
+    tag(Tag::ForStmt);
+    position(stmt->position);
+    wstring(forStmt->identifier);
+    position(forStmt->range.position);
+    expression(forStmt->range.start.get());
+    expression(forStmt->range.end.get());
+    block(forStmt->block);
+  } else if (auto whileStmt = dyn_cast<WhileStmt>(stmt)) {
+    tag(Tag::WhileStmt);
+    position(stmt->position);
+    expression(whileStmt->condition.get());
+    block(whileStmt->block);
+  } else if (dyn_cast<ContinueStmt>(stmt)) {
+    tag(Tag::ContinueStmt);
+    position(stmt->position);
+  } else if (dyn_cast<BreakStmt>(stmt)) {
+    tag(Tag::BreakStmt);
+    position(stmt->position);
+  } else if (auto returnStmt = dyn_cast<ReturnStmt>(stmt)) {
+    tag(Tag::ReturnStmt);
+    position(stmt->position);
+    expression(returnStmt->expr.get());
+  } else {
+    throw std::logic_error("Unknown statement type!");
+  }
+}
+
+void Writer::expressions(const std::vector<std::unique_ptr<Expression>>& exprs) {
+  varint(exprs.size());
+  for (const auto& expr : exprs) expression(expr.get());
+}
+
+void Writer::expression(const Expression* expr) {
+  if (expr == nullptr) {
+    tag(Tag::Null);
+  } else if (auto binary = dyn_cast<BinaryExpression>(expr)) {
+    tag(Tag::BinaryExpression);
+    position(expr->position);
+    op(binary->op);
+    expression(binary->lhs.get());
+    expression(binary->rhs.get());
+  } else if (auto unary = dyn_cast<UnaryExpression>(expr)) {
+    tag(Tag::UnaryExpression);
+    position(expr->position);
+    op(unary->op);
+    expression(unary->expr.get());
+  } else if (auto functional = dyn_cast<FunctionalExpression>(expr)) {
+    tag(Tag::FunctionalExpression);
+    position(expr->position);
+    expression(functional->expr.get());
+
+    const auto* postfix = functional->postfix.get();
+    if (auto call = dyn_cast<FnCallPostfix>(postfix)) {
+      tag(Tag::FnCallPostfix);
+      position(postfix->position);
+      expressions(call->args);
+    } else if (auto member = dyn_cast<MemberAccessPostfix>(postfix)) {
+      tag(Tag::MemberAccessPostfix);
+      position(postfix->position);
+      wstring(member->member);
+    } else if (auto variant = dyn_cast<VariantAccessPostfix>(postfix)) {
+      tag(Tag::VariantAccessPostfix);
+      position(postfix->position);
+      wstring(variant->variant);
+    } else {
+      throw std::logic_error("Unknown functional postfix type!");
+    }
+  } else if (auto identifier = dyn_cast<IdentifierExpr>(expr)) {
+    tag(Tag::IdentifierExpr);
+    position(expr->position);
+    wstring(identifier->name);
+  } else if (auto intLiteral = dyn_cast<Literal<int>>(expr)) {
+    tag(Tag::IntLiteral);
+    position(expr->position);
+    varint(static_cast<std::uint32_t>(intLiteral->value));
+  } else if (auto floatLiteral = dyn_cast<Literal<float>>(expr)) {
+    tag(Tag::FloatLiteral);
+    position(expr->position);
+    raw(&floatLiteral->value, sizeof(float));
+  } else if (auto boolLiteral = dyn_cast<Literal<bool>>(expr)) {
+    tag(Tag::BoolLiteral);
+    position(expr->position);
+    u8(boolLiteral->value);
+  } else if (auto charLiteral = dyn_cast<Literal<wchar_t>>(expr)) {
+    tag(Tag::CharLiteral);
+    position(expr->position);
+    varint(static_cast<std::uint32_t>(charLiteral->value));
+  } else if (auto stringLiteral = dyn_cast<Literal<std::wstring>>(expr)) {
+    tag(Tag::StringLiteral);
+    position(expr->position);
+    wstring(stringLiteral->value);
+  } else if (auto object = dyn_cast<Object>(expr)) {
+    tag(Tag::Object);
+    position(expr->position);
+    varint(object->members.size());
+    for (const auto& [name, member] : object->members) {
+      wstring(member.name);
+      expression(member.value.get());
+    }
+  } else if (auto paren = dyn_cast<ParenExpr>(expr)) {
+    tag(Tag::ParenExpr);
+    position(expr->position);
+    expression(paren->expr.get());
+  } else if (auto cast = dyn_cast<CastExpr>(expr)) {
+    tag(Tag::CastExpr);
+    position(expr->position);
+    u8(static_cast<std::uint8_t>(cast->type));
+    expression(cast->expr.get());
+  } else if (auto shared = dyn_cast<SharedExpr>(expr)) {
+    // Sharing is not part of the format, every use is written out as a copy of the subtree
+    expression(shared->expr);
+  } else {
+    throw std::logic_error("Unknown expression type!");
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   Reader                                   */
+/* -------------------------------------------------------------------------- */
+
+struct MalformedData : public std::runtime_error {
+  MalformedData() : std::runtime_error("Malformed AST data!") {}
+};
+
+class Reader {
+ public:
+  Reader(const std::uint8_t* data, std::size_t size) : m_data{data}, m_end{data + size} {}
+
+  std::uint8_t u8() {
+    if (m_data == m_end) throw MalformedData{};
+    return *m_data++;
+  }
+
+  void raw(void* data, std::size_t size) {
+    if (static_cast<std::size_t>(m_end - m_data) < size) throw MalformedData{};
+    std::memcpy(data, m_data, size);
+    m_data += size;
+  }
+
+  std::uint64_t varint() {
+    std::uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      auto byte = u8();
+      value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+      if ((byte & 0x80) == 0) return value;
+    }
+    throw MalformedData{};
+  }
+
+  // Guards against allocating huge containers because of a corrupted length
+  std::size_t length() {
+    auto length = varint();
+    if (length > static_cast<std::size_t>(m_end - m_data)) throw MalformedData{};
+    return length;
+  }
+
+  std::string string() {
+    std::string str(length(), '\0');
+    raw(str.data(), str.size());
+    return str;
+  }
+
+  // Whether the next string is `expected`, compared in place
+  bool string(std::string_view expected) {
+    auto size = length();
+    auto equal = std::string_view{reinterpret_cast<const char*>(m_data), size} == expected;
+    m_data += size;
+    return equal;
+  }
+
+  std::wstring wstring() {
+    std::wstring str(length(), L'\0');
+    for (auto& c : str) c = static_cast<wchar_t>(varint());
+    return str;
+  }
+
+  Tag tag() {
+    auto value = u8();
+    if (value > static_cast<std::uint8_t>(Tag::CastExpr)) throw MalformedData{};
+    return static_cast<Tag>(value);
+  }
+
+  Position position() {
+    Position position;
+    position.line = static_cast<int>(varint());
+    position.column = static_cast<int>(varint());
+    position.sourceFile = sourceFile;
+    return position;
+  }
+
+  std::optional<Operator> op() {
+    auto value = u8();
+    if (value == NO_OPERATOR) return std::nullopt;
+    if (value > static_cast<std::uint8_t>(Operator::Geq)) throw MalformedData{};
+    return static_cast<Operator>(value);
+  }
+
+  bool atEnd() const { return m_data == m_end; }
+
+  std::unique_ptr<Definition> definition(Tag tag);
+  std::unique_ptr<Statement> statement();
+  BlockStmt block();
+  std::unique_ptr<Expression> expression();
+  std::vector<std::unique_ptr<Expression>> expressions();
+
+  std::string sourceFile;
+
+ private:
+  const std::uint8_t* m_data;
+  const std::uint8_t* m_end;
+};
+
+std::unique_ptr<Definition> Reader::definition(Tag tag) {
+  auto pos = position();
+  auto name = wstring();
+
+  switch (tag) {
+    case Tag::VarDef: {
+      auto type = wstring();
+      auto value = expression();
+      return std::make_unique<VarDef>(std::move(pos), std::move(name), std::move(type),
+                                      std::move(value));
+    }
+    case Tag::ConstDef: {
+      auto type = wstring();
+      auto value = expression();
+      return std::make_unique<ConstDef>(std::move(pos), std::move(name), std::move(type),
+                                        std::move(value));
+    }
+    case Tag::StructDef: {
+      StructDef::Members members;
+      for (auto count = length(); count > 0; count--) {
+        auto memberPos = position();
+        auto memberName = wstring();
+        auto memberType = wstring();
+        auto key = memberName;
+        members.insert(std::make_pair(
+            std::move(key),
+            StructMember{std::move(memberPos), std::move(memberName), std::move(memberType)}));
+      }
+      return std::make_unique<StructDef>(std::move(pos), std::move(name), std::move(members));
+    }
+    case Tag::VariantDef: {
+      VariantDef::Types types;
+      for (auto count = length(); count > 0; count--) types.push_back(wstring());
+      return std::make_unique<VariantDef>(std::move(pos), std::move(name), std::move(types));
+    }
+    case Tag::FnDef: {
+      FnDef::Params params;
+      for (auto count = length(); count > 0; count--) {
+        auto paramPos = position();
+        bool isConst = u8() != 0;
+        auto paramName = wstring();
+        auto paramType = wstring();
+        auto key = paramName;
+        params.insert(std::make_pair(std::move(key),
+                                     FnParam{std::move(paramPos), isConst, std::move(paramName),
+                                             std::move(paramType)}));
+      }
+      auto returnType = wstring();
+      auto body = block();
+      return std::make_unique<FnDef>(std::move(pos), std::move(name), std::move(params),
+                                     std::move(returnType), std::move(body));
+    }
+    default:
+      throw MalformedData{};
+  }
+}
+
+BlockStmt Reader::block() {
+  auto pos = position();
+  BlockStmt::Statements statements;
+  for (auto count = length(); count > 0; count--) {
+    auto stmt = statement();
+    if (stmt == nullptr) throw MalformedData{};
+    statements.push_back(std::move(stmt));
+  }
+  return BlockStmt{std::move(pos), std::move(statements)};
+}
+
+std::unique_ptr<Statement> Reader::statement() {
+  auto type = tag();
+
+  switch (type) {
+    case Tag::Null:
+      return nullptr;
+    case Tag::VarDef:
+    case Tag::ConstDef:
+    case Tag::StructDef:
+    case Tag::VariantDef:
+    case Tag::FnDef:
+      return definition(type);
+    case Tag::BlockStmt:
+      return std::make_unique<BlockStmt>(block());
+    default:
+      break;
+  }
+
+  auto pos = position();
+  switch (type) {
+    case Tag::ExpressionStmt:
+      return std::make_unique<ExpressionStmt>(std::move(pos), expression());
+    case Tag::AssignmentStmt: {
+      auto lhs = expression();
+      auto rhs = expression();
+      return std::make_unique<AssignmentStmt>(std::move(pos), std::move(lhs), std::move(rhs));
+    }
+    case Tag::StdinExtractionStmt:
+      return std::make_unique<StdinExtractionStmt>(std::move(pos), expressions());
+    case Tag::StdoutInsertionStmt:
+      return std::make_unique<StdoutInsertionStmt>(std::move(pos), expressions());
+    case Tag::VariantMatchStmt: {
+      auto expr = expression();
+      VariantMatchStmt::Cases cases;
+      for (auto count = length(); count > 0; count--) {
+        auto casePos = position();
+        auto variant = wstring();
+        auto key = variant;
+        cases.insert(std::make_pair(
+            std::move(key), VariantMatchCase{std::move(casePos), std::move(variant), block()}));
+      }
+      return std::make_unique<VariantMatchStmt>(std::move(pos), std::move(expr), std::move(cases));
+    }
+    case Tag::IfStmt: {
+      auto condition = expression();
+      auto body = block();
+      IfStmt::Elifs elifs;
+      for (auto count = length(); count > 0; count--) {
+        auto elifPos = position();
+        auto elifCondition = expression();
+        elifs.emplace_back(std::move(elifPos), std::move(elifCondition), block());
+      }
+      std::unique_ptr<Else> elseClause;
+      if (u8() != 0) {
+        auto elsePos = position();
+        elseClause = std::make_unique<Else>(std::move(elsePos), block());
+      }
+      return std::make_unique<IfStmt>(std::move(pos), std::move(condition), std::move(body),
+                                      std::move(elifs), std::move(elseClause));
+    }
+    case Tag::ForStmt: {
+      auto identifier = wstring();
+      auto rangePos = position();
+      auto start = expression();
+      auto end = expression();
+      Range range{std::move(rangePos), std::move(start), std::move(end)};
+      return std::make_unique<ForStmt>(std::move(pos), std::move(identifier), std::move(range),
+                                       block());
+    }
+    case Tag::WhileStmt: {
+      auto condition = expression();
+      return std::make_unique<WhileStmt>(std::move(pos), std::move(condition), block());
+    }
+    case Tag::ContinueStmt:
+      return std::make_unique<ContinueStmt>(std::move(pos));
+    case Tag::BreakStmt:
+      return std::make_unique<BreakStmt>(std::move(pos));
+    case Tag::ReturnStmt:
+      return std::make_unique<ReturnStmt>(std::move(pos), expression());
+    default:
+      throw MalformedData{};
+  }
+}
+
+std::vector<std::unique_ptr<Expression>> Reader::expressions() {
+  std::vector<std::unique_ptr<Expression>> exprs;
+  for (auto count = length(); count > 0; count--) exprs.push_back(expression());
+  return exprs;
+}
+
+std::unique_ptr<Expression> Reader::expression() {
+  auto type = tag();
+  if (type == Tag::Null) return nullptr;
+
+  auto pos = position();
+  switch (type) {
+    case Tag::BinaryExpression: {
+      auto binaryOp = op();
+      auto lhs = expression();
+      auto rhs = expression();
+      return std::make_unique<BinaryExpression>(std::move(pos), std::move(lhs), binaryOp,
+                                                std::move(rhs));
+    }
+    case Tag::UnaryExpression: {
+      auto unaryOp = op();
+      return std::make_unique<UnaryExpression>(std::move(pos), unaryOp, expression());
+    }
+    case Tag::FunctionalExpression: {
+      auto expr = expression();
+      auto postfixType = tag();
+      auto postfixPos = position();
+      std::unique_ptr<FunctionalPostfix> postfix;
+      if (postfixType == Tag::FnCallPostfix) {
+        postfix = std::make_unique<FnCallPostfix>(std::move(postfixPos), expressions());
+      } else if (postfixType == Tag::MemberAccessPostfix) {
+        postfix = std::make_unique<MemberAccessPostfix>(std::move(postfixPos), wstring());
+      } else if (postfixType == Tag::VariantAccessPostfix) {
+        postfix = std::make_unique<VariantAccessPostfix>(std::move(postfixPos), wstring());
+      } else {
+        throw MalformedData{};
+      }
+      return std::make_unique<FunctionalExpression>(std::move(pos), std::move(expr),
+                                                    std::move(postfix));
+    }
+    case Tag::IdentifierExpr:
+      return std::make_unique<IdentifierExpr>(std::move(pos), wstring());
+    case Tag::IntLiteral: {
+      int value = static_cast<int>(static_cast<std::uint32_t>(varint()));
+      return std::make_unique<Literal<int>>(std::move(pos), std::move(value));
+    }
+    case Tag::FloatLiteral: {
+      float value;
+      raw(&value, sizeof(float));
+      return std::make_unique<Literal<float>>(std::move(pos), std::move(value));
+    }
+    case Tag::BoolLiteral: {
+      bool value = u8() != 0;
+      return std::make_unique<Literal<bool>>(std::move(pos), std::move(value));
+    }
+    case Tag::CharLiteral: {
+      wchar_t value = static_cast<wchar_t>(varint());
+      return std::make_unique<Literal<wchar_t>>(std::move(pos), std::move(value));
+    }
+    case Tag::StringLiteral:
+      return std::make_unique<Literal<std::wstring>>(std::move(pos), wstring());
+    case Tag::Object: {
+      Object::Members members;
+      for (auto count = length(); count > 0; count--) {
+        auto name = wstring();
+        auto key = name;
+        members.insert(std::make_pair(std::move(key), ObjectMember{std::move(name), expression()}));
+      }
+      return std::make_unique<Object>(std::move(pos), std::move(members));
+    }
+    case Tag::ParenExpr:
+      return std::make_unique<ParenExpr>(std::move(pos), expression());
+    case Tag::CastExpr: {
+      auto primitiveType = u8();
+      if (primitiveType > static_cast<std::uint8_t>(PrimitiveType::String)) throw MalformedData{};
+      return std::make_unique<CastExpr>(std::move(pos), static_cast<PrimitiveType>(primitiveType),
+                                        expression());
+    }
+    default:
+      throw MalformedData{};
+  }
+}
+
+}  // namespace
+
+std::vector<std::uint8_t> serializeProgram(const Program& program, std::string_view source,
+                                           const std::string& toolVersion) {
+  Writer writer;
+
+  writer.raw(AST_MAGIC, sizeof(AST_MAGIC));
+  writer.raw(&AST_FORMAT_VERSION, sizeof(AST_FORMAT_VERSION));
+  writer.string(toolVersion);
+  writer.string(source);
+  writer.string(program.position.sourceFile);
+
+  writer.position(program.position);
+  writer.varint(program.definitions.size());
+  for (const auto& [name, definition] : program.definitions) writer.definition(*definition);
+
+  return std::move(writer.bytes);
+}
+
+std::optional<Program> deserializeProgram(const std::uint8_t* data, std::size_t size,
+                                          std::string_view source, const std::string& toolVersion,
+                                          std::optional<std::string> sourceFile) {
+  Reader reader{data, size};
+
+  try {
+    char magic[sizeof(AST_MAGIC)];
+    std::uint32_t formatVersion;
+
+    reader.raw(magic, sizeof(magic));
+    reader.raw(&formatVersion, sizeof(formatVersion));
+    if (std::memcmp(magic, AST_MAGIC, sizeof(AST_MAGIC)) != 0 ||
+        formatVersion != AST_FORMAT_VERSION || !reader.string(toolVersion) ||
+        !reader.string(source)) {
+      return std::nullopt;
+    }
+    reader.sourceFile = reader.string();
+    if (sourceFile.has_value()) reader.sourceFile = std::move(*sourceFile);
+
+    auto position = reader.position();
+    Program::Definitions definitions;
+    for (auto count = reader.length(); count > 0; count--) {
+      auto definition = reader.definition(reader.tag());
+      auto entry = std::make_pair(definition->name, std::move(definition));
+      definitions.insert(std::move(entry));
+    }
+    if (!reader.atEnd()) return std::nullopt;
+
+    return Program{std::move(position), std::move(definitions)};
+  } catch (const MalformedData&) {
+    return std::nullopt;
+  }
+}
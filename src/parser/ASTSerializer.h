@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Definition.h"
+#include "Program.h"
+
+/*
+ * Binary AST format
+ *
+ *   header  = magic "PAST", u32 formatVersion, string toolVersion, string source,
+ *             string sourceFile;
+ *   program = position, varint definitionCount, { node };
+ *   node    = u8 tag, position, fields of the node in declaration order;
+ *
+ * Integers are LEB128 varints, floats are stored as their raw 4 bytes and strings as a length
+ * followed by code points. Every position shares the source file stored in the header. The whole
+ * source is stored too, the data is only used for the very source it was parsed from.
+ */
+const std::uint32_t AST_FORMAT_VERSION = 2;
+
+std::vector<std::uint8_t> serializeProgram(const Program& program, std::string_view source,
+                                           const std::string& toolVersion);
+
+/**
+ * @brief Rebuilds the program straight from the given bytes, which are typically a memory
+ * mapped cache file.
+ *
+ * Positions refer to `sourceFile` if given, instead of the file the program was serialized from:
+ * files with the same contents share their serialized programs.
+ *
+ * @return std::nullopt if the data is malformed, was written by another format or tool version,
+ * or for a different source.
+ */
+std::optional<Program> deserializeProgram(const std::uint8_t* data, std::size_t size,
+                                          std::string_view source, const std::string& toolVersion,
+                                          std::optional<std::string> sourceFile = std::nullopt);
@@ -0,0 +1,348 @@
+#include <algorithm>
+#include <iomanip>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "ASTStats.h"
+#include "RecursiveASTVisitor.h"
+
+namespace {
+
+// glibc malloc: 8 byte chunk header, 16 byte alignment, 32 byte minimal chunk
+constexpr std::size_t MALLOC_HEADER = 8;
+constexpr std::size_t MALLOC_ALIGNMENT = 16;
+constexpr std::size_t MALLOC_MIN_CHUNK = 32;
+
+std::size_t mallocOverhead(std::size_t size) {
+  auto chunk = (size + MALLOC_HEADER + MALLOC_ALIGNMENT - 1) / MALLOC_ALIGNMENT * MALLOC_ALIGNMENT;
+  return std::max(chunk, MALLOC_MIN_CHUNK) - size;
+}
+
+template <typename Char>
+std::size_t stringHeapBytes(const std::basic_string<Char>& str) {
+  static const auto inlineCapacity = std::basic_string<Char>{}.capacity();
+  return str.capacity() > inlineCapacity ? (str.capacity() + 1) * sizeof(Char) : 0;
+}
+
+/**
+ * @brief Nodes embedded by value in their parent (or in a container buffer of the parent) are not
+ * allocated on their own.
+ */
+bool isSeparatelyAllocated(NodeKind kind, NodeKind parent) {
+  switch (kind) {
+    case NodeKind::Program:
+    case NodeKind::StructMember:
+    case NodeKind::FnParam:
+    case NodeKind::VariantMatchCase:
+    case NodeKind::Elif:
+    case NodeKind::Range:
+      return false;
+    case NodeKind::BlockStmt:
+      return parent == NodeKind::BlockStmt;
+    default:
+      return true;
+  }
+}
+
+class StatsCollector : public RecursiveASTVisitor<StatsCollector> {
+ public:
+  ASTStats collect(Program& program) {
+    traverse(program);
+
+    for (const auto& entry : m_stats.perKind) {
+      m_stats.totalNodes += entry.count;
+      m_stats.totalBytes += entry.bytes;
+    }
+    if (m_innerNodes > 0) {
+      m_stats.averageFanOut = static_cast<double>(m_edges) / static_cast<double>(m_innerNodes);
+    }
+    return m_stats;
+  }
+
+  template <typename Node>
+  void visit(Node& node) {
+    auto parent = m_path.empty() ? NodeKind::Program : m_path.back().kind;
+    if (!m_path.empty()) m_path.back().children++;
+    m_path.push_back({node.kind, 0});
+    m_stats.maxDepth = std::max(m_stats.maxDepth, m_path.size());
+
+    m_bytes = sizeof(Node);
+    if (isSeparatelyAllocated(node.kind, parent)) countAllocation(sizeof(Node));
+    position(node.position);
+    payload(node);
+
+    auto& entry = m_stats.perKind[static_cast<std::size_t>(node.kind)];
+    entry.count++;
+    entry.bytes += m_bytes;
+  }
+
+  // A shared subtree is counted at its first use only
+  bool visit(SharedExpr& expr) {
+    visit<SharedExpr>(expr);
+    return m_sharedVisited.insert(expr.expr).second;
+  }
+
+  template <typename Node>
+  void postVisit(Node&) {
+    if (auto children = m_path.back().children; children > 0) {
+      m_innerNodes++;
+      m_edges += children;
+    }
+    m_path.pop_back();
+  }
+
+ private:
+  struct PathEntry {
+    NodeKind kind;
+    std::size_t children;
+  };
+
+  /* --------------------------- Owned heap memory -------------------------- */
+
+  void payload(ASTNode&) {}
+  void payload(Program& program) {
+    map(program.definitions);
+    vector(program.sharedExpressions);
+  }
+
+  void payload(VarDef& def) {
+    identifier(def.name);
+    identifier(def.type);
+  }
+  void payload(ConstDef& def) {
+    identifier(def.name);
+    identifier(def.type);
+  }
+  void payload(StructDef& def) {
+    identifier(def.name);
+    map(def.members, sizeof(StructMember));
+  }
+  void payload(StructMember& member) {
+    identifier(member.name);
+    identifier(member.type);
+  }
+  void payload(VariantDef& def) {
+    identifier(def.name);
+    vector(def.types);
+    for (auto& type : def.types) identifier(type, false);
+  }
+  void payload(FnDef& def) {
+    identifier(def.name);
+    identifier(def.returnType);
+    map(def.parameters, sizeof(FnParam));
+    m_bytes -= sizeof(BlockStmt);
+  }
+  void payload(FnParam& param) {
+    identifier(param.name);
+    identifier(param.type);
+  }
+
+  void payload(BlockStmt& stmt) { vector(stmt.statements); }
+  void payload(StdinExtractionStmt& stmt) { vector(stmt.expressions); }
+  void payload(StdoutInsertionStmt& stmt) { vector(stmt.expressions); }
+  void payload(VariantMatchStmt& stmt) { map(stmt.cases, sizeof(VariantMatchCase)); }
+  void payload(VariantMatchCase& matchCase) {
+    identifier(matchCase.variant);
+    m_bytes -= sizeof(BlockStmt);
+  }
+  void payload(IfStmt& stmt) {
+    vector(stmt.elifs, sizeof(Elif));
+    m_bytes -= sizeof(BlockStmt);
+  }
+  void payload(Elif&) { m_bytes -= sizeof(BlockStmt); }
+  void payload(Else&) { m_bytes -= sizeof(BlockStmt); }
+  void payload(ForStmt& stmt) {
+    identifier(stmt.identifier);
+    m_bytes -= sizeof(Range) + sizeof(BlockStmt);
+  }
+  void payload(WhileStmt&) { m_bytes -= sizeof(BlockStmt); }
+
+  void payload(IdentifierExpr& expr) { identifier(expr.name); }
+  void payload(FnCallPostfix& postfix) { vector(postfix.args); }
+  void payload(MemberAccessPostfix& postfix) { identifier(postfix.member); }
+  void payload(VariantAccessPostfix& postfix) { identifier(postfix.variant); }
+  void payload(Literal<std::wstring>& literal) { allocate(stringHeapBytes(literal.value)); }
+  void payload(Object& object) {
+    map(object.members);
+    for (auto& [name, member] : object.members) identifier(member.name, false);
+  }
+  void payload(InlinedCall& call) {
+    identifier(call.callee);
+    vector(call.parameters);
+    for (auto& parameter : call.parameters) identifier(parameter.name, false);
+    vector(call.args);
+    m_bytes -= sizeof(BlockStmt);
+  }
+
+  /* -------------------------------- Helpers ------------------------------- */
+
+  void countAllocation(std::size_t size) {
+    m_stats.heapAllocations++;
+    m_stats.heapOverheadBytes += mallocOverhead(size);
+  }
+
+  void allocate(std::size_t size) {
+    if (size == 0) return;
+    countAllocation(size);
+    m_bytes += size;
+  }
+
+  // `inNode` is false for strings stored in a container buffer, already counted with the buffer
+  void identifier(const std::wstring& name, bool inNode = true) {
+    auto heap = stringHeapBytes(name);
+    allocate(heap);
+    m_stats.identifierBytes += heap + (inNode ? sizeof(name) : 0);
+  }
+
+  void position(const Position& position) {
+    auto heap = stringHeapBytes(position.sourceFile);
+    allocate(heap);
+    m_stats.positionBytes += sizeof(Position) + heap;
+  }
+
+  // Elements that are nodes themselves are counted under their own kind
+  template <typename T>
+  void vector(const std::vector<T>& elements, std::size_t elementNodeSize = 0) {
+    if (elements.capacity() == 0) return;
+    countAllocation(elements.capacity() * sizeof(T));
+    m_bytes += elements.capacity() * sizeof(T) - elements.size() * elementNodeSize;
+  }
+
+  // Approximates libstdc++: bucket array plus one node (next pointer, value, cached hash) per entry
+  template <typename Map>
+  void map(const Map& map, std::size_t valueNodeSize = 0) {
+    if (map.bucket_count() > 1) allocate(map.bucket_count() * sizeof(void*));
+    for (auto& [key, value] : map) {
+      auto nodeSize = sizeof(void*) + sizeof(typename Map::value_type) + sizeof(std::size_t);
+      countAllocation(nodeSize);
+      m_bytes += nodeSize - valueNodeSize;
+      identifier(key, false);
+    }
+  }
+
+  ASTStats m_stats;
+  std::vector<PathEntry> m_path;
+  std::size_t m_bytes = 0;
+  std::size_t m_innerNodes = 0;
+  std::size_t m_edges = 0;
+  std::unordered_set<const Expression*> m_sharedVisited;
+};
+
+}  // namespace
+
+ASTStats collectASTStats(Program& program) { return StatsCollector{}.collect(program); }
+
+void printASTStats(std::ostream& out, const ASTStats& stats) {
+  std::vector<NodeKind> kinds;
+  for (std::size_t i = 0; i < NUM_NODE_KINDS; i++) {
+    if (stats.perKind[i].count > 0) kinds.push_back(static_cast<NodeKind>(i));
+  }
+  std::sort(kinds.begin(), kinds.end(),
+            [&](NodeKind lhs, NodeKind rhs) { return stats[lhs].bytes > stats[rhs].bytes; });
+
+  out << "AST statistics\n"
+      << "  " << std::left << std::setw(22) << "node kind" << std::right << std::setw(10)
+      << "count" << std::setw(14) << "bytes" << "\n";
+  for (auto kind : kinds) {
+    out << "  " << std::left << std::setw(22) << nodeKindName(kind) << std::right
+        << std::setw(10) << stats[kind].count << std::setw(14) << stats[kind].bytes << "\n";
+  }
+  out << "  " << std::left << std::setw(22) << "total" << std::right << std::setw(10)
+      << stats.totalNodes << std::setw(14) << stats.totalBytes << "\n"
+      << "  identifier payloads: " << stats.identifierBytes << " bytes\n"
+      << "  position copies: " << stats.positionBytes << " bytes\n"
+      << "  max depth: " << stats.maxDepth << "\n"
+      << "  average fan-out: " << std::fixed << std::setprecision(2) << stats.averageFanOut
+      << "\n"
+      << "  heap allocations: " << stats.heapAllocations << "\n"
+      << "  estimated heap overhead: " << stats.heapOverheadBytes << " bytes\n";
+}
+
+std::string_view nodeKindName(NodeKind kind) {
+  switch (kind) {
+    case NodeKind::Program:
+      return "Program";
+    case NodeKind::VarDef:
+      return "VarDef";
+    case NodeKind::ConstDef:
+      return "ConstDef";
+    case NodeKind::StructDef:
+      return "StructDef";
+    case NodeKind::VariantDef:
+      return "VariantDef";
+    case NodeKind::FnDef:
+      return "FnDef";
+    case NodeKind::BlockStmt:
+      return "BlockStmt";
+    case NodeKind::ExpressionStmt:
+      return "ExpressionStmt";
+    case NodeKind::AssignmentStmt:
+      return "AssignmentStmt";
+    case NodeKind::StdinExtractionStmt:
+      return "StdinExtractionStmt";
+    case NodeKind::StdoutInsertionStmt:
+      return "StdoutInsertionStmt";
+    case NodeKind::VariantMatchStmt:
+      return "VariantMatchStmt";
+    case NodeKind::IfStmt:
+      return "IfStmt";
+    case NodeKind::ForStmt:
+      return "ForStmt";
+    case NodeKind::WhileStmt:
+      return "WhileStmt";
+    case NodeKind::ContinueStmt:
+      return "ContinueStmt";
+    case NodeKind::BreakStmt:
+      return "BreakStmt";
+    case NodeKind::ReturnStmt:
+      return "ReturnStmt";
+    case NodeKind::BinaryExpression:
+      return "BinaryExpression";
+    case NodeKind::UnaryExpression:
+      return "UnaryExpression";
+    case NodeKind::FunctionalExpression:
+      return "FunctionalExpression";
+    case NodeKind::IdentifierExpr:
+      return "IdentifierExpr";
+    case NodeKind::IntLiteral:
+      return "IntLiteral";
+    case NodeKind::FloatLiteral:
+      return "FloatLiteral";
+    case NodeKind::BoolLiteral:
+      return "BoolLiteral";
+    case NodeKind::CharLiteral:
+      return "CharLiteral";
+    case NodeKind::StringLiteral:
+      return "StringLiteral";
+    case NodeKind::Object:
+      return "Object";
+    case NodeKind::ParenExpr:
+      return "ParenExpr";
+    case NodeKind::CastExpr:
+      return "CastExpr";
+    case NodeKind::SharedExpr:
+      return "SharedExpr";
+    case NodeKind::InlinedCall:
+      return "InlinedCall";
+    case NodeKind::FnCallPostfix:
+      return "FnCallPostfix";
+    case NodeKind::MemberAccessPostfix:
+      return "MemberAccessPostfix";
+    case NodeKind::VariantAccessPostfix:
+      return "VariantAccessPostfix";
+    case NodeKind::StructMember:
+      return "StructMember";
+    case NodeKind::FnParam:
+      return "FnParam";
+    case NodeKind::VariantMatchCase:
+      return "VariantMatchCase";
+    case NodeKind::Elif:
+      return "Elif";
+    case NodeKind::Else:
+      return "Else";
+    case NodeKind::Range:
+      return "Range";
+  }
+  return "Unknown";
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <ostream>
+#include <string_view>
+
+#include "ASTNode.h"
+#include "Program.h"
+
+struct NodeKindStats {
+  std::size_t count = 0;
+  std::size_t bytes = 0;
+};
+
+/**
+ * @brief Memory and shape of an AST. Bytes of a node type are the sizes of its nodes plus the
+ * heap memory they own directly (strings, vector buffers, hash map nodes and buckets). Nodes
+ * embedded by value in another node are counted only once, under their own type.
+ *
+ * Heap overhead is an estimate of the malloc bookkeeping and padding of every allocation the
+ * tree makes (8 bytes of header, 16 byte alignment), the AST is not allocated in an arena.
+ */
+struct ASTStats {
+  std::array<NodeKindStats, NUM_NODE_KINDS> perKind{};
+
+  std::size_t totalNodes = 0;
+  std::size_t totalBytes = 0;
+
+  // Included in the per-kind bytes
+  std::size_t identifierBytes = 0;
+  std::size_t positionBytes = 0;
+
+  std::size_t maxDepth = 0;
+  double averageFanOut = 0;
+
+  std::size_t heapAllocations = 0;
+  std::size_t heapOverheadBytes = 0;
+
+  const NodeKindStats& operator[](NodeKind kind) const {
+    return perKind[static_cast<std::size_t>(kind)];
+  }
+};
+
+ASTStats collectASTStats(Program& program);
+void printASTStats(std::ostream& out, const ASTStats& stats);
+
+std::string_view nodeKindName(NodeKind kind);
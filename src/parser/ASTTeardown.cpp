@@ -0,0 +1,111 @@
+#include <vector>
+
+#include "ASTTeardown.h"
+#include "Casting.h"
+#include "Definition.h"
+#include "Expression.h"
+#include "Statement.h"
+
+namespace {
+
+using Nodes = std::vector<std::unique_ptr<ASTNode>>;
+
+template <typename T>
+void detach(std::unique_ptr<T>& child, Nodes& nodes) {
+  if (child != nullptr) nodes.push_back(std::move(child));
+}
+
+template <typename T>
+void detach(std::vector<std::unique_ptr<T>>& children, Nodes& nodes) {
+  for (auto& child : children) detach(child, nodes);
+  children.clear();
+}
+
+/**
+ * @brief Moves all owned subtrees of `node` to `nodes`, leaving it without children.
+ */
+void detachChildren(ASTNode& node, Nodes& nodes) {
+  if (auto binary = dyn_cast<BinaryExpression>(&node)) {
+    detach(binary->lhs, nodes);
+    detach(binary->rhs, nodes);
+  } else if (auto unary = dyn_cast<UnaryExpression>(&node)) {
+    detach(unary->expr, nodes);
+  } else if (auto functional = dyn_cast<FunctionalExpression>(&node)) {
+    detach(functional->expr, nodes);
+    detach(functional->postfix, nodes);
+  } else if (auto call = dyn_cast<FnCallPostfix>(&node)) {
+    detach(call->args, nodes);
+  } else if (auto object = dyn_cast<Object>(&node)) {
+    for (auto& [name, member] : object->members) detach(member.value, nodes);
+  } else if (auto paren = dyn_cast<ParenExpr>(&node)) {
+    detach(paren->expr, nodes);
+  } else if (auto cast = dyn_cast<CastExpr>(&node)) {
+    detach(cast->expr, nodes);
+  } else if (auto inlined = dyn_cast<InlinedCall>(&node)) {
+    detach(inlined->args, nodes);
+    detach(inlined->body.statements, nodes);
+  } else if (auto block = dyn_cast<BlockStmt>(&node)) {
+    detach(block->statements, nodes);
+  } else if (auto exprStmt = dyn_cast<ExpressionStmt>(&node)) {
+    detach(exprStmt->expr, nodes);
+  } else if (auto assignment = dyn_cast<AssignmentStmt>(&node)) {
+    detach(assignment->lhs, nodes);
+    detach(assignment->rhs, nodes);
+  } else if (auto extraction = dyn_cast<StdinExtractionStmt>(&node)) {
+    detach(extraction->expressions, nodes);
+  } else if (auto insertion = dyn_cast<StdoutInsertionStmt>(&node)) {
+    detach(insertion->expressions, nodes);
+  } else if (auto match = dyn_cast<VariantMatchStmt>(&node)) {
+    detach(match->expr, nodes);
+    for (auto& [variant, matchCase] : match->cases) detach(matchCase.block.statements, nodes);
+  } else if (auto ifStmt = dyn_cast<IfStmt>(&node)) {
+    detach(ifStmt->condition, nodes);
+    detach(ifStmt->block.statements, nodes);
+    for (auto& elif : ifStmt->elifs) {
+      detach(elif.condition, nodes);
+      detach(elif.block.statements, nodes);
+    }
+    detach(ifStmt->elseClause, nodes);
+  } else if (auto elseClause = dyn_cast<Else>(&node)) {
+    detach(elseClause->block.statements, nodes);
+  } else if (auto forStmt = dyn_cast<ForStmt>(&node)) {
+    detach(forStmt->range.start, nodes);
+    detach(forStmt->range.end, nodes);
+    detach(forStmt->block.statements, nodes);
+  } else if (auto whileStmt = dyn_cast<WhileStmt>(&node)) {
+    detach(whileStmt->condition, nodes);
+    detach(whileStmt->block.statements, nodes);
+  } else if (auto returnStmt = dyn_cast<ReturnStmt>(&node)) {
+    detach(returnStmt->expr, nodes);
+  } else if (auto varDef = dyn_cast<VarDef>(&node)) {
+    detach(varDef->value, nodes);
+  } else if (auto constDef = dyn_cast<ConstDef>(&node)) {
+    detach(constDef->value, nodes);
+  } else if (auto fnDef = dyn_cast<FnDef>(&node)) {
+    detach(fnDef->body.statements, nodes);
+  }
+}
+
+void destroyAll(Nodes& nodes) {
+  while (!nodes.empty()) {
+    auto node = std::move(nodes.back());
+    nodes.pop_back();
+    detachChildren(*node, nodes);
+  }
+}
+
+}  // namespace
+
+void destroyIteratively(std::unique_ptr<ASTNode> node) {
+  Nodes nodes;
+  detach(node, nodes);
+  destroyAll(nodes);
+}
+
+void destroyIteratively(Program& program) {
+  Nodes nodes;
+  for (auto& [name, definition] : program.definitions) detach(definition, nodes);
+  program.definitions.clear();
+  detach(program.sharedExpressions, nodes);
+  destroyAll(nodes);
+}
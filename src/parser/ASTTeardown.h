@@ -0,0 +1,13 @@
+#pragma once
+
+#include <memory>
+
+#include "ASTNode.h"
+#include "Program.h"
+
+/**
+ * @brief Destroys a tree node by node instead of through nested destructor calls, so that trees
+ * nested too deeply for the native stack (see ParsingMode::Iterative) can be released.
+ */
+void destroyIteratively(std::unique_ptr<ASTNode> node);
+void destroyIteratively(Program& program);
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "Casting.h"
+#include "Definition.h"
+#include "Expression.h"
+
+// Whether the position comes before the other one in the source
+inline bool precedes(const Position& lhs, const Position& rhs) {
+  return lhs.line != rhs.line ? lhs.line < rhs.line : lhs.column < rhs.column;
+}
+
+template <typename T>
+std::vector<T*> inSourceOrder(std::vector<T*>&& nodes) {
+  std::sort(nodes.begin(), nodes.end(), [](const auto* lhs, const auto* rhs) {
+    return precedes(lhs->position, rhs->position);
+  });
+  return std::move(nodes);
+}
+
+/**
+ * @brief Parameters of the function in the order they are written in, which is the order the
+ * arguments of its calls are passed in.
+ */
+template <typename Def>
+  requires std::is_same_v<std::remove_const_t<Def>, FnDef>
+auto parametersInOrder(Def& def) {
+  using Param = std::conditional_t<std::is_const_v<Def>, const FnParam, FnParam>;
+  std::vector<Param*> params;
+  for (auto& [name, param] : def.parameters) params.push_back(&param);
+  return inSourceOrder(std::move(params));
+}
+
+/**
+ * @brief Calls `fn` with every owned expression slot of `expr`: the operands, the arguments of
+ * function calls and of inlined calls, and the values of object members. Shared subtrees and the
+ * bodies of inlined calls are not its children.
+ */
+template <typename Expr, typename Fn>
+  requires std::is_same_v<std::remove_const_t<Expr>, Expression>
+void forEachChild(Expr& expr, Fn&& fn) {
+  if (auto binary = dyn_cast<BinaryExpression>(&expr)) {
+    fn(binary->lhs);
+    fn(binary->rhs);
+  } else if (auto unary = dyn_cast<UnaryExpression>(&expr)) {
+    fn(unary->expr);
+  } else if (auto functional = dyn_cast<FunctionalExpression>(&expr)) {
+    fn(functional->expr);
+    if (auto call = dyn_cast<FnCallPostfix>(functional->postfix.get())) {
+      for (auto& arg : call->args) fn(arg);
+    }
+  } else if (auto object = dyn_cast<Object>(&expr)) {
+    for (auto& [name, member] : object->members) fn(member.value);
+  } else if (auto paren = dyn_cast<ParenExpr>(&expr)) {
+    fn(paren->expr);
+  } else if (auto castExpr = dyn_cast<CastExpr>(&expr)) {
+    fn(castExpr->expr);
+  } else if (auto inlined = dyn_cast<InlinedCall>(&expr)) {
+    for (auto& arg : inlined->args) fn(arg);
+  }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cassert>
+#include <type_traits>
+
+#include "ASTNode.h"
+
+/*
+ * LLVM style RTTI for AST nodes. Every node type provides `static bool classof(const ASTNode*)`
+ * testing the node's kind, so a check costs one load and a compare (or a range check for the
+ * abstract categories).
+ */
+
+namespace detail {
+
+template <typename To, typename From>
+using CastResult = std::conditional_t<std::is_const_v<From>, const To, To>;
+
+}  // namespace detail
+
+/**
+ * @brief Whether `node` is a `To`. The node must not be null.
+ */
+template <typename To, typename From>
+bool isa(From* node) {
+  assert(node != nullptr && "isa<> used on a null pointer");
+  return To::classof(node);
+}
+
+template <typename To, typename From>
+  requires(!std::is_pointer_v<From>)
+bool isa(const From& node) {
+  return To::classof(&node);
+}
+
+/**
+ * @brief Checked cast, `node` must be a `To`.
+ */
+template <typename To, typename From>
+detail::CastResult<To, From>* cast(From* node) {
+  assert(isa<To>(node) && "cast<> argument of incompatible type");
+  return static_cast<detail::CastResult<To, From>*>(node);
+}
+
+template <typename To, typename From>
+  requires(!std::is_pointer_v<From>)
+detail::CastResult<To, From>& cast(From& node) {
+  assert(isa<To>(node) && "cast<> argument of incompatible type");
+  return static_cast<detail::CastResult<To, From>&>(node);
+}
+
+/**
+ * @brief `node` as a `To`, or null if it is of a different type. The node must not be null.
+ */
+template <typename To, typename From>
+detail::CastResult<To, From>* dyn_cast(From* node) {
+  return isa<To>(node) ? static_cast<detail::CastResult<To, From>*>(node) : nullptr;
+}
+
+/**
+ * @brief Like dyn_cast, but also accepts a null node.
+ */
+template <typename To, typename From>
+detail::CastResult<To, From>* dyn_cast_or_null(From* node) {
+  return node != nullptr ? dyn_cast<To>(node) : nullptr;
+}
@@ -19,10 +19,16 @@
  */
 struct Definition : public Statement {
  public:
-  Definition(Position&& position, Identifier&& defName)
-      : Statement{std::move(position)}, name{std::move(defName)} {}
+  Definition(NodeKind kind, Position&& position, Identifier&& defName)
+      : Statement{kind, std::move(position)}, name{std::move(defName)} {}
+
+  static bool classof(const ASTNode* node) {
+    return node->kind >= NodeKind::FirstDefinition && node->kind <= NodeKind::LastDefinition;
+  }
 
   Identifier name;
+  Storage storage;
+  TypeId typeId = ERROR_TYPE;  // Of the value, the type itself for struct and variant definitions
 };
 
 /* --------------------------------- VarDef --------------------------------- */
@@ -35,10 +41,12 @@ struct VarDef : public Definition {
  public:
   VarDef(Position&& position, Identifier&& varName, TypeIdentifier&& varType,
          std::unique_ptr<Expression>&& varValue)
-      : Definition{std::move(position), std::move(varName)},
+      : Definition{NodeKind::VarDef, std::move(position), std::move(varName)},
         type{std::move(varType)},
         value{std::move(varValue)} {}
 
+  static bool classof(const ASTNode* node) { return node->kind == NodeKind::VarDef; }
+
   TypeIdentifier type;
   std::unique_ptr<Expression> value;
 };
@@ -53,10 +61,12 @@ struct ConstDef : public Definition {
  public:
   ConstDef(Position&& position, Identifier&& varName, TypeIdentifier&& varType,
            std::unique_ptr<Expression>&& varValue)
-      : Definition{std::move(position), std::move(varName)},
+      : Definition{NodeKind::ConstDef, std::move(position), std::move(varName)},
         type{std::move(varType)},
         value{std::move(varValue)} {}
 
+  static bool classof(const ASTNode* node) { return node->kind == NodeKind::ConstDef; }
+
   TypeIdentifier type;
   std::unique_ptr<Expression> value;
 };
@@ -68,7 +78,11 @@ struct ConstDef : public Definition {
  */
 struct StructMember : public ASTNode {
   StructMember(Position&& position, Identifier&& memberName, TypeIdentifier&& memberType)
-      : ASTNode{std::move(position)}, name{std::move(memberName)}, type{std::move(memberType)} {}
+      : ASTNode{NodeKind::StructMember, std::move(position)},
+        name{std::move(memberName)},
+        type{std::move(memberType)} {}
+
+  static bool classof(const ASTNode* node) { return node->kind == NodeKind::StructMember; }
 
   Identifier name;
   TypeIdentifier type;
@@ -83,7 +97,10 @@ struct StructDef : public Definition {
   using Members = std::unordered_map<Identifier, StructMember>;
 
   StructDef(Position&& position, Identifier&& structName, Members&& structMembers)
-      : Definition{std::move(position), std::move(structName)}, members{std::move(structMembers)} {}
+      : Definition{NodeKind::StructDef, std::move(position), std::move(structName)},
+        members{std::move(structMembers)} {}
+
+  static bool classof(const ASTNode* node) { return node->kind == NodeKind::StructDef; }
 
   Members members;
 };
@@ -99,7 +116,10 @@ struct VariantDef : public Definition {
   using Types = std::vector<TypeIdentifier>;
 
   VariantDef(Position&& position, Identifier&& variantName, Types&& variantTypes)
-      : Definition{std::move(position), std::move(variantName)}, types{std::move(variantTypes)} {}
+      : Definition{NodeKind::VariantDef, std::move(position), std::move(variantName)},
+        types{std::move(variantTypes)} {}
+
+  static bool classof(const ASTNode* node) { return node->kind == NodeKind::VariantDef; }
 
   Types types;
 };
@@ -113,14 +133,18 @@ struct VariantDef : public Definition {
 struct FnParam : public ASTNode {
   FnParam(Position&& position, bool paramIsConst, Identifier&& paramName,
           TypeIdentifier&& paramType)
-      : ASTNode{std::move(position)},
+      : ASTNode{NodeKind::FnParam, std::move(position)},
         isConst{paramIsConst},
         name{std::move(paramName)},
         type{std::move(paramType)} {}
 
+  static bool classof(const ASTNode* node) { return node->kind == NodeKind::FnParam; }
+
   bool isConst;
   Identifier name;
   TypeIdentifier type;
+  Storage storage;
+  TypeId typeId = ERROR_TYPE;
 };
 
 /*
@@ -133,12 +157,17 @@ struct FnDef : public Definition {
 
   FnDef(Position&& position, Identifier&& fnName, Params&& fnParams, TypeIdentifier&& fnReturnType,
         BlockStmt&& fnBody)
-      : Definition{std::move(position), std::move(fnName)},
+      : Definition{NodeKind::FnDef, std::move(position), std::move(fnName)},
         parameters{std::move(fnParams)},
         returnType{std::move(fnReturnType)},
         body{std::move(fnBody)} {}
 
+  static bool classof(const ASTNode* node) { return node->kind == NodeKind::FnDef; }
+
   Params parameters;
   TypeIdentifier returnType;
   BlockStmt body;
+
+  std::uint32_t localCount = 0;  // Frame size including the parameters, see Storage
+  bool isPure = false;           // The result depends only on the arguments, see PurityAnalysis
 };
@@ -2,6 +2,7 @@
 
 #include <memory>
 #include <optional>
+#include <type_traits>
 #include <unordered_map>
 #include <vector>
 
@@ -21,8 +22,14 @@ struct Expression : public ASTNode {
  public:
   virtual ~Expression() = default;
 
+  static bool classof(const ASTNode* node) {
+    return node->kind >= NodeKind::FirstExpression && node->kind <= NodeKind::LastExpression;
+  }
+
+  TypeId typeId = ERROR_TYPE;
+
  protected:
-  Expression(Position&& position) : ASTNode{std::move(position)} {}
+  Expression(NodeKind kind, Position&& position) : ASTNode{kind, std::move(position)} {}
 };
 
 /*
@@ -38,7 +45,12 @@ struct BinaryExpression : public Expression {
  public:
   BinaryExpression(Position&& position, std::unique_ptr<Expression>&& lhs,
                    std::optional<Operator> op, std::unique_ptr<Expression>&& rhs)
-      : Expression{std::move(position)}, lhs{std::move(lhs)}, op{op}, rhs{std::move(rhs)} {}
+      : Expression{NodeKind::BinaryExpression, std::move(position)},
+        lhs{std::move(lhs)},
+        op{op},
+        rhs{std::move(rhs)} {}
+
+  static bool classof(const ASTNode* node) { return node->kind == NodeKind::BinaryExpression; }
 
   std::unique_ptr<Expression> lhs;
   std::optional<Operator> op;
@@ -53,7 +65,9 @@ struct UnaryExpression : public Expression {
  public:
   UnaryExpression(Position&& position, std::optional<Operator> op,
                   std::unique_ptr<Expression>&& expr)
-      : Expression{std::move(position)}, op{op}, expr{std::move(expr)} {}
+      : Expression{NodeKind::UnaryExpression, std::move(position)}, op{op}, expr{std::move(expr)} {}
+
+  static bool classof(const ASTNode* node) { return node->kind == NodeKind::UnaryExpression; }
 
   std::optional<Operator> op;
   std::unique_ptr<Expression> expr;
@@ -66,7 +80,12 @@ struct UnaryExpression : public Expression {
  */
 struct FunctionalPostfix : public ASTNode {
  public:
-  FunctionalPostfix(Position&& position) : ASTNode{std::move(position)} {}
+  FunctionalPostfix(NodeKind kind, Position&& position) : ASTNode{kind, std::move(position)} {}
+
+  static bool classof(const ASTNode* node) {
+    return node->kind >= NodeKind::FirstFunctionalPostfix &&
+           node->kind <= NodeKind::LastFunctionalPostfix;
+  }
 };
 
 /*
@@ -79,7 +98,11 @@ struct FunctionalExpression : public Expression {
  public:
   FunctionalExpression(Position&& position, std::unique_ptr<Expression>&& expr,
                        std::unique_ptr<FunctionalPostfix>&& postfix)
-      : Expression{std::move(position)}, expr{std::move(expr)}, postfix{std::move(postfix)} {}
+      : Expression{NodeKind::FunctionalExpression, std::move(position)},
+        expr{std::move(expr)},
+        postfix{std::move(postfix)} {}
+
+  static bool classof(const ASTNode* node) { return node->kind == NodeKind::FunctionalExpression; }
 
   std::unique_ptr<Expression> expr;
   std::unique_ptr<FunctionalPostfix> postfix;
@@ -95,7 +118,12 @@ struct FunctionalExpression : public Expression {
  */
 struct PrimaryExpression : public Expression {
  public:
-  PrimaryExpression(Position&& position) : Expression{std::move(position)} {}
+  PrimaryExpression(NodeKind kind, Position&& position) : Expression{kind, std::move(position)} {}
+
+  static bool classof(const ASTNode* node) {
+    return node->kind >= NodeKind::FirstPrimaryExpression &&
+           node->kind <= NodeKind::LastPrimaryExpression;
+  }
 };
 
 /* --------------------------- FunctionalPostfixes -------------------------- */
@@ -109,7 +137,9 @@ using FnCallArgs = std::vector<std::unique_ptr<Expression>>;
 struct FnCallPostfix : public FunctionalPostfix {
  public:
   FnCallPostfix(Position&& position, FnCallArgs&& args)
-      : FunctionalPostfix{std::move(position)}, args{std::move(args)} {}
+      : FunctionalPostfix{NodeKind::FnCallPostfix, std::move(position)}, args{std::move(args)} {}
+
+  static bool classof(const ASTNode* node) { return node->kind == NodeKind::FnCallPostfix; }
 
   FnCallArgs args;
 };
@@ -121,9 +151,13 @@ struct FnCallPostfix : public FunctionalPostfix {
 struct MemberAccessPostfix : public FunctionalPostfix {
  public:
   MemberAccessPostfix(Position&& position, Identifier&& member)
-      : FunctionalPostfix{std::move(position)}, member{std::move(member)} {}
+      : FunctionalPostfix{NodeKind::MemberAccessPostfix, std::move(position)},
+        member{std::move(member)} {}
+
+  static bool classof(const ASTNode* node) { return node->kind == NodeKind::MemberAccessPostfix; }
 
   Identifier member;
+  std::uint32_t offset = 0;  // Among the fields of the struct, see TypeTable::layOutStructs()
 };
 
 /*
@@ -133,9 +167,13 @@ struct MemberAccessPostfix : public FunctionalPostfix {
 struct VariantAccessPostfix : public FunctionalPostfix {
  public:
   VariantAccessPostfix(Position&& position, TypeIdentifier&& variant)
-      : FunctionalPostfix{std::move(position)}, variant{std::move(variant)} {}
+      : FunctionalPostfix{NodeKind::VariantAccessPostfix, std::move(position)},
+        variant{std::move(variant)} {}
+
+  static bool classof(const ASTNode* node) { return node->kind == NodeKind::VariantAccessPostfix; }
 
   TypeIdentifier variant;
+  VariantTag tag = 0;  // Of the accessed alternative
 };
 
 /* --------------------------------- Primary -------------------------------- */
@@ -156,9 +194,13 @@ struct VariantAccessPostfix : public FunctionalPostfix {
 struct IdentifierExpr : public PrimaryExpression {
  public:
   IdentifierExpr(Position&& position, Identifier&& name)
-      : PrimaryExpression{std::move(position)}, name{std::move(name)} {}
+      : PrimaryExpression{NodeKind::IdentifierExpr, std::move(position)}, name{std::move(name)} {}
+
+  static bool classof(const ASTNode* node) { return node->kind == NodeKind::IdentifierExpr; }
 
   Identifier name;
+  Storage storage;
+  bool isLastUse = false;  // The value may be moved out of the local, see markLastUses()
 };
 
 /*
@@ -170,11 +212,32 @@ struct IdentifierExpr : public PrimaryExpression {
  *    | String;
  */
 
+template <typename T>
+constexpr NodeKind literalKind() {
+  if constexpr (std::is_same_v<T, int>) {
+    return NodeKind::IntLiteral;
+  } else if constexpr (std::is_same_v<T, float>) {
+    return NodeKind::FloatLiteral;
+  } else if constexpr (std::is_same_v<T, bool>) {
+    return NodeKind::BoolLiteral;
+  } else if constexpr (std::is_same_v<T, wchar_t>) {
+    return NodeKind::CharLiteral;
+  } else {
+    static_assert(std::is_same_v<T, std::wstring>, "Unsupported literal type");
+    return NodeKind::StringLiteral;
+  }
+}
+
 template <typename T>
 struct Literal : public PrimaryExpression {
  public:
+  static constexpr NodeKind Kind = literalKind<T>();
+
   Literal(Position&& position, T&& value)
-      : PrimaryExpression{std::move(position)}, value(std::move(value)) {}
+      : PrimaryExpression{Kind, std::move(position)}, value(std::move(value)) {}
+
+  static bool classof(const ASTNode* node) { return node->kind == Kind; }
+
   T value;
 };
 
@@ -199,7 +262,9 @@ struct Object : public PrimaryExpression {
   using Members = std::unordered_map<Identifier, ObjectMember>;
 
   Object(Position&& position, Members&& members)
-      : PrimaryExpression{std::move(position)}, members{std::move(members)} {}
+      : PrimaryExpression{NodeKind::Object, std::move(position)}, members{std::move(members)} {}
+
+  static bool classof(const ASTNode* node) { return node->kind == NodeKind::Object; }
 
   Members members;
 };
@@ -211,7 +276,9 @@ struct Object : public PrimaryExpression {
 struct ParenExpr : public PrimaryExpression {
  public:
   ParenExpr(Position&& position, std::unique_ptr<Expression>&& expr)
-      : PrimaryExpression{std::move(position)}, expr{std::move(expr)} {}
+      : PrimaryExpression{NodeKind::ParenExpr, std::move(position)}, expr{std::move(expr)} {}
+
+  static bool classof(const ASTNode* node) { return node->kind == NodeKind::ParenExpr; }
 
   std::unique_ptr<Expression> expr;
 };
@@ -225,8 +292,30 @@ enum class PrimitiveType { Int, Float, Bool, Char, String };
 struct CastExpr : public PrimaryExpression {
  public:
   CastExpr(Position&& position, PrimitiveType type, std::unique_ptr<Expression>&& expr)
-      : PrimaryExpression{std::move(position)}, type{type}, expr{std::move(expr)} {}
+      : PrimaryExpression{NodeKind::CastExpr, std::move(position)},
+        type{type},
+        expr{std::move(expr)} {}
+
+  static bool classof(const ASTNode* node) { return node->kind == NodeKind::CastExpr; }
 
   PrimitiveType type;
   std::unique_ptr<Expression> expr;
 };
+
+/* ---------------------------- Hash-consed nodes --------------------------- */
+
+/**
+ * @brief Use of a structurally deduplicated subtree, see ExpressionDeduplication.h. The subtree is
+ * owned by `Program::sharedExpressions` and referenced by every use, the node itself only keeps
+ * the position of its use.
+ */
+struct SharedExpr : public Expression {
+ public:
+  SharedExpr(Position&& position, Expression* expr, std::size_t hash)
+      : Expression{NodeKind::SharedExpr, std::move(position)}, expr{expr}, hash{hash} {}
+
+  static bool classof(const ASTNode* node) { return node->kind == NodeKind::SharedExpr; }
+
+  Expression* expr;
+  std::size_t hash;
+};
@@ -0,0 +1,313 @@
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "ASTUtils.h"
+#include "Casting.h"
+#include "ExpressionDeduplication.h"
+#include "RecursiveASTVisitor.h"
+
+namespace {
+
+std::size_t combine(std::size_t seed, std::size_t value) {
+  return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+}
+
+std::size_t hashOperator(std::optional<Operator> op) {
+  return op.has_value() ? static_cast<std::size_t>(*op) + 1 : 0;
+}
+
+const Expression& unwrapShared(const Expression& expr) {
+  if (auto shared = dyn_cast<SharedExpr>(&expr)) return *shared->expr;
+  return expr;
+}
+
+/**
+ * @brief Whether the node itself, regardless of its children, may be part of a pure expression.
+ */
+bool isPureNode(const Expression& expr) {
+  switch (expr.kind) {
+    case NodeKind::FunctionalExpression:
+      return !isa<FnCallPostfix>(cast<FunctionalExpression>(expr).postfix.get());
+    case NodeKind::Object:
+    case NodeKind::InlinedCall:
+      return false;
+    default:
+      return true;
+  }
+}
+
+/**
+ * @brief Hash of a single pure node, mixing in the hashes of its children given by `childHash`.
+ */
+template <typename ChildHash>
+std::size_t nodeHash(const Expression& expr, ChildHash&& childHash) {
+  if (auto shared = dyn_cast<SharedExpr>(&expr)) return shared->hash;
+
+  auto hash = static_cast<std::size_t>(expr.kind);
+  if (auto binary = dyn_cast<BinaryExpression>(&expr)) {
+    hash = combine(hash, hashOperator(binary->op));
+    hash = combine(hash, childHash(*binary->lhs));
+    hash = combine(hash, childHash(*binary->rhs));
+  } else if (auto unary = dyn_cast<UnaryExpression>(&expr)) {
+    hash = combine(hash, hashOperator(unary->op));
+    hash = combine(hash, childHash(*unary->expr));
+  } else if (auto functional = dyn_cast<FunctionalExpression>(&expr)) {
+    hash = combine(hash, childHash(*functional->expr));
+    hash = combine(hash, static_cast<std::size_t>(functional->postfix->kind));
+    if (auto member = dyn_cast<MemberAccessPostfix>(functional->postfix.get())) {
+      hash = combine(hash, std::hash<std::wstring>{}(member->member));
+    } else {
+      auto& variant = cast<VariantAccessPostfix>(*functional->postfix);
+      hash = combine(hash, std::hash<std::wstring>{}(variant.variant));
+    }
+  } else if (auto identifier = dyn_cast<IdentifierExpr>(&expr)) {
+    hash = combine(hash, std::hash<std::wstring>{}(identifier->name));
+    hash = combine(hash, static_cast<std::size_t>(identifier->storage.kind));
+    hash = combine(hash, identifier->storage.depth);
+    hash = combine(hash, identifier->storage.slot);
+  } else if (auto intLiteral = dyn_cast<Literal<int>>(&expr)) {
+    hash = combine(hash, std::hash<int>{}(intLiteral->value));
+  } else if (auto floatLiteral = dyn_cast<Literal<float>>(&expr)) {
+    hash = combine(hash, std::bit_cast<std::uint32_t>(floatLiteral->value));
+  } else if (auto boolLiteral = dyn_cast<Literal<bool>>(&expr)) {
+    hash = combine(hash, boolLiteral->value);
+  } else if (auto charLiteral = dyn_cast<Literal<wchar_t>>(&expr)) {
+    hash = combine(hash, static_cast<std::size_t>(charLiteral->value));
+  } else if (auto stringLiteral = dyn_cast<Literal<std::wstring>>(&expr)) {
+    hash = combine(hash, std::hash<std::wstring>{}(stringLiteral->value));
+  } else if (auto paren = dyn_cast<ParenExpr>(&expr)) {
+    hash = combine(hash, childHash(*paren->expr));
+  } else if (auto castExpr = dyn_cast<CastExpr>(&expr)) {
+    hash = combine(hash, static_cast<std::size_t>(castExpr->type));
+    hash = combine(hash, childHash(*castExpr->expr));
+  } else {
+    throw std::logic_error("Expected a pure expression!");
+  }
+  return hash;
+}
+
+bool equalPostfixes(const FunctionalPostfix& lhs, const FunctionalPostfix& rhs) {
+  if (lhs.kind != rhs.kind) return false;
+  if (auto member = dyn_cast<MemberAccessPostfix>(&lhs)) {
+    return member->member == cast<MemberAccessPostfix>(rhs).member;
+  }
+  if (auto variant = dyn_cast<VariantAccessPostfix>(&lhs)) {
+    return variant->variant == cast<VariantAccessPostfix>(rhs).variant;
+  }
+  return false;
+}
+
+/**
+ * @brief Counts the equivalence classes of the pure subtrees of the program, then replaces the
+ * repeated ones top-down. Both phases reach the top-level expressions through the visitor and
+ * recurse through the expressions on their own, as the second phase replaces the owning slots.
+ */
+class Deduplicator : public RecursiveASTVisitor<Deduplicator> {
+ public:
+  explicit Deduplicator(Program& program) : m_program{program} {}
+
+  DeduplicationStats run() {
+    traverse(m_program);
+    m_rewriting = true;
+    traverse(m_program);
+    return m_stats;
+  }
+
+  template <typename Node>
+  bool visit(Node& node) {
+    if constexpr (std::is_base_of_v<Expression, Node>) {
+      return false;
+    } else {
+      roots(node);
+      return true;
+    }
+  }
+
+ private:
+  static constexpr std::size_t NO_CLASS = static_cast<std::size_t>(-1);
+
+  struct SubtreeInfo {
+    std::size_t hash;
+    std::size_t size;
+    std::size_t equivalenceClass = NO_CLASS;  // Only subtrees of at least two nodes are classified
+  };
+
+  struct EquivalenceClass {
+    const Expression* representative;
+    std::size_t occurrences = 1;
+    Expression* canonical = nullptr;
+  };
+
+  /* ------------------------ Top-level expressions ------------------------ */
+
+  void roots(ASTNode&) {}
+  void roots(VarDef& def) { root(def.value); }
+  void roots(ConstDef& def) { root(def.value); }
+  void roots(ExpressionStmt& stmt) { root(stmt.expr); }
+  void roots(AssignmentStmt& stmt) {
+    root(stmt.lhs);
+    root(stmt.rhs);
+  }
+  void roots(StdinExtractionStmt& stmt) {
+    for (auto& expr : stmt.expressions) root(expr);
+  }
+  void roots(StdoutInsertionStmt& stmt) {
+    for (auto& expr : stmt.expressions) root(expr);
+  }
+  void roots(VariantMatchStmt& stmt) { root(stmt.expr); }
+  void roots(IfStmt& stmt) { root(stmt.condition); }
+  void roots(Elif& elif) { root(elif.condition); }
+  void roots(Range& range) {
+    root(range.start);
+    root(range.end);
+  }
+  void roots(WhileStmt& stmt) { root(stmt.condition); }
+  void roots(ReturnStmt& stmt) { root(stmt.expr); }
+
+  void root(std::unique_ptr<Expression>& slot) {
+    if (slot == nullptr) return;
+    if (m_rewriting) {
+      rewrite(slot);
+    } else {
+      count(*slot);
+    }
+  }
+
+  /* ------------------------------- Counting ------------------------------ */
+
+  // Returns whether the subtree is pure
+  bool count(Expression& expr) {
+    bool pureChildren = true;
+    std::size_t size = 1;
+    forEachChild(expr, [&](std::unique_ptr<Expression>& child) {
+      pureChildren = count(*child) && pureChildren;
+      if (pureChildren) size += m_subtrees.at(child.get()).size;
+    });
+    if (!pureChildren || !isPureNode(expr)) return false;
+
+    auto hash = nodeHash(expr, [&](const Expression& child) { return m_subtrees.at(&child).hash; });
+    SubtreeInfo info{hash, size};
+    if (size >= 2) info.equivalenceClass = classify(expr, hash);
+    m_subtrees.emplace(&expr, info);
+    return true;
+  }
+
+  std::size_t classify(const Expression& expr, std::size_t hash) {
+    auto [begin, end] = m_classesByHash.equal_range(hash);
+    for (auto it = begin; it != end; ++it) {
+      auto& equivalenceClass = m_classes[it->second];
+      if (structurallyEqual(*equivalenceClass.representative, expr)) {
+        equivalenceClass.occurrences++;
+        return it->second;
+      }
+    }
+    m_classes.push_back({&expr});
+    m_classesByHash.emplace(hash, m_classes.size() - 1);
+    return m_classes.size() - 1;
+  }
+
+  /* ------------------------------ Rewriting ------------------------------ */
+
+  void rewrite(std::unique_ptr<Expression>& slot) {
+    auto it = m_subtrees.find(slot.get());
+    if (it != m_subtrees.end() && it->second.equivalenceClass != NO_CLASS &&
+        m_classes[it->second.equivalenceClass].occurrences >= 2) {
+      share(slot, it->second);
+      return;
+    }
+    forEachChild(*slot, [this](std::unique_ptr<Expression>& child) { rewrite(child); });
+  }
+
+  void share(std::unique_ptr<Expression>& slot, const SubtreeInfo& info) {
+    auto& equivalenceClass = m_classes[info.equivalenceClass];
+    auto position = slot->position;
+
+    if (equivalenceClass.canonical == nullptr) {
+      equivalenceClass.canonical = slot.get();
+      m_program.sharedExpressions.push_back(std::move(slot));
+      m_stats.sharedSubtrees++;
+      forEachChild(*equivalenceClass.canonical,
+                   [this](std::unique_ptr<Expression>& child) { rewrite(child); });
+    } else {
+      m_stats.freedNodes += info.size;
+    }
+
+    slot = std::make_unique<SharedExpr>(std::move(position), equivalenceClass.canonical, info.hash);
+    m_stats.sharedUses++;
+  }
+
+  Program& m_program;
+  bool m_rewriting = false;
+
+  std::unordered_map<const Expression*, SubtreeInfo> m_subtrees;
+  std::vector<EquivalenceClass> m_classes;
+  std::unordered_multimap<std::size_t, std::size_t> m_classesByHash;
+
+  DeduplicationStats m_stats;
+};
+
+}  // namespace
+
+bool isPureExpression(const Expression& expr) {
+  if (!isPureNode(expr)) return false;
+
+  bool pure = true;
+  forEachChild(expr, [&](const std::unique_ptr<Expression>& child) {
+    pure = pure && isPureExpression(*child);
+  });
+  return pure;
+}
+
+std::size_t structuralHash(const Expression& expr) {
+  return nodeHash(expr, [](const Expression& child) { return structuralHash(child); });
+}
+
+bool structurallyEqual(const Expression& lhsExpr, const Expression& rhsExpr) {
+  const auto& lhs = unwrapShared(lhsExpr);
+  const auto& rhs = unwrapShared(rhsExpr);
+  // Only pure subtrees are shared
+  if (&lhs == &rhs && (&lhs != &lhsExpr || &rhs != &rhsExpr)) return true;
+  if (lhs.kind != rhs.kind || !isPureNode(lhs) || !isPureNode(rhs)) return false;
+
+  if (auto binary = dyn_cast<BinaryExpression>(&lhs)) {
+    auto& other = cast<BinaryExpression>(rhs);
+    return binary->op == other.op && structurallyEqual(*binary->lhs, *other.lhs) &&
+           structurallyEqual(*binary->rhs, *other.rhs);
+  } else if (auto unary = dyn_cast<UnaryExpression>(&lhs)) {
+    auto& other = cast<UnaryExpression>(rhs);
+    return unary->op == other.op && structurallyEqual(*unary->expr, *other.expr);
+  } else if (auto functional = dyn_cast<FunctionalExpression>(&lhs)) {
+    auto& other = cast<FunctionalExpression>(rhs);
+    return equalPostfixes(*functional->postfix, *other.postfix) &&
+           structurallyEqual(*functional->expr, *other.expr);
+  } else if (auto identifier = dyn_cast<IdentifierExpr>(&lhs)) {
+    auto& other = cast<IdentifierExpr>(rhs);
+    return identifier->name == other.name && identifier->storage == other.storage;
+  } else if (auto intLiteral = dyn_cast<Literal<int>>(&lhs)) {
+    return intLiteral->value == cast<Literal<int>>(rhs).value;
+  } else if (auto floatLiteral = dyn_cast<Literal<float>>(&lhs)) {
+    return std::bit_cast<std::uint32_t>(floatLiteral->value) ==
+           std::bit_cast<std::uint32_t>(cast<Literal<float>>(rhs).value);
+  } else if (auto boolLiteral = dyn_cast<Literal<bool>>(&lhs)) {
+    return boolLiteral->value == cast<Literal<bool>>(rhs).value;
+  } else if (auto charLiteral = dyn_cast<Literal<wchar_t>>(&lhs)) {
+    return charLiteral->value == cast<Literal<wchar_t>>(rhs).value;
+  } else if (auto stringLiteral = dyn_cast<Literal<std::wstring>>(&lhs)) {
+    return stringLiteral->value == cast<Literal<std::wstring>>(rhs).value;
+  } else if (auto paren = dyn_cast<ParenExpr>(&lhs)) {
+    return structurallyEqual(*paren->expr, *cast<ParenExpr>(rhs).expr);
+  } else if (auto castExpr = dyn_cast<CastExpr>(&lhs)) {
+    auto& other = cast<CastExpr>(rhs);
+    return castExpr->type == other.type && structurallyEqual(*castExpr->expr, *other.expr);
+  }
+  return false;
+}
+
+DeduplicationStats deduplicateExpressions(Program& program) {
+  return Deduplicator{program}.run();
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+
+#include "Expression.h"
+#include "Program.h"
+
+/**
+ * @brief Pure expressions are built only out of identifiers, literals, member and variant
+ * accesses, casts and operators, so two structurally equal ones always denote the same value.
+ * Function calls and object literals are never pure.
+ */
+bool isPureExpression(const Expression& expr);
+
+/**
+ * @brief Hash of a pure expression that depends only on its structure, not on positions.
+ * SharedExpr nodes are transparent, they hash and compare as the subtree they refer to.
+ */
+std::size_t structuralHash(const Expression& expr);
+bool structurallyEqual(const Expression& lhs, const Expression& rhs);
+
+struct DeduplicationStats {
+  std::size_t sharedSubtrees = 0;  // Subtrees moved to Program::sharedExpressions
+  std::size_t sharedUses = 0;      // SharedExpr nodes created
+  std::size_t freedNodes = 0;      // Nodes of the duplicates that were destroyed
+};
+
+/**
+ * @brief Hash-conses the program: every pure subtree of at least two nodes that occurs more than
+ * once is moved to `program.sharedExpressions` and each of its occurrences is replaced with a
+ * SharedExpr carrying the cached structural hash. Subtrees are shared maximally, i.e. the largest
+ * repeated subtree is shared and the repeated parts inside of it are shared on their own.
+ *
+ * Identifiers are equal only if they resolve to the same Storage, so the pass belongs after the
+ * ScopeChecker (before it, equal names are assumed to denote the same variable). It must not run
+ * on trees that are reused by the IncrementalParser.
+ */
+DeduplicationStats deduplicateExpressions(Program& program);
@@ -0,0 +1,290 @@
+#include <algorithm>
+#include <cwctype>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+#include "IncrementalParser.h"
+#include "Lexer.h"
+#include "Parser.h"
+#include "RecursiveASTVisitor.h"
+#include "StringCharReader.h"
+
+namespace {
+
+/*
+ * Chunk boundaries are found with a separate lexing pass. Lexical errors are reported once,
+ * by the lexer that feeds the parser, so this pass has to stay silent.
+ */
+class SilentErrorHandler : public ErrorHandler {
+ protected:
+  void handleError(const ErrorType, const Position&) override {}
+  void handleWarning(const ErrorType, const Position&) override {}
+};
+
+/*
+ * Moves every position of a reused definition from its old place in the source to the new one.
+ * Columns change only on the line the definition starts on.
+ */
+class PositionShift : public RecursiveASTVisitor<PositionShift> {
+ public:
+  PositionShift(int line, int lineDelta, int columnDelta)
+      : m_line{line}, m_lineDelta{lineDelta}, m_columnDelta{columnDelta} {}
+
+  void visit(ASTNode& node) {
+    if (node.position.line == m_line) node.position.column += m_columnDelta;
+    node.position.line += m_lineDelta;
+  }
+
+ private:
+  int m_line;
+  int m_lineDelta;
+  int m_columnDelta;
+};
+
+}  // namespace
+
+IncrementalParser::IncrementalParser(ErrorHandler& errorHandler) : m_errorHandler{errorHandler} {}
+
+const std::wstring& IncrementalParser::source() const { return m_source; }
+
+std::optional<Program>& IncrementalParser::program() { return m_program; }
+
+/**
+ * @brief Parses the whole source. Definitions kept from the previous parse are still reused if
+ * their text did not change.
+ */
+IncrementalParser::Update IncrementalParser::parse(const std::wstring& source) {
+  m_previousSource = std::exchange(m_source, source);
+  computeLineStarts();
+
+  std::optional<std::size_t> syncedAt;
+  return rebuildProgram(splitIntoChunks(0, {}, syncedAt));
+}
+
+/**
+ * @brief Applies the edit to the kept source and updates the program. Only the part of the
+ * source between the first chunk touched by the edit and the first chunk boundary found after it
+ * is lexed again, the remaining chunks are just moved by the length difference.
+ */
+IncrementalParser::Update IncrementalParser::applyEdit(const TextEdit& edit) {
+  auto offset = std::min(edit.offset, m_source.size());
+  auto length = std::min(edit.length, m_source.size() - offset);
+  auto delta = static_cast<long>(edit.text.size()) - static_cast<long>(length);
+
+  m_previousSource = m_source;
+  m_source.replace(offset, length, edit.text);
+  computeLineStarts();
+
+  // First chunk whose text or end boundary could have been affected
+  auto first = std::find_if(m_chunks.begin(), m_chunks.end(),
+                            [offset](const Chunk& chunk) { return chunk.end >= offset; });
+  auto relexBegin = first == m_chunks.begin() || first == m_chunks.end() ? 0 : first->begin;
+  if (relexBegin == 0) first = m_chunks.begin();
+
+  // Boundaries of the untouched chunks after the edit, in the new source coordinates
+  std::unordered_set<std::size_t> syncOffsets;
+  for (auto it = first; it != m_chunks.end(); ++it) {
+    if (it->begin >= offset + length) syncOffsets.insert(it->begin + delta);
+  }
+
+  std::optional<std::size_t> syncedAt;
+  auto chunks = splitIntoChunks(relexBegin, syncOffsets, syncedAt);
+  chunks.insert(chunks.begin(), m_chunks.begin(), first);
+
+  if (syncedAt.has_value()) {
+    auto synced = std::find_if(first, m_chunks.end(), [&](const Chunk& chunk) {
+      return chunk.begin + delta == *syncedAt;
+    });
+    for (auto it = synced; it != m_chunks.end(); ++it) {
+      Chunk chunk = *it;
+      chunk.begin += delta;
+      chunk.end += delta;
+      chunk.position = positionOf(chunk.begin);
+      chunks.push_back(std::move(chunk));
+    }
+  }
+
+  return rebuildProgram(std::move(chunks));
+}
+
+/**
+ * @brief Lexes the source starting at `begin` and splits it into chunks. A chunk starts at the
+ * first token and at every definition keyword found outside of braces and parentheses.
+ *
+ * @param syncOffsets - chunk boundaries known to be followed by unchanged text
+ * @param syncedAt - set to the boundary at which splitting stopped, if any
+ */
+std::vector<IncrementalParser::Chunk> IncrementalParser::splitIntoChunks(
+    std::size_t begin, const std::unordered_set<std::size_t>& syncOffsets,
+    std::optional<std::size_t>& syncedAt) const {
+  std::vector<Chunk> chunks;
+
+  auto origin = positionOf(begin);
+  SilentErrorHandler errorHandler;
+  StringCharReader reader{m_source.substr(begin), origin.line, origin.column};
+  Lexer lexer{reader, errorHandler};
+
+  int braceDepth = 0;
+  int parenDepth = 0;
+
+  for (auto token = lexer.getNextToken(); token.type != TokenType::ETX;
+       token = lexer.getNextToken()) {
+    bool atTopLevel = braceDepth == 0 && parenDepth == 0;
+    if (chunks.empty() || (atTopLevel && isDefinitionKeyword(token.type))) {
+      auto offset = offsetOf(token.position);
+      if (!chunks.empty()) {
+        chunks.back().end = offset;
+        if (syncOffsets.contains(offset)) {
+          syncedAt = offset;
+          break;
+        }
+      }
+      chunks.push_back(Chunk{offset, m_source.size(), 0, token.position, {}, false});
+    }
+
+    if (token.type == TokenType::LBRACE) braceDepth++;
+    if (token.type == TokenType::RBRACE) braceDepth--;
+    if (token.type == TokenType::LPAREN) parenDepth++;
+    if (token.type == TokenType::RPAREN) parenDepth--;
+  }
+
+  for (auto& chunk : chunks) {
+    chunk.hash = std::hash<std::wstring_view>{}(chunkText(m_source, chunk));
+  }
+
+  return chunks;
+}
+
+/**
+ * @brief Text of the chunk without trailing whitespace, which does not belong to the definition.
+ */
+std::wstring_view IncrementalParser::chunkText(const std::wstring& source, const Chunk& chunk) {
+  auto end = chunk.end;
+  while (end > chunk.begin && iswspace(source[end - 1])) end--;
+
+  return std::wstring_view{source}.substr(chunk.begin, end - chunk.begin);
+}
+
+/**
+ * @brief Parses a single definition out of the chunk, with positions matching the whole
+ * source.
+ */
+std::unique_ptr<Definition> IncrementalParser::parseChunk(Chunk& chunk) {
+  auto origin = chunk.position;
+  StringCharReader reader{m_source.substr(chunk.begin, chunk.end - chunk.begin), origin.line,
+                          origin.column};
+  Lexer lexer{reader, m_errorHandler};
+  Parser parser{lexer, m_errorHandler};
+
+  auto definition = parser.parseDefinition();
+  chunk.complete = parser.m_token.type == TokenType::ETX;
+  chunk.name = definition != nullptr ? definition->name : Identifier{};
+
+  return definition;
+}
+
+/**
+ * @brief Builds the program out of the chunks the same way Parser::parseProgram would, taking
+ * definitions with unchanged text from the previous program instead of parsing them.
+ */
+IncrementalParser::Update IncrementalParser::rebuildProgram(std::vector<Chunk>&& chunks) {
+  auto oldChunks = std::move(m_chunks);
+  auto oldDefinitions = m_program.has_value() ? std::move(m_program->definitions)
+                                              : Program::Definitions{};
+  m_program.reset();
+
+  std::unordered_multimap<std::size_t, const Chunk*> reusable;
+  for (const auto& chunk : oldChunks) {
+    if (oldDefinitions.contains(chunk.name)) reusable.insert({chunk.hash, &chunk});
+  }
+
+  auto position = chunks.empty() ? positionOf(m_source.size()) : chunks.front().position;
+  Program::Definitions definitions;
+  ChangedDefinitions changed;
+  bool failed = false;
+
+  for (auto& chunk : chunks) {
+    std::unique_ptr<Definition> definition;
+
+    // The hash only finds the candidates, a collision must not reuse another definition
+    auto text = chunkText(m_source, chunk);
+    auto [it, end] = reusable.equal_range(chunk.hash);
+    for (; it != end; ++it) {
+      const auto& oldChunk = *it->second;
+      if (oldDefinitions.contains(oldChunk.name) && chunkText(m_previousSource, oldChunk) == text) {
+        break;
+      }
+    }
+
+    // Unchanged text, reuse the definition
+    if (it != end) {
+      const auto& oldChunk = *it->second;
+      definition = std::move(oldDefinitions.extract(oldChunk.name).mapped());
+      chunk.name = oldChunk.name;
+      chunk.complete = oldChunk.complete;
+
+      if (oldChunk.position.line != chunk.position.line ||
+          oldChunk.position.column != chunk.position.column) {
+        PositionShift shift{oldChunk.position.line, chunk.position.line - oldChunk.position.line,
+                            chunk.position.column - oldChunk.position.column};
+        shift.traverseNode(*definition);
+      }
+    }
+    // Changed or new text, parse it
+    else {
+      definition = parseChunk(chunk);
+      if (definition != nullptr) changed.insert(definition->name);
+    }
+
+    if (definition == nullptr) break;
+
+    if (definitions.find(definition->name) != definitions.end()) {
+      m_errorHandler(ErrorType::REDEFINITION, definition->position);
+      failed = true;
+      break;
+    }
+    auto entry = std::make_pair(definition->name, std::move(definition));
+    definitions.insert(std::move(entry));
+
+    if (!chunk.complete) break;
+  }
+
+  for (const auto& [name, definition] : oldDefinitions) changed.insert(name);
+  m_chunks = std::move(chunks);
+  m_previousSource.clear();
+
+  if (!failed && definitions.find(L"main") == definitions.end()) {
+    m_errorHandler(ErrorType::EXPECTED_MAIN_FUNCTION_DEF, position);
+    failed = true;
+  }
+  if (!failed) {
+    m_program.emplace(std::move(position), std::move(definitions));
+  }
+
+  return Update{m_program, std::move(changed)};
+}
+
+void IncrementalParser::computeLineStarts() {
+  m_lineStarts.assign(1, 0);
+  for (std::size_t i = 0; i < m_source.size(); i++) {
+    if (m_source[i] == L'\n') m_lineStarts.push_back(i + 1);
+  }
+}
+
+std::size_t IncrementalParser::offsetOf(const Position& position) const {
+  return m_lineStarts[position.line] + position.column;
+}
+
+/**
+ * @brief Position the reader is at after consuming the first `offset` characters.
+ */
+Position IncrementalParser::positionOf(std::size_t offset) const {
+  auto line = std::upper_bound(m_lineStarts.begin(), m_lineStarts.end(), offset) - 1;
+
+  Position position;
+  position.line = static_cast<int>(line - m_lineStarts.begin());
+  position.column = static_cast<int>(offset - *line);
+  position.sourceFile = STRING_INPUT_FILENAME;
+  return position;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include "Definition.h"
+#include "ErrorHandler.h"
+#include "Program.h"
+
+/**
+ * @brief Replaces `length` characters starting at `offset` with `text`.
+ */
+struct TextEdit {
+  std::size_t offset;
+  std::size_t length;
+  std::wstring text;
+};
+
+/**
+ * @brief Keeps the last parsed Program together with the source it was parsed from and, after a
+ * text edit, reparses only the top-level definitions whose source changed.
+ *
+ * The source is split into chunks, each starting at a definition keyword found at brace depth
+ * zero and spanning up to the next one. Chunks are looked up by a hash of their text and compared
+ * in full, so a definition that was merely moved by an edit is reused as is, only with its
+ * positions shifted.
+ *
+ * @note Passes that rewrite the AST in place should work on a copy, otherwise reused definitions
+ * will no longer correspond to their source text.
+ */
+class IncrementalParser {
+ public:
+  using ChangedDefinitions = std::unordered_set<Identifier>;
+
+  struct Update {
+    std::optional<Program>& program;
+    ChangedDefinitions changed;  // Reparsed, added and removed definitions
+  };
+
+  IncrementalParser() = delete;
+  IncrementalParser(const IncrementalParser&) = delete;
+  IncrementalParser(IncrementalParser&&) = delete;
+  IncrementalParser& operator=(const IncrementalParser&) = delete;
+  IncrementalParser& operator=(IncrementalParser&&) = delete;
+  ~IncrementalParser() = default;
+
+  IncrementalParser(ErrorHandler& errorHandler);
+
+  Update parse(const std::wstring& source);
+  Update applyEdit(const TextEdit& edit);
+
+  const std::wstring& source() const;
+  std::optional<Program>& program();
+
+ private:
+  /* Source range of a single top-level definition */
+  struct Chunk {
+    std::size_t begin;
+    std::size_t end;
+    std::size_t hash = 0;
+    Position position;
+    Identifier name;        // Name of the definition parsed from this chunk, if any
+    bool complete = false;  // Whether the definition spans the whole chunk
+  };
+
+  std::vector<Chunk> splitIntoChunks(std::size_t begin,
+                                     const std::unordered_set<std::size_t>& syncOffsets,
+                                     std::optional<std::size_t>& syncedAt) const;
+  static std::wstring_view chunkText(const std::wstring& source, const Chunk& chunk);
+  std::size_t offsetOf(const Position& position) const;
+  Position positionOf(std::size_t offset) const;
+  void computeLineStarts();
+
+  std::unique_ptr<Definition> parseChunk(Chunk& chunk);
+  Update rebuildProgram(std::vector<Chunk>&& chunks);
+
+  ErrorHandler& m_errorHandler;
+
+  std::wstring m_source;
+  std::wstring m_previousSource;  // Text of m_chunks while the program is rebuilt
+  std::vector<std::size_t> m_lineStarts;
+  std::vector<Chunk> m_chunks;
+  std::optional<Program> m_program;
+};
@@ -0,0 +1,569 @@
+#include <cassert>
+
+#include "ErrorType.h"
+#include "Parser.h"
+#include "TokenType.h"
+
+/*
+ * Explicit-stack implementations of the expression and block rules. Nested constructs push a frame
+ * onto a heap allocated stack instead of recursing, so nesting depth is limited only by memory.
+ * Both modes build identical trees. On invalid input only the innermost error is reported; the
+ * enclosing constructs do not add their own follow-up errors as they do in recursive mode.
+ */
+
+namespace {
+
+/* -------------------------------------------------------------------------- */
+/*                                 Expressions                                */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Binding strength of binary operators, mirroring the nesting of the expression rules.
+ */
+int precedenceOf(Operator op) {
+  switch (op) {
+    case Operator::Or:
+      return 1;
+    case Operator::And:
+      return 2;
+    case Operator::Eq:
+    case Operator::Neq:
+      return 3;
+    case Operator::Lt:
+    case Operator::Gt:
+    case Operator::Leq:
+    case Operator::Geq:
+      return 4;
+    case Operator::Add:
+    case Operator::Sub:
+      return 5;
+    default:
+      return 6;
+  }
+}
+
+/**
+ * @brief An expression that is being parsed, either the whole expression or one nested in
+ * parentheses, a cast, call arguments or an object member.
+ */
+struct ExpressionFrame {
+  enum class Kind { Root, Paren, Cast, FnCall, Object };
+
+  ExpressionFrame(Kind kind, Position position) : kind{kind}, position{std::move(position)} {}
+
+  /**
+   * @brief Folds pending binary operators binding at least as strongly as `minPrecedence`.
+   * All operators are left associative.
+   */
+  void reduce(int minPrecedence) {
+    while (!operators.empty() && precedenceOf(operators.back()) >= minPrecedence) {
+      auto rhs = std::move(operands.back());
+      operands.pop_back();
+      auto lhs = std::move(operands.back());
+      operands.pop_back();
+
+      auto lhsPosition = lhs->position;
+      operands.push_back(std::make_unique<BinaryExpression>(std::move(lhsPosition), std::move(lhs),
+                                                            operators.back(), std::move(rhs)));
+      operators.pop_back();
+    }
+  }
+
+  Kind kind;
+  Position position;
+
+  std::vector<std::unique_ptr<Expression>> operands;
+  std::vector<Operator> operators;
+  std::optional<std::pair<Operator, Position>> unaryOperator;
+
+  PrimitiveType castType = PrimitiveType::Int;  // Cast
+  std::unique_ptr<Expression> callee;           // FnCall
+  FnCallArgs args;                              // FnCall
+  Object::Members members;                      // Object
+  Identifier memberName;                        // Object
+};
+
+/* -------------------------------------------------------------------------- */
+/*                                   Blocks                                   */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief A block whose closing brace has not been reached yet.
+ */
+struct OpenBlock {
+  enum class Owner { Block, If, Elif, Else, For, While, MatchCase };
+
+  Owner owner;
+  Position position;
+  BlockStmt::Statements statements;
+};
+
+/**
+ * @brief A statement owning the innermost open blocks, completed once its last block is closed.
+ */
+struct PendingStmt {
+  Position position;
+  std::unique_ptr<Expression> expr;  // if or while condition, matched expression
+
+  std::optional<BlockStmt> block;  // IfStmt
+  IfStmt::Elifs elifs;             // IfStmt
+  Identifier identifier;           // ForStmt
+  std::unique_ptr<Range> range;    // ForStmt
+  VariantMatchStmt::Cases cases;   // VariantMatchStmt
+
+  // Elif, else or case currently being parsed
+  Position clausePosition;
+  std::unique_ptr<Expression> clauseCondition;
+  TypeIdentifier clauseVariant;
+};
+
+}  // namespace
+
+/* -------------------------------------------------------------------------- */
+/*                                 Expressions                                */
+/* -------------------------------------------------------------------------- */
+
+/*
+ * Expression
+ *    = BinaryExpression
+ *    | UnaryExpression
+ *    | FunctionalExpression;
+ *
+ * Binary operators are folded by precedence climbing, nested expressions push a frame.
+ */
+std::unique_ptr<Expression> Parser::parseExpressionIteratively() {
+  using Kind = ExpressionFrame::Kind;
+
+  std::vector<ExpressionFrame> frames;
+  frames.emplace_back(Kind::Root, m_token.position);
+
+  /*
+   * Completes the innermost nested expression. Returns false on error, otherwise `operand` is
+   * either the completed construct or null when the frame expects another expression (next call
+   * argument or object member).
+   */
+  auto closeFrame = [this, &frames](std::unique_ptr<Expression>& operand) {
+    auto& frame = frames.back();
+
+    std::unique_ptr<Expression> expr;
+    if (!frame.operands.empty()) {
+      expr = std::move(frame.operands.back());
+      frame.operands.pop_back();
+    }
+
+    switch (frame.kind) {
+      case Kind::Paren:
+        if (!consumeIf(TokenType::RPAREN, ErrorType::PARENEXPR_EXPECTED_RPAREN)) return false;
+        operand = std::make_unique<ParenExpr>(std::move(frame.position), std::move(expr));
+        break;
+      case Kind::Cast:
+        if (!consumeIf(TokenType::RPAREN, ErrorType::CASTEXPR_EXPECTED_RPAREN)) return false;
+        operand =
+            std::make_unique<CastExpr>(std::move(frame.position), frame.castType, std::move(expr));
+        break;
+      case Kind::FnCall: {
+        if (expr != nullptr) {
+          frame.args.push_back(std::move(expr));
+          if (m_token.type == TokenType::COMMA) {
+            consumeToken();
+            return true;
+          }
+        }
+        if (!consumeIf(TokenType::RPAREN, ErrorType::FNCALL_EXPECTED_RPAREN)) return false;
+
+        auto postfixPosition = frame.position;
+        auto postfix =
+            std::make_unique<FnCallPostfix>(std::move(frame.position), std::move(frame.args));
+        operand = std::make_unique<FunctionalExpression>(
+            std::move(postfixPosition), std::move(frame.callee), std::move(postfix));
+        break;
+      }
+      case Kind::Object:
+        if (frame.members.find(frame.memberName) != frame.members.end()) {
+          reportError(ErrorType::OBJECTMEMBER_REDEFINITION, m_token.position);
+          return false;
+        }
+        frame.members.insert(std::make_pair(
+            frame.memberName, ObjectMember{Identifier{frame.memberName}, std::move(expr)}));
+
+        if (m_token.type == TokenType::COMMA) {
+          consumeToken();
+          if (m_token.type == TokenType::IDENTIFIER) {
+            frame.memberName = m_token.representation;
+            consumeToken();
+            return consumeIf(TokenType::COLON, ErrorType::OBJECTMEMBER_EXPECTED_COLON);
+          }
+        }
+        if (!consumeIf(TokenType::RBRACE, ErrorType::OBJECT_EXPECTED_RBRACE)) return false;
+        operand = std::make_unique<Object>(std::move(frame.position), std::move(frame.members));
+        break;
+      case Kind::Root:
+        assert(false && "The root expression is never closed as a nested frame");
+        return false;
+    }
+
+    frames.pop_back();
+    return true;
+  };
+
+  std::unique_ptr<Expression> operand;
+
+  while (true) {
+    // Expecting an operand, optionally preceded by a single unary operator
+    if (operand == nullptr) {
+      auto& frame = frames.back();
+      auto position = m_token.position;
+
+      if (!frame.unaryOperator &&
+          (m_token.type == TokenType::LOGIC_NOT || m_token.type == TokenType::MINUS)) {
+        frame.unaryOperator = {m_tokenTypeToOperator.at(m_token.type), position};
+        consumeToken();
+        continue;
+      }
+
+      if (m_token.type == TokenType::LPAREN) {
+        consumeToken();
+        frames.emplace_back(Kind::Paren, std::move(position));
+        continue;
+      }
+
+      if (isPrimitiveType(m_token.type)) {
+        auto type = m_tokenTypeToPrimitiveType.at(m_token.type);
+        consumeToken();
+        if (!consumeIf(TokenType::LPAREN, ErrorType::CASTEXPR_EXPECTED_LPAREN)) return nullptr;
+        frames.emplace_back(Kind::Cast, std::move(position)).castType = type;
+        continue;
+      }
+
+      if (m_token.type == TokenType::LBRACE) {
+        consumeToken();
+        if (m_token.type == TokenType::IDENTIFIER) {
+          auto& object = frames.emplace_back(Kind::Object, std::move(position));
+          object.memberName = m_token.representation;
+          consumeToken();
+          if (!consumeIf(TokenType::COLON, ErrorType::OBJECTMEMBER_EXPECTED_COLON)) return nullptr;
+          continue;
+        }
+        if (!consumeIf(TokenType::RBRACE, ErrorType::OBJECT_EXPECTED_RBRACE)) return nullptr;
+        operand = std::make_unique<Object>(std::move(position), Object::Members{});
+        continue;
+      }
+
+      // Identifiers and literals
+      if ((operand = parsePrimaryExpression()) != nullptr) continue;
+
+      if (frame.unaryOperator) {
+        reportError(ErrorType::UNARYEXPRESSION_EXPECTED_EXPR, m_token.position);
+        return nullptr;
+      }
+      if (!frame.operators.empty()) {
+        reportError(ErrorType::BINARYEXPRESSION_EXPECTED_RHS, m_token.position);
+        return nullptr;
+      }
+
+      switch (frame.kind) {
+        case Kind::Root:
+          return nullptr;
+        case Kind::Paren:
+          reportError(ErrorType::PARENEXPR_EXPECTED_EXPRESSION, m_token.position);
+          return nullptr;
+        case Kind::Cast:
+          reportError(ErrorType::CASTEXPR_EXPECTED_EXPRESSION, m_token.position);
+          return nullptr;
+        case Kind::Object:
+          reportError(ErrorType::OBJECTMEMBER_EXPECTED_EXPRESSION, m_token.position);
+          return nullptr;
+        case Kind::FnCall:
+          if (!frame.args.empty()) {
+            reportError(ErrorType::FNCALL_EXPECTED_ARGUMENT, m_token.position);
+            return nullptr;
+          }
+          // Call without arguments
+          if (!closeFrame(operand)) return nullptr;
+          continue;
+      }
+    }
+
+    // Member and variant access postfixes, a call opens a new frame for its arguments
+    auto postfixPosition = m_token.position;
+    if (m_token.type == TokenType::DOT || m_token.type == TokenType::AS_KWRD) {
+      auto postfix = parseFunctionalExpressionPostfix();
+      if (postfix == nullptr) return nullptr;
+      operand = std::make_unique<FunctionalExpression>(std::move(postfixPosition),
+                                                       std::move(operand), std::move(postfix));
+      continue;
+    }
+    if (m_token.type == TokenType::LPAREN) {
+      consumeToken();
+      frames.emplace_back(Kind::FnCall, std::move(postfixPosition)).callee = std::move(operand);
+      continue;
+    }
+
+    auto& frame = frames.back();
+    if (frame.unaryOperator) {
+      auto [op, position] = std::move(*frame.unaryOperator);
+      operand = std::make_unique<UnaryExpression>(std::move(position), op, std::move(operand));
+      frame.unaryOperator.reset();
+    }
+    frame.operands.push_back(std::move(operand));
+
+    // Binary operator, folding the pending ones that bind at least as strongly
+    auto it = m_tokenTypeToOperator.find(m_token.type);
+    if (it != m_tokenTypeToOperator.end() && it->second != Operator::Not) {
+      frame.reduce(precedenceOf(it->second));
+      frame.operators.push_back(it->second);
+      consumeToken();
+      continue;
+    }
+
+    // End of the innermost expression
+    frame.reduce(0);
+    if (frame.kind == Kind::Root) {
+      return std::move(frame.operands.back());
+    }
+    if (!closeFrame(operand)) return nullptr;
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 Statements                                 */
+/* -------------------------------------------------------------------------- */
+
+/*
+ * BlockStmt
+ *     = "{", { Statement }, "}";
+ *
+ * Statements owning blocks (BlockStmt, IfStmt, ForStmt, WhileStmt, VariantMatchStmt) are kept
+ * pending while their blocks are open, all other statements are parsed as usual.
+ */
+std::unique_ptr<Statement> Parser::parseBlockStmtIteratively() {
+  using Owner = OpenBlock::Owner;
+
+  if (m_token.type != TokenType::LBRACE) {
+    return nullptr;
+  }
+
+  std::vector<OpenBlock> blocks;
+  std::vector<PendingStmt> pending;
+
+  auto openBlock = [this, &blocks](Owner owner) {
+    blocks.push_back(OpenBlock{owner, m_token.position, {}});
+    consumeToken();
+  };
+
+  auto expectBlock = [this, &openBlock](Owner owner, ErrorType error) {
+    if (m_token.type != TokenType::LBRACE) {
+      reportError(error, m_token.position);
+      return false;
+    }
+    openBlock(owner);
+    return true;
+  };
+
+  auto append = [&blocks](std::unique_ptr<Statement> statement) {
+    blocks.back().statements.push_back(std::move(statement));
+  };
+
+  // Called after each block of an IfStmt, opens the next clause or completes the statement
+  auto continueIf = [&]() {
+    auto& stmt = pending.back();
+
+    if (m_token.type == TokenType::ELIF_KWRD) {
+      stmt.clausePosition = m_token.position;
+      consumeToken();
+      if ((stmt.clauseCondition = parseExpression()) == nullptr) {
+        reportError(ErrorType::ELIF_EXPECTED_CONDITION, m_token.position);
+        return false;
+      }
+      return expectBlock(Owner::Elif, ErrorType::ELIF_EXPECTED_BLOCK);
+    }
+
+    if (m_token.type == TokenType::ELSE_KWRD) {
+      stmt.clausePosition = m_token.position;
+      consumeToken();
+      return expectBlock(Owner::Else, ErrorType::ELSE_EXPECTED_BLOCK);
+    }
+
+    auto ifStmt = std::make_unique<IfStmt>(std::move(stmt.position), std::move(stmt.expr),
+                                           std::move(*stmt.block), std::move(stmt.elifs), nullptr);
+    pending.pop_back();
+    append(std::move(ifStmt));
+    return true;
+  };
+
+  // Called after each case of a VariantMatchStmt, opens the next case or completes the statement
+  auto continueMatch = [&]() {
+    auto& stmt = pending.back();
+
+    if (m_token.type == TokenType::CASE_KWRD) {
+      stmt.clausePosition = m_token.position;
+      consumeToken();
+
+      auto variant = parseTypeIdentifier();
+      if (variant == std::nullopt) {
+        reportError(ErrorType::VARIANTMATCHCASE_EXPECTED_TYPE, m_token.position);
+        return false;
+      }
+      stmt.clauseVariant = std::move(*variant);
+
+      if (!consumeIf(TokenType::ARROW, ErrorType::VARIANTMATCHCASE_EXPECTED_ARROW)) return false;
+      return expectBlock(Owner::MatchCase, ErrorType::VARIANTMATCHCASE_EXPECTED_BLOCK);
+    }
+
+    if (!consumeIf(TokenType::RBRACE, ErrorType::VARIANTMATCH_EXPECTED_RBRACE)) return false;
+
+    auto matchStmt = std::make_unique<VariantMatchStmt>(
+        std::move(stmt.position), std::move(stmt.expr), std::move(stmt.cases));
+    pending.pop_back();
+    append(std::move(matchStmt));
+    return true;
+  };
+
+  openBlock(Owner::Block);
+
+  while (true) {
+    if (m_token.type != TokenType::RBRACE) {
+      PendingStmt stmt;
+      stmt.position = m_token.position;
+
+      switch (m_token.type) {
+        case TokenType::LBRACE:
+          openBlock(Owner::Block);
+          break;
+
+        case TokenType::IF_KWRD:
+          consumeToken();
+          if ((stmt.expr = parseExpression()) == nullptr) {
+            reportError(ErrorType::IF_EXPECTED_CONDITION, m_token.position);
+            return nullptr;
+          }
+          pending.push_back(std::move(stmt));
+          if (!expectBlock(Owner::If, ErrorType::IF_EXPECTED_BLOCK)) return nullptr;
+          break;
+
+        case TokenType::WHILE_KWRD:
+          consumeToken();
+          if ((stmt.expr = parseExpression()) == nullptr) {
+            reportError(ErrorType::WHILE_EXPECTED_CONDITION, m_token.position);
+            return nullptr;
+          }
+          pending.push_back(std::move(stmt));
+          if (!expectBlock(Owner::While, ErrorType::WHILE_EXPECTED_BLOCK)) return nullptr;
+          break;
+
+        case TokenType::FOR_KWRD: {
+          consumeToken();
+          auto identifier = parseIdentifier();
+          if (identifier == std::nullopt) {
+            reportError(ErrorType::FOR_EXPECTED_IDENTIFIER, m_token.position);
+            return nullptr;
+          }
+          stmt.identifier = std::move(*identifier);
+          if (!consumeIf(TokenType::IN_KWRD, ErrorType::FOR_EXPECTED_IN)) return nullptr;
+          if ((stmt.range = parseRange()) == nullptr) {
+            reportError(ErrorType::FOR_EXPECTED_RANGE, m_token.position);
+            return nullptr;
+          }
+          pending.push_back(std::move(stmt));
+          if (!expectBlock(Owner::For, ErrorType::FOR_EXPECTED_BLOCK)) return nullptr;
+          break;
+        }
+
+        case TokenType::MATCH_KWRD:
+          consumeToken();
+          if ((stmt.expr = parseExpression()) == nullptr) {
+            reportError(ErrorType::VARIANTMATCH_EXPECTED_EXPRESSION, m_token.position);
+            return nullptr;
+          }
+          if (!consumeIf(TokenType::LBRACE, ErrorType::VARIANTMATCH_EXPECTED_LBRACE)) {
+            return nullptr;
+          }
+          pending.push_back(std::move(stmt));
+          if (!continueMatch()) return nullptr;
+          break;
+
+        default: {
+          auto statement = parseStatement();
+          if (statement == nullptr) return nullptr;
+          append(std::move(statement));
+          break;
+        }
+      }
+      continue;
+    }
+
+    // Closing brace of the innermost block
+    auto closed = std::move(blocks.back());
+    blocks.pop_back();
+    consumeToken();
+
+    BlockStmt block{std::move(closed.position), std::move(closed.statements)};
+    if (blocks.empty()) {
+      return std::make_unique<BlockStmt>(std::move(block));
+    }
+
+    switch (closed.owner) {
+      case Owner::Block:
+        append(std::make_unique<BlockStmt>(std::move(block)));
+        break;
+
+      case Owner::If:
+        pending.back().block.emplace(std::move(block));
+        if (!continueIf()) return nullptr;
+        break;
+
+      case Owner::Elif: {
+        auto& stmt = pending.back();
+        stmt.elifs.emplace_back(std::move(stmt.clausePosition), std::move(stmt.clauseCondition),
+                                std::move(block));
+        if (!continueIf()) return nullptr;
+        break;
+      }
+
+      case Owner::Else: {
+        auto& stmt = pending.back();
+        auto elseClause = std::make_unique<Else>(std::move(stmt.clausePosition), std::move(block));
+        auto ifStmt =
+            std::make_unique<IfStmt>(std::move(stmt.position), std::move(stmt.expr),
+                                     std::move(*stmt.block), std::move(stmt.elifs),
+                                     std::move(elseClause));
+        pending.pop_back();
+        append(std::move(ifStmt));
+        break;
+      }
+
+      case Owner::For: {
+        auto& stmt = pending.back();
+        auto forStmt =
+            std::make_unique<ForStmt>(std::move(stmt.position), std::move(stmt.identifier),
+                                      std::move(*stmt.range), std::move(block));
+        pending.pop_back();
+        append(std::move(forStmt));
+        break;
+      }
+
+      case Owner::While: {
+        auto& stmt = pending.back();
+        auto whileStmt = std::make_unique<WhileStmt>(std::move(stmt.position),
+                                                     std::move(stmt.expr), std::move(block));
+        pending.pop_back();
+        append(std::move(whileStmt));
+        break;
+      }
+
+      case Owner::MatchCase: {
+        auto& stmt = pending.back();
+        if (stmt.cases.find(stmt.clauseVariant) != stmt.cases.end()) {
+          reportError(ErrorType::VARIANTMATCHCASE_REDEFINITION, m_token.position);
+          return nullptr;
+        }
+        auto variant = stmt.clauseVariant;
+        stmt.cases.insert(std::make_pair(
+            std::move(variant), VariantMatchCase{std::move(stmt.clausePosition),
+                                                 std::move(stmt.clauseVariant), std::move(block)}));
+        if (!continueMatch()) return nullptr;
+        break;
+      }
+    }
+  }
+}
@@ -1,11 +1,10 @@
-#include <cassert>
-
+#include "Casting.h"
 #include "ErrorType.h"
 #include "Parser.h"
 #include "TokenType.h"
 
-Parser::Parser(Lexer& lexer, ErrorHandler& errorHandler)
-    : m_lexer{lexer}, m_errorHandler{errorHandler} {
+Parser::Parser(Lexer& lexer, ErrorHandler& errorHandler, ParsingMode mode, ErrorRecovery recovery)
+    : m_lexer{lexer}, m_errorHandler{errorHandler}, m_mode{mode}, m_recovery{recovery} {
   consumeToken();
   initParserMaps();
 }
@@ -88,17 +87,81 @@ void Parser::initParserMaps() {
 /*                               Utility Methods                              */
 /* -------------------------------------------------------------------------- */
 
-void Parser::consumeToken() { m_token = m_lexer.getNextToken(); }
+void Parser::consumeToken() {
+  m_token = m_lexer.getNextToken();
+  m_consumedTokens++;
+}
 
 bool Parser::consumeIf(TokenType expectedType, ErrorType error) {
   if (m_token.type == expectedType) {
     consumeToken();
     return true;
   }
-  m_errorHandler(error, m_token.position);
+  reportError(error, m_token.position);
   return false;
 }
 
+/* -------------------------------------------------------------------------- */
+/*                               Error Recovery                               */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Reports the error, unless it is a follow-up of an error reported since the parser last
+ * synchronized (ErrorRecovery::PanicMode only).
+ */
+void Parser::reportError(ErrorType error, const Position& position) {
+  if (m_recovery == ErrorRecovery::PanicMode) {
+    if (m_panicking) return;
+    m_panicking = true;
+    m_hadErrors = true;
+  }
+  m_errorHandler(error, position);
+}
+
+bool Parser::canRecover() const {
+  return m_recovery == ErrorRecovery::PanicMode && m_panicking && m_token.type != TokenType::ETX;
+}
+
+/**
+ * @brief Skips tokens up to the next definition keyword. `failedAt` is the token count at the
+ * start of the broken definition, at least one token is skipped to guarantee progress.
+ */
+void Parser::synchronizeDefinition(std::size_t failedAt) {
+  if (m_consumedTokens == failedAt) consumeToken();
+  while (m_token.type != TokenType::ETX && !isDefinitionKeyword(m_token.type)) {
+    consumeToken();
+  }
+  m_panicking = false;
+}
+
+/**
+ * @brief Skips the rest of a broken statement: up to and including the next `;`, up to the `}`
+ * closing the enclosing block or up to the next definition keyword. Nested blocks are skipped as
+ * a whole and end the statement.
+ */
+void Parser::synchronizeStatement(std::size_t failedAt) {
+  if (m_consumedTokens == failedAt) consumeToken();
+
+  int depth = 0;
+  while (m_token.type != TokenType::ETX) {
+    if (m_token.type == TokenType::LBRACE) {
+      depth++;
+    } else if (m_token.type == TokenType::RBRACE) {
+      if (depth == 0) break;
+      consumeToken();
+      if (--depth == 0) break;
+      continue;
+    } else if (depth == 0 && m_token.type == TokenType::SEMICOLON) {
+      consumeToken();
+      break;
+    } else if (depth == 0 && isDefinitionKeyword(m_token.type)) {
+      break;
+    }
+    consumeToken();
+  }
+  m_panicking = false;
+}
+
 std::optional<Identifier> Parser::parseIdentifier() {
   if (m_token.type != TokenType::IDENTIFIER) {
     return std::nullopt;
@@ -126,24 +189,38 @@ std::optional<Program> Parser::parseProgram() {
 
   Program::Definitions definitions;
 
-  auto definition = parseDefinition();
-  while (definition != nullptr) {
+  while (true) {
+    m_panicking = false;
+    auto start = m_consumedTokens;
+
+    auto definition = parseDefinition();
+    if (definition == nullptr) {
+      // A stray token that starts no definition, skipped like a broken one
+      if (m_recovery == ErrorRecovery::PanicMode && m_token.type != TokenType::ETX) {
+        reportError(ErrorType::EXPECTED_DEFINITION, m_token.position);
+      }
+      if (!canRecover()) break;
+      synchronizeDefinition(start);
+      continue;
+    }
+
     // Redefinition
     if (definitions.find(definition->name) != definitions.end()) {
-      m_errorHandler(ErrorType::REDEFINITION, definition->position);
-      return std::nullopt;
+      reportError(ErrorType::REDEFINITION, definition->position);
+      if (m_recovery == ErrorRecovery::None) return std::nullopt;
     }
     // Success, add to map
     else {
       auto entry = std::make_pair(definition->name, std::move(definition));
       definitions.insert(std::move(entry));
     }
-
-    definition = parseDefinition();
   }
 
+  // Only set with ErrorRecovery::PanicMode, the errors were reported already
+  if (m_hadErrors) return std::nullopt;
+
   if (definitions.find(L"main") == definitions.end()) {
-    m_errorHandler(ErrorType::EXPECTED_MAIN_FUNCTION_DEF, position);
+    reportError(ErrorType::EXPECTED_MAIN_FUNCTION_DEF, position);
     return std::nullopt;
   }
 
@@ -187,17 +264,17 @@ std::unique_ptr<Definition> Parser::parseVarDef() {
   std::unique_ptr<Expression> expr;
 
   if ((name = parseIdentifier()) == std::nullopt) {
-    m_errorHandler(ErrorType::VARDEF_EXPECTED_IDENTIFIER, m_token.position);
+    reportError(ErrorType::VARDEF_EXPECTED_IDENTIFIER, m_token.position);
     return nullptr;
   }
   if (!consumeIf(TokenType::COLON, ErrorType::VARDEF_EXPECTED_COLON)) return nullptr;
   if ((type = parseTypeIdentifier()) == std::nullopt) {
-    m_errorHandler(ErrorType::VARDEF_EXPECTED_TYPE_IDENTIFIER, m_token.position);
+    reportError(ErrorType::VARDEF_EXPECTED_TYPE_IDENTIFIER, m_token.position);
     return nullptr;
   }
   if (!consumeIf(TokenType::ASSIGNMENT, ErrorType::VARDEF_EXPECTED_ASSIGNMENT)) return nullptr;
   if ((expr = parseExpression()) == nullptr) {
-    m_errorHandler(ErrorType::VARDEF_EXPECTED_EXPRESSION, m_token.position);
+    reportError(ErrorType::VARDEF_EXPECTED_EXPRESSION, m_token.position);
     return nullptr;
   }
   if (!consumeIf(TokenType::SEMICOLON, ErrorType::VARDEF_EXPECTED_SEMICOLON)) return nullptr;
@@ -222,17 +299,17 @@ std::unique_ptr<Definition> Parser::parseConstDef() {
   std::unique_ptr<Expression> expr;
 
   if ((name = parseIdentifier()) == std::nullopt) {
-    m_errorHandler(ErrorType::CONSTDEF_EXPECTED_IDENTIFIER, m_token.position);
+    reportError(ErrorType::CONSTDEF_EXPECTED_IDENTIFIER, m_token.position);
     return nullptr;
   }
   if (!consumeIf(TokenType::COLON, ErrorType::CONSTDEF_EXPECTED_COLON)) return nullptr;
   if ((type = parseTypeIdentifier()) == std::nullopt) {
-    m_errorHandler(ErrorType::CONSTDEF_EXPECTED_TYPE_IDENTIFIER, m_token.position);
+    reportError(ErrorType::CONSTDEF_EXPECTED_TYPE_IDENTIFIER, m_token.position);
     return nullptr;
   }
   if (!consumeIf(TokenType::ASSIGNMENT, ErrorType::CONSTDEF_EXPECTED_ASSIGNMENT)) return nullptr;
   if ((expr = parseExpression()) == nullptr) {
-    m_errorHandler(ErrorType::CONSTDEF_EXPECTED_EXPRESSION, m_token.position);
+    reportError(ErrorType::CONSTDEF_EXPECTED_EXPRESSION, m_token.position);
     return nullptr;
   }
   if (!consumeIf(TokenType::SEMICOLON, ErrorType::CONSTDEF_EXPECTED_SEMICOLON)) return nullptr;
@@ -256,7 +333,7 @@ std::unique_ptr<Definition> Parser::parseStructDef() {
   std::optional<StructDef::Members> members;
 
   if ((name = parseIdentifier()) == std::nullopt) {
-    m_errorHandler(ErrorType::STRUCTDEF_EXPECTED_IDENTIFIER, m_token.position);
+    reportError(ErrorType::STRUCTDEF_EXPECTED_IDENTIFIER, m_token.position);
     return nullptr;
   }
   if (!consumeIf(TokenType::LBRACE, ErrorType::STRUCTDEF_EXPECTED_LBRACE)) return nullptr;
@@ -273,7 +350,7 @@ std::optional<StructDef::Members> Parser::parseStructMembers() {
   auto member = parseStructMember();
   while (member != nullptr) {
     if (members.find(member->name) != members.end()) {
-      m_errorHandler(ErrorType::STRUCTMEMBER_REDEFINITION, m_token.position);
+      reportError(ErrorType::STRUCTMEMBER_REDEFINITION, m_token.position);
       return std::nullopt;
     } else {
       members.insert(std::make_pair(member->name, std::move(*member)));
@@ -300,7 +377,7 @@ std::unique_ptr<StructMember> Parser::parseStructMember() {
   name = parseIdentifier();
   if (!consumeIf(TokenType::COLON, ErrorType::STRUCTMEMBER_EXPECTED_COLON)) return nullptr;
   if ((type = parseTypeIdentifier()) == std::nullopt) {
-    m_errorHandler(ErrorType::STRUCTMEMBER_EXPECTED_TYPE_IDENTIFIER, m_token.position);
+    reportError(ErrorType::STRUCTMEMBER_EXPECTED_TYPE_IDENTIFIER, m_token.position);
     return nullptr;
   }
   if (!consumeIf(TokenType::SEMICOLON, ErrorType::STRUCTMEMBER_EXPECTED_SEMICOLON)) {
@@ -325,7 +402,7 @@ std::unique_ptr<Definition> Parser::parseVariantDef() {
   std::optional<VariantDef::Types> types;
 
   if ((name = parseIdentifier()) == std::nullopt) {
-    m_errorHandler(ErrorType::VARIANTDEF_EXPECTED_IDENTIFIER, m_token.position);
+    reportError(ErrorType::VARIANTDEF_EXPECTED_IDENTIFIER, m_token.position);
     return nullptr;
   }
   if (!consumeIf(TokenType::LBRACE, ErrorType::VARIANTDEF_EXPECTED_LBRACE)) return nullptr;
@@ -348,7 +425,7 @@ std::optional<VariantDef::Types> Parser::parseVariantTypes() {
     type = parseTypeIdentifier();
     if (type == std::nullopt) return types;
     if (std::find(types.begin(), types.end(), *type) != types.end()) {
-      m_errorHandler(ErrorType::VARIANTTYPE_REDEFINITION, m_token.position);
+      reportError(ErrorType::VARIANTTYPE_REDEFINITION, m_token.position);
       return std::nullopt;
     }
     types.push_back(std::move(*type));
@@ -374,7 +451,7 @@ std::unique_ptr<Definition> Parser::parseFnDef() {
   std::unique_ptr<Statement> body;
 
   if ((name = parseIdentifier()) == std::nullopt) {
-    m_errorHandler(ErrorType::FNDEF_EXPECTED_IDENTIFIER, m_token.position);
+    reportError(ErrorType::FNDEF_EXPECTED_IDENTIFIER, m_token.position);
     return nullptr;
   }
   if (!consumeIf(TokenType::LPAREN, ErrorType::FNDEF_EXPECTED_LPAREN)) return nullptr;
@@ -382,17 +459,15 @@ std::unique_ptr<Definition> Parser::parseFnDef() {
   if (!consumeIf(TokenType::RPAREN, ErrorType::FNDEF_EXPECTED_RPAREN)) return nullptr;
   if (!consumeIf(TokenType::ARROW, ErrorType::FNDEF_EXPECTED_ARROW)) return nullptr;
   if ((returnType = parseTypeIdentifier()) == std::nullopt) {
-    m_errorHandler(ErrorType::FNDEF_EXPECTED_RETURN_TYPE, m_token.position);
+    reportError(ErrorType::FNDEF_EXPECTED_RETURN_TYPE, m_token.position);
     return nullptr;
   }
   if ((body = parseBlockStmt()) == nullptr) {
-    m_errorHandler(ErrorType::FNDEF_EXPECTED_BLOCK, m_token.position);
+    reportError(ErrorType::FNDEF_EXPECTED_BLOCK, m_token.position);
     return nullptr;
   }
 
-  BlockStmt* block = dynamic_cast<BlockStmt*>(body.get());
-  assert(block != nullptr && "Expected body to be a BlockStmt");
-  body.release();
+  auto block = std::unique_ptr<BlockStmt>{cast<BlockStmt>(body.release())};
 
   return std::make_unique<FnDef>(std::move(position), std::move(*name), std::move(*params),
                                  std::move(*returnType), std::move(*block));
@@ -410,7 +485,7 @@ std::optional<FnDef::Params> Parser::parseFnParams() {
     param = parseFnParam();
     if (param == nullptr) return params;
     if (params.find(param->name) != params.end()) {
-      m_errorHandler(ErrorType::FNPARAM_REDEFINITION, m_token.position);
+      reportError(ErrorType::FNPARAM_REDEFINITION, m_token.position);
       return std::nullopt;
     }
     params.insert(std::make_pair(param->name, std::move(*param)));
@@ -438,12 +513,12 @@ std::unique_ptr<FnParam> Parser::parseFnParam() {
     consumeToken();
   }
   if ((name = parseIdentifier()) == std::nullopt) {
-    m_errorHandler(ErrorType::FNPARAM_EXPECTED_IDENTIFIER, m_token.position);
+    reportError(ErrorType::FNPARAM_EXPECTED_IDENTIFIER, m_token.position);
     return nullptr;
   }
   if (!consumeIf(TokenType::COLON, ErrorType::FNPARAM_EXPECTED_COLON)) return nullptr;
   if ((type = parseTypeIdentifier()) == std::nullopt) {
-    m_errorHandler(ErrorType::FNPARAM_EXPECTED_TYPE_IDENTIFIER, m_token.position);
+    reportError(ErrorType::FNPARAM_EXPECTED_TYPE_IDENTIFIER, m_token.position);
     return nullptr;
   }
 
@@ -475,7 +550,7 @@ std::unique_ptr<Expression> Parser::parseBinaryExpression(
 
     auto rhs = (this->*parseSubExpr)();
     if (rhs == nullptr) {
-      m_errorHandler(ErrorType::BINARYEXPRESSION_EXPECTED_RHS, m_token.position);
+      reportError(ErrorType::BINARYEXPRESSION_EXPECTED_RHS, m_token.position);
       return nullptr;
     };
 
@@ -505,7 +580,7 @@ std::unique_ptr<Expression> Parser::parseUnaryExpression(
   auto expr = (this->*parseSubExpr)();
   if (expr == nullptr) {
     // No expression after the operator
-    m_errorHandler(ErrorType::UNARYEXPRESSION_EXPECTED_EXPR, m_token.position);
+    reportError(ErrorType::UNARYEXPRESSION_EXPECTED_EXPR, m_token.position);
     return nullptr;
   }
 
@@ -519,6 +594,8 @@ std::unique_ptr<Expression> Parser::parseUnaryExpression(
  *    | FunctionalExpression;
  */
 std::unique_ptr<Expression> Parser::parseExpression() {
+  if (m_mode == ParsingMode::Iterative) return parseExpressionIteratively();
+
   // For operator prescedence, we have to enter the lowest level of the expression tree first
   return parseLogicOrExpr();
 }
@@ -649,7 +726,7 @@ std::optional<FnCallArgs> Parser::parseFnCallArgs() {
     consumeToken();
     arg = parseExpression();
     if (arg == nullptr) {
-      m_errorHandler(ErrorType::FNCALL_EXPECTED_ARGUMENT, m_token.position);
+      reportError(ErrorType::FNCALL_EXPECTED_ARGUMENT, m_token.position);
       return std::nullopt;
     }
     args.push_back(std::move(arg));
@@ -671,7 +748,7 @@ std::unique_ptr<FunctionalPostfix> Parser::parseMemberAccessPostfix() {
 
   std::optional<Identifier> name;
   if ((name = parseIdentifier()) == std::nullopt) {
-    m_errorHandler(ErrorType::MEMBERACCESS_EXPECTED_IDENTIFIER, m_token.position);
+    reportError(ErrorType::MEMBERACCESS_EXPECTED_IDENTIFIER, m_token.position);
     return nullptr;
   }
 
@@ -692,7 +769,7 @@ std::unique_ptr<FunctionalPostfix> Parser::parseVariantAccessPostfix() {
 
   std::optional<TypeIdentifier> type;
   if ((type = parseTypeIdentifier()) == std::nullopt) {
-    m_errorHandler(ErrorType::VARIANTACCESS_EXPECTED_TYPE_IDENTIFIER, m_token.position);
+    reportError(ErrorType::VARIANTACCESS_EXPECTED_TYPE_IDENTIFIER, m_token.position);
     return nullptr;
   }
 
@@ -762,7 +839,7 @@ std::optional<Object::Members> Parser::parseObjectMembers() {
       return members;
     }
     if (members.find(member->name) != members.end()) {
-      m_errorHandler(ErrorType::OBJECTMEMBER_REDEFINITION, m_token.position);
+      reportError(ErrorType::OBJECTMEMBER_REDEFINITION, m_token.position);
       return std::nullopt;
     }
     members.insert(std::make_pair(member->name, std::move(*member)));
@@ -787,7 +864,7 @@ std::unique_ptr<ObjectMember> Parser::parseObjectMember() {
 
   if (!consumeIf(TokenType::COLON, ErrorType::OBJECTMEMBER_EXPECTED_COLON)) return nullptr;
   if ((expr = parseExpression()) == nullptr) {
-    m_errorHandler(ErrorType::OBJECTMEMBER_EXPECTED_EXPRESSION, m_token.position);
+    reportError(ErrorType::OBJECTMEMBER_EXPECTED_EXPRESSION, m_token.position);
     return nullptr;
   };
 
@@ -807,7 +884,7 @@ std::unique_ptr<Expression> Parser::parseParenExpr() {
 
   std::unique_ptr<Expression> expr;
   if ((expr = parseExpression()) == nullptr) {
-    m_errorHandler(ErrorType::PARENEXPR_EXPECTED_EXPRESSION, m_token.position);
+    reportError(ErrorType::PARENEXPR_EXPECTED_EXPRESSION, m_token.position);
     return nullptr;
   }
   if (!consumeIf(TokenType::RPAREN, ErrorType::PARENEXPR_EXPECTED_RPAREN)) return nullptr;
@@ -831,7 +908,7 @@ std::unique_ptr<Expression> Parser::parseCastExpr() {
 
   if (!consumeIf(TokenType::LPAREN, ErrorType::CASTEXPR_EXPECTED_LPAREN)) return nullptr;
   if ((expr = parseExpression()) == nullptr) {
-    m_errorHandler(ErrorType::CASTEXPR_EXPECTED_EXPRESSION, m_token.position);
+    reportError(ErrorType::CASTEXPR_EXPECTED_EXPRESSION, m_token.position);
     return nullptr;
   }
   if (!consumeIf(TokenType::RPAREN, ErrorType::CASTEXPR_EXPECTED_RPAREN)) return nullptr;
@@ -877,6 +954,8 @@ std::unique_ptr<Statement> Parser::parseStatement() {
  *     = "{", { Statement }, "}";
  */
 std::unique_ptr<Statement> Parser::parseBlockStmt() {
+  if (m_mode == ParsingMode::Iterative) return parseBlockStmtIteratively();
+
   if (m_token.type != TokenType::LBRACE) {
     return nullptr;
   }
@@ -886,8 +965,13 @@ std::unique_ptr<Statement> Parser::parseBlockStmt() {
   BlockStmt::Statements statements{};
 
   while (m_token.type != TokenType::RBRACE) {
+    m_panicking = false;
+    auto start = m_consumedTokens;
+
     if (auto statement = parseStatement(); statement != nullptr) {
       statements.push_back(std::move(statement));
+    } else if (canRecover()) {
+      synchronizeStatement(start);
     } else {
       return nullptr;
     }
@@ -913,7 +997,7 @@ std::unique_ptr<Statement> Parser::parseExpressionOrAssignmentStmt() {
   if (m_token.type == TokenType::ASSIGNMENT) {
     consumeToken();
     if ((value = parseExpression()) == nullptr) {
-      m_errorHandler(ErrorType::ASSIGNMENTSTMT_EXPECTED_EXPRESSION, m_token.position);
+      reportError(ErrorType::ASSIGNMENTSTMT_EXPECTED_EXPRESSION, m_token.position);
       return nullptr;
     };
 
@@ -946,7 +1030,7 @@ std::unique_ptr<Statement> Parser::parseStdinExtractionStmt() {
   while (m_token.type == TokenType::EXTRACTION_OP) {
     consumeToken();
     if ((expr = parseExpression()) == nullptr) {
-      m_errorHandler(ErrorType::STDINEXTRACTION_EXPECTED_EXPRESSION, m_token.position);
+      reportError(ErrorType::STDINEXTRACTION_EXPECTED_EXPRESSION, m_token.position);
       return nullptr;
     };
     expressions.push_back(std::move(expr));
@@ -974,7 +1058,7 @@ std::unique_ptr<Statement> Parser::parseStdoutInsertionStmt() {
   while (m_token.type == TokenType::INSERTION_OP) {
     consumeToken();
     if ((expr = parseExpression()) == nullptr) {
-      m_errorHandler(ErrorType::STDOUTINSERTION_EXPECTED_EXPRESSION, m_token.position);
+      reportError(ErrorType::STDOUTINSERTION_EXPECTED_EXPRESSION, m_token.position);
       return nullptr;
     };
     expressions.push_back(std::move(expr));
@@ -1001,7 +1085,7 @@ std::unique_ptr<Statement> Parser::parseVariantMatchStmt() {
   std::optional<VariantMatchStmt::Cases> cases;
 
   if ((expr = parseExpression()) == nullptr) {
-    m_errorHandler(ErrorType::VARIANTMATCH_EXPECTED_EXPRESSION, m_token.position);
+    reportError(ErrorType::VARIANTMATCH_EXPECTED_EXPRESSION, m_token.position);
     return nullptr;
   };
 
@@ -1021,7 +1105,7 @@ std::optional<VariantMatchStmt::Cases> Parser::parseVariantMatchCases() {
   auto variantCase = parseVariantMatchCase();
   while (variantCase != nullptr) {
     if (cases.find(variantCase->variant) != cases.end()) {
-      m_errorHandler(ErrorType::VARIANTMATCHCASE_REDEFINITION, m_token.position);
+      reportError(ErrorType::VARIANTMATCHCASE_REDEFINITION, m_token.position);
       return std::nullopt;
     } else {
       cases.insert(std::make_pair(variantCase->variant, std::move(*variantCase)));
@@ -1047,20 +1131,18 @@ std::unique_ptr<VariantMatchCase> Parser::parseVariantMatchCase() {
   std::unique_ptr<Statement> block;
 
   if ((variant = parseTypeIdentifier()) == std::nullopt) {
-    m_errorHandler(ErrorType::VARIANTMATCHCASE_EXPECTED_TYPE, m_token.position);
+    reportError(ErrorType::VARIANTMATCHCASE_EXPECTED_TYPE, m_token.position);
     return nullptr;
   }
 
   if (!consumeIf(TokenType::ARROW, ErrorType::VARIANTMATCHCASE_EXPECTED_ARROW)) return nullptr;
 
   if ((block = parseBlockStmt()) == nullptr) {
-    m_errorHandler(ErrorType::VARIANTMATCHCASE_EXPECTED_BLOCK, m_token.position);
+    reportError(ErrorType::VARIANTMATCHCASE_EXPECTED_BLOCK, m_token.position);
     return nullptr;
   }
 
-  auto blockStmt = dynamic_cast<BlockStmt*>(block.get());
-  assert(blockStmt != nullptr && "Expected body to be a BlockStmt");
-  block.release();
+  auto blockStmt = std::unique_ptr<BlockStmt>{cast<BlockStmt>(block.release())};
 
   return std::make_unique<VariantMatchCase>(std::move(position), std::move(*variant),
                                             std::move(*blockStmt));
@@ -1083,19 +1165,17 @@ std::unique_ptr<Statement> Parser::parseIfStmt() {
   std::unique_ptr<Else> elseClause;
 
   if ((condition = parseExpression()) == nullptr) {
-    m_errorHandler(ErrorType::IF_EXPECTED_CONDITION, m_token.position);
+    reportError(ErrorType::IF_EXPECTED_CONDITION, m_token.position);
     return nullptr;
   }
   if ((body = parseBlockStmt()) == nullptr) {
-    m_errorHandler(ErrorType::IF_EXPECTED_BLOCK, m_token.position);
+    reportError(ErrorType::IF_EXPECTED_BLOCK, m_token.position);
     return nullptr;
   }
   if ((elifs = parseElifs()) == std::nullopt) return nullptr;
   elseClause = parseElse();  // Can be null
 
-  auto block = dynamic_cast<BlockStmt*>(body.get());
-  assert(block != nullptr && "Expected body to be a BlockStmt");
-  body.release();
+  auto block = std::unique_ptr<BlockStmt>{cast<BlockStmt>(body.release())};
 
   return std::make_unique<IfStmt>(std::move(position), std::move(condition), std::move(*block),
                                   std::move(*elifs), std::move(elseClause));
@@ -1128,17 +1208,15 @@ std::unique_ptr<Elif> Parser::parseElif() {
   std::unique_ptr<Statement> body;
 
   if ((condition = parseExpression()) == nullptr) {
-    m_errorHandler(ErrorType::ELIF_EXPECTED_CONDITION, m_token.position);
+    reportError(ErrorType::ELIF_EXPECTED_CONDITION, m_token.position);
     return nullptr;
   }
   if ((body = parseBlockStmt()) == nullptr) {
-    m_errorHandler(ErrorType::ELIF_EXPECTED_BLOCK, m_token.position);
+    reportError(ErrorType::ELIF_EXPECTED_BLOCK, m_token.position);
     return nullptr;
   }
 
-  auto block = dynamic_cast<BlockStmt*>(body.get());
-  assert(block != nullptr && "Expected body to be a BlockStmt");
-  body.release();
+  auto block = std::unique_ptr<BlockStmt>{cast<BlockStmt>(body.release())};
 
   return std::make_unique<Elif>(std::move(position), std::move(condition), std::move(*block));
 }
@@ -1157,13 +1235,11 @@ std::unique_ptr<Else> Parser::parseElse() {
   std::unique_ptr<Statement> body;
 
   if ((body = parseBlockStmt()) == nullptr) {
-    m_errorHandler(ErrorType::ELSE_EXPECTED_BLOCK, m_token.position);
+    reportError(ErrorType::ELSE_EXPECTED_BLOCK, m_token.position);
     return nullptr;
   }
 
-  auto block = dynamic_cast<BlockStmt*>(body.get());
-  assert(block != nullptr && "Expected body to be a BlockStmt");
-  body.release();
+  auto block = std::unique_ptr<BlockStmt>{cast<BlockStmt>(body.release())};
 
   return std::make_unique<Else>(std::move(position), std::move(*block));
 }
@@ -1184,25 +1260,23 @@ std::unique_ptr<Statement> Parser::parseForStmt() {
   std::unique_ptr<Statement> body;
 
   if ((identifier = parseIdentifier()) == std::nullopt) {
-    m_errorHandler(ErrorType::FOR_EXPECTED_IDENTIFIER, m_token.position);
+    reportError(ErrorType::FOR_EXPECTED_IDENTIFIER, m_token.position);
     return nullptr;
   }
 
   if (!consumeIf(TokenType::IN_KWRD, ErrorType::FOR_EXPECTED_IN)) return nullptr;
 
   if ((range = parseRange()) == nullptr) {
-    m_errorHandler(ErrorType::FOR_EXPECTED_RANGE, m_token.position);
+    reportError(ErrorType::FOR_EXPECTED_RANGE, m_token.position);
     return nullptr;
   }
 
   if ((body = parseBlockStmt()) == nullptr) {
-    m_errorHandler(ErrorType::FOR_EXPECTED_BLOCK, m_token.position);
+    reportError(ErrorType::FOR_EXPECTED_BLOCK, m_token.position);
     return nullptr;
   }
 
-  auto block = dynamic_cast<BlockStmt*>(body.get());
-  assert(block != nullptr && "Expected body to be a BlockStmt");
-  body.release();
+  auto block = std::unique_ptr<BlockStmt>{cast<BlockStmt>(body.release())};
 
   return std::make_unique<ForStmt>(std::move(position), std::move(*identifier), std::move(*range),
                                    std::move(*block));
@@ -1221,7 +1295,7 @@ std::unique_ptr<Range> Parser::parseRange() {
   if ((from = parseExpression()) == nullptr) return nullptr;
   if (!consumeIf(TokenType::UNTIL_KWRD, ErrorType::FORRANGE_EXPECTED_UNTIL)) return nullptr;
   if ((to = parseExpression()) == nullptr) {
-    m_errorHandler(ErrorType::FORRANGE_EXPECTED_END_EXPR, m_token.position);
+    reportError(ErrorType::FORRANGE_EXPECTED_END_EXPR, m_token.position);
     return nullptr;
   }
 
@@ -1243,18 +1317,16 @@ std::unique_ptr<Statement> Parser::parseWhileStmt() {
   std::unique_ptr<Statement> body;
 
   if ((condition = parseExpression()) == nullptr) {
-    m_errorHandler(ErrorType::WHILE_EXPECTED_CONDITION, m_token.position);
+    reportError(ErrorType::WHILE_EXPECTED_CONDITION, m_token.position);
     return nullptr;
   }
 
   if ((body = parseBlockStmt()) == nullptr) {
-    m_errorHandler(ErrorType::WHILE_EXPECTED_BLOCK, m_token.position);
+    reportError(ErrorType::WHILE_EXPECTED_BLOCK, m_token.position);
     return nullptr;
   }
 
-  auto block = dynamic_cast<BlockStmt*>(body.get());
-  assert(block != nullptr && "Expected body to be a BlockStmt");
-  body.release();
+  auto block = std::unique_ptr<BlockStmt>{cast<BlockStmt>(body.release())};
 
   return std::make_unique<WhileStmt>(std::move(position), std::move(condition), std::move(*block));
 }
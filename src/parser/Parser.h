@@ -14,6 +14,22 @@
 #include "Statement.h"
 #include "parser_utils.h"
 
+/**
+ * @brief Recursive mode follows the grammar with one native call per rule. Iterative mode parses
+ * expressions and blocks with explicit stacks kept on the heap, so deeply nested (e.g. generated)
+ * code cannot overflow the native stack.
+ */
+enum class ParsingMode { Recursive, Iterative };
+
+/**
+ * @brief With PanicMode the parser does not give up on the first syntax error. It skips the broken
+ * statement (up to `;`, `}` or the next definition keyword) or definition and carries on, so one
+ * run reports every independent error. Follow-up errors of a skipped region are not reported.
+ * Statements are recovered in ParsingMode::Recursive, top-level definitions in both modes. A
+ * program with errors is still rejected.
+ */
+enum class ErrorRecovery { None, PanicMode };
+
 class Parser {
  public:
   Parser() = delete;
@@ -23,16 +39,24 @@ class Parser {
   Parser &operator=(Parser &&) = delete;
   ~Parser() = default;
 
-  Parser(Lexer &lexer, ErrorHandler &errorHandler);
+  Parser(Lexer &lexer, ErrorHandler &errorHandler, ParsingMode mode = ParsingMode::Recursive,
+         ErrorRecovery recovery = ErrorRecovery::None);
 
   std::optional<Program> parseProgram();
 
  private:
   friend class ParserTest;
+  friend class IncrementalParser;
 
   void consumeToken();
   bool consumeIf(TokenType expectedType, ErrorType error);
 
+  // Error recovery
+  void reportError(ErrorType error, const Position &position);
+  bool canRecover() const;
+  void synchronizeDefinition(std::size_t failedAt);
+  void synchronizeStatement(std::size_t failedAt);
+
   /* ASTNodes are returned by pointers, convenience methods return optional */
 
   // Identifiers
@@ -117,12 +141,21 @@ class Parser {
   std::unique_ptr<Statement> parseBreakStmt();
   std::unique_ptr<Statement> parseReturnStmt();
 
+  // Explicit-stack variants used in ParsingMode::Iterative, see IterativeParser.cpp
+  std::unique_ptr<Expression> parseExpressionIteratively();
+  std::unique_ptr<Statement> parseBlockStmtIteratively();
+
  private:
   void initParserMaps();
 
   Lexer &m_lexer;
   ErrorHandler &m_errorHandler;
+  ParsingMode m_mode;
+  ErrorRecovery m_recovery;
   Token m_token;
+  std::size_t m_consumedTokens = 0;
+  bool m_panicking = false;
+  bool m_hadErrors = false;
 
   std::unordered_map<TokenType, std::function<std::unique_ptr<Definition>()>> m_definitionParsers;
   std::unordered_map<TokenType, std::function<std::unique_ptr<Expression>()>> m_primaryExprParsers;
@@ -1,4 +1,12 @@
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
 #include "ASTNode.h"
+#include "Definition.h"
+#include "Types.h"
 
 /*
  * Program
@@ -9,7 +17,14 @@ struct Program : public ASTNode {
   using Definitions = std::unordered_map<Identifier, std::unique_ptr<Definition>>;
 
   Program(Position &&position, Definitions &&definitions)
-      : ASTNode{std::move(position)}, definitions{std::move(definitions)} {}
+      : ASTNode{NodeKind::Program, std::move(position)}, definitions{std::move(definitions)} {}
+
+  static bool classof(const ASTNode *node) { return node->kind == NodeKind::Program; }
 
   Definitions definitions;
+  std::uint32_t globalCount = 0;  // See Storage
+  TypeTable types;
+
+  // Subtrees referenced by the SharedExpr nodes of the definitions
+  std::vector<std::unique_ptr<Expression>> sharedExpressions;
 };
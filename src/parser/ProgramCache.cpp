@@ -0,0 +1,117 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <system_error>
+
+#include "ASTSerializer.h"
+#include "ProgramCache.h"
+
+ProgramCache::ProgramCache(std::filesystem::path directory, std::string toolVersion)
+    : m_directory{std::move(directory)}, m_toolVersion{std::move(toolVersion)} {}
+
+/**
+ * @brief 64-bit FNV-1a, stable across runs and platforms unlike std::hash.
+ */
+std::uint64_t ProgramCache::hashSource(std::string_view source) {
+  std::uint64_t hash = 0xcbf29ce484222325ULL;
+  for (unsigned char c : source) {
+    hash ^= c;
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+/**
+ * @brief $PROTON_CACHE_DIR if set, otherwise $XDG_CACHE_HOME/proton or ~/.cache/proton.
+ */
+std::filesystem::path ProgramCache::defaultDirectory() {
+  if (auto dir = std::getenv("PROTON_CACHE_DIR"); dir != nullptr && *dir != '\0') {
+    return dir;
+  }
+  if (auto dir = std::getenv("XDG_CACHE_HOME"); dir != nullptr && *dir != '\0') {
+    return std::filesystem::path{dir} / "proton";
+  }
+  if (auto home = std::getenv("HOME"); home != nullptr && *home != '\0') {
+    return std::filesystem::path{home} / ".cache" / "proton";
+  }
+  return std::filesystem::temp_directory_path() / "proton";
+}
+
+std::filesystem::path ProgramCache::entryPath(std::string_view source) const {
+  auto key = hashSource(source) ^ (hashSource(m_toolVersion) * 31);
+
+  std::stringstream name;
+  name << std::hex << std::setw(16) << std::setfill('0') << key << ".past";
+  return m_directory / name.str();
+}
+
+/**
+ * @brief Maps the cache entry into memory and deserializes the program directly from the
+ * mapping, without reading the file into an intermediate buffer.
+ *
+ * @return std::nullopt on a cache miss or when the entry is stale or corrupted, or was stored for
+ * another source whose key collides with this one.
+ */
+std::optional<Program> ProgramCache::load(std::string_view source,
+                                          const std::string& sourceFile) const {
+  auto path = entryPath(source);
+
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) return std::nullopt;
+
+  struct stat info;
+  if (::fstat(fd, &info) != 0 || info.st_size == 0) {
+    ::close(fd);
+    return std::nullopt;
+  }
+
+  auto size = static_cast<std::size_t>(info.st_size);
+  void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) return std::nullopt;
+
+  ::madvise(data, size, MADV_SEQUENTIAL);
+  auto program = deserializeProgram(static_cast<const std::uint8_t*>(data), size,
+                                    source, m_toolVersion, sourceFile);
+  ::munmap(data, size);
+
+  return program;
+}
+
+/**
+ * @brief Writes the entry to a temporary file first and renames it, so concurrent runs never
+ * observe a partially written entry.
+ */
+bool ProgramCache::store(std::string_view source, const Program& program) const {
+  std::error_code error;
+  std::filesystem::create_directories(m_directory, error);
+  if (error) return false;
+
+  auto bytes = serializeProgram(program, source, m_toolVersion);
+  auto path = entryPath(source);
+  auto tmpPath = path;
+  tmpPath += "." + std::to_string(::getpid()) + ".tmp";
+
+  {
+    std::ofstream file{tmpPath, std::ios::binary | std::ios::trunc};
+    file.write(reinterpret_cast<const char*>(bytes.data()),
+               static_cast<std::streamsize>(bytes.size()));
+    if (!file) {
+      std::filesystem::remove(tmpPath, error);
+      return false;
+    }
+  }
+
+  std::filesystem::rename(tmpPath, path, error);
+  if (error) {
+    std::filesystem::remove(tmpPath, error);
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "Program.h"
+
+/**
+ * @brief On-disk cache of parsed programs. Entries are keyed by a hash of the source contents
+ * and the tool version, and are memory mapped when loaded. An entry holds the whole source it
+ * was stored for and is only used for that source. The positions of a loaded program refer to
+ * the file it is loaded for, whichever file with the same contents stored it.
+ */
+class ProgramCache {
+ public:
+  ProgramCache() = delete;
+  ProgramCache(const ProgramCache&) = delete;
+  ProgramCache(ProgramCache&&) = delete;
+  ProgramCache& operator=(const ProgramCache&) = delete;
+  ProgramCache& operator=(ProgramCache&&) = delete;
+  ~ProgramCache() = default;
+
+  ProgramCache(std::filesystem::path directory, std::string toolVersion);
+
+  std::optional<Program> load(std::string_view source, const std::string& sourceFile) const;
+  bool store(std::string_view source, const Program& program) const;
+
+  std::filesystem::path entryPath(std::string_view source) const;
+
+  static std::uint64_t hashSource(std::string_view source);
+  static std::filesystem::path defaultDirectory();
+
+ private:
+  std::filesystem::path m_directory;
+  std::string m_toolVersion;
+};
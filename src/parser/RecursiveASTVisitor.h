@@ -0,0 +1,252 @@
+#pragma once
+
+#include <type_traits>
+
+#include "ASTDispatch.h"
+#include "Definition.h"
+#include "Expression.h"
+#include "Program.h"
+#include "Statement.h"
+
+/**
+ * @brief Depth-first traversal of the whole AST, dispatched statically through the derived pass.
+ *
+ * Derived passes declare only the hooks they care about, no other code runs for the remaining
+ * nodes:
+ *  - `visit(X&)` runs before the children of X are traversed. It may return void or bool, false
+ *    skips the children of the node.
+ *  - `postVisit(X&)` runs after the children (also when they were skipped).
+ * Hooks taking a category (e.g. `visit(Expression&)`) are called for every node of that category
+ * that has no more specific hook. Hooks may be private if the pass befriends the visitor.
+ *
+ * A pass can replace the traversal of a node type by declaring `traverse(X&)` (together with
+ * `using RecursiveASTVisitor<Derived>::traverse;`), e.g. to visit the children in a different
+ * order.
+ */
+template <typename Derived>
+class RecursiveASTVisitor {
+ public:
+  void traverseNode(ASTNode& node) {
+    dispatch(node, [this](auto& concrete) { derived().traverse(concrete); });
+  }
+
+  void traverse(Program& program) {
+    walk(program, [&] {
+      for (auto& [name, definition] : program.definitions) traverseNode(*definition);
+    });
+  }
+
+  /* ------------------------------- Definitions ------------------------------ */
+
+  void traverse(VarDef& def) {
+    walk(def, [&] { traverseNode(*def.value); });
+  }
+
+  void traverse(ConstDef& def) {
+    walk(def, [&] { traverseNode(*def.value); });
+  }
+
+  void traverse(StructDef& def) {
+    walk(def, [&] {
+      for (auto& [name, member] : def.members) derived().traverse(member);
+    });
+  }
+
+  void traverse(StructMember& member) { walk(member, [] {}); }
+
+  void traverse(VariantDef& def) { walk(def, [] {}); }
+
+  void traverse(FnDef& def) {
+    walk(def, [&] {
+      for (auto& [name, param] : def.parameters) derived().traverse(param);
+      derived().traverse(def.body);
+    });
+  }
+
+  void traverse(FnParam& param) { walk(param, [] {}); }
+
+  /* ------------------------------- Statements ------------------------------- */
+
+  void traverse(BlockStmt& stmt) {
+    walk(stmt, [&] {
+      for (auto& statement : stmt.statements) traverseNode(*statement);
+    });
+  }
+
+  void traverse(ExpressionStmt& stmt) {
+    walk(stmt, [&] { traverseNode(*stmt.expr); });
+  }
+
+  void traverse(AssignmentStmt& stmt) {
+    walk(stmt, [&] {
+      traverseNode(*stmt.lhs);
+      traverseNode(*stmt.rhs);
+    });
+  }
+
+  void traverse(StdinExtractionStmt& stmt) {
+    walk(stmt, [&] {
+      for (auto& expr : stmt.expressions) traverseNode(*expr);
+    });
+  }
+
+  void traverse(StdoutInsertionStmt& stmt) {
+    walk(stmt, [&] {
+      for (auto& expr : stmt.expressions) traverseNode(*expr);
+    });
+  }
+
+  void traverse(VariantMatchStmt& stmt) {
+    walk(stmt, [&] {
+      traverseNode(*stmt.expr);
+      for (auto& [variant, matchCase] : stmt.cases) derived().traverse(matchCase);
+    });
+  }
+
+  void traverse(VariantMatchCase& matchCase) {
+    walk(matchCase, [&] { derived().traverse(matchCase.block); });
+  }
+
+  void traverse(IfStmt& stmt) {
+    walk(stmt, [&] {
+      traverseNode(*stmt.condition);
+      derived().traverse(stmt.block);
+      for (auto& elif : stmt.elifs) derived().traverse(elif);
+      if (stmt.elseClause) derived().traverse(*stmt.elseClause);
+    });
+  }
+
+  void traverse(Elif& elif) {
+    walk(elif, [&] {
+      traverseNode(*elif.condition);
+      derived().traverse(elif.block);
+    });
+  }
+
+  void traverse(Else& elseClause) {
+    walk(elseClause, [&] { derived().traverse(elseClause.block); });
+  }
+
+  void traverse(ForStmt& stmt) {
+    walk(stmt, [&] {
+      derived().traverse(stmt.range);
+      derived().traverse(stmt.block);
+    });
+  }
+
+  void traverse(Range& range) {
+    walk(range, [&] {
+      traverseNode(*range.start);
+      traverseNode(*range.end);
+    });
+  }
+
+  void traverse(WhileStmt& stmt) {
+    walk(stmt, [&] {
+      traverseNode(*stmt.condition);
+      derived().traverse(stmt.block);
+    });
+  }
+
+  void traverse(ContinueStmt& stmt) { walk(stmt, [] {}); }
+
+  void traverse(BreakStmt& stmt) { walk(stmt, [] {}); }
+
+  void traverse(ReturnStmt& stmt) {
+    walk(stmt, [&] {
+      if (stmt.expr) traverseNode(*stmt.expr);
+    });
+  }
+
+  /* ------------------------------- Expressions ------------------------------ */
+
+  void traverse(BinaryExpression& expr) {
+    walk(expr, [&] {
+      traverseNode(*expr.lhs);
+      traverseNode(*expr.rhs);
+    });
+  }
+
+  void traverse(UnaryExpression& expr) {
+    walk(expr, [&] { traverseNode(*expr.expr); });
+  }
+
+  void traverse(FunctionalExpression& expr) {
+    walk(expr, [&] {
+      traverseNode(*expr.expr);
+      traverseNode(*expr.postfix);
+    });
+  }
+
+  void traverse(FnCallPostfix& postfix) {
+    walk(postfix, [&] {
+      for (auto& arg : postfix.args) traverseNode(*arg);
+    });
+  }
+
+  void traverse(MemberAccessPostfix& postfix) { walk(postfix, [] {}); }
+
+  void traverse(VariantAccessPostfix& postfix) { walk(postfix, [] {}); }
+
+  void traverse(IdentifierExpr& expr) { walk(expr, [] {}); }
+
+  template <typename T>
+  void traverse(Literal<T>& expr) {
+    walk(expr, [] {});
+  }
+
+  void traverse(Object& expr) {
+    walk(expr, [&] {
+      for (auto& [name, member] : expr.members) traverseNode(*member.value);
+    });
+  }
+
+  void traverse(ParenExpr& expr) {
+    walk(expr, [&] { traverseNode(*expr.expr); });
+  }
+
+  void traverse(CastExpr& expr) {
+    walk(expr, [&] { traverseNode(*expr.expr); });
+  }
+
+  // The shared subtree is traversed again at each of its uses
+  void traverse(SharedExpr& expr) {
+    walk(expr, [&] { traverseNode(*expr.expr); });
+  }
+
+  void traverse(InlinedCall& expr) {
+    walk(expr, [&] {
+      for (auto& arg : expr.args) traverseNode(*arg);
+      derived().traverse(expr.body);
+    });
+  }
+
+ protected:
+  RecursiveASTVisitor() = default;
+  ~RecursiveASTVisitor() = default;
+
+  Derived& derived() { return static_cast<Derived&>(*this); }
+
+ private:
+  template <typename Node, typename Children>
+  void walk(Node& node, Children&& children) {
+    if (preVisit(node)) {
+      children();
+    }
+    if constexpr (requires(Derived& pass) { pass.postVisit(node); }) {
+      derived().postVisit(node);
+    }
+  }
+
+  template <typename Node>
+  bool preVisit(Node& node) {
+    if constexpr (requires(Derived& pass) { pass.visit(node); }) {
+      if constexpr (std::is_same_v<decltype(derived().visit(node)), bool>) {
+        return derived().visit(node);
+      } else {
+        derived().visit(node);
+      }
+    }
+    return true;
+  }
+};
@@ -2,9 +2,11 @@
 
 #include <memory>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "ASTNode.h"
+#include "Expression.h"
 
 /*
  * Statement
@@ -23,7 +25,11 @@
  */
 struct Statement : public ASTNode {
  public:
-  Statement(Position &&position) : ASTNode{std::move(position)} {}
+  Statement(NodeKind kind, Position &&position) : ASTNode{kind, std::move(position)} {}
+
+  static bool classof(const ASTNode *node) {
+    return node->kind >= NodeKind::FirstStatement && node->kind <= NodeKind::LastStatement;
+  }
 };
 
 /*
@@ -35,7 +41,9 @@ struct BlockStmt : public Statement {
   using Statements = std::vector<std::unique_ptr<Statement>>;
 
   BlockStmt(Position &&position, Statements &&statements)
-      : Statement{std::move(position)}, statements{std::move(statements)} {}
+      : Statement{NodeKind::BlockStmt, std::move(position)}, statements{std::move(statements)} {}
+
+  static bool classof(const ASTNode *node) { return node->kind == NodeKind::BlockStmt; }
 
   Statements statements;
 };
@@ -47,7 +55,9 @@ struct BlockStmt : public Statement {
 struct ExpressionStmt : public Statement {
  public:
   ExpressionStmt(Position &&position, std::unique_ptr<Expression> &&expr)
-      : Statement{std::move(position)}, expr{std::move(expr)} {}
+      : Statement{NodeKind::ExpressionStmt, std::move(position)}, expr{std::move(expr)} {}
+
+  static bool classof(const ASTNode *node) { return node->kind == NodeKind::ExpressionStmt; }
 
   std::unique_ptr<Expression> expr;
 };
@@ -60,7 +70,11 @@ struct AssignmentStmt : public Statement {
  public:
   AssignmentStmt(Position &&position, std::unique_ptr<Expression> &&lhs,
                  std::unique_ptr<Expression> &&rhs)
-      : Statement{std::move(position)}, lhs{std::move(lhs)}, rhs{std::move(rhs)} {}
+      : Statement{NodeKind::AssignmentStmt, std::move(position)},
+        lhs{std::move(lhs)},
+        rhs{std::move(rhs)} {}
+
+  static bool classof(const ASTNode *node) { return node->kind == NodeKind::AssignmentStmt; }
 
   std::unique_ptr<Expression> lhs;
   std::unique_ptr<Expression> rhs;
@@ -73,7 +87,10 @@ struct AssignmentStmt : public Statement {
 struct StdinExtractionStmt : public Statement {
  public:
   StdinExtractionStmt(Position &&position, std::vector<std::unique_ptr<Expression>> &&expressions)
-      : Statement{std::move(position)}, expressions{std::move(expressions)} {}
+      : Statement{NodeKind::StdinExtractionStmt, std::move(position)},
+        expressions{std::move(expressions)} {}
+
+  static bool classof(const ASTNode *node) { return node->kind == NodeKind::StdinExtractionStmt; }
 
   std::vector<std::unique_ptr<Expression>> expressions;
 };
@@ -85,7 +102,10 @@ struct StdinExtractionStmt : public Statement {
 struct StdoutInsertionStmt : public Statement {
  public:
   StdoutInsertionStmt(Position &&position, std::vector<std::unique_ptr<Expression>> &&expressions)
-      : Statement{std::move(position)}, expressions{std::move(expressions)} {}
+      : Statement{NodeKind::StdoutInsertionStmt, std::move(position)},
+        expressions{std::move(expressions)} {}
+
+  static bool classof(const ASTNode *node) { return node->kind == NodeKind::StdoutInsertionStmt; }
 
   std::vector<std::unique_ptr<Expression>> expressions;
 };
@@ -96,9 +116,15 @@ struct StdoutInsertionStmt : public Statement {
 struct VariantMatchCase : public ASTNode {
  public:
   VariantMatchCase(Position &&position, TypeIdentifier &&variant, BlockStmt &&block)
-      : ASTNode{std::move(position)}, variant{std::move(variant)}, block{std::move(block)} {}
+      : ASTNode{NodeKind::VariantMatchCase, std::move(position)},
+        variant{std::move(variant)},
+        block{std::move(block)} {}
+
+  static bool classof(const ASTNode *node) { return node->kind == NodeKind::VariantMatchCase; }
 
   TypeIdentifier variant;
+  TypeId typeId = ERROR_TYPE;  // Of the matched alternative
+  VariantTag tag = 0;          // Of the matched alternative
   BlockStmt block;
 };
 
@@ -111,10 +137,26 @@ struct VariantMatchStmt : public Statement {
   using Cases = std::unordered_map<TypeIdentifier, VariantMatchCase>;
 
   VariantMatchStmt(Position &&position, std::unique_ptr<Expression> &&expr, Cases &&cases)
-      : Statement{std::move(position)}, expr{std::move(expr)}, cases{std::move(cases)} {}
+      : Statement{NodeKind::VariantMatchStmt, std::move(position)},
+        expr{std::move(expr)},
+        cases{std::move(cases)} {}
+
+  static bool classof(const ASTNode *node) { return node->kind == NodeKind::VariantMatchStmt; }
 
   std::unique_ptr<Expression> expr;
   Cases cases;
+  std::vector<VariantMatchCase *> jumpTable;  // Cases by tag, null for alternatives without one
+};
+
+/**
+ * @brief Branches of an if statement whose conditions compare one expression with distinct int or
+ * char constants, by constant: 1 for the if block, 2 and up for the elifs, 0 for the else block
+ * or none. Either dense (indexed by constant - min) or sparse (sorted by constant).
+ */
+struct SwitchTable {
+  int min = 0;
+  std::vector<std::uint32_t> dense;
+  std::vector<std::pair<int, std::uint32_t>> sparse;
 };
 
 struct Elif : public ASTNode {
@@ -124,7 +166,11 @@ struct Elif : public ASTNode {
    *     = "elif", Expression, BlockStmt;
    */
   Elif(Position &&position, std::unique_ptr<Expression> &&expr, BlockStmt &&block)
-      : ASTNode{std::move(position)}, condition{std::move(expr)}, block{std::move(block)} {}
+      : ASTNode{NodeKind::Elif, std::move(position)},
+        condition{std::move(expr)},
+        block{std::move(block)} {}
+
+  static bool classof(const ASTNode *node) { return node->kind == NodeKind::Elif; }
 
   std::unique_ptr<Expression> condition;
   BlockStmt block;
@@ -137,7 +183,9 @@ struct Elif : public ASTNode {
 struct Else : public ASTNode {
  public:
   Else(Position &&position, BlockStmt &&block)
-      : ASTNode{std::move(position)}, block{std::move(block)} {}
+      : ASTNode{NodeKind::Else, std::move(position)}, block{std::move(block)} {}
+
+  static bool classof(const ASTNode *node) { return node->kind == NodeKind::Else; }
 
   BlockStmt block;
 };
@@ -152,16 +200,19 @@ struct IfStmt : public Statement {
 
   IfStmt(Position &&position, std::unique_ptr<Expression> &&expr, BlockStmt &&block, Elifs &&elifs,
          std::unique_ptr<Else> &&elseClause)
-      : Statement{std::move(position)},
+      : Statement{NodeKind::IfStmt, std::move(position)},
         condition{std::move(expr)},
         block{std::move(block)},
         elifs{std::move(elifs)},
         elseClause{std::move(elseClause)} {}
 
+  static bool classof(const ASTNode *node) { return node->kind == NodeKind::IfStmt; }
+
   std::unique_ptr<Expression> condition;
   BlockStmt block;
   Elifs elifs;
   std::unique_ptr<Else> elseClause;
+  std::unique_ptr<SwitchTable> switchTable;  // See lowerSwitches()
 };
 
 /*
@@ -171,12 +222,19 @@ struct IfStmt : public Statement {
 struct Range : public ASTNode {
  public:
   Range(Position &&position, std::unique_ptr<Expression> &&start, std::unique_ptr<Expression> &&end)
-      : ASTNode{std::move(position)}, start{std::move(start)}, end{std::move(end)} {}
+      : ASTNode{NodeKind::Range, std::move(position)},
+        start{std::move(start)},
+        end{std::move(end)} {}
+
+  static bool classof(const ASTNode *node) { return node->kind == NodeKind::Range; }
 
   std::unique_ptr<Expression> start;
   std::unique_ptr<Expression> end;
 };
 
+// Direction of a range known before the loop runs, see specializeCountedLoops()
+enum class RangeDirection : std::uint8_t { Unresolved, Ascending, Descending, Empty };
+
 /*
  * ForStmt
  *     = "for", Identifier, "in", Range, BlockStmt;
@@ -184,14 +242,18 @@ struct Range : public ASTNode {
 struct ForStmt : public Statement {
  public:
   ForStmt(Position &&position, Identifier &&identifier, Range &&range, BlockStmt &&block)
-      : Statement{std::move(position)},
+      : Statement{NodeKind::ForStmt, std::move(position)},
         identifier{std::move(identifier)},
         range{std::move(range)},
         block{std::move(block)} {}
 
+  static bool classof(const ASTNode *node) { return node->kind == NodeKind::ForStmt; }
+
   Identifier identifier;
+  Storage storage;  // Of the loop variable
   Range range;
   BlockStmt block;
+  RangeDirection direction = RangeDirection::Unresolved;
 };
 
 /*
@@ -201,7 +263,11 @@ struct ForStmt : public Statement {
 struct WhileStmt : public Statement {
  public:
   WhileStmt(Position &&position, std::unique_ptr<Expression> &&expr, BlockStmt &&block)
-      : Statement{std::move(position)}, condition{std::move(expr)}, block{std::move(block)} {}
+      : Statement{NodeKind::WhileStmt, std::move(position)},
+        condition{std::move(expr)},
+        block{std::move(block)} {}
+
+  static bool classof(const ASTNode *node) { return node->kind == NodeKind::WhileStmt; }
 
   std::unique_ptr<Expression> condition;
   BlockStmt block;
@@ -213,7 +279,9 @@ struct WhileStmt : public Statement {
  */
 struct ContinueStmt : public Statement {
  public:
-  ContinueStmt(Position &&position) : Statement{std::move(position)} {}
+  ContinueStmt(Position &&position) : Statement{NodeKind::ContinueStmt, std::move(position)} {}
+
+  static bool classof(const ASTNode *node) { return node->kind == NodeKind::ContinueStmt; }
 };
 
 /*
@@ -222,7 +290,9 @@ struct ContinueStmt : public Statement {
  */
 struct BreakStmt : public Statement {
  public:
-  BreakStmt(Position &&position) : Statement{std::move(position)} {}
+  BreakStmt(Position &&position) : Statement{NodeKind::BreakStmt, std::move(position)} {}
+
+  static bool classof(const ASTNode *node) { return node->kind == NodeKind::BreakStmt; }
 };
 
 /*
@@ -232,7 +302,46 @@ struct BreakStmt : public Statement {
 struct ReturnStmt : public Statement {
  public:
   ReturnStmt(Position &&position, std::unique_ptr<Expression> &&expr)
-      : Statement{std::move(position)}, expr{std::move(expr)} {}
+      : Statement{NodeKind::ReturnStmt, std::move(position)}, expr{std::move(expr)} {}
+
+  static bool classof(const ASTNode *node) { return node->kind == NodeKind::ReturnStmt; }
 
   std::unique_ptr<Expression> expr;
 };
+
+/* ------------------------------ Inlined calls ----------------------------- */
+
+struct InlinedParameter {
+  Identifier name;
+  Storage storage;  // In the frame of the caller
+  TypeId typeId = ERROR_TYPE;
+};
+
+/**
+ * @brief Call whose callee body was spliced into the caller by the inliner, there is no source
+ * syntax for it. The arguments are stored to the parameters, now locals of the caller's frame,
+ * then the body runs in place. A return ends the inlined body, the value returned is the value of
+ * the expression.
+ *
+ * Parameters passed a local the callee never writes may be bound to that local directly instead
+ * of to a copy, the body then uses the local and the parameter has no argument.
+ */
+struct InlinedCall : public Expression {
+ public:
+  using Arguments = std::vector<std::unique_ptr<Expression>>;
+
+  InlinedCall(Position &&position, Identifier &&callee, std::vector<InlinedParameter> &&parameters,
+              Arguments &&args, BlockStmt &&body)
+      : Expression{NodeKind::InlinedCall, std::move(position)},
+        callee{std::move(callee)},
+        parameters{std::move(parameters)},
+        args{std::move(args)},
+        body{std::move(body)} {}
+
+  static bool classof(const ASTNode *node) { return node->kind == NodeKind::InlinedCall; }
+
+  Identifier callee;
+  std::vector<InlinedParameter> parameters;
+  Arguments args;  // Of the parameters, in the order of evaluation
+  BlockStmt body;
+};
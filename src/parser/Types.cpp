@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "Types.h"
+
+TypeTable::TypeTable() {
+  m_types.push_back({TypeKind::Error, L"<error>"});
+  m_types.push_back({TypeKind::Int, L"int"});
+  m_types.push_back({TypeKind::Float, L"float"});
+  m_types.push_back({TypeKind::Bool, L"bool"});
+  m_types.push_back({TypeKind::Char, L"char"});
+  m_types.push_back({TypeKind::String, L"string"});
+}
+
+TypeId TypeTable::primitive(PrimitiveType type) { return static_cast<TypeId>(type) + INT_TYPE; }
+
+std::optional<TypeId> TypeTable::primitive(const TypeIdentifier& name) const {
+  for (auto id = INT_TYPE; id <= STRING_TYPE; id++) {
+    if (m_types[id].name == name) return id;
+  }
+  return std::nullopt;
+}
+
+bool TypeTable::isPrimitive(TypeId id) const { return id >= INT_TYPE && id <= STRING_TYPE; }
+
+/* ------------------------------ Nominal types ----------------------------- */
+
+TypeId TypeTable::declareStruct(const Identifier& name) {
+  m_types.push_back({TypeKind::Struct, name});
+  return static_cast<TypeId>(m_types.size() - 1);
+}
+
+TypeId TypeTable::declareVariant(const Identifier& name) {
+  m_types.push_back({TypeKind::Variant, name});
+  return static_cast<TypeId>(m_types.size() - 1);
+}
+
+void TypeTable::defineStruct(TypeId id, std::vector<StructField>&& members) {
+  if (m_types.at(id).kind != TypeKind::Struct) throw std::logic_error("Not a struct type!");
+  m_types[id].members = std::move(members);
+}
+
+void TypeTable::defineVariant(TypeId id, std::vector<TypeId>&& alternatives) {
+  if (m_types.at(id).kind != TypeKind::Variant) throw std::logic_error("Not a variant type!");
+  m_types[id].alternatives = std::move(alternatives);
+}
+
+void TypeTable::layOutStructs() {
+  std::vector<TypeId> enclosing;
+  for (TypeId id = 0; id < m_types.size(); id++) {
+    if (m_types[id].kind == TypeKind::Struct) layOut(id, enclosing);
+  }
+}
+
+// Nested structs are laid out first. A struct nested in itself, which no value can have, takes up
+// a single field to end the recursion
+void TypeTable::layOut(TypeId id, std::vector<TypeId>& enclosing) {
+  if (m_types[id].offsets.size() == m_types[id].members.size()) return;
+
+  enclosing.push_back(id);
+  std::vector<std::uint32_t> offsets;
+  std::uint32_t width = 0;
+  for (const auto& member : m_types[id].members) {
+    offsets.push_back(width);
+    auto nested = m_types[member.type].kind == TypeKind::Struct &&
+                  std::find(enclosing.begin(), enclosing.end(), member.type) == enclosing.end();
+    if (nested) layOut(member.type, enclosing);
+    width += nested ? m_types[member.type].width : 1;
+  }
+  enclosing.pop_back();
+
+  m_types[id].offsets = std::move(offsets);
+  m_types[id].width = width;
+}
+
+/* ---------------------------- Structural types ---------------------------- */
+
+TypeId TypeTable::function(std::vector<TypeId>&& parameters, TypeId result) {
+  auto key = std::make_pair(parameters, result);
+  if (auto it = m_functions.find(key); it != m_functions.end()) return it->second;
+
+  Type type{TypeKind::Function};
+  type.parameters = std::move(parameters);
+  type.result = result;
+  m_types.push_back(std::move(type));
+
+  auto id = static_cast<TypeId>(m_types.size() - 1);
+  m_functions.emplace(std::move(key), id);
+  return id;
+}
+
+TypeId TypeTable::object(std::vector<StructField>&& members) {
+  std::sort(members.begin(), members.end());
+  if (auto it = m_objects.find(members); it != m_objects.end()) return it->second;
+
+  Type type{TypeKind::Struct};
+  type.members = members;
+  m_types.push_back(std::move(type));
+
+  auto id = static_cast<TypeId>(m_types.size() - 1);
+  m_objects.emplace(std::move(members), id);
+  std::vector<TypeId> enclosing;
+  layOut(id, enclosing);
+  return id;
+}
+
+/* --------------------------------- Queries -------------------------------- */
+
+std::optional<std::size_t> TypeTable::memberIndex(TypeId structType,
+                                                  const Identifier& member) const {
+  const auto& members = m_types[structType].members;
+  for (std::size_t i = 0; i < members.size(); i++) {
+    if (members[i].name == member) return i;
+  }
+  return std::nullopt;
+}
+
+bool TypeTable::hasAlternative(TypeId variantType, TypeId alternative) const {
+  return tag(variantType, alternative).has_value();
+}
+
+std::optional<VariantTag> TypeTable::tag(TypeId variantType, TypeId alternative) const {
+  const auto& alternatives = m_types[variantType].alternatives;
+  auto it = std::find(alternatives.begin(), alternatives.end(), alternative);
+  if (it == alternatives.end()) return std::nullopt;
+  return static_cast<VariantTag>(it - alternatives.begin());
+}
+
+std::wstring TypeTable::name(TypeId id) const {
+  const auto& type = m_types[id];
+  switch (type.kind) {
+    case TypeKind::Function: {
+      std::wstring name = L"fn(";
+      for (std::size_t i = 0; i < type.parameters.size(); i++) {
+        name += (i > 0 ? L", " : L"") + this->name(type.parameters[i]);
+      }
+      return name + L") -> " + this->name(type.result);
+    }
+    case TypeKind::Struct:
+      if (type.name.empty()) {
+        std::wstring name = L"{";
+        for (std::size_t i = 0; i < type.members.size(); i++) {
+          name += (i > 0 ? L", " : L" ") + type.members[i].name + L": " +
+                  this->name(type.members[i].type);
+        }
+        return name + L" }";
+      }
+      return type.name;
+    default:
+      return type.name;
+  }
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <compare>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ASTNode.h"
+#include "Expression.h"
+
+enum class TypeKind : std::uint8_t {
+  Error,
+  Int,
+  Float,
+  Bool,
+  Char,
+  String,
+  Struct,
+  Variant,
+  Function,
+};
+
+// Reserved ids of the primitive types, in the order of PrimitiveType
+constexpr TypeId INT_TYPE = 1;
+constexpr TypeId FLOAT_TYPE = 2;
+constexpr TypeId BOOL_TYPE = 3;
+constexpr TypeId CHAR_TYPE = 4;
+constexpr TypeId STRING_TYPE = 5;
+
+struct StructField {
+  Identifier name;
+  TypeId type;
+
+  auto operator<=>(const StructField& other) const = default;
+};
+
+struct Type {
+  TypeKind kind;
+  Identifier name = {};                     // Struct and variant types, empty for object literals
+  std::vector<StructField> members = {};    // In the order of definition
+  std::vector<std::uint32_t> offsets = {};  // Struct types, of the members, see layOutStructs()
+  std::uint32_t width = 0;                  // Struct types, number of fields of a value
+  std::vector<TypeId> alternatives = {};    // Variant types
+  std::vector<TypeId> parameters = {};      // Function types
+  TypeId result = ERROR_TYPE;               // Function types
+};
+
+/**
+ * @brief Every type of a program, referred to by TypeId. Primitive types have fixed ids, struct
+ * and variant types are nominal (a new id for each definition) and function types structural
+ * (interned, equal signatures share their id).
+ *
+ * Object literals get anonymous struct types, interned by their members sorted by name.
+ */
+class TypeTable {
+ public:
+  TypeTable();
+
+  const Type& operator[](TypeId id) const { return m_types[id]; }
+  std::size_t size() const { return m_types.size(); }
+
+  static TypeId primitive(PrimitiveType type);
+  std::optional<TypeId> primitive(const TypeIdentifier& name) const;
+  bool isPrimitive(TypeId id) const;
+  bool isNumeric(TypeId id) const { return id == INT_TYPE || id == FLOAT_TYPE; }
+
+  TypeId declareStruct(const Identifier& name);
+  TypeId declareVariant(const Identifier& name);
+  void defineStruct(TypeId id, std::vector<StructField>&& members);
+  void defineVariant(TypeId id, std::vector<TypeId>&& alternatives);
+
+  /**
+   * @brief Lays out the values of the defined struct types not laid out yet: the members are
+   * fields in the order of definition, except that the fields of a nested struct are stored
+   * inline in place of the member. A member's offset is that of its first field.
+   */
+  void layOutStructs();
+
+  TypeId function(std::vector<TypeId>&& parameters, TypeId result);
+  TypeId object(std::vector<StructField>&& members);
+
+  // Index of the member in the struct, if it has one with that name
+  std::optional<std::size_t> memberIndex(TypeId structType, const Identifier& member) const;
+  // Number of fields a value of the type takes up when it is a member of a struct
+  std::uint32_t width(TypeId id) const {
+    return m_types[id].kind == TypeKind::Struct ? m_types[id].width : 1;
+  }
+  bool hasAlternative(TypeId variantType, TypeId alternative) const;
+  // Index of the alternative in the variant, if it is one of its alternatives
+  std::optional<VariantTag> tag(TypeId variantType, TypeId alternative) const;
+
+  std::wstring name(TypeId id) const;
+
+ private:
+  void layOut(TypeId id, std::vector<TypeId>& enclosing);
+
+  std::vector<Type> m_types;
+
+  std::map<std::pair<std::vector<TypeId>, TypeId>, TypeId> m_functions;
+  std::map<std::vector<StructField>, TypeId> m_objects;
+};
@@ -1,30 +1,50 @@
-#include "Definition.h"
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "ASTStats.h"
 #include "ErrorHandler.h"
-#include "Expression.h"
+#include "ExpressionDeduplication.h"
+#include "FileCharReader.h"
 #include "Lexer.h"
 #include "Parser.h"
-#include "StringCharReader.h"
-
-int main() {
-  ErrorHandler errorHandler;
-  StringCharReader reader{L"2 + 2 * 3;"};
-  Lexer lexer{reader, errorHandler};
-  Parser parser{lexer, errorHandler};
 
-  // std::optional<Program> program;
+int main(int argc, char* argv[]) {
+  bool astStats = false;
+  bool dedupExpressions = false;
 
-  // ProgramDeclarations declarations;
-  // auto decl = std::make_unique<VarDecl>(L"foo", L"bar");
-  // declarations[decl->name] = std::move(decl);
+  int i = 1;
+  for (; i < argc && std::strncmp(argv[i], "--", 2) == 0; i++) {
+    if (std::strcmp(argv[i], "--ast-stats") == 0) {
+      astStats = true;
+    } else if (std::strcmp(argv[i], "--dedup-expressions") == 0) {
+      dedupExpressions = true;
+    } else {
+      std::cerr << "Unknown option: " << argv[i] << "\n";
+      return 1;
+    }
+  }
+  if (i >= argc) {
+    std::cerr << "Usage: parser [--ast-stats] [--dedup-expressions] <source file>\n";
+    return 1;
+  }
 
-  // ProgramDefinitions definitions;
-  // StructMembers members;
-  // auto baz = std::make_unique<VarDecl>(L"baz", L"string");
-  // members.push_back(std::move(baz));
-  // auto Baz = std::make_unique<StructDef>(L"Baz", std::move(members));
-  // definitions[Baz->name] = std::move(Baz);
+  ErrorHandler errorHandler{ErrorPolicy::Collect, 10};
+  FileCharReader reader{argv[i]};
+  Lexer lexer{reader, errorHandler};
+  Parser parser{lexer, errorHandler, ParsingMode::Recursive, ErrorRecovery::PanicMode};
+  auto program = parser.parseProgram();
 
-  // program = Program{std::move(declarations), std::move(definitions)};
+  if (errorHandler.hasErrors() || !program.has_value()) {
+    errorHandler.dumpErrors();
+    return 1;
+  }
 
+  if (dedupExpressions) {
+    auto dedup = deduplicateExpressions(*program);
+    std::cout << "Shared subtrees: " << dedup.sharedSubtrees << ", uses: " << dedup.sharedUses
+              << ", freed nodes: " << dedup.freedNodes << "\n";
+  }
+  if (astStats) printASTStats(std::cout, collectASTStats(*program));
   return 0;
 }
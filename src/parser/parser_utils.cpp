@@ -10,3 +10,9 @@ bool isPrimitiveType(TokenType tokenType) {
 bool isTypeIdentifier(TokenType tokenType) {
   return isPrimitiveType(tokenType) || tokenType == TokenType::IDENTIFIER;
 }
+
+bool isDefinitionKeyword(TokenType tokenType) {
+  return tokenType == TokenType::VAR_KWRD || tokenType == TokenType::CONST_KWRD ||
+         tokenType == TokenType::STRUCT_KWRD || tokenType == TokenType::VARIANT_KWRD ||
+         tokenType == TokenType::FN_KWRD;
+}
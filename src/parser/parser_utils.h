@@ -1,4 +1,5 @@
 #include <typeindex>
+#include <unordered_map>
 
 #include "TokenType.h"
 
@@ -27,3 +28,4 @@ bool isLiteralT(TokenType tokenType) {
 
 bool isPrimitiveType(TokenType tokenType);
 bool isTypeIdentifier(TokenType tokenType);
+bool isDefinitionKeyword(TokenType tokenType);
@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include "DiagnosticSink.h"
+#include "ErrorHandler.h"
+
+using namespace std;
+
+namespace {
+
+Position at(int line, int column, const std::string& file = "main.pr") {
+  return Position{line, column, file};
+}
+
+}  // namespace
+
+TEST(ErrorHandler, KeepsOnlyFirstErrorByDefault) {
+  ErrorHandler errorHandler;
+  errorHandler(ErrorType::VARDEF_EXPECTED_EXPRESSION, at(1, 2));
+  errorHandler(ErrorType::FNDEF_EXPECTED_BLOCK, at(1, 0));
+  errorHandler(ErrorType::INVALID_CHAR_LITERAL, at(3, 4), ErrorLevel::Warning);
+
+  EXPECT_TRUE(errorHandler.hasErrors());
+  ASSERT_EQ(errorHandler.diagnostics().size(), 2);
+  EXPECT_EQ(errorHandler.diagnostics().at(0).type, ErrorType::VARDEF_EXPECTED_EXPRESSION);
+  EXPECT_EQ(errorHandler.diagnostics().at(1).level, ErrorLevel::Warning);
+}
+
+TEST(ErrorHandler, CollectsUpToTheLimit) {
+  ErrorHandler errorHandler{ErrorPolicy::Collect, 2};
+  errorHandler(ErrorType::REDEFINITION, at(1, 0, "a.pr"));
+  errorHandler(ErrorType::REDEFINITION, at(2, 0, "b.pr"));
+  EXPECT_FALSE(errorHandler.limitReached());
+  errorHandler(ErrorType::REDEFINITION, at(3, 0, "c.pr"));
+
+  EXPECT_TRUE(errorHandler.limitReached());
+  ASSERT_EQ(errorHandler.diagnostics().size(), 2);
+  EXPECT_EQ(errorHandler.sourceFile(errorHandler.diagnostics().at(0)), "a.pr");
+  EXPECT_EQ(errorHandler.sourceFile(errorHandler.diagnostics().at(1)), "b.pr");
+}
+
+TEST(ErrorHandler, WarningsAreNotErrors) {
+  ErrorHandler errorHandler;
+  errorHandler(ErrorType::INVALID_NUMBER_LITERAL, at(1, 1), ErrorLevel::Warning);
+  EXPECT_FALSE(errorHandler.hasErrors());
+  EXPECT_EQ(errorHandler.diagnostics().size(), 1);
+}
+
+TEST(DiagnosticSink, FormatsText) {
+  ErrorHandler errorHandler;
+  errorHandler(ErrorType::REDEFINITION, at(4, 7));
+
+  std::stringstream out;
+  TextDiagnosticSink sink{out};
+  errorHandler.emitDiagnostics(sink);
+
+  EXPECT_EQ(out.str(),
+            "\nERROR in line 4 col 7 of main.pr\n"
+            "WHAT? Semantic Error: Redefinition, identifier with that name already exists!\n");
+}
+
+TEST(DiagnosticSink, FormatsJsonLines) {
+  ErrorHandler errorHandler{ErrorPolicy::Collect, 10};
+  errorHandler(ErrorType::EXPECTED_MAIN_FUNCTION_DEF, at(0, 0, "dir\\\"quoted\".pr"));
+  errorHandler(ErrorType::UNEXPECTED_CHARACTER, at(2, 5), ErrorLevel::Warning);
+
+  std::stringstream out;
+  JsonLinesDiagnosticSink sink{out};
+  errorHandler.emitDiagnostics(sink);
+
+  std::string first, second;
+  std::getline(out, first);
+  std::getline(out, second);
+  EXPECT_NE(first.find("\"level\":\"error\""), std::string::npos);
+  EXPECT_NE(first.find("\"file\":\"dir\\\\\\\"quoted\\\".pr\""), std::string::npos);
+  EXPECT_NE(first.find("(fn main() -> int { return 0; })"), std::string::npos);
+  EXPECT_NE(second.find("\"level\":\"warning\""), std::string::npos);
+  EXPECT_NE(second.find("\"line\":2,\"column\":5}"), std::string::npos);
+}
+
+TEST(DiagnosticSink, EscapesControlCharactersInJson) {
+  ErrorHandler errorHandler{ErrorPolicy::Collect, 10};
+  errorHandler(ErrorType::EXPECTED_MAIN_FUNCTION_DEF, at(0, 0, "dir\r\x1f\tname\n.pr"));
+
+  std::stringstream out;
+  JsonLinesDiagnosticSink sink{out};
+  errorHandler.emitDiagnostics(sink);
+
+  std::string line;
+  std::getline(out, line);
+  EXPECT_NE(line.find("\"file\":\"dir\\u000d\\u001f\\tname\\n.pr\""), std::string::npos);
+  EXPECT_EQ(out.get(), std::char_traits<char>::eof());
+}
+
+TEST(DiagnosticSink, PassesRecordsToCallback) {
+  ErrorHandler errorHandler{ErrorPolicy::Collect, 10};
+  errorHandler(ErrorType::FNPARAM_REDEFINITION, at(1, 2));
+  errorHandler(ErrorType::STRUCTMEMBER_REDEFINITION, at(3, 4));
+
+  std::vector<ErrorType> types;
+  CallbackDiagnosticSink sink{[&](const Diagnostic& diagnostic, std::string_view file) {
+    types.push_back(diagnostic.type);
+    EXPECT_EQ(file, "main.pr");
+  }};
+  errorHandler.emitDiagnostics(sink);
+
+  EXPECT_EQ(types, (std::vector{ErrorType::FNPARAM_REDEFINITION,
+                                ErrorType::STRUCTMEMBER_REDEFINITION}));
+}
+
+TEST(ErrorType, MessageTableIsIndexedByType) {
+  static_assert(errorInfo(ErrorType::REDEFINITION).category == SEMANTIC_ERROR);
+  EXPECT_EQ(errorInfo(ErrorType::TOKEN_INVARIANT_VIOLATION).category, INTERNAL_ERROR);
+  EXPECT_EQ(errorInfo(ErrorType::INVALID_NUMBER_LITERAL).message, "Invalid number literal!");
+}
@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+
+#include "Casting.h"
+#include "CompileTimeEvaluation.h"
+#include "ConstantFolding.h"
+#include "TypedProgram.h"
+
+using namespace std;
+using namespace ::testing;
+
+namespace {
+
+Expression& initializer(Program& program, const Identifier& name) {
+  auto& definition = *program.definitions.at(name);
+  if (auto varDef = dyn_cast<VarDef>(&definition)) return *varDef->value;
+  return *cast<ConstDef>(definition).value;
+}
+
+BlockStmt& body(Program& program, const Identifier& fn) {
+  return cast<FnDef>(*program.definitions.at(fn)).body;
+}
+
+Expression& returned(Program& program, const Identifier& fn) {
+  return *cast<ReturnStmt>(*body(program, fn).statements.back()).expr;
+}
+
+}  // namespace
+
+TEST(CompileTimeEvaluation, EvaluatesGlobalInitializers) {
+  auto program = typed(
+      L"struct Point { x: int; y: int; };\n"
+      L"struct Line { from: Point; to: Point; };\n"
+      L"const SIZE: int = square(4);\n"
+      L"var line: Line = { from: origin(), to: { x: SIZE, y: fib(10) } };\n"
+      L"fn main() -> int { return 0; }\n"
+      L"fn square(n: int) -> int { return n * n; }\n"
+      L"fn origin() -> Point { return { x: 0, y: 0 }; }\n"
+      L"fn fib(n: int) -> int {\n"
+      L"  var a: int = 0;\n"
+      L"  var b: int = 1;\n"
+      L"  for i in 0 until n { var next: int = a + b; a = b; b = next; }\n"
+      L"  return a;\n"
+      L"}\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  auto stats = evaluateAtCompileTime(*program);
+  EXPECT_EQ(stats.evaluatedInitializers, 2);
+
+  EXPECT_EQ(literalValue(initializer(*program, L"SIZE")), ConstantValue{16});
+
+  auto& line = cast<Object>(initializer(*program, L"line"));
+  EXPECT_EQ(line.typeId, program->definitions.at(L"Line")->typeId);
+  auto& to = cast<Object>(*line.members.at(L"to").value);
+  EXPECT_EQ(literalValue(*to.members.at(L"x").value), ConstantValue{16});
+  EXPECT_EQ(literalValue(*to.members.at(L"y").value), ConstantValue{55});
+  auto& from = cast<Object>(*line.members.at(L"from").value);
+  EXPECT_EQ(literalValue(*from.members.at(L"y").value), ConstantValue{0});
+}
+
+TEST(CompileTimeEvaluation, ReplacesConstantCallsInBodies) {
+  auto program = typed(
+      L"variant Number { int, float };\n"
+      L"fn main() -> int {\n"
+      L"  var n: int = 3;\n"
+      L"  << describe(2.5) << abs(-7) + abs(n);\n"
+      L"  return abs(sign(-2)) * 10;\n"
+      L"}\n"
+      L"fn abs(n: int) -> int { if n < 0 { return -n; } return n; }\n"
+      L"fn sign(n: int) -> int { if n < 0 { return -1; } elif n > 0 { return 1; } return 0; }\n"
+      L"fn describe(value: Number) -> string {\n"
+      L"  match value {\n"
+      L"    case int -> { return \"int \" + string(value as int); }\n"
+      L"    case float -> { return \"float\"; }\n"
+      L"  }\n"
+      L"  return \"\";\n"
+      L"}\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  auto stats = evaluateAtCompileTime(*program);
+  EXPECT_EQ(stats.evaluatedCalls, 3);
+  EXPECT_EQ(literalValue(returned(*program, L"main")), ConstantValue{10});
+
+  auto& printed = cast<StdoutInsertionStmt>(*body(*program, L"main").statements[1]).expressions;
+  EXPECT_EQ(literalValue(*printed[0]), ConstantValue{L"float"});
+
+  // abs(n) refers to a variable, only the other operand is evaluated
+  auto& sum = cast<BinaryExpression>(*printed[1]);
+  EXPECT_EQ(literalValue(*sum.lhs), ConstantValue{7});
+  EXPECT_TRUE(isa<FunctionalExpression>(*sum.rhs));
+}
+
+TEST(CompileTimeEvaluation, KeepsVariantTypedExpressionsWhereNothingConverts) {
+  auto program = typed(
+      L"variant Shape { int, string };\n"
+      L"const SHAPE: Shape = make();\n"
+      L"const RESULT: int = main();\n"
+      L"fn make() -> Shape { return \"square\"; }\n"
+      L"fn main() -> int {\n"
+      L"  match make() { case int -> { return 1; } case string -> { return 2; } }\n"
+      L"  match SHAPE { case int -> { return 3; } case string -> { return 4; } }\n"
+      L"  return 0;\n"
+      L"}\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  evaluateAtCompileTime(*program);
+
+  // The initializer is converted to the type of the const, the match subject is not
+  auto shape = cast<ConstDef>(*program->definitions.at(L"SHAPE")).typeId;
+  EXPECT_TRUE(isa<Literal<std::wstring>>(initializer(*program, L"SHAPE")));
+  auto& statements = body(*program, L"main").statements;
+  EXPECT_EQ(cast<VariantMatchStmt>(*statements[0]).expr->typeId, shape);
+  EXPECT_TRUE(isa<FunctionalExpression>(*cast<VariantMatchStmt>(*statements[0]).expr));
+  EXPECT_EQ(cast<VariantMatchStmt>(*statements[1]).expr->typeId, shape);
+
+  Evaluator evaluator{*program};
+  auto value = evaluator.evaluate(initializer(*program, L"RESULT"));
+  ASSERT_TRUE(value.has_value());
+  EXPECT_EQ(std::get<int>(value->data), 2);
+}
+
+TEST(CompileTimeEvaluation, LeavesSideEffectsToRuntime) {
+  auto program = typed(
+      L"var counter: int = 0;\n"
+      L"const ONE: int = 1;\n"
+      L"fn main() -> int { return greet() + count() + read() + ONE / zero(); }\n"
+      L"fn greet() -> int { << \"hello\"; return 1; }\n"
+      L"fn count() -> int { counter = counter + 1; return counter; }\n"
+      L"fn read() -> int { return counter; }\n"
+      L"fn zero() -> int { return 0; }\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  auto stats = evaluateAtCompileTime(*program);
+  EXPECT_EQ(stats.evaluatedCalls, 1);
+
+  // Only zero() is replaced, the division by zero is left to runtime
+  auto& sum = cast<BinaryExpression>(returned(*program, L"main"));
+  auto& division = cast<BinaryExpression>(*sum.rhs);
+  EXPECT_TRUE(isa<IdentifierExpr>(*division.lhs));
+  EXPECT_EQ(literalValue(*division.rhs), ConstantValue{0});
+}
+
+TEST(CompileTimeEvaluation, GivesUpOnReachingLimits) {
+  auto program = typed(
+      L"const FOREVER: int = loop();\n"
+      L"const DEEP: int = recurse(1000);\n"
+      L"fn main() -> int { return 0; }\n"
+      L"fn loop() -> int { while true {} return 0; }\n"
+      L"fn recurse(n: int) -> int { if n == 0 { return 0; } return recurse(n - 1); }\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  auto stats = evaluateAtCompileTime(*program, {10000, 100});
+  EXPECT_EQ(stats.evaluatedInitializers, 0);
+  EXPECT_EQ(stats.exhaustedLimits, 2);
+  EXPECT_TRUE(isa<FunctionalExpression>(initializer(*program, L"FOREVER")));
+
+  stats = evaluateAtCompileTime(*program, {100000, 2000});
+  EXPECT_EQ(literalValue(initializer(*program, L"DEEP")), ConstantValue{0});
+}
@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+
+#include "Casting.h"
+#include "ConstantFolding.h"
+#include "Lexer.h"
+#include "Parser.h"
+#include "ScopeChecker.h"
+#include "StringCharReader.h"
+#include "mocks/ErrorHandlerMock.h"
+
+using namespace std;
+using namespace ::testing;
+
+namespace {
+
+std::optional<Program> resolve(const std::wstring& source) {
+  ErrorHandler errorHandler;
+  StringCharReader reader{source};
+  Lexer lexer{reader, errorHandler};
+  Parser parser{lexer, errorHandler};
+  auto program = parser.parseProgram();
+  if (program.has_value()) ScopeChecker{errorHandler}.check(*program);
+  return errorHandler.hasErrors() ? std::nullopt : std::move(program);
+}
+
+BlockStmt& body(Program& program, const Identifier& fn) {
+  return cast<FnDef>(*program.definitions.at(fn)).body;
+}
+
+Expression& returned(Program& program, const Identifier& fn) {
+  return *cast<ReturnStmt>(*body(program, fn).statements.back()).expr;
+}
+
+}  // namespace
+
+TEST(ConstantFolding, FoldsOperatorsOverLiterals) {
+  auto program = resolve(
+      L"fn main() -> int {\n"
+      L"  << \"n = \" + string(2 * 21) << 'a' < 'b' << !(1.5 >= 2.0) << -(3 % 2);\n"
+      L"  return (1 + 2) * 3 - int(2.5);\n"
+      L"}\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  ErrorHandler errorHandler;
+  auto stats = foldConstants(*program, errorHandler);
+  EXPECT_FALSE(errorHandler.hasErrors());
+  EXPECT_EQ(stats.foldedExpressions, 15);
+
+  auto& result = returned(*program, L"main");
+  ASSERT_TRUE(isa<Literal<int>>(result));
+  EXPECT_EQ(cast<Literal<int>>(result).value, 7);
+  EXPECT_EQ(result.typeId, INT_TYPE);
+
+  auto& printed = cast<StdoutInsertionStmt>(*body(*program, L"main").statements[0]).expressions;
+  EXPECT_EQ(literalValue(*printed[0]), ConstantValue{L"n = 42"});
+  EXPECT_EQ(literalValue(*printed[1]), ConstantValue{true});
+  EXPECT_EQ(literalValue(*printed[2]), ConstantValue{true});
+  EXPECT_EQ(literalValue(*printed[3]), ConstantValue{-1});
+}
+
+TEST(ConstantFolding, LeavesNonConstantOperandsAlone) {
+  auto program = resolve(
+      L"fn main() -> int {\n"
+      L"  var a: int = 1;\n"
+      L"  return a * (2 + 3) + f(4 - 1);\n"
+      L"}\n"
+      L"fn f(n: int) -> int { return n; }\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  ErrorHandler errorHandler;
+  auto stats = foldConstants(*program, errorHandler);
+  EXPECT_EQ(stats.foldedExpressions, 3);
+
+  auto& sum = cast<BinaryExpression>(returned(*program, L"main"));
+  auto& product = cast<BinaryExpression>(*sum.lhs);
+  EXPECT_TRUE(isa<IdentifierExpr>(*product.lhs));
+  EXPECT_EQ(literalValue(*product.rhs), ConstantValue{5});
+
+  auto& call = cast<FnCallPostfix>(*cast<FunctionalExpression>(*sum.rhs).postfix);
+  EXPECT_EQ(literalValue(*call.args[0]), ConstantValue{3});
+}
+
+TEST(ConstantFolding, PropagatesConstGlobals) {
+  auto program = resolve(
+      L"variant Number { int, float };\n"
+      L"const A: int = B * 2;\n"
+      L"const B: int = 3;\n"
+      L"const N: Number = 1;\n"
+      L"fn main() -> int { return A + 1; }\n"
+      L"fn shadowed() -> int { const A: int = 0; var n: Number = N; return A; }\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  ErrorHandler errorHandler;
+  auto stats = foldConstants(*program, errorHandler);
+  EXPECT_EQ(stats.propagatedConstants, 2);
+
+  EXPECT_EQ(literalValue(*cast<ConstDef>(*program->definitions.at(L"A")).value), ConstantValue{6});
+  EXPECT_EQ(literalValue(returned(*program, L"main")), ConstantValue{7});
+  EXPECT_TRUE(isa<IdentifierExpr>(returned(*program, L"shadowed")));
+
+  auto& n = cast<VarDef>(*body(*program, L"shadowed").statements[1]);
+  EXPECT_TRUE(isa<IdentifierExpr>(*n.value));
+}
+
+TEST(ConstantFolding, ReportsEvaluationErrors) {
+  auto program = resolve(
+      L"const ZERO: int = 0;\n"
+      L"fn main() -> int {\n"
+      L"  var a: int = 10 / ZERO;\n"
+      L"  var b: int = 2147483647 + 1;\n"
+      L"  var c: float = 1.0 / 0.0;\n"
+      L"  return int(10000000000.0) + a % 0;\n"
+      L"}\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  ErrorHandlerMock errorHandler;
+  EXPECT_CALL(errorHandler,
+              handleError(ErrorType::DIVISION_BY_ZERO, Field(&Position::line, AnyOf(2, 4))))
+      .Times(2);
+  EXPECT_CALL(errorHandler, handleError(ErrorType::INTEGER_OVERFLOW, Field(&Position::line, 3)))
+      .Times(1);
+  EXPECT_CALL(errorHandler, handleError(ErrorType::INTEGER_OVERFLOW, Field(&Position::line, 5)))
+      .Times(1);
+  foldConstants(*program, errorHandler);
+
+  auto& a = cast<VarDef>(*body(*program, L"main").statements[0]);
+  EXPECT_TRUE(isa<BinaryExpression>(*a.value));
+}
+
+TEST(ConstantFolding, LeavesShortCircuitedOperandsUnreported) {
+  auto program = resolve(
+      L"const D: int = 0;\n"
+      L"fn main(n: int) -> int {\n"
+      L"  if D != 0 && 10 / D > 1 { return 1; }\n"
+      L"  if D == 0 || 10 % D > 1 { return 2; }\n"
+      L"  if n > 0 && 10 / D > 1 { return 3; }\n"
+      L"  if true && 10 / D > 1 { return 4; }\n"
+      L"  return 0;\n"
+      L"}\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  // Only the operand evaluated whenever the condition is, is reported
+  ErrorHandlerMock errorHandler;
+  EXPECT_CALL(errorHandler, handleError(ErrorType::DIVISION_BY_ZERO, Field(&Position::line, 5)))
+      .Times(1);
+  foldConstants(*program, errorHandler);
+
+  auto& statements = body(*program, L"main").statements;
+  EXPECT_EQ(literalValue(*cast<IfStmt>(*statements[0]).condition), ConstantValue{false});
+  EXPECT_EQ(literalValue(*cast<IfStmt>(*statements[1]).condition), ConstantValue{true});
+  EXPECT_TRUE(isa<BinaryExpression>(*cast<IfStmt>(*statements[2]).condition));
+}
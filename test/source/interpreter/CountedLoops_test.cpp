@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include "Casting.h"
+#include "CountedLoops.h"
+#include "Evaluator.h"
+#include "RecursiveASTVisitor.h"
+#include "TypedProgram.h"
+
+using namespace std;
+using namespace ::testing;
+
+namespace {
+
+// Directions of the range loops, in the order they appear in the source
+class Directions : public RecursiveASTVisitor<Directions> {
+ public:
+  std::vector<RangeDirection> directions;
+
+  void visit(ForStmt& stmt) { directions.push_back(stmt.direction); }
+};
+
+}  // namespace
+
+TEST(CountedLoops, ResolvesTheDirectionOfConstantRanges) {
+  auto program = typed(
+      L"const RESULT: int = main();\n"
+      L"const TOP: int = 4;\n"
+      L"fn main() -> int {\n"
+      L"  var total: int = 0;\n"
+      L"  var n: int = 3;\n"
+      L"  for i in 0 until TOP { total = total + i; }\n"
+      L"  for i in TOP until -(2) { total = total * 2 + i; }\n"
+      L"  for i in 5 until 5 { total = total + 100; }\n"
+      L"  for i in n until 0 { total = total + i; }\n"
+      L"  return total;\n"
+      L"}\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  auto report = specializeCountedLoops(*program);
+  EXPECT_EQ(report.loops, 4);
+  EXPECT_EQ(report.resolved, 3);
+
+  Directions visitor;
+  visitor.traverse(cast<FnDef>(*program->definitions.at(L"main")).body);
+  EXPECT_EQ(visitor.directions,
+            (std::vector<RangeDirection>{RangeDirection::Ascending, RangeDirection::Descending,
+                                         RangeDirection::Empty, RangeDirection::Unresolved}));
+
+  // 0 + 1 + 2 + 3, then doubled and added 4 down to -1, then 3 + 2 + 1
+  Evaluator evaluator{*program};
+  auto value = evaluator.evaluate(*cast<ConstDef>(*program->definitions.at(L"RESULT")).value);
+  ASSERT_TRUE(value.has_value());
+  EXPECT_EQ(std::get<int>(value->data), 579 + 6);
+}
+
+TEST(CountedLoops, PrintsTheReport) {
+  std::ostringstream out;
+  printCountedLoopReport(out, CountedLoopReport{5, 3});
+  EXPECT_EQ(out.str(), "Counted loops\n  3 of 5 range loops with the direction resolved\n");
+}
@@ -0,0 +1,149 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include "Casting.h"
+#include "DeadCodeElimination.h"
+#include "Lexer.h"
+#include "Parser.h"
+#include "ScopeChecker.h"
+#include "StringCharReader.h"
+#include "TypeChecker.h"
+#include "mocks/ErrorHandlerMock.h"
+
+using namespace std;
+using namespace ::testing;
+
+namespace {
+
+std::optional<Program> resolve(const std::wstring& source) {
+  ErrorHandler errorHandler;
+  StringCharReader reader{source};
+  Lexer lexer{reader, errorHandler};
+  Parser parser{lexer, errorHandler};
+  auto program = parser.parseProgram();
+  if (program.has_value()) ScopeChecker{errorHandler}.check(*program);
+  return errorHandler.hasErrors() ? std::nullopt : std::move(program);
+}
+
+std::vector<Identifier> removedNames(const DeadCodeReport& report) {
+  std::vector<Identifier> names;
+  for (const auto& definition : report.definitions) names.push_back(definition.name);
+  return names;
+}
+
+BlockStmt& body(Program& program, const Identifier& fn) {
+  return cast<FnDef>(*program.definitions.at(fn)).body;
+}
+
+}  // namespace
+
+TEST(DeadCodeElimination, RemovesUnreachableDefinitions) {
+  auto program = resolve(
+      L"struct Point { x: int; y: int; };\n"
+      L"struct Segment { from: Point; to: Point; };\n"
+      L"struct Unused { p: Point; };\n"
+      L"variant Shape { Segment, int };\n"
+      L"var counter: int = 0;\n"
+      L"var started: int = start();\n"
+      L"const LIMIT: int = 10;\n"
+      L"fn main() -> int { return area(2) + counter; }\n"
+      L"fn area(n: int) -> int { match make(n) { case Segment -> {} case int -> {} } return n; }\n"
+      L"fn make(n: int) -> Shape { return n; }\n"
+      L"fn start() -> int { return 1; }\n"
+      L"fn ping(n: int) -> int { return pong(n); }\n"
+      L"fn pong(n: int) -> int { return ping(n) + LIMIT; }\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  auto report = eliminateDeadCode(*program);
+
+  // Mutually recursive functions nobody calls are dropped together with what only they use
+  EXPECT_THAT(removedNames(report), ElementsAre(L"Unused", L"LIMIT", L"ping", L"pong"));
+  EXPECT_EQ(report.definitions[0].kind, NodeKind::StructDef);
+  EXPECT_EQ(report.definitions[0].position.line, 2);
+
+  EXPECT_EQ(program->definitions.size(), 9);
+  for (const auto* name : {L"Point", L"Segment", L"Shape", L"counter", L"started", L"start"}) {
+    EXPECT_TRUE(program->definitions.contains(name)) << "missing definition";
+  }
+}
+
+TEST(DeadCodeElimination, PrunesStatementsAfterLeavingTheBlock) {
+  auto program = resolve(
+      L"fn main() -> int {\n"
+      L"  while true {\n"
+      L"    if false { continue; }\n"
+      L"    break;\n"
+      L"    << \"never\";\n"
+      L"  }\n"
+      L"  if true { return 1; } elif false { return 2; } else { return 3; }\n"
+      L"  << helper();\n"
+      L"  return 0;\n"
+      L"}\n"
+      L"fn helper() -> int { return 4; }\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  auto report = eliminateDeadCode(*program);
+
+  // The call in the pruned statement does not keep helper alive
+  EXPECT_THAT(removedNames(report), ElementsAre(L"helper"));
+
+  ASSERT_EQ(report.statements.size(), 2);
+  EXPECT_EQ(report.statements[0].position.line, 4);
+  EXPECT_EQ(report.statements[0].count, 1);
+  EXPECT_EQ(report.statements[1].position.line, 7);
+  EXPECT_EQ(report.statements[1].count, 2);
+  EXPECT_EQ(report.prunedStatements(), 3);
+
+  auto& statements = body(*program, L"main").statements;
+  ASSERT_EQ(statements.size(), 2);
+  EXPECT_EQ(cast<WhileStmt>(*statements[0]).block.statements.size(), 2);
+  EXPECT_TRUE(isa<IfStmt>(*statements[1]));
+}
+
+TEST(DeadCodeElimination, KeepsStatementsAfterConditionalExits) {
+  auto program = resolve(
+      L"fn main() -> int {\n"
+      L"  if true { return 1; } elif false { << 2; } else { return 3; }\n"
+      L"  { if false { return 4; } }\n"
+      L"  return 0;\n"
+      L"}\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  auto report = eliminateDeadCode(*program);
+  EXPECT_TRUE(report.definitions.empty());
+  EXPECT_TRUE(report.statements.empty());
+  EXPECT_EQ(body(*program, L"main").statements.size(), 3);
+}
+
+TEST(DeadCodeElimination, RunsAfterTheTypeCheckerReportedDeadCode) {
+  auto program = resolve(
+      L"fn main() -> int { return 0; var x: int = \"one\"; }\n"
+      L"fn unused() -> int { return \"not an int\"; }\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  // Unreachable code is checked like any other, the errors do not depend on what main calls
+  ErrorHandlerMock errorHandler;
+  EXPECT_CALL(errorHandler, handleError(ErrorType::TYPE_MISMATCH, _)).Times(2);
+  TypeChecker{errorHandler}.check(*program);
+
+  auto report = eliminateDeadCode(*program);
+  EXPECT_THAT(removedNames(report), ElementsAre(L"unused"));
+  EXPECT_EQ(report.prunedStatements(), 1);
+}
+
+TEST(DeadCodeElimination, PrintsTheReport) {
+  auto program = resolve(
+      L"fn main() -> int { return 0; << 1; }\n"
+      L"fn unused() -> int { return 0; }\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  std::ostringstream out;
+  printDeadCodeReport(out, eliminateDeadCode(*program));
+  EXPECT_EQ(out.str(),
+            "Dead code\n"
+            "  removed fn unused (line 1 col 3)\n"
+            "  pruned 1 unreachable statement (line 0 col 29)\n"
+            "  total: 1 definitions, 1 statements\n");
+}
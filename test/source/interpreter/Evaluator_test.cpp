@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+
+#include "ASTClone.h"
+#include "Casting.h"
+#include "Evaluator.h"
+#include "PurityAnalysis.h"
+#include "TypedProgram.h"
+
+using namespace std;
+using namespace ::testing;
+
+namespace {
+
+// Value of `const RESULT: int = ...;`
+std::optional<int> result(Evaluator& evaluator, const Program& program) {
+  auto value = evaluator.evaluate(*cast<ConstDef>(*program.definitions.at(L"RESULT")).value);
+  if (!value.has_value()) return std::nullopt;
+  return std::get<int>(value->data);
+}
+
+}  // namespace
+
+TEST(Evaluator, BindsConstParametersToTheArguments) {
+  auto program = typed(
+      L"struct Board { cells: string; turn: int; };\n"
+      L"variant Number { int, float };\n"
+      L"const RESULT: int = main();\n"
+      L"fn turns(const board: Board, const cells: string) -> int {\n"
+      L"  return board.turn + count(board);\n"
+      L"}\n"
+      L"fn count(const board: Board) -> int { return board.turn; }\n"
+      L"fn first(const n: Number) -> int { return n as int; }\n"
+      L"fn main() -> int {\n"
+      L"  var board: Board = { cells: \"x-o\", turn: 4 };\n"
+      L"  var i: int = 3;\n"
+      L"  var n: Number = 5;\n"
+      L"  return turns(board, board.cells) + turns(board, \"abc\") + first(i) + first(n);\n"
+      L"}\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  // Both calls of turns pass board on to count, the int converted into a Number is copied
+  Evaluator evaluator{*program};
+  EXPECT_EQ(result(evaluator, *program), 8 + 8 + 3 + 5);
+  EXPECT_EQ(evaluator.referencedArguments(), 2 + 1 + 1 + 1 + 1);
+}
+
+TEST(Evaluator, CopiesArgumentsLocalFunctionsMayWrite) {
+  auto program = typed(
+      L"struct Board { cells: string; turn: int; };\n"
+      L"const RESULT: int = main();\n"
+      L"fn peek(const board: Board, n: int) -> int { return board.turn + n; }\n"
+      L"fn main() -> int {\n"
+      L"  var board: Board = { cells: \"x-o\", turn: 1 };\n"
+      L"  fn bump() -> int { board.turn = board.turn + 1; return 0; }\n"
+      L"  return peek(board, bump()) * 10 + board.turn;\n"
+      L"}\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  // The argument is the board before bump() ran
+  Evaluator evaluator{*program};
+  EXPECT_EQ(result(evaluator, *program), 12);
+  EXPECT_EQ(evaluator.referencedArguments(), 0);
+}
+
+TEST(Evaluator, MemoizesPureCalls) {
+  auto program = typed(
+      L"const RESULT: int = fib(30) + fib(30);\n"
+      L"fn main() -> int { return 0; }\n"
+      L"fn fib(n: int) -> int { if n < 2 { return n; } return fib(n - 1) + fib(n - 2); }\n");
+  ASSERT_TRUE(program != std::nullopt);
+  markPureFunctions(*program);
+
+  // Exponential without the cache
+  Evaluator plain{*program};
+  EXPECT_EQ(result(plain, *program), std::nullopt);
+  EXPECT_EQ(plain.exhaustedLimits(), 1);
+
+  // Each fib(n) runs once, its second call and the second fib(30) are hits
+  Evaluator memoized{*program, {.memoEntries = 64}};
+  EXPECT_EQ(result(memoized, *program), 2 * 832040);
+  EXPECT_EQ(memoized.memoStats().misses, 31);
+  EXPECT_EQ(memoized.memoStats().hits, 28 + 1);
+  EXPECT_EQ(memoized.memoStats().evictions, 0);
+}
+
+TEST(Evaluator, DispatchesOnVariantTags) {
+  auto program = typed(
+      L"variant Value { int, string, bool };\n"
+      L"const RESULT: int = main();\n"
+      L"const WRONG: int = wrong();\n"
+      L"fn score(v: Value) -> int {\n"
+      L"  match v {\n"
+      L"    case bool -> { return 100; }\n"
+      L"    case string -> { return 10; }\n"
+      L"    case int -> { return v as int; }\n"
+      L"  }\n"
+      L"  return 0;\n"
+      L"}\n"
+      L"fn wrong() -> int { var v: Value = 1; return int(v as bool); }\n"
+      L"fn main() -> int { return score(1) + score(\"x\") + score(true); }\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  // The jump table of a copy refers to the cases of the copy
+  auto& score = cast<FnDef>(*program->definitions.at(L"score"));
+  score.body = cloneBlock(score.body);
+
+  Evaluator evaluator{*program};
+  EXPECT_EQ(result(evaluator, *program), 111);
+  auto wrong = evaluator.evaluate(*cast<ConstDef>(*program->definitions.at(L"WRONG")).value);
+  EXPECT_EQ(wrong, std::nullopt);
+}
+
+TEST(Evaluator, StoresNestedStructsInline) {
+  auto program = typed(
+      L"struct Point { x: int; y: int; };\n"
+      L"struct Segment { a: Point; b: Point; id: int; };\n"
+      L"const RESULT: int = main();\n"
+      L"const ORIGIN: Segment = { a: { x: 0, y: 0 }, b: { x: 1, y: 1 }, id: 0 };\n"
+      L"fn length(p: Point) -> int { return p.x + p.y; }\n"
+      L"fn main() -> int {\n"
+      L"  var s: Segment = { a: { x: 1, y: 2 }, b: { x: 3, y: 4 }, id: 5 };\n"
+      L"  var before: int = s.b.y;\n"
+      L"  s.a = s.b;\n"
+      L"  s.b.x = 10;\n"
+      L"  var copy: Point = s.a;\n"
+      L"  return before * 1000 + length(s.a) * 100 + s.b.x + s.id + ORIGIN.b.y + copy.x;\n"
+      L"}\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  Evaluator evaluator{*program};
+  EXPECT_EQ(result(evaluator, *program), 4000 + 700 + 10 + 5 + 1 + 3);
+}
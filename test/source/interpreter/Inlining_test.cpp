@@ -0,0 +1,188 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <sstream>
+
+#include "Casting.h"
+#include "Evaluator.h"
+#include "Inlining.h"
+#include "RecursiveASTVisitor.h"
+#include "TypedProgram.h"
+
+using namespace std;
+using namespace ::testing;
+
+namespace {
+
+// Value of `const RESULT: int = main();`
+int result(const Program& program) {
+  Evaluator evaluator{program};
+  auto value = evaluator.evaluate(*cast<ConstDef>(*program.definitions.at(L"RESULT")).value);
+  return std::get<int>(value.value().data);
+}
+
+FnDef& fnDef(Program& program, const Identifier& name) {
+  return cast<FnDef>(*program.definitions.at(name));
+}
+
+class InlinedCallCounter : public RecursiveASTVisitor<InlinedCallCounter> {
+ public:
+  std::size_t count = 0;
+  std::size_t maxNesting = 0;
+
+  void visit(InlinedCall&) {
+    count++;
+    maxNesting = std::max(maxNesting, ++m_nesting);
+  }
+  void postVisit(InlinedCall&) { m_nesting--; }
+
+ private:
+  std::size_t m_nesting = 0;
+};
+
+InlinedCallCounter countInlinedCalls(FnDef& def) {
+  InlinedCallCounter counter;
+  counter.traverse(def.body);
+  return counter;
+}
+
+}  // namespace
+
+TEST(Inlining, InlinesSmallHelpers) {
+  auto program = typed(
+      L"const RESULT: int = main();\n"
+      L"fn main() -> int {\n"
+      L"  var total: int = 0;\n"
+      L"  for i in 0 until 10 { total = total + square(i); }\n"
+      L"  return total;\n"
+      L"}\n"
+      L"fn square(n: int) -> int { return n * n; }\n");
+  ASSERT_TRUE(program != std::nullopt);
+  auto localCount = fnDef(*program, L"main").localCount;
+
+  auto report = inlineCalls(*program);
+  ASSERT_EQ(report.calls.size(), 1);
+  EXPECT_EQ(report.calls[0].caller, L"main");
+  EXPECT_EQ(report.calls[0].callee, L"square");
+  EXPECT_EQ(report.calls[0].position.line, 3);
+
+  // The loop variable is only read by square, it is used in place of the parameter
+  EXPECT_EQ(report.calls[0].elidedCopies, 1);
+  EXPECT_EQ(report.calls[0].removedInstructions, 5);
+  EXPECT_EQ(report.removedInstructions(), 5);
+
+  EXPECT_EQ(fnDef(*program, L"main").localCount, localCount + 1);
+  EXPECT_EQ(countInlinedCalls(fnDef(*program, L"main")).count, 1);
+  EXPECT_EQ(result(*program), 285);
+}
+
+TEST(Inlining, KeepsShadowedNamesAndNestedReturnsApart) {
+  auto program = typed(
+      L"const RESULT: int = main();\n"
+      L"fn main() -> int {\n"
+      L"  var n: int = 5;\n"
+      L"  var x: int = 1;\n"
+      L"  return classify(n) * 10 + classify(x - 3) + n;\n"
+      L"}\n"
+      L"fn classify(x: int) -> int {\n"
+      L"  var n: int = x;\n"
+      L"  if x > 0 { while true { if n > 7 { return 2; } n = n + 1; } } elif x < 0 { return 0; }\n"
+      L"  return 1;\n"
+      L"}\n");
+  ASSERT_TRUE(program != std::nullopt);
+  ASSERT_EQ(result(*program), 25);
+
+  auto report = inlineCalls(*program, {.alwaysInlineSize = 100});
+  ASSERT_EQ(report.calls.size(), 2);
+  EXPECT_EQ(report.calls[0].elidedCopies, 1);
+  EXPECT_EQ(report.calls[1].elidedCopies, 0);
+
+  // The callee's n is a fresh slot, main's n keeps its value
+  EXPECT_EQ(countInlinedCalls(fnDef(*program, L"main")).count, 2);
+  EXPECT_EQ(result(*program), 25);
+}
+
+TEST(Inlining, LimitsRecursion) {
+  const auto* source =
+      L"const RESULT: int = main();\n"
+      L"fn main() -> int { return fact(5); }\n"
+      L"fn fact(n: int) -> int { if n <= 1 { return 1; } return n * fact(n - 1); }\n";
+
+  auto program = typed(source);
+  ASSERT_TRUE(program != std::nullopt);
+  inlineCalls(*program, {.alwaysInlineSize = 100, .recursionDepth = 1});
+  EXPECT_EQ(countInlinedCalls(fnDef(*program, L"main")).maxNesting, 2);
+  EXPECT_EQ(countInlinedCalls(fnDef(*program, L"fact")).maxNesting, 1);
+  EXPECT_EQ(result(*program), 120);
+
+  program = typed(source);
+  ASSERT_TRUE(program != std::nullopt);
+  inlineCalls(*program, {.alwaysInlineSize = 100, .recursionDepth = 0});
+  EXPECT_EQ(countInlinedCalls(fnDef(*program, L"main")).maxNesting, 1);
+  EXPECT_EQ(countInlinedCalls(fnDef(*program, L"fact")).count, 0);
+  EXPECT_EQ(result(*program), 120);
+}
+
+TEST(Inlining, WeighsSizeAgainstFrequency) {
+  const auto* source =
+      L"const RESULT: int = main();\n"
+      L"fn main() -> int {\n"
+      L"  var total: int = poly(1);\n"
+      L"  var i: int = 0;\n"
+      L"  while i < 3 { total = total + poly(i); i = i + 1; }\n"
+      L"  return total;\n"
+      L"}\n"
+      L"fn poly(n: int) -> int { return n * n * n + 2 * n * n + 3 * n + 4; }\n";
+  InliningOptions options{.alwaysInlineSize = 0, .maxInlineSize = 100, .loopWeight = 8};
+
+  // Only the call in the loop pays for the 19 nodes of poly
+  auto program = typed(source);
+  ASSERT_TRUE(program != std::nullopt);
+  auto report = inlineCalls(*program, options);
+  ASSERT_EQ(report.calls.size(), 1);
+  EXPECT_EQ(report.calls[0].position.line, 4);
+  EXPECT_EQ(report.calls[0].addedNodes, 19);
+  EXPECT_EQ(result(*program), 10 + 4 + 10 + 26);
+
+  // Growth budget exhausted
+  program = typed(source);
+  ASSERT_TRUE(program != std::nullopt);
+  options.maxGrowth = 10;
+  EXPECT_TRUE(inlineCalls(*program, options).calls.empty());
+}
+
+TEST(Inlining, CopiesArgumentsTheCalleeWrites) {
+  auto program = typed(
+      L"struct Point { x: int; y: int; };\n"
+      L"const RESULT: int = main();\n"
+      L"fn main() -> int {\n"
+      L"  var p: Point = { x: 1, y: 2 };\n"
+      L"  return moved(p) + sum(p) + p.x;\n"
+      L"}\n"
+      L"fn moved(p: Point) -> int { p.x = 10; return p.x; }\n"
+      L"fn sum(p: Point) -> int { return p.x + p.y; }\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  auto report = inlineCalls(*program);
+  ASSERT_EQ(report.calls.size(), 2);
+  EXPECT_EQ(report.calls[0].callee, L"moved");
+  EXPECT_EQ(report.calls[0].elidedCopies, 0);
+  EXPECT_EQ(report.calls[1].elidedCopies, 1);
+  EXPECT_EQ(report.calls[1].removedInstructions, 4 + 2);
+  EXPECT_EQ(result(*program), 10 + 3 + 1);
+}
+
+TEST(Inlining, PrintsTheReport) {
+  auto program = typed(
+      L"fn main() -> int { var n: int = 2; return twice(n); }\n"
+      L"fn twice(n: int) -> int { return 2 * n; }\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  std::ostringstream out;
+  printInliningReport(out, inlineCalls(*program));
+  EXPECT_EQ(out.str(),
+            "Inlining\n"
+            "  twice into main (line 0 col 47): 5 instructions removed, 1 copies elided, "
+            "5 nodes added\n"
+            "  total: 1 calls, 5 instructions removed\n");
+}
@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include "Casting.h"
+#include "Evaluator.h"
+#include "LastUseAnalysis.h"
+#include "RecursiveASTVisitor.h"
+#include "TypedProgram.h"
+
+using namespace std;
+using namespace ::testing;
+
+namespace {
+
+// Names of the locals marked as their last use, in the order they appear in the source
+class LastUses : public RecursiveASTVisitor<LastUses> {
+ public:
+  std::vector<std::wstring> names;
+
+  void visit(IdentifierExpr& expr) {
+    if (expr.isLastUse) names.push_back(expr.name);
+  }
+};
+
+std::vector<std::wstring> lastUses(Program& program, const Identifier& function) {
+  LastUses visitor;
+  visitor.traverse(cast<FnDef>(*program.definitions.at(function)).body);
+  return visitor.names;
+}
+
+}  // namespace
+
+TEST(LastUseAnalysis, MovesArgumentsReturnsAndAssignments) {
+  auto program = typed(
+      L"struct Board { cells: string; turn: int; };\n"
+      L"const RESULT: int = main();\n"
+      L"fn play(b: Board) -> Board { b.turn = b.turn + 1; return b; }\n"
+      L"fn main() -> int {\n"
+      L"  var board: Board = { cells: \"---\", turn: 0 };\n"
+      L"  board = play(board);\n"
+      L"  var saved: Board = board;\n"
+      L"  board = play(board);\n"
+      L"  var other: Board = saved;\n"
+      L"  return board.turn * 10 + other.turn;\n"
+      L"}\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  auto report = markLastUses(*program);
+  EXPECT_EQ(report.arguments, 2);
+  EXPECT_EQ(report.returns, 1);
+  EXPECT_EQ(report.assignments, 1);
+  EXPECT_EQ(report.avoidedCopies(), 4);
+  EXPECT_EQ(lastUses(*program, L"main"),
+            (std::vector<std::wstring>{L"board", L"board", L"saved"}));
+
+  // Both calls move their result out, the values the program sees are unchanged
+  Evaluator evaluator{*program};
+  auto value = evaluator.evaluate(*cast<ConstDef>(*program->definitions.at(L"RESULT")).value);
+  ASSERT_TRUE(value.has_value());
+  EXPECT_EQ(std::get<int>(value->data), 21);
+  EXPECT_EQ(evaluator.movedValues(), 5);
+}
+
+TEST(LastUseAnalysis, KeepsLocalsLiveAcrossLoopsAndBranches) {
+  auto program = typed(
+      L"const RESULT: int = main();\n"
+      L"fn length(s: string) -> int { return 1; }\n"
+      L"fn main() -> int {\n"
+      L"  var s: string = \"abc\";\n"
+      L"  var total: int = 0;\n"
+      L"  while true {\n"
+      L"    if total > 2 { break; }\n"
+      L"    total = total + length(s);\n"
+      L"  }\n"
+      L"  for i in 0 until 2 { total = total + length(s); }\n"
+      L"  var t: string = s;\n"
+      L"  if total > 10 { return length(t); } elif total > 4 { s = t; }\n"
+      L"  return total + length(t) + length(s);\n"
+      L"}\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  // Neither s nor t is moved where the other branch or the loops still read it
+  auto report = markLastUses(*program);
+  EXPECT_EQ(lastUses(*program, L"main"), (std::vector<std::wstring>{L"t", L"t", L"s"}));
+  EXPECT_EQ(report.arguments, 3);
+  EXPECT_EQ(report.assignments, 0);
+
+  Evaluator evaluator{*program};
+  auto value = evaluator.evaluate(*cast<ConstDef>(*program->definitions.at(L"RESULT")).value);
+  ASSERT_TRUE(value.has_value());
+  EXPECT_EQ(std::get<int>(value->data), 7);
+  EXPECT_EQ(evaluator.movedValues(), 2);
+}
+
+TEST(LastUseAnalysis, LeavesFunctionsDefiningFunctionsAlone) {
+  auto program = typed(
+      L"fn main() -> string {\n"
+      L"  var s: string = \"abc\";\n"
+      L"  fn read() -> string { return s; }\n"
+      L"  var t: string = s;\n"
+      L"  return read();\n"
+      L"}\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  EXPECT_EQ(markLastUses(*program).avoidedCopies(), 0);
+  EXPECT_TRUE(lastUses(*program, L"main").empty());
+}
+
+TEST(LastUseAnalysis, KeepsArgumentsBoundToConstParametersUntilTheCall) {
+  auto program = typed(
+      L"const RESULT: string = main();\n"
+      L"fn f(const a: string, b: string) -> string { return a + b; }\n"
+      L"fn main() -> string {\n"
+      L"  var s: string = \"ab\";\n"
+      L"  return f(s, s);\n"
+      L"}\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  // The second argument may not move out the value the first one is bound to
+  markLastUses(*program);
+  EXPECT_TRUE(lastUses(*program, L"main").empty());
+
+  Evaluator evaluator{*program};
+  auto value = evaluator.evaluate(*cast<ConstDef>(*program->definitions.at(L"RESULT")).value);
+  ASSERT_TRUE(value.has_value());
+  EXPECT_EQ(std::get<std::wstring>(value->data), L"abab");
+}
+
+TEST(LastUseAnalysis, PrintsTheReport) {
+  auto program = typed(
+      L"fn main() -> int { return 0; }\n"
+      L"fn id(s: string) -> string { return s; }\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  std::ostringstream out;
+  printLastUseReport(out, markLastUses(*program));
+  EXPECT_EQ(out.str(),
+            "Last uses\n"
+            "  0 arguments, 1 returns, 0 assignments moved\n"
+            "  total: 1 copies avoided\n");
+}
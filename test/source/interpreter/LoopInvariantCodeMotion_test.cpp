@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include "Casting.h"
+#include "Evaluator.h"
+#include "LoopInvariantCodeMotion.h"
+#include "PurityAnalysis.h"
+#include "TypedProgram.h"
+
+using namespace std;
+using namespace ::testing;
+
+namespace {
+
+// Typed, with the pure functions marked as the pass expects
+std::optional<Program> pure(const std::wstring& source) {
+  auto program = typed(source);
+  if (program.has_value()) markPureFunctions(*program);
+  return program;
+}
+
+const BlockStmt& body(const Program& program, const Identifier& function) {
+  return cast<FnDef>(*program.definitions.at(function)).body;
+}
+
+}  // namespace
+
+TEST(LoopInvariantCodeMotion, HoistsInvariantsIntoGuardedPreheaders) {
+  auto program = pure(
+      L"const RESULT: int = main();\n"
+      L"fn square(x: int) -> int { return x * x; }\n"
+      L"fn main() -> int {\n"
+      L"  var n: int = 10;\n"
+      L"  var k: int = 3;\n"
+      L"  var total: int = 0;\n"
+      L"  for i in 0 until n { total = total + square(k) + i; }\n"
+      L"  var j: int = 0;\n"
+      L"  while j < n * 2 { j = j + (k - 1); }\n"
+      L"  return total + j;\n"
+      L"}\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  auto report = hoistLoopInvariants(*program);
+  EXPECT_EQ(report.loops, 2);
+  EXPECT_EQ(report.expressions, 3);
+
+  // Each loop is the last statement of the block run only if it is entered
+  const auto& statements = body(*program, L"main").statements;
+  for (auto index : {3, 5}) {
+    auto ifStmt = dyn_cast<IfStmt>(statements[index].get());
+    ASSERT_NE(ifStmt, nullptr);
+    ASSERT_FALSE(ifStmt->block.statements.empty());
+    EXPECT_TRUE(isa<VarDef>(*ifStmt->block.statements.front()));
+    auto loop = ifStmt->block.statements.back().get();
+    EXPECT_TRUE(isa<ForStmt>(*loop) || isa<WhileStmt>(*loop));
+  }
+
+  Evaluator evaluator{*program};
+  auto value = evaluator.evaluate(*cast<ConstDef>(*program->definitions.at(L"RESULT")).value);
+  ASSERT_TRUE(value.has_value());
+  EXPECT_EQ(std::get<int>(value->data), 10 * 9 + 45 + 20);
+}
+
+TEST(LoopInvariantCodeMotion, TreatsWritesOfMembersAndCalleesAsWritesOfTheVariable) {
+  auto program = pure(
+      L"struct Point { x: int; y: int; };\n"
+      L"var scale: int = 2;\n"
+      L"fn bump() -> int { scale = scale + 1; return scale; }\n"
+      L"fn indirect() -> int { return bump(); }\n"
+      L"fn members() -> int {\n"
+      L"  var p: Point = { x: 1, y: 2 };\n"
+      L"  for i in 0 until 3 { p.y = p.x * 2; p.x = p.y + 1; }\n"
+      L"  return p.x;\n"
+      L"}\n"
+      L"fn callees() -> int {\n"
+      L"  var t: int = 0;\n"
+      L"  for i in 0 until 3 { t = t + scale * 2; indirect(); }\n"
+      L"  return t;\n"
+      L"}\n"
+      L"fn reads() -> int {\n"
+      L"  var t: int = 0;\n"
+      L"  for i in 0 until 3 { t = t + scale * 2; }\n"
+      L"  return t;\n"
+      L"}\n"
+      L"fn main() -> int { return members() + callees() + reads(); }\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  auto report = hoistLoopInvariants(*program);
+  EXPECT_EQ(report.loops, 1);
+  EXPECT_EQ(report.expressions, 1);
+  EXPECT_TRUE(isa<ForStmt>(*body(*program, L"members").statements[1]));
+  EXPECT_TRUE(isa<ForStmt>(*body(*program, L"callees").statements[1]));
+  EXPECT_TRUE(isa<IfStmt>(*body(*program, L"reads").statements[1]));
+}
+
+TEST(LoopInvariantCodeMotion, LeavesConditionalCodeAndUnknownCallsAlone) {
+  auto program = pure(
+      L"fn conditional(k: int) -> int {\n"
+      L"  var t: int = 0;\n"
+      L"  for i in 0 until 3 { if i > 1 { t = t + k * 2; } t = t + k * 3; }\n"
+      L"  return t;\n"
+      L"}\n"
+      L"fn unknown(k: int) -> int {\n"
+      L"  var t: int = 0;\n"
+      L"  fn add(x: int) -> int { t = t + x; return t; }\n"
+      L"  for i in 0 until 3 { t = k * 2 + add(i); }\n"
+      L"  return t;\n"
+      L"}\n"
+      L"fn main() -> int { return conditional(1) + unknown(1); }\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  auto report = hoistLoopInvariants(*program);
+  EXPECT_EQ(report.loops, 0);
+  EXPECT_EQ(report.expressions, 0);
+}
+
+TEST(LoopInvariantCodeMotion, StopsAtTheFirstStatementWithSideEffects) {
+  auto program = pure(
+      L"fn after(n: int, d: int) -> int {\n"
+      L"  var t: int = 0;\n"
+      L"  for i in 0 until 3 { << \"a\"; t = t + n / d; }\n"
+      L"  return t;\n"
+      L"}\n"
+      L"fn before(n: int, d: int) -> int {\n"
+      L"  var t: int = 0;\n"
+      L"  for i in 0 until 3 { t = t + n * d; << \"a\"; t = t + n / d; }\n"
+      L"  return t;\n"
+      L"}\n"
+      L"fn main() -> int { return after(1, 0) + before(1, 0); }\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  // The division by zero must not run ahead of the first output
+  auto report = hoistLoopInvariants(*program);
+  EXPECT_EQ(report.loops, 1);
+  EXPECT_EQ(report.expressions, 1);
+  EXPECT_TRUE(isa<ForStmt>(*body(*program, L"after").statements[1]));
+  EXPECT_TRUE(isa<IfStmt>(*body(*program, L"before").statements[1]));
+}
+
+TEST(LoopInvariantCodeMotion, PrintsTheReport) {
+  std::ostringstream out;
+  printLoopInvariantReport(out, LoopInvariantReport{2, 5});
+  EXPECT_EQ(out.str(), "Loop invariants\n  5 expressions hoisted out of 2 loops\n");
+}
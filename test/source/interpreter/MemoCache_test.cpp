@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+
+#include "MemoCache.h"
+
+using namespace std;
+using namespace ::testing;
+
+namespace {
+
+FnDef fnDef(const Identifier& name) {
+  return FnDef{Position{}, Identifier{name}, {}, TypeIdentifier{L"int"}, BlockStmt{Position{}, {}}};
+}
+
+}  // namespace
+
+TEST(MemoCache, EvictsTheLeastRecentlyUsedResult) {
+  auto square = fnDef(L"square");
+  auto half = fnDef(L"half");
+  MemoCache cache{2};
+
+  EXPECT_EQ(cache.find(square, {2}), nullptr);
+  cache.insert(square, {2}, Value{4});
+  cache.insert(half, {2}, Value{1});
+
+  // A different function or different arguments are different calls
+  ASSERT_NE(cache.find(square, {2}), nullptr);
+  EXPECT_EQ(std::get<int>(cache.find(square, {2})->data), 4);
+  EXPECT_EQ(cache.find(square, {3}), nullptr);
+
+  // half is used least recently
+  cache.insert(square, {3}, Value{9});
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_EQ(cache.find(half, {2}), nullptr);
+  EXPECT_NE(cache.find(square, {3}), nullptr);
+
+  const auto& stats = cache.stats();
+  EXPECT_EQ(stats.hits, 3);
+  EXPECT_EQ(stats.misses, 3);
+  EXPECT_EQ(stats.evictions, 1);
+  EXPECT_DOUBLE_EQ(stats.hitRate(), 0.5);
+}
+
+TEST(MemoCache, KeysByEveryArgument) {
+  auto concat = fnDef(L"concat");
+  MemoCache cache{8};
+  cache.insert(concat, {std::wstring{L"ab"}, L'c'}, Value{std::wstring{L"abc"}});
+
+  EXPECT_NE(cache.find(concat, {std::wstring{L"ab"}, L'c'}), nullptr);
+  EXPECT_EQ(cache.find(concat, {std::wstring{L"ab"}, L'd'}), nullptr);
+  EXPECT_EQ(cache.find(concat, {std::wstring{L"ab"}}), nullptr);
+  EXPECT_EQ(cache.find(concat, {L'c', std::wstring{L"ab"}}), nullptr);
+}
@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+
+#include "Casting.h"
+#include "PurityAnalysis.h"
+#include "TypedProgram.h"
+
+using namespace std;
+using namespace ::testing;
+
+namespace {
+
+bool isPure(Program& program, const Identifier& name) {
+  return cast<FnDef>(*program.definitions.at(name)).isPure;
+}
+
+}  // namespace
+
+TEST(PurityAnalysis, MarksFunctionsWithoutEffects) {
+  auto program = typed(
+      L"const LIMIT: int = 10;\n"
+      L"var counter: int = 0;\n"
+      L"fn main() -> int { return 0; }\n"
+      L"fn fib(n: int) -> int { if n < 2 { return n; } return fib(n - 1) + fib(n - 2); }\n"
+      L"fn capped(n: int) -> int { if n > LIMIT { return LIMIT; } return fib(n); }\n"
+      L"fn print(n: int) -> int { << n; return n; }\n"
+      L"fn count() -> int { counter = counter + 1; return 0; }\n"
+      L"fn peek() -> int { return counter; }\n"
+      L"fn printed(n: int) -> int { return print(fib(n)); }\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  auto report = markPureFunctions(*program);
+  EXPECT_EQ(report.functions, 7);
+  EXPECT_EQ(report.pure, 3);
+  EXPECT_TRUE(isPure(*program, L"main"));
+  EXPECT_TRUE(isPure(*program, L"fib"));
+  EXPECT_TRUE(isPure(*program, L"capped"));
+  EXPECT_FALSE(isPure(*program, L"print"));
+  EXPECT_FALSE(isPure(*program, L"count"));
+  EXPECT_FALSE(isPure(*program, L"peek"));
+  EXPECT_FALSE(isPure(*program, L"printed"));
+}
+
+TEST(PurityAnalysis, SpreadsImpurityThroughRecursionAndLocalFunctions) {
+  auto program = typed(
+      L"fn main() -> int { return 0; }\n"
+      L"fn isEven(n: int) -> bool { if n == 0 { return true; } return isOdd(n - 1); }\n"
+      L"fn isOdd(n: int) -> bool { if n == 0 { return false; } return isEven(n - 1); }\n"
+      L"fn ping(n: int) -> int { if n == 0 { << 0; return 0; } return pong(n - 1); }\n"
+      L"fn pong(n: int) -> int { return ping(n); }\n"
+      L"fn outer(n: int) -> int {\n"
+      L"  fn inner(m: int) -> int { var k: int = m; return k * 2; }\n"
+      L"  return n;\n"
+      L"}\n"
+      L"fn closure(n: int) -> int {\n"
+      L"  fn inner() -> int { return n; }\n"
+      L"  return inner();\n"
+      L"}\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  markPureFunctions(*program);
+  EXPECT_TRUE(isPure(*program, L"isEven"));
+  EXPECT_TRUE(isPure(*program, L"isOdd"));
+  EXPECT_FALSE(isPure(*program, L"ping"));
+  EXPECT_FALSE(isPure(*program, L"pong"));
+
+  // Locals of the function itself may be read by the functions it defines, not called through them
+  EXPECT_TRUE(isPure(*program, L"outer"));
+  EXPECT_FALSE(isPure(*program, L"closure"));
+}
@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+
+#include "Casting.h"
+#include "Lexer.h"
+#include "Parser.h"
+#include "ScopeChecker.h"
+#include "StringCharReader.h"
+#include "mocks/ErrorHandlerMock.h"
+
+using namespace std;
+using namespace ::testing;
+
+namespace {
+
+void check(const std::wstring& source, ErrorHandler& checkerErrorHandler) {
+  ErrorHandler errorHandler;
+  StringCharReader reader{source};
+  Lexer lexer{reader, errorHandler};
+  Parser parser{lexer, errorHandler};
+  auto program = parser.parseProgram();
+  ASSERT_TRUE(program != std::nullopt);
+
+  ScopeChecker checker{checkerErrorHandler};
+  checker.check(*program);
+}
+
+}  // namespace
+
+TEST(ScopeChecker, AcceptsWellScopedProgram) {
+  ErrorHandlerMock errorHandler;
+  EXPECT_CALL(errorHandler, handleError(_, _)).Times(0);
+
+  check(
+      L"struct Point { x: int; y: int; };\n"
+      L"fn main() -> int { return fib(LIMIT) + origin.x; }\n"
+      L"fn fib(n: int) -> int {\n"
+      L"  if n < 2 { return n; }\n"
+      L"  var sum: int = 0;\n"
+      L"  for i in 0 until n { sum = sum + i; var n: int = i; }\n"
+      L"  { var sum: int = n; << sum; }\n"
+      L"  return fib(n - 1) + fib(n - 2);\n"
+      L"}\n"
+      L"const LIMIT: int = 10;\n"
+      L"var origin: Point = { x: LIMIT, y: 0 };\n",
+      errorHandler);
+}
+
+TEST(ScopeChecker, ReportsUndefinedIdentifiers) {
+  ErrorHandlerMock errorHandler;
+  EXPECT_CALL(errorHandler, handleError(ErrorType::UNDEFINED_IDENTIFIER, _)).Times(5);
+
+  check(
+      L"fn main() -> int {\n"
+      L"  var a: int = a;\n"
+      L"  for i in i until 10 {}\n"
+      L"  if true { var b: int = 1; }\n"
+      L"  << b << i << missing(1);\n"
+      L"  return 0;\n"
+      L"}\n",
+      errorHandler);
+}
+
+TEST(ScopeChecker, ReportsRedefinitionInSameScope) {
+  ErrorHandlerMock errorHandler;
+  EXPECT_CALL(errorHandler, handleError(ErrorType::REDEFINITION, _)).Times(2);
+
+  check(
+      L"fn main() -> int {\n"
+      L"  var a: int = 1;\n"
+      L"  const a: int = 2;\n"
+      L"  fn main() -> int { return 0; }\n"
+      L"  fn main() -> int { return 0; }\n"
+      L"  return a;\n"
+      L"}\n",
+      errorHandler);
+}
+
+/* ------------------------------- Resolution ------------------------------- */
+
+namespace {
+
+std::optional<Program> resolve(const std::wstring& source) {
+  ErrorHandler errorHandler;
+  StringCharReader reader{source};
+  Lexer lexer{reader, errorHandler};
+  Parser parser{lexer, errorHandler};
+  auto program = parser.parseProgram();
+  if (program.has_value()) ScopeChecker{errorHandler}.check(*program);
+  return errorHandler.hasErrors() ? std::nullopt : std::move(program);
+}
+
+BlockStmt& body(Program& program, const Identifier& fn) {
+  return cast<FnDef>(*program.definitions.at(fn)).body;
+}
+
+Storage storageOf(Statement& stmt) {
+  if (auto returnStmt = dyn_cast<ReturnStmt>(&stmt)) {
+    return cast<IdentifierExpr>(*returnStmt->expr).storage;
+  }
+  return cast<IdentifierExpr>(*cast<AssignmentStmt>(stmt).lhs).storage;
+}
+
+Storage local(std::uint16_t depth, std::uint32_t slot) {
+  return {Storage::Kind::Local, depth, slot};
+}
+
+}  // namespace
+
+TEST(ScopeChecker, NumbersGlobalsInDefinitionOrder) {
+  auto program = resolve(
+      L"const A: int = 1;\n"
+      L"fn main() -> int { return B; }\n"
+      L"var B: int = A;\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  EXPECT_EQ(program->globalCount, 3);
+  EXPECT_EQ(program->definitions.at(L"A")->storage, (Storage{Storage::Kind::Global, 0, 0}));
+  EXPECT_EQ(program->definitions.at(L"main")->storage, (Storage{Storage::Kind::Global, 0, 1}));
+
+  auto& b = cast<VarDef>(*program->definitions.at(L"B"));
+  EXPECT_EQ(b.storage, (Storage{Storage::Kind::Global, 0, 2}));
+  EXPECT_EQ(cast<IdentifierExpr>(*b.value).storage, (Storage{Storage::Kind::Global, 0, 0}));
+  EXPECT_EQ(storageOf(*body(*program, L"main").statements[0]), b.storage);
+}
+
+TEST(ScopeChecker, AssignsFrameSlotsToLocals) {
+  auto program = resolve(
+      L"fn main() -> int { return 0; }\n"
+      L"fn f(a: int, b: int) -> int {\n"
+      L"  var c: int = 0;\n"
+      L"  { var d: int = 0; var e: int = 0; e = a; }\n"
+      L"  { var g: int = 0; g = c; }\n"
+      L"  for i in 0 until b { i = b; }\n"
+      L"  return c;\n"
+      L"}\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  auto& f = cast<FnDef>(*program->definitions.at(L"f"));
+  EXPECT_EQ(f.parameters.at(L"a").storage, local(0, 0));
+  EXPECT_EQ(f.parameters.at(L"b").storage, local(0, 1));
+  // a, b, c, d and e, the later blocks and the loop reuse the slots of d and e
+  EXPECT_EQ(f.localCount, 5);
+
+  auto& statements = f.body.statements;
+  EXPECT_EQ(cast<VarDef>(*statements[0]).storage, local(0, 2));
+
+  auto& first = cast<BlockStmt>(*statements[1]).statements;
+  EXPECT_EQ(cast<VarDef>(*first[1]).storage, local(0, 4));
+  EXPECT_EQ(storageOf(*first[2]), local(0, 4));
+  EXPECT_EQ(cast<IdentifierExpr>(*cast<AssignmentStmt>(*first[2]).rhs).storage, local(0, 0));
+
+  auto& second = cast<BlockStmt>(*statements[2]).statements;
+  EXPECT_EQ(cast<VarDef>(*second[0]).storage, local(0, 3));
+  EXPECT_EQ(storageOf(*second[1]), local(0, 3));
+
+  auto& loop = cast<ForStmt>(*statements[3]);
+  EXPECT_EQ(loop.storage, local(0, 3));
+  EXPECT_EQ(storageOf(*loop.block.statements[0]), local(0, 3));
+
+  EXPECT_EQ(storageOf(*statements[4]), local(0, 2));
+}
+
+TEST(ScopeChecker, CountsFramesToEnclosingFunctions) {
+  auto program = resolve(
+      L"fn main() -> int {\n"
+      L"  var a: int = 0;\n"
+      L"  fn inner(b: int) -> int { a = b; return a; }\n"
+      L"  return inner(a);\n"
+      L"}\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  auto& statements = body(*program, L"main").statements;
+  auto& inner = cast<FnDef>(*statements[1]);
+  EXPECT_EQ(inner.storage, local(0, 1));
+  EXPECT_EQ(inner.localCount, 1);
+  EXPECT_EQ(cast<FnDef>(*program->definitions.at(L"main")).localCount, 2);
+
+  EXPECT_EQ(storageOf(*inner.body.statements[0]), local(1, 0));
+  EXPECT_EQ(cast<IdentifierExpr>(*cast<AssignmentStmt>(*inner.body.statements[0]).rhs).storage,
+            local(0, 0));
+  EXPECT_EQ(storageOf(*inner.body.statements[1]), local(1, 0));
+}
@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "ScopedTable.h"
+
+using namespace std;
+
+TEST(ScopedTable, FindsInnermostBinding) {
+  ScopedTable<int> table;
+  table.enterScope();
+  EXPECT_TRUE(table.insert(L"a", 1).second);
+  EXPECT_TRUE(table.insert(L"b", 2).second);
+
+  table.enterScope();
+  EXPECT_TRUE(table.insert(L"a", 3).second);
+  EXPECT_EQ(*table.find(L"a"), 3);
+  EXPECT_EQ(*table.find(L"b"), 2);
+  EXPECT_EQ(table.find(L"c"), nullptr);
+  EXPECT_EQ(table.depth(), 2);
+
+  table.exitScope();
+  EXPECT_EQ(*table.find(L"a"), 1);
+  EXPECT_EQ(table.depth(), 1);
+}
+
+TEST(ScopedTable, RejectsRedefinitionInSameScope) {
+  ScopedTable<int> table;
+  table.enterScope();
+  table.insert(L"a", 1);
+
+  auto [value, inserted] = table.insert(L"a", 2);
+  EXPECT_FALSE(inserted);
+  EXPECT_EQ(*value, 1);
+}
+
+TEST(ScopedTable, ForgetsBindingsOfExitedScopes) {
+  ScopedTable<int> table;
+  table.enterScope();
+  table.enterScope();
+  table.insert(L"a", 1);
+  table.exitScope();
+
+  EXPECT_FALSE(table.contains(L"a"));
+  EXPECT_TRUE(table.insert(L"a", 2).second);
+  EXPECT_EQ(*table.find(L"a"), 2);
+}
+
+TEST(ScopedTable, KeepsBindingsWhenGrowing) {
+  ScopedTable<int> table;
+  const int levels = 50;
+  const int perLevel = 20;
+
+  for (int level = 0; level < levels; level++) {
+    table.enterScope();
+    for (int i = 0; i < perLevel; i++) {
+      table.insert(L"v" + to_wstring(i), level * perLevel + i);
+      table.insert(L"l" + to_wstring(level) + L"_" + to_wstring(i), int{level});
+    }
+  }
+  EXPECT_EQ(*table.find(L"v7"), (levels - 1) * perLevel + 7);
+  EXPECT_EQ(*table.find(L"l3_5"), 3);
+
+  for (int level = levels - 1; level > 0; level--) table.exitScope();
+  EXPECT_EQ(*table.find(L"v7"), 7);
+  EXPECT_FALSE(table.contains(L"l3_5"));
+  EXPECT_TRUE(table.contains(L"l0_19"));
+}
+
+TEST(ScopedTable, ThrowsWithoutScope) {
+  ScopedTable<int> table;
+  EXPECT_THROW(table.insert(L"a", 1), std::logic_error);
+  EXPECT_THROW(table.exitScope(), std::logic_error);
+
+  table.enterScope();
+  EXPECT_NO_THROW(table.exitScope());
+}
@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include "Casting.h"
+#include "Evaluator.h"
+#include "SwitchLowering.h"
+#include "TypedProgram.h"
+
+using namespace std;
+using namespace ::testing;
+
+namespace {
+
+IfStmt& firstIf(Program& program, const Identifier& function) {
+  for (auto& stmt : cast<FnDef>(*program.definitions.at(function)).body.statements) {
+    if (auto ifStmt = dyn_cast<IfStmt>(stmt.get())) return *ifStmt;
+  }
+  throw std::logic_error("No if statement");
+}
+
+std::optional<int> evaluate(Program& program, const Identifier& constant) {
+  Evaluator evaluator{program};
+  auto value = evaluator.evaluate(*cast<ConstDef>(*program.definitions.at(constant)).value);
+  if (!value.has_value()) return std::nullopt;
+  return std::get<int>(value->data);
+}
+
+}  // namespace
+
+TEST(SwitchLowering, LowersDenseChainsToJumpTables) {
+  auto program = typed(
+      L"const RESULT: int = pick(2) * 1000 + pick(4) * 100 + pick(5) * 10 + pick(9);\n"
+      L"fn pick(move: int) -> int {\n"
+      L"  var field: int = 0;\n"
+      L"  if move == 1 { field = 1; }\n"
+      L"  elif 2 == move { field = 2; }\n"
+      L"  elif (move == 3) { field = 3; }\n"
+      L"  elif move == 5 { field = 5; }\n"
+      L"  elif move == 6 { return 6; }\n"
+      L"  else { field = 9; }\n"
+      L"  return field;\n"
+      L"}\n"
+      L"fn main() -> int { return pick(1); }\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  auto report = lowerSwitches(*program);
+  EXPECT_EQ(report.jumpTables, 1);
+  EXPECT_EQ(report.binarySearches, 0);
+
+  // Branches of 1 to 6, 4 has none; every condition is now `move == constant`
+  auto& ifStmt = firstIf(*program, L"pick");
+  ASSERT_NE(ifStmt.switchTable, nullptr);
+  EXPECT_EQ(ifStmt.switchTable->min, 1);
+  EXPECT_EQ(ifStmt.switchTable->dense, (std::vector<std::uint32_t>{1, 2, 3, 0, 4, 5}));
+  for (auto& elif : ifStmt.elifs) {
+    auto& comparison = cast<BinaryExpression>(*elif.condition);
+    EXPECT_TRUE(isa<IdentifierExpr>(*comparison.lhs));
+    EXPECT_EQ(comparison.typeId, BOOL_TYPE);
+  }
+
+  EXPECT_EQ(evaluate(*program, L"RESULT"), 2000 + 900 + 50 + 9);
+}
+
+TEST(SwitchLowering, SearchesSparseChains) {
+  auto program = typed(
+      L"struct Key { code: char; };\n"
+      L"const RESULT: int = score('a') * 100 + score('m') * 10 + score('q');\n"
+      L"fn score(c: char) -> int {\n"
+      L"  var key: Key = { code: c };\n"
+      L"  if key.code == 'z' { return 3; }\n"
+      L"  elif key.code == 'a' { return 1; }\n"
+      L"  elif key.code == 'm' { return 2; }\n"
+      L"  return 0;\n"
+      L"}\n"
+      L"fn main() -> int { return 0; }\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  auto report = lowerSwitches(*program);
+  EXPECT_EQ(report.jumpTables, 0);
+  EXPECT_EQ(report.binarySearches, 1);
+
+  auto& table = *firstIf(*program, L"score").switchTable;
+  EXPECT_TRUE(table.dense.empty());
+  EXPECT_EQ(table.sparse, (std::vector<std::pair<int, std::uint32_t>>{
+                              {L'a', 2}, {L'm', 3}, {L'z', 1}}));
+
+  EXPECT_EQ(evaluate(*program, L"RESULT"), 100 + 20);
+}
+
+TEST(SwitchLowering, LeavesOtherChainsAlone) {
+  auto program = typed(
+      L"fn id(x: int) -> int { return x; }\n"
+      L"fn main() -> int {\n"
+      L"  var a: int = 1;\n"
+      L"  var b: int = 2;\n"
+      L"  if a == 1 { << 1; } elif b == 2 { << 2; } elif a == 3 { << 3; }\n"
+      L"  if a == 1 { << 1; } elif a == 2 { << 2; } elif a == 1 { << 3; }\n"
+      L"  if id(a) == 1 { << 1; } elif id(a) == 2 { << 2; } elif id(a) == 3 { << 3; }\n"
+      L"  if a == 1 { << 1; } elif a < 2 { << 2; } elif a == 3 { << 3; }\n"
+      L"  if a == 1 { << 1; } elif a == 2 { << 2; } else { << 3; }\n"
+      L"  return a;\n"
+      L"}\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  auto report = lowerSwitches(*program);
+  EXPECT_EQ(report.jumpTables, 0);
+  EXPECT_EQ(report.binarySearches, 0);
+}
+
+TEST(SwitchLowering, PrintsTheReport) {
+  std::ostringstream out;
+  printSwitchReport(out, SwitchReport{2, 1});
+  EXPECT_EQ(out.str(), "Switches\n  2 jump tables, 1 binary searches\n");
+}
@@ -0,0 +1,258 @@
+#include <gtest/gtest.h>
+
+#include "Casting.h"
+#include "Lexer.h"
+#include "Parser.h"
+#include "StringCharReader.h"
+#include "TypeChecker.h"
+#include "mocks/ErrorHandlerMock.h"
+
+using namespace std;
+using namespace ::testing;
+
+namespace {
+
+std::optional<Program> parse(const std::wstring& source) {
+  ErrorHandler errorHandler;
+  StringCharReader reader{source};
+  Lexer lexer{reader, errorHandler};
+  Parser parser{lexer, errorHandler};
+  return parser.parseProgram();
+}
+
+void check(const std::wstring& source, ErrorHandler& checkerErrorHandler) {
+  auto program = parse(source);
+  ASSERT_TRUE(program != std::nullopt);
+  TypeChecker{checkerErrorHandler}.check(*program);
+}
+
+std::optional<Program> typed(const std::wstring& source) {
+  auto program = parse(source);
+  if (!program.has_value()) return std::nullopt;
+
+  ErrorHandler errorHandler;
+  TypeChecker{errorHandler}.check(*program);
+  return errorHandler.hasErrors() ? std::nullopt : std::move(program);
+}
+
+BlockStmt& body(Program& program, const Identifier& fn) {
+  return cast<FnDef>(*program.definitions.at(fn)).body;
+}
+
+}  // namespace
+
+TEST(TypeChecker, AcceptsWellTypedProgram) {
+  ErrorHandlerMock errorHandler;
+  EXPECT_CALL(errorHandler, handleError(_, _)).Times(0);
+
+  check(
+      L"struct Point { x: int; y: float; };\n"
+      L"variant Number { int, float };\n"
+      L"fn main() -> int {\n"
+      L"  var p: Point = { y: 1.5, x: LIMIT };\n"
+      L"  var n: Number = p.y;\n"
+      L"  match n { case int -> { << n as int; } case float -> { p.y = n as float; } }\n"
+      L"  for i in 0 until LIMIT { if i % 2 == 0 && i < 5 { p.x = p.x + i; } }\n"
+      L"  while !(p.x >= 100) { p.x = int(float(p.x) * 2.0); }\n"
+      L"  >> p.x;\n"
+      L"  << \"p.x = \" + string(p.x);\n"
+      L"  return scale(p, 2).x;\n"
+      L"}\n"
+      L"fn scale(p: Point, k: int) -> Point { return { x: p.x * k, y: p.y }; }\n"
+      L"const LIMIT: int = 10;\n",
+      errorHandler);
+}
+
+TEST(TypeChecker, ReportsMismatchedValues) {
+  ErrorHandlerMock errorHandler;
+  EXPECT_CALL(errorHandler, handleError(ErrorType::TYPE_MISMATCH, _)).Times(6);
+
+  check(
+      L"struct Point { x: int; y: int; };\n"
+      L"fn main() -> int {\n"
+      L"  var a: int = 1.0;\n"
+      L"  var p: Point = { x: 1, z: 2 };\n"
+      L"  a = \"text\";\n"
+      L"  if a { return f(true); }\n"
+      L"  return 'c';\n"
+      L"}\n"
+      L"fn f(n: int) -> int { return n; }\n",
+      errorHandler);
+}
+
+TEST(TypeChecker, ReportsInvalidOperations) {
+  ErrorHandlerMock errorHandler;
+  EXPECT_CALL(errorHandler, handleError(ErrorType::INVALID_OPERAND_TYPES, _)).Times(3);
+  EXPECT_CALL(errorHandler, handleError(ErrorType::INVALID_CAST, _)).Times(1);
+  EXPECT_CALL(errorHandler, handleError(ErrorType::NOT_CALLABLE, _)).Times(1);
+  EXPECT_CALL(errorHandler, handleError(ErrorType::ARGUMENT_COUNT_MISMATCH, _)).Times(1);
+  EXPECT_CALL(errorHandler, handleError(ErrorType::UNKNOWN_MEMBER, _)).Times(1);
+  EXPECT_CALL(errorHandler, handleError(ErrorType::NOT_ASSIGNABLE, _)).Times(1);
+  EXPECT_CALL(errorHandler, handleError(ErrorType::INVALID_IO_OPERAND, _)).Times(1);
+
+  check(
+      L"struct Point { x: int; y: int; };\n"
+      L"fn main() -> int {\n"
+      L"  var p: Point = { x: 1, y: 2 };\n"
+      L"  << 1 + 1.0 << !1 << \"a\" % \"b\";\n"
+      L"  << int(\"12\") << p.x(1) << main(1) << p.z;\n"
+      L"  main = p.x;\n"
+      L"  << p;\n"
+      L"  return 0;\n"
+      L"}\n",
+      errorHandler);
+}
+
+TEST(TypeChecker, ChecksVariantAccessAndMatch) {
+  ErrorHandlerMock errorHandler;
+  EXPECT_CALL(errorHandler, handleError(ErrorType::INVALID_VARIANT_ACCESS, _)).Times(2);
+  EXPECT_CALL(errorHandler, handleError(ErrorType::INVALID_MATCH_CASE, _)).Times(1);
+  EXPECT_CALL(errorHandler, handleError(ErrorType::NON_EXHAUSTIVE_MATCH, _)).Times(1);
+  EXPECT_CALL(errorHandler, handleError(ErrorType::UNKNOWN_TYPE, _)).Times(1);
+
+  check(
+      L"variant Number { int, float };\n"
+      L"fn main() -> int {\n"
+      L"  var n: Number = 1;\n"
+      L"  var i: int = 1;\n"
+      L"  << n as bool << i as int << n as Missing;\n"
+      L"  match n { case int -> {} case char -> {} }\n"
+      L"  return 0;\n"
+      L"}\n",
+      errorHandler);
+}
+
+TEST(TypeChecker, ReportsWritesToConsts) {
+  ErrorHandlerMock errorHandler;
+  EXPECT_CALL(errorHandler, handleError(ErrorType::CONST_ASSIGNMENT, _)).Times(4);
+
+  check(
+      L"struct Point { x: int; y: int; };\n"
+      L"const ORIGIN: Point = { x: 0, y: 0 };\n"
+      L"fn move(const p: Point, q: Point) -> int {\n"
+      L"  q.x = p.x;\n"
+      L"  p.x = 1;\n"
+      L"  p = q;\n"
+      L"  >> p.y;\n"
+      L"  ORIGIN.y = 2;\n"
+      L"  return p.x;\n"
+      L"}\n"
+      L"fn main() -> int { return 0; }\n",
+      errorHandler);
+}
+
+TEST(TypeChecker, AnnotatesExpressionsWithInternedTypes) {
+  auto program = typed(
+      L"struct Point { x: int; y: int; };\n"
+      L"variant Shape { Point, int };\n"
+      L"fn main() -> int { return area(origin) + area(origin); }\n"
+      L"fn area(p: Point) -> int { return p.x * p.y; }\n"
+      L"fn add(a: int, b: int) -> int { return a + b; }\n"
+      L"var origin: Point = { x: 0, y: 0 };\n");
+  ASSERT_TRUE(program != std::nullopt);
+  auto& types = program->types;
+
+  auto point = program->definitions.at(L"Point")->typeId;
+  EXPECT_EQ(types[point].kind, TypeKind::Struct);
+  EXPECT_EQ(types[point].members, (std::vector<StructField>{{L"x", INT_TYPE}, {L"y", INT_TYPE}}));
+
+  auto shape = program->definitions.at(L"Shape")->typeId;
+  EXPECT_EQ(types[shape].alternatives, (std::vector<TypeId>{point, INT_TYPE}));
+
+  // Equal signatures share their id
+  auto area = program->definitions.at(L"area")->typeId;
+  EXPECT_EQ(types[area].parameters, std::vector<TypeId>{point});
+  EXPECT_NE(area, program->definitions.at(L"add")->typeId);
+  auto size = types.size();
+  EXPECT_EQ(types.function({}, INT_TYPE), program->definitions.at(L"main")->typeId);
+  EXPECT_EQ(types.size(), size);
+
+  auto& origin = cast<VarDef>(*program->definitions.at(L"origin"));
+  EXPECT_EQ(origin.typeId, point);
+  EXPECT_EQ(origin.value->typeId, point);
+
+  auto& ret = cast<ReturnStmt>(*body(*program, L"main").statements[0]);
+  auto& sum = cast<BinaryExpression>(*ret.expr);
+  EXPECT_EQ(sum.typeId, INT_TYPE);
+  EXPECT_EQ(sum.lhs->typeId, INT_TYPE);
+  EXPECT_EQ(cast<FunctionalExpression>(*sum.lhs).expr->typeId, area);
+}
+
+TEST(TypeChecker, TypesLocalDefinitionsInScope) {
+  auto program = typed(
+      L"fn main() -> int {\n"
+      L"  struct Pair { a: int; b: char; };\n"
+      L"  var p: Pair = { a: 1, b: 'x' };\n"
+      L"  { var p: bool = true; << p; }\n"
+      L"  for i in 0 until 3 { << i; }\n"
+      L"  return p.a;\n"
+      L"}\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  auto& statements = body(*program, L"main").statements;
+  auto pair = cast<StructDef>(*statements[0]).typeId;
+  EXPECT_EQ(program->types[pair].name, L"Pair");
+  EXPECT_EQ(cast<VarDef>(*statements[1]).typeId, pair);
+
+  auto& inner = cast<BlockStmt>(*statements[2]).statements;
+  EXPECT_EQ(cast<VarDef>(*inner[0]).typeId, BOOL_TYPE);
+  EXPECT_EQ(cast<StdoutInsertionStmt>(*inner[1]).expressions[0]->typeId, BOOL_TYPE);
+
+  auto& loop = cast<ForStmt>(*statements[3]);
+  EXPECT_EQ(cast<StdoutInsertionStmt>(*loop.block.statements[0]).expressions[0]->typeId, INT_TYPE);
+
+  auto& member = *cast<ReturnStmt>(*statements[4]).expr;
+  EXPECT_EQ(member.typeId, INT_TYPE);
+}
+
+TEST(TypeChecker, TagsVariantAlternatives) {
+  auto program = typed(
+      L"variant Value { int, string, bool };\n"
+      L"fn main() -> int {\n"
+      L"  var v: Value = true;\n"
+      L"  match v { case bool -> { << 1; } case int -> { << 2; } case string -> { << 3; } }\n"
+      L"  return int(v as bool);\n"
+      L"}\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  auto& statements = body(*program, L"main").statements;
+  auto variant = cast<VarDef>(*statements[0]).typeId;
+  EXPECT_EQ(program->types.tag(variant, BOOL_TYPE), 2);
+  EXPECT_EQ(program->types.tag(variant, CHAR_TYPE), std::nullopt);
+
+  // The jump table holds the cases in the order of the alternatives, not of the source
+  auto& match = cast<VariantMatchStmt>(*statements[1]);
+  ASSERT_EQ(match.jumpTable.size(), 3);
+  EXPECT_EQ(match.jumpTable[0], &match.cases.at(L"int"));
+  EXPECT_EQ(match.jumpTable[1], &match.cases.at(L"string"));
+  EXPECT_EQ(match.jumpTable[2], &match.cases.at(L"bool"));
+  EXPECT_EQ(match.cases.at(L"string").tag, 1);
+
+  auto& castExpr = cast<CastExpr>(*cast<ReturnStmt>(*statements[2]).expr);
+  auto& access = cast<FunctionalExpression>(*castExpr.expr);
+  EXPECT_EQ(cast<VariantAccessPostfix>(*access.postfix).tag, 2);
+}
+
+TEST(TypeChecker, LaysOutNestedStructsInline) {
+  auto program = typed(
+      L"struct Point { x: int; y: int; };\n"
+      L"struct Segment { a: Point; b: Point; id: int; };\n"
+      L"fn main() -> int {\n"
+      L"  var s: Segment = { a: { x: 1, y: 2 }, b: { x: 3, y: 4 }, id: 5 };\n"
+      L"  return s.b.y;\n"
+      L"}\n");
+  ASSERT_TRUE(program != std::nullopt);
+
+  auto& statements = body(*program, L"main").statements;
+  const auto& segment = program->types[cast<VarDef>(*statements[0]).typeId];
+  EXPECT_EQ(segment.width, 5);
+  EXPECT_EQ(segment.offsets, (std::vector<std::uint32_t>{0, 2, 4}));
+  EXPECT_EQ(program->types.width(segment.members[0].type), 2);
+  EXPECT_EQ(program->types.width(INT_TYPE), 1);
+
+  // Offsets are relative to the struct holding the member
+  auto& y = cast<FunctionalExpression>(*cast<ReturnStmt>(*statements[1]).expr);
+  EXPECT_EQ(cast<MemberAccessPostfix>(*y.postfix).offset, 1);
+  auto& b = cast<FunctionalExpression>(*y.expr);
+  EXPECT_EQ(cast<MemberAccessPostfix>(*b.postfix).offset, 2);
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <optional>
+#include <string>
+
+#include "ErrorHandler.h"
+#include "Lexer.h"
+#include "Parser.h"
+#include "ScopeChecker.h"
+#include "StringCharReader.h"
+#include "TypeChecker.h"
+
+/**
+ * @brief Parses the source and resolves its names and types, as the interpreter passes expect.
+ * @return std::nullopt if any of the stages reports an error.
+ */
+inline std::optional<Program> typed(const std::wstring& source) {
+  ErrorHandler errorHandler;
+  StringCharReader reader{source};
+  Lexer lexer{reader, errorHandler};
+  Parser parser{lexer, errorHandler};
+  auto program = parser.parseProgram();
+  if (program.has_value()) {
+    ScopeChecker{errorHandler}.check(*program);
+    TypeChecker{errorHandler}.check(*program);
+  }
+  return errorHandler.hasErrors() ? std::nullopt : std::move(program);
+}
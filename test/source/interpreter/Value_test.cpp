@@ -0,0 +1,49 @@
+#include <gtest/gtest.h>
+
+#include "Value.h"
+
+using namespace std;
+using namespace ::testing;
+
+namespace {
+
+constexpr TypeId VARIANT_TYPE = 100;
+constexpr TypeId STRUCT_TYPE = 101;
+
+}  // namespace
+
+TEST(Value, HoldsSmallVariantAlternativesInline) {
+  VariantValue number{VARIANT_TYPE, 0, Value{42}};
+  EXPECT_TRUE(number.isInline());
+  EXPECT_EQ(std::get<int>(number.value().data), 42);
+
+  VariantValue text{VARIANT_TYPE, 1, Value{std::wstring{L"a string too long for SSO"}}};
+  EXPECT_EQ(text.isInline(), sizeof(std::wstring) <= VARIANT_INLINE_SIZE);
+  EXPECT_EQ(std::get<std::wstring>(text.value().data), L"a string too long for SSO");
+
+  // Variants of variants are always on the heap, a variant can not hold itself inline
+  VariantValue nested{VARIANT_TYPE + 1, 0, Value{number}};
+  EXPECT_FALSE(nested.isInline());
+  EXPECT_EQ(std::get<int>(std::get<VariantValue>(nested.value().data).value().data), 42);
+}
+
+TEST(Value, CopiesAndMovesVariantValues) {
+  StructValue point{STRUCT_TYPE, {Value{1}, Value{2}}};
+  VariantValue original{VARIANT_TYPE, 2, Value{std::move(point)}};
+
+  auto copy = original;
+  auto moved = std::move(copy);
+  EXPECT_EQ(moved.tag, 2);
+  EXPECT_EQ(std::get<int>(std::get<StructValue>(moved.value().data).fields[1].data), 2);
+
+  // Assigning replaces the alternative, whichever way each of them is held
+  VariantValue nested{VARIANT_TYPE + 1, 0, Value{original}};
+  moved = nested;
+  EXPECT_FALSE(moved.isInline());
+  moved = VariantValue{VARIANT_TYPE, 0, Value{7}};
+  EXPECT_TRUE(moved.isInline());
+  EXPECT_EQ(std::get<int>(moved.release().data), 7);
+
+  auto fields = std::get<StructValue>(original.release().data).fields;
+  EXPECT_EQ(fields.size(), 2);
+}
@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+
+#include "ASTSerializer.h"
+#include "Lexer.h"
+#include "Parser.h"
+#include "ProgramCache.h"
+#include "StringCharReader.h"
+
+using namespace std;
+
+namespace {
+
+const std::wstring SOURCE =
+    L"struct Point { x: int; y: int; };\n"
+    L"variant Number { int, float, string };\n"
+    L"const LIMIT: int = -1000;\n"
+    L"var origin: Point = { x: 0, y: 0 };\n"
+    L"fn walk(const p: Point, steps: int) -> Point {\n"
+    L"  for i in 0 until steps { if i % 2 == 0 { continue; } elif i > 5 { break; } else {} }\n"
+    L"  while steps > 0 && !false { steps = steps - 1; }\n"
+    L"  return { x: p.x + steps, y: int(3.5 * 2.0) };\n"
+    L"}\n"
+    L"fn main() -> int {\n"
+    L"  var n: Number = 'c';\n"
+    L"  match n { case int -> { << n as int; } case string -> { >> origin.x; } }\n"
+    L"  << \"done\\n\";\n"
+    L"  return walk(origin, LIMIT).x;\n"
+    L"}\n";
+
+std::optional<Program> parse(const std::wstring& source) {
+  ErrorHandler errorHandler;
+  StringCharReader reader{source};
+  Lexer lexer{reader, errorHandler};
+  Parser parser{lexer, errorHandler};
+  return parser.parseProgram();
+}
+
+}  // namespace
+
+TEST(ASTSerializer, RoundTripPreservesProgram) {
+  auto program = parse(SOURCE);
+  ASSERT_TRUE(program != std::nullopt);
+
+  auto bytes = serializeProgram(*program, "source", "1.0");
+  auto loaded = deserializeProgram(bytes.data(), bytes.size(), "source", "1.0");
+  ASSERT_TRUE(loaded != std::nullopt);
+  EXPECT_EQ(loaded->definitions.size(), program->definitions.size());
+
+  auto walk = dynamic_cast<FnDef*>(loaded->definitions.at(L"walk").get());
+  ASSERT_TRUE(walk != nullptr);
+  EXPECT_TRUE(walk->parameters.at(L"p").isConst);
+  EXPECT_EQ(walk->body.statements.size(), 3);
+  EXPECT_EQ(walk->position.line, 4);
+  EXPECT_EQ(walk->position.sourceFile, program->position.sourceFile);
+
+  // Definitions may be written in a different order, but nothing is lost or added
+  EXPECT_EQ(serializeProgram(*loaded, "source", "1.0").size(), bytes.size());
+}
+
+TEST(ASTSerializer, RejectsStaleData) {
+  auto program = parse(SOURCE);
+  auto bytes = serializeProgram(*program, "source", "1.0");
+
+  EXPECT_TRUE(deserializeProgram(bytes.data(), bytes.size(), "changed source", "1.0") == std::nullopt);
+  EXPECT_TRUE(deserializeProgram(bytes.data(), bytes.size(), "source", "1.1") == std::nullopt);
+}
+
+TEST(ASTSerializer, RejectsMalformedData) {
+  auto program = parse(SOURCE);
+  auto bytes = serializeProgram(*program, "source", "1.0");
+
+  for (std::size_t size = 0; size < bytes.size(); size += 7) {
+    EXPECT_TRUE(deserializeProgram(bytes.data(), size, "source", "1.0") == std::nullopt);
+  }
+
+  bytes.push_back(0);
+  EXPECT_TRUE(deserializeProgram(bytes.data(), bytes.size(), "source", "1.0") == std::nullopt);
+}
+
+TEST(ProgramCache, StoresAndLoadsPrograms) {
+  auto directory = std::filesystem::temp_directory_path() / "proton_program_cache_test";
+  std::filesystem::remove_all(directory);
+  ProgramCache cache{directory, "1.0"};
+
+  auto program = parse(SOURCE);
+  EXPECT_TRUE(cache.load("source", "a.prot") == std::nullopt);
+  ASSERT_TRUE(cache.store("source", *program));
+
+  auto loaded = cache.load("source", "a.prot");
+  ASSERT_TRUE(loaded != std::nullopt);
+  EXPECT_EQ(loaded->definitions.size(), program->definitions.size());
+
+  // A copy of the file hits the entry, its positions refer to the copy
+  auto copy = cache.load("source", "b.prot");
+  ASSERT_TRUE(copy != std::nullopt);
+  EXPECT_EQ(copy->position.sourceFile, "b.prot");
+  EXPECT_EQ(copy->definitions.at(L"main")->position.sourceFile, "b.prot");
+
+  // Different contents or tool version never hit the entry
+  EXPECT_TRUE(cache.load("changed source", "a.prot") == std::nullopt);
+  ProgramCache newerCache{directory, "1.1"};
+  EXPECT_TRUE(newerCache.load("source", "a.prot") == std::nullopt);
+
+  std::filesystem::remove_all(directory);
+}
+
+TEST(ProgramCache, MissesEntriesOfCollidingSources) {
+  auto directory = std::filesystem::temp_directory_path() / "proton_program_cache_collision_test";
+  std::filesystem::remove_all(directory);
+  ProgramCache cache{directory, "1.0"};
+
+  auto program = parse(SOURCE);
+  ASSERT_TRUE(cache.store("source", *program));
+
+  // The entry of "source" at the key of another source, as if their hashes collided
+  std::filesystem::copy_file(cache.entryPath("source"), cache.entryPath("other source"));
+  EXPECT_TRUE(cache.load("other source", "a.prot") == std::nullopt);
+  EXPECT_TRUE(cache.load("source", "a.prot") != std::nullopt);
+
+  std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include "ASTStats.h"
+#include "Lexer.h"
+#include "Parser.h"
+#include "StringCharReader.h"
+
+using namespace std;
+
+namespace {
+
+std::optional<Program> parse(const std::wstring& source) {
+  ErrorHandler errorHandler;
+  StringCharReader reader{source};
+  Lexer lexer{reader, errorHandler};
+  Parser parser{lexer, errorHandler};
+  return parser.parseProgram();
+}
+
+}  // namespace
+
+TEST(ASTStats, CountsNodesPerKind) {
+  auto program = parse(L"fn main() -> int { var a: int = 1 + 2; return a; }");
+  ASSERT_TRUE(program != std::nullopt);
+
+  auto stats = collectASTStats(*program);
+
+  // Program, FnDef, BlockStmt, VarDef, BinaryExpression, 2 literals, ReturnStmt, IdentifierExpr
+  EXPECT_EQ(stats.totalNodes, 9);
+  EXPECT_EQ(stats[NodeKind::IntLiteral].count, 2);
+  EXPECT_EQ(stats[NodeKind::IdentifierExpr].count, 1);
+  EXPECT_EQ(stats[NodeKind::Program].count, 1);
+  EXPECT_EQ(stats[NodeKind::WhileStmt].count, 0);
+
+  // Program -> FnDef -> BlockStmt -> VarDef -> BinaryExpression -> Literal
+  EXPECT_EQ(stats.maxDepth, 6);
+  // 8 edges from 6 inner nodes
+  EXPECT_DOUBLE_EQ(stats.averageFanOut, 8.0 / 6.0);
+}
+
+TEST(ASTStats, CountsBytesAndAllocations) {
+  auto program = parse(L"fn main() -> int { var aVeryLongVariableName: int = 1; return 0; }");
+  ASSERT_TRUE(program != std::nullopt);
+
+  auto stats = collectASTStats(*program);
+
+  EXPECT_GE(stats[NodeKind::IntLiteral].bytes, 2 * sizeof(Literal<int>));
+  // Body block is embedded in the function, counted once under BlockStmt
+  EXPECT_GE(stats[NodeKind::BlockStmt].bytes, sizeof(BlockStmt));
+  EXPECT_LT(stats[NodeKind::FnDef].bytes, sizeof(FnDef) + 1000);
+
+  // The long name does not fit in the inline string buffer
+  EXPECT_GT(stats.identifierBytes, 22 * sizeof(wchar_t));
+  EXPECT_GE(stats.positionBytes, stats.totalNodes * sizeof(Position));
+  EXPECT_LE(stats.identifierBytes + stats.positionBytes, stats.totalBytes);
+
+  std::size_t perKindTotal = 0;
+  for (const auto& entry : stats.perKind) perKindTotal += entry.bytes;
+  EXPECT_EQ(perKindTotal, stats.totalBytes);
+
+  // FnDef, VarDef, ReturnStmt, 2 literals at least, each with malloc overhead
+  EXPECT_GE(stats.heapAllocations, 5);
+  EXPECT_GE(stats.heapOverheadBytes, 5 * 8);
+}
+
+TEST(ASTStats, PrintsReport) {
+  auto program = parse(L"fn main() -> int { return 0; }");
+  ASSERT_TRUE(program != std::nullopt);
+
+  std::stringstream out;
+  printASTStats(out, collectASTStats(*program));
+
+  EXPECT_NE(out.str().find("ReturnStmt"), std::string::npos);
+  EXPECT_NE(out.str().find("max depth: 5"), std::string::npos);
+  EXPECT_EQ(out.str().find("WhileStmt"), std::string::npos);
+}
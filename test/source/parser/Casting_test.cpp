@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+
+#include "ASTDispatch.h"
+#include "Lexer.h"
+#include "Parser.h"
+#include "StringCharReader.h"
+
+using namespace std;
+
+namespace {
+
+std::optional<Program> parse(const std::wstring& source) {
+  ErrorHandler errorHandler;
+  StringCharReader reader{source};
+  Lexer lexer{reader, errorHandler};
+  Parser parser{lexer, errorHandler};
+  return parser.parseProgram();
+}
+
+}  // namespace
+
+TEST(Casting, IsaMatchesConcreteKindsAndCategories) {
+  auto program = parse(L"const A: int = 1 + 2; fn main() -> int { return 0; }");
+  ASSERT_TRUE(program != std::nullopt);
+
+  const Definition* constDef = program->definitions.at(L"A").get();
+  EXPECT_TRUE(isa<ConstDef>(constDef));
+  EXPECT_TRUE(isa<Definition>(constDef));
+  EXPECT_TRUE(isa<Statement>(constDef));
+  EXPECT_FALSE(isa<VarDef>(constDef));
+  EXPECT_FALSE(isa<BlockStmt>(constDef));
+
+  auto value = cast<ConstDef>(constDef)->value.get();
+  EXPECT_TRUE(isa<BinaryExpression>(value));
+  EXPECT_TRUE(isa<Expression>(value));
+  EXPECT_FALSE(isa<PrimaryExpression>(value));
+
+  auto& lhs = *cast<BinaryExpression>(value)->lhs;
+  EXPECT_TRUE(isa<PrimaryExpression>(lhs));
+  EXPECT_TRUE(isa<Literal<int>>(lhs));
+  EXPECT_FALSE(isa<Literal<float>>(lhs));
+  EXPECT_EQ(cast<Literal<int>>(lhs).value, 1);
+}
+
+TEST(Casting, DynCastReturnsNullOnMismatch) {
+  auto program = parse(L"fn main() -> int { return 0; }");
+  ASSERT_TRUE(program != std::nullopt);
+
+  Definition* main = program->definitions.at(L"main").get();
+  EXPECT_TRUE(dyn_cast<StructDef>(main) == nullptr);
+  ASSERT_TRUE(dyn_cast<FnDef>(main) != nullptr);
+  EXPECT_EQ(dyn_cast<FnDef>(main), main);
+
+  Expression* missing = nullptr;
+  EXPECT_TRUE(dyn_cast_or_null<IdentifierExpr>(missing) == nullptr);
+}
+
+TEST(Casting, DispatchCallsMostDerivedOverload) {
+  auto program = parse(L"fn main() -> int { while x { x = 'c'; } return 0; }");
+  ASSERT_TRUE(program != std::nullopt);
+
+  struct KindName {
+    std::string operator()(const WhileStmt&) { return "while"; }
+    std::string operator()(const ReturnStmt&) { return "return"; }
+    std::string operator()(const Literal<wchar_t>&) { return "char"; }
+    std::string operator()(const ASTNode&) { return "other"; }
+  };
+
+  auto& body = cast<FnDef>(*program->definitions.at(L"main")).body;
+  EXPECT_EQ(dispatch(*body.statements.at(0), KindName{}), "while");
+  EXPECT_EQ(dispatch(*body.statements.at(1), KindName{}), "return");
+  EXPECT_EQ(dispatch(body, KindName{}), "other");
+
+  auto& loop = cast<WhileStmt>(*body.statements.at(0));
+  auto& assignment = cast<AssignmentStmt>(*loop.block.statements.at(0));
+  EXPECT_EQ(dispatch(*assignment.rhs, KindName{}), "char");
+}
@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+
+#include "Lexer.h"
+#include "Parser.h"
+#include "StringCharReader.h"
+#include "mocks/ErrorHandlerMock.h"
+
+using namespace std;
+using namespace ::testing;
+
+namespace {
+
+std::optional<Program> parse(const std::wstring& source, ErrorHandler& errorHandler,
+                             ParsingMode mode = ParsingMode::Recursive) {
+  StringCharReader reader{source};
+  Lexer lexer{reader, errorHandler};
+  Parser parser{lexer, errorHandler, mode, ErrorRecovery::PanicMode};
+  return parser.parseProgram();
+}
+
+}  // namespace
+
+TEST(ErrorRecovery, ReportsEveryBrokenStatementOnce) {
+  ErrorHandlerMock errorHandler;
+
+  InSequence sequence;
+  EXPECT_CALL(errorHandler, handleError(ErrorType::VARDEF_EXPECTED_TYPE_IDENTIFIER, _)).Times(1);
+  EXPECT_CALL(errorHandler, handleError(ErrorType::PARENEXPR_EXPECTED_RPAREN, _)).Times(1);
+  EXPECT_CALL(errorHandler, handleError(ErrorType::ASSIGNMENTSTMT_EXPECTED_EXPRESSION, _))
+      .Times(1);
+  EXPECT_CALL(errorHandler, handleError(ErrorType::RETURN_EXPECTED_SEMICOLON, _)).Times(1);
+
+  auto program = parse(
+      L"fn main() -> int {\n"
+      L"  var a: = 1;\n"
+      L"  while (a < 2 { a = a + 1; }\n"
+      L"  if a { b = ; } else { << a; }\n"
+      L"  return a\n"
+      L"}\n",
+      errorHandler);
+  EXPECT_TRUE(program == std::nullopt);
+}
+
+TEST(ErrorRecovery, ResynchronizesAtNextDefinition) {
+  ErrorHandlerMock errorHandler;
+
+  InSequence sequence;
+  EXPECT_CALL(errorHandler, handleError(ErrorType::STRUCTMEMBER_EXPECTED_COLON, _)).Times(1);
+  EXPECT_CALL(errorHandler, handleError(ErrorType::FNDEF_EXPECTED_ARROW, _)).Times(1);
+  EXPECT_CALL(errorHandler, handleError(ErrorType::REDEFINITION, _)).Times(1);
+  EXPECT_CALL(errorHandler, handleError(ErrorType::CONSTDEF_EXPECTED_SEMICOLON, _)).Times(1);
+
+  auto program = parse(
+      L"struct Point { x int; y: int; };\n"
+      L"fn f() int { return 1; }\n"
+      L"fn main() -> int { return 0; }\n"
+      L"fn main() -> int { return 1; }\n"
+      L"const A: int = 1\n",
+      errorHandler);
+  EXPECT_TRUE(program == std::nullopt);
+}
+
+TEST(ErrorRecovery, SkipsStrayTokensBetweenDefinitions) {
+  ErrorHandlerMock errorHandler;
+
+  InSequence sequence;
+  EXPECT_CALL(errorHandler, handleError(ErrorType::VARDEF_EXPECTED_EXPRESSION, _)).Times(1);
+  EXPECT_CALL(errorHandler, handleError(ErrorType::EXPECTED_DEFINITION, _)).Times(1);
+  EXPECT_CALL(errorHandler, handleError(ErrorType::PARENEXPR_EXPECTED_RPAREN, _)).Times(1);
+
+  auto program = parse(
+      L"fn f() -> int { var a: int = ; return 1; }\n"
+      L";\n"
+      L"fn g() -> int { return (1; }\n"
+      L"fn main() -> int { return 0; }\n",
+      errorHandler);
+  EXPECT_TRUE(program == std::nullopt);
+}
+
+TEST(ErrorRecovery, RecoversDefinitionsInIterativeMode) {
+  ErrorHandlerMock errorHandler;
+
+  InSequence sequence;
+  EXPECT_CALL(errorHandler, handleError(ErrorType::BINARYEXPRESSION_EXPECTED_RHS, _)).Times(1);
+  EXPECT_CALL(errorHandler, handleError(ErrorType::VARIANTDEF_EXPECTED_RBRACE, _)).Times(1);
+
+  auto program = parse(
+      L"fn f() -> int { while x { return 1 + ; } }\n"
+      L"variant V { int, float ;\n"
+      L"fn main() -> int { return 0; }\n",
+      errorHandler, ParsingMode::Iterative);
+  EXPECT_TRUE(program == std::nullopt);
+}
+
+TEST(ErrorRecovery, AcceptsValidProgram) {
+  ErrorHandlerMock errorHandler;
+  EXPECT_CALL(errorHandler, handleError(_, _)).Times(0);
+
+  auto program = parse(L"var a: int = 1; fn main() -> int { if a { return 1; } return 0; }",
+                       errorHandler);
+  ASSERT_TRUE(program != std::nullopt);
+  EXPECT_EQ(program->definitions.size(), 2);
+}
+
+TEST(ErrorRecovery, CollectingErrorHandlerStopsAtCap) {
+  auto source = std::wstring{L"fn main() -> int {"};
+  for (int i = 0; i < 10; i++) source += L" a = ;";
+  source += L" return 0; }";
+
+  ErrorHandler errorHandler{ErrorPolicy::Collect, 3};
+  EXPECT_TRUE(parse(source, errorHandler) == std::nullopt);
+  EXPECT_EQ(errorHandler.diagnostics().size(), 3);
+  EXPECT_TRUE(errorHandler.limitReached());
+}
@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+
+#include "ASTSerializer.h"
+#include "ASTStats.h"
+#include "Casting.h"
+#include "ExpressionDeduplication.h"
+#include "Lexer.h"
+#include "Parser.h"
+#include "StringCharReader.h"
+
+using namespace std;
+
+namespace {
+
+std::optional<Program> parse(const std::wstring& source) {
+  ErrorHandler errorHandler;
+  StringCharReader reader{source};
+  Lexer lexer{reader, errorHandler};
+  Parser parser{lexer, errorHandler};
+  return parser.parseProgram();
+}
+
+Statement& statement(Program& program, std::size_t index) {
+  return *cast<FnDef>(*program.definitions.at(L"main")).body.statements.at(index);
+}
+
+std::unique_ptr<Expression> parseExpression(const std::wstring& source) {
+  auto program = parse(L"fn main() -> int { return " + source + L"; }");
+  return std::move(cast<ReturnStmt>(statement(*program, 0)).expr);
+}
+
+const std::wstring REPEATED_SOURCE =
+    L"fn main() -> int {"
+    L"  var a: int = b.x + b.y * 2;"
+    L"  var c: int = b.x + b.y * 2;"
+    L"  return b.x;"
+    L"}";
+
+}  // namespace
+
+TEST(ExpressionDeduplication, SharesRepeatedSubtrees) {
+  auto program = parse(REPEATED_SOURCE);
+  ASSERT_TRUE(program != std::nullopt);
+
+  auto stats = deduplicateExpressions(*program);
+
+  // b.x + b.y * 2, b.x, b.y * 2 and b.y
+  EXPECT_EQ(stats.sharedSubtrees, 4);
+  EXPECT_EQ(program->sharedExpressions.size(), 4);
+  // Both definitions and the return, plus b.x, b.y * 2 and b.y inside of the shared sum
+  EXPECT_EQ(stats.sharedUses, 6);
+  // The second sum and the returned b.x
+  EXPECT_EQ(stats.freedNodes, 9);
+
+  auto first = dyn_cast<SharedExpr>(cast<VarDef>(statement(*program, 0)).value.get());
+  auto second = dyn_cast<SharedExpr>(cast<VarDef>(statement(*program, 1)).value.get());
+  ASSERT_TRUE(first != nullptr);
+  ASSERT_TRUE(second != nullptr);
+  EXPECT_EQ(first->expr, second->expr);
+  EXPECT_EQ(first->hash, structuralHash(*first->expr));
+  EXPECT_NE(first->position.column, second->position.column);
+
+  auto sum = dyn_cast<BinaryExpression>(first->expr);
+  ASSERT_TRUE(sum != nullptr);
+  auto lhs = dyn_cast<SharedExpr>(sum->lhs.get());
+  auto returned = dyn_cast<SharedExpr>(cast<ReturnStmt>(statement(*program, 2)).expr.get());
+  ASSERT_TRUE(lhs != nullptr);
+  ASSERT_TRUE(returned != nullptr);
+  EXPECT_EQ(lhs->expr, returned->expr);
+}
+
+TEST(ExpressionDeduplication, DoesNotShareImpureExpressions) {
+  auto program = parse(
+      L"fn main() -> int {"
+      L"  var a: int = f(x) + 1;"
+      L"  var b: int = f(x) + 1;"
+      L"  var c: P = {x: 1};"
+      L"  var d: P = {x: 1};"
+      L"  return 0;"
+      L"}");
+  ASSERT_TRUE(program != std::nullopt);
+
+  auto stats = deduplicateExpressions(*program);
+
+  EXPECT_EQ(stats.sharedSubtrees, 0);
+  EXPECT_TRUE(program->sharedExpressions.empty());
+  EXPECT_TRUE(isa<BinaryExpression>(cast<VarDef>(statement(*program, 1)).value.get()));
+}
+
+TEST(ExpressionDeduplication, SharesUnderImpureParents) {
+  auto program = parse(
+      L"fn main() -> int {"
+      L"  f(a.b, a.b);"
+      L"  return 0;"
+      L"}");
+  ASSERT_TRUE(program != std::nullopt);
+
+  auto stats = deduplicateExpressions(*program);
+
+  EXPECT_EQ(stats.sharedSubtrees, 1);
+  EXPECT_EQ(stats.sharedUses, 2);
+}
+
+TEST(ExpressionDeduplication, ReducesASTMemory) {
+  auto program = parse(REPEATED_SOURCE);
+  ASSERT_TRUE(program != std::nullopt);
+  auto before = collectASTStats(*program);
+
+  deduplicateExpressions(*program);
+  auto after = collectASTStats(*program);
+
+  EXPECT_LT(after.totalBytes, before.totalBytes);
+  EXPECT_LT(after.totalNodes, before.totalNodes);
+  EXPECT_EQ(after[NodeKind::SharedExpr].count, 6);
+  // Every shared subtree is counted once, b.x three times before
+  EXPECT_EQ(after[NodeKind::MemberAccessPostfix].count, 2);
+  EXPECT_EQ(before[NodeKind::MemberAccessPostfix].count, 5);
+}
+
+TEST(ExpressionDeduplication, IsIdempotent) {
+  auto program = parse(REPEATED_SOURCE);
+  ASSERT_TRUE(program != std::nullopt);
+  deduplicateExpressions(*program);
+
+  auto stats = deduplicateExpressions(*program);
+
+  EXPECT_EQ(stats.sharedSubtrees, 0);
+  EXPECT_EQ(program->sharedExpressions.size(), 4);
+}
+
+TEST(ExpressionDeduplication, SerializesSharedSubtreesAsCopies) {
+  auto program = parse(REPEATED_SOURCE);
+  ASSERT_TRUE(program != std::nullopt);
+  deduplicateExpressions(*program);
+
+  auto bytes = serializeProgram(*program, "source", "test");
+  auto restored = deserializeProgram(bytes.data(), bytes.size(), "source", "test");
+  ASSERT_TRUE(restored != std::nullopt);
+
+  auto& original = *cast<VarDef>(statement(*program, 1)).value;
+  auto& copy = *cast<VarDef>(statement(*restored, 1)).value;
+  EXPECT_TRUE(isa<BinaryExpression>(copy));
+  EXPECT_TRUE(structurallyEqual(original, copy));
+  EXPECT_EQ(structuralHash(original), structuralHash(copy));
+}
+
+TEST(ExpressionDeduplication, ComparesStructureOnly) {
+  auto expr = parseExpression(L"(a.b + 1.5) * -c");
+  auto spaced = parseExpression(L"(a.b  +  1.5)  *  -c");
+  auto otherMember = parseExpression(L"(a.x + 1.5) * -c");
+  auto otherLiteral = parseExpression(L"(a.b + 2.5) * -c");
+  auto call = parseExpression(L"f(a)");
+
+  EXPECT_TRUE(isPureExpression(*expr));
+  EXPECT_FALSE(isPureExpression(*call));
+
+  EXPECT_TRUE(structurallyEqual(*expr, *spaced));
+  EXPECT_EQ(structuralHash(*expr), structuralHash(*spaced));
+  EXPECT_FALSE(structurallyEqual(*expr, *otherMember));
+  EXPECT_FALSE(structurallyEqual(*expr, *otherLiteral));
+  EXPECT_FALSE(structurallyEqual(*call, *call));
+}
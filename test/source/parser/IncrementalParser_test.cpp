@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+
+#include "IncrementalParser.h"
+#include "Lexer.h"
+#include "Parser.h"
+#include "StringCharReader.h"
+#include "mocks/ErrorHandlerMock.h"
+
+using namespace std;
+using namespace ::testing;
+
+class IncrementalParserTest : public ::Test {
+ public:
+  IncrementalParserTest() : m_parser{m_errorHandler} {}
+
+ protected:
+  std::optional<Program> parseFromScratch(const std::wstring& source) {
+    ErrorHandler errorHandler;
+    StringCharReader reader{source};
+    Lexer lexer{reader, errorHandler};
+    Parser parser{lexer, errorHandler};
+    return parser.parseProgram();
+  }
+
+  ::testing::StrictMock<ErrorHandlerMock> m_errorHandler;
+  IncrementalParser m_parser;
+};
+
+const std::wstring SOURCE =
+    L"const answer: int = 42;\n"
+    L"fn add(a: int, b: int) -> int {\n"
+    L"  return a + b;\n"
+    L"}\n"
+    L"fn main() -> int {\n"
+    L"  return add(answer, 1);\n"
+    L"}\n";
+
+TEST_F(IncrementalParserTest, InitialParseReportsAllDefinitions) {
+  EXPECT_CALL(m_errorHandler, handleError(_, _)).Times(0);
+  auto update = m_parser.parse(SOURCE);
+
+  ASSERT_TRUE(update.program != std::nullopt);
+  EXPECT_EQ(update.program->definitions.size(), 3);
+  EXPECT_EQ(update.changed, IncrementalParser::ChangedDefinitions({L"answer", L"add", L"main"}));
+}
+
+TEST_F(IncrementalParserTest, EditInFunctionBodyReparsesOnlyThatFunction) {
+  EXPECT_CALL(m_errorHandler, handleError(_, _)).Times(0);
+  m_parser.parse(SOURCE);
+  auto answer = m_parser.program()->definitions.at(L"answer").get();
+  auto main = m_parser.program()->definitions.at(L"main").get();
+
+  auto offset = SOURCE.find(L"a + b");
+  auto update = m_parser.applyEdit({offset, 5, L"a * b"});
+
+  ASSERT_TRUE(update.program != std::nullopt);
+  EXPECT_EQ(update.changed, IncrementalParser::ChangedDefinitions({L"add"}));
+  EXPECT_EQ(update.program->definitions.at(L"answer").get(), answer);
+  EXPECT_EQ(update.program->definitions.at(L"main").get(), main);
+
+  auto add = dynamic_cast<FnDef*>(update.program->definitions.at(L"add").get());
+  ASSERT_TRUE(add != nullptr);
+  auto returnStmt = dynamic_cast<ReturnStmt*>(add->body.statements.front().get());
+  auto binary = dynamic_cast<BinaryExpression*>(returnStmt->expr.get());
+  ASSERT_TRUE(binary != nullptr);
+  EXPECT_EQ(binary->op, Operator::Mul);
+}
+
+TEST_F(IncrementalParserTest, ReusedDefinitionsHaveShiftedPositions) {
+  EXPECT_CALL(m_errorHandler, handleError(_, _)).Times(0);
+  m_parser.parse(SOURCE);
+  auto main = m_parser.program()->definitions.at(L"main").get();
+
+  auto offset = SOURCE.find(L"return a + b;");
+  auto update = m_parser.applyEdit({offset, 0, L"var c: int = 0;\n\n  "});
+  ASSERT_TRUE(update.program != std::nullopt);
+  EXPECT_EQ(update.changed, IncrementalParser::ChangedDefinitions({L"add"}));
+  EXPECT_EQ(update.program->definitions.at(L"main").get(), main);
+
+  auto expected = parseFromScratch(m_parser.source());
+  ASSERT_TRUE(expected != std::nullopt);
+
+  auto actualMain = dynamic_cast<FnDef*>(update.program->definitions.at(L"main").get());
+  auto expectedMain = dynamic_cast<FnDef*>(expected->definitions.at(L"main").get());
+  EXPECT_EQ(actualMain->position.line, expectedMain->position.line);
+  EXPECT_EQ(actualMain->position.column, expectedMain->position.column);
+
+  auto actualReturn = dynamic_cast<ReturnStmt*>(actualMain->body.statements.front().get());
+  auto expectedReturn = dynamic_cast<ReturnStmt*>(expectedMain->body.statements.front().get());
+  EXPECT_EQ(actualReturn->position.line, expectedReturn->position.line);
+  EXPECT_EQ(actualReturn->position.column, expectedReturn->position.column);
+  EXPECT_EQ(actualReturn->expr->position.line, expectedReturn->expr->position.line);
+  EXPECT_EQ(actualReturn->expr->position.column, expectedReturn->expr->position.column);
+}
+
+TEST_F(IncrementalParserTest, EditOnDefinitionLineShiftsColumns) {
+  EXPECT_CALL(m_errorHandler, handleError(_, _)).Times(0);
+  const std::wstring source = L"const a: int = 1; fn main() -> int { return a; }";
+  m_parser.parse(source);
+
+  auto update = m_parser.applyEdit({source.find(L"1"), 1, L"1000"});
+  ASSERT_TRUE(update.program != std::nullopt);
+  EXPECT_EQ(update.changed, IncrementalParser::ChangedDefinitions({L"a"}));
+
+  auto expected = parseFromScratch(m_parser.source());
+  auto& actualMain = update.program->definitions.at(L"main");
+  auto& expectedMain = expected->definitions.at(L"main");
+  EXPECT_EQ(actualMain->position.column, expectedMain->position.column);
+}
+
+TEST_F(IncrementalParserTest, AddingDefinitionReportsIt) {
+  EXPECT_CALL(m_errorHandler, handleError(_, _)).Times(0);
+  m_parser.parse(SOURCE);
+
+  auto update = m_parser.applyEdit({0, 0, L"var counter: int = 0;\n"});
+  ASSERT_TRUE(update.program != std::nullopt);
+  EXPECT_EQ(update.program->definitions.size(), 4);
+  EXPECT_EQ(update.changed, IncrementalParser::ChangedDefinitions({L"counter"}));
+}
+
+TEST_F(IncrementalParserTest, RemovingDefinitionReportsIt) {
+  EXPECT_CALL(m_errorHandler, handleError(_, _)).Times(0);
+  m_parser.parse(SOURCE);
+
+  auto begin = SOURCE.find(L"fn add");
+  auto end = SOURCE.find(L"fn main");
+  auto update = m_parser.applyEdit({begin, end - begin, L""});
+  ASSERT_TRUE(update.program != std::nullopt);
+  EXPECT_EQ(update.program->definitions.size(), 2);
+  EXPECT_EQ(update.changed, IncrementalParser::ChangedDefinitions({L"add"}));
+}
+
+TEST_F(IncrementalParserTest, WhitespaceEditBetweenDefinitionsChangesNothing) {
+  EXPECT_CALL(m_errorHandler, handleError(_, _)).Times(0);
+  m_parser.parse(SOURCE);
+
+  auto update = m_parser.applyEdit({SOURCE.find(L"fn main"), 0, L"\n\n"});
+  ASSERT_TRUE(update.program != std::nullopt);
+  EXPECT_TRUE(update.changed.empty());
+
+  auto expected = parseFromScratch(m_parser.source());
+  EXPECT_EQ(update.program->definitions.at(L"main")->position.line,
+            expected->definitions.at(L"main")->position.line);
+}
+
+TEST_F(IncrementalParserTest, EditCausingRedefinitionIsReported) {
+  m_parser.parse(SOURCE);
+
+  EXPECT_CALL(m_errorHandler, handleError(ErrorType::REDEFINITION, _)).Times(1);
+  auto offset = SOURCE.find(L"fn add");
+  auto update = m_parser.applyEdit({offset + 3, 3, L"main"});
+  ASSERT_TRUE(update.program == std::nullopt);
+}
+
+TEST_F(IncrementalParserTest, RecoversAfterFailedEdit) {
+  m_parser.parse(SOURCE);
+
+  EXPECT_CALL(m_errorHandler, handleError(ErrorType::EXPECTED_MAIN_FUNCTION_DEF, _)).Times(1);
+  auto offset = SOURCE.find(L"fn main");
+  auto update = m_parser.applyEdit({offset + 3, 4, L"mian"});
+  ASSERT_TRUE(update.program == std::nullopt);
+
+  auto fixed = m_parser.applyEdit({offset + 3, 4, L"main"});
+  ASSERT_TRUE(fixed.program != std::nullopt);
+  EXPECT_EQ(fixed.program->definitions.size(), 3);
+}
@@ -0,0 +1,191 @@
+#include <gtest/gtest.h>
+
+#include "ASTSerializer.h"
+#include "ASTTeardown.h"
+#include "Lexer.h"
+#include "Parser.h"
+#include "StringCharReader.h"
+#include "mocks/ErrorHandlerMock.h"
+
+using namespace std;
+using namespace ::testing;
+
+namespace {
+
+const int STRESS_DEPTH = 100000;
+
+std::optional<Program> parse(const std::wstring& source, ParsingMode mode) {
+  ErrorHandler errorHandler;
+  StringCharReader reader{source};
+  Lexer lexer{reader, errorHandler};
+  Parser parser{lexer, errorHandler, mode};
+  return parser.parseProgram();
+}
+
+std::wstring repeat(const std::wstring& str, int times) {
+  std::wstring result;
+  result.reserve(str.size() * times);
+  for (int i = 0; i < times; i++) result += str;
+  return result;
+}
+
+BlockStmt& mainBody(Program& program) {
+  return dynamic_cast<FnDef&>(*program.definitions.at(L"main")).body;
+}
+
+void expectSameTree(const std::wstring& source) {
+  auto recursive = parse(source, ParsingMode::Recursive);
+  auto iterative = parse(source, ParsingMode::Iterative);
+  ASSERT_TRUE(recursive != std::nullopt);
+  ASSERT_TRUE(iterative != std::nullopt);
+  EXPECT_EQ(serializeProgram(*recursive, "", ""), serializeProgram(*iterative, "", ""));
+}
+
+}  // namespace
+
+/* ---------------------------- Recursive parity ---------------------------- */
+
+TEST(IterativeParser, BuildsSameExpressionsAsRecursiveParser) {
+  expectSameTree(
+      L"const A: int = -(a + b) * c.d as int - f(1, g(), { x: 1, y: -2, })(3) || !x && y;\n"
+      L"const B: bool = a == b != c < d % 5 / -e.f.g >= int(\"7\") - {} + { a: (1) } + h(i)(j);\n"
+      L"const C: int = a - b - c * d * e || f || g && h == i;\n"
+      L"fn main() -> int { return 0; }\n");
+}
+
+TEST(IterativeParser, BuildsSameStatementsAsRecursiveParser) {
+  expectSameTree(
+      L"struct Point { x: int; y: int; };\n"
+      L"fn walk(const p: Point, steps: int) -> Point {\n"
+      L"  for i in 0 until steps { if i % 2 == 0 { continue; } elif i > 5 { break; } else {} }\n"
+      L"  while steps > 0 && !false { steps = steps - 1; { { } } }\n"
+      L"  match n { case int -> { << n as int; } case string -> { >> origin.x; } }\n"
+      L"  if a { if b {} } elif c { match d {} } elif e {}\n"
+      L"  fn nested() -> int { while x { return 1; } }\n"
+      L"  return { x: p.x + steps, y: int(3.5 * 2.0) };\n"
+      L"}\n"
+      L"fn main() -> int { var p: Point = walk({ x: 1, y: 2 }, 3); return p.x; }\n");
+}
+
+TEST(IterativeParser, ReportsInnermostError) {
+  ErrorHandlerMock errorHandler;
+  StringCharReader reader{L"fn main() -> int { if x { while y { z = (a + ; } } }"};
+  Lexer lexer{reader, errorHandler};
+  Parser parser{lexer, errorHandler, ParsingMode::Iterative};
+
+  // Enclosing paren, while and if do not report follow-up errors
+  InSequence sequence;
+  EXPECT_CALL(errorHandler, handleError(ErrorType::BINARYEXPRESSION_EXPECTED_RHS, _)).Times(1);
+  EXPECT_CALL(errorHandler, handleError(ErrorType::ASSIGNMENTSTMT_EXPECTED_EXPRESSION, _))
+      .Times(1);
+  EXPECT_CALL(errorHandler, handleError(ErrorType::FNDEF_EXPECTED_BLOCK, _)).Times(1);
+  EXPECT_CALL(errorHandler, handleError(ErrorType::EXPECTED_MAIN_FUNCTION_DEF, _)).Times(1);
+  EXPECT_TRUE(parser.parseProgram() == std::nullopt);
+}
+
+/* ------------------------------ Stress tests ------------------------------ */
+
+TEST(IterativeParser, ParsesDeeplyParenthesizedExpression) {
+  auto source = L"fn main() -> int { return " + repeat(L"(", STRESS_DEPTH) + L"1" +
+                repeat(L")", STRESS_DEPTH) + L"; }";
+
+  auto program = parse(source, ParsingMode::Iterative);
+  ASSERT_TRUE(program != std::nullopt);
+
+  auto returnStmt = dynamic_cast<ReturnStmt*>(mainBody(*program).statements.at(0).get());
+  ASSERT_TRUE(returnStmt != nullptr);
+
+  int depth = 0;
+  Expression* expr = returnStmt->expr.get();
+  while (auto paren = dynamic_cast<ParenExpr*>(expr)) {
+    expr = paren->expr.get();
+    depth++;
+  }
+  EXPECT_EQ(depth, STRESS_DEPTH);
+  EXPECT_TRUE(dynamic_cast<Literal<int>*>(expr) != nullptr);
+
+  destroyIteratively(*program);
+}
+
+TEST(IterativeParser, ParsesDeeplyNestedCalls) {
+  auto source = L"fn main() -> int { return " + repeat(L"f(-x, ", STRESS_DEPTH) + L"{ a: 1 }" +
+                repeat(L")", STRESS_DEPTH) + L"; }";
+
+  auto program = parse(source, ParsingMode::Iterative);
+  ASSERT_TRUE(program != std::nullopt);
+
+  auto returnStmt = dynamic_cast<ReturnStmt*>(mainBody(*program).statements.at(0).get());
+  ASSERT_TRUE(returnStmt != nullptr);
+
+  int depth = 0;
+  Expression* expr = returnStmt->expr.get();
+  while (auto call = dynamic_cast<FunctionalExpression*>(expr)) {
+    auto& args = dynamic_cast<FnCallPostfix&>(*call->postfix).args;
+    ASSERT_EQ(args.size(), 2);
+    expr = args.at(1).get();
+    depth++;
+  }
+  EXPECT_EQ(depth, STRESS_DEPTH);
+  EXPECT_TRUE(dynamic_cast<Object*>(expr) != nullptr);
+
+  destroyIteratively(*program);
+}
+
+TEST(IterativeParser, ParsesDeeplyNestedBlocks) {
+  const std::vector<std::pair<std::wstring, std::wstring>> nestings = {
+      {L"if x {} elif y { ", L"} "},           {L"while z { ", L"} "},
+      {L"for i in 0 until 1 { ", L"} "},       {L"if x {} else { ", L"} "},
+      {L"match v { case int -> { ", L"} } "}, {L"{ ", L"} "},
+  };
+
+  std::wstring opening, closing;
+  for (int i = 0; i < STRESS_DEPTH; i++) {
+    opening += nestings[i % nestings.size()].first;
+  }
+  for (int i = STRESS_DEPTH - 1; i >= 0; i--) {
+    closing += nestings[i % nestings.size()].second;
+  }
+  auto source = L"fn main() -> int { " + opening + L"return 0; " + closing + L"}";
+
+  auto program = parse(source, ParsingMode::Iterative);
+  ASSERT_TRUE(program != std::nullopt);
+
+  int depth = 0;
+  BlockStmt* block = &mainBody(*program);
+  while (block->statements.size() == 1) {
+    auto statement = block->statements.at(0).get();
+    if (auto ifStmt = dynamic_cast<IfStmt*>(statement)) {
+      block = ifStmt->elseClause ? &ifStmt->elseClause->block : &ifStmt->elifs.at(0).block;
+    } else if (auto whileStmt = dynamic_cast<WhileStmt*>(statement)) {
+      block = &whileStmt->block;
+    } else if (auto forStmt = dynamic_cast<ForStmt*>(statement)) {
+      block = &forStmt->block;
+    } else if (auto match = dynamic_cast<VariantMatchStmt*>(statement)) {
+      block = &match->cases.at(L"int").block;
+    } else if (auto nested = dynamic_cast<BlockStmt*>(statement)) {
+      block = nested;
+    } else {
+      break;
+    }
+    depth++;
+  }
+  EXPECT_EQ(depth, STRESS_DEPTH);
+  EXPECT_TRUE(dynamic_cast<ReturnStmt*>(block->statements.at(0).get()) != nullptr);
+
+  destroyIteratively(*program);
+}
+
+TEST(IterativeParser, ParsesLongElifChain) {
+  auto source = L"fn main() -> int { if x {}" + repeat(L" elif x {}", STRESS_DEPTH) +
+                L" else { return 0; } }";
+
+  auto program = parse(source, ParsingMode::Iterative);
+  ASSERT_TRUE(program != std::nullopt);
+
+  auto ifStmt = dynamic_cast<IfStmt*>(mainBody(*program).statements.at(0).get());
+  ASSERT_TRUE(ifStmt != nullptr);
+  EXPECT_EQ(ifStmt->elifs.size(), STRESS_DEPTH);
+  EXPECT_TRUE(ifStmt->elseClause != nullptr);
+
+  destroyIteratively(*program);
+}